@@ -35,6 +35,7 @@ enum VmafOutputFormat {
     VMAF_OUTPUT_FORMAT_XML,
     VMAF_OUTPUT_FORMAT_JSON,
     VMAF_OUTPUT_FORMAT_CSV,
+    VMAF_OUTPUT_FORMAT_BIN, ///< Binary columnar, one f64 column per feature.
 };
 
 enum VmafPoolingMethod {
@@ -44,15 +45,63 @@ enum VmafPoolingMethod {
     VMAF_POOL_METHOD_HARMONIC_MEAN,
 };
 
+enum VmafSubsampleMode {
+    VMAF_SUBSAMPLE_MODE_FIXED = 0, ///< Every `n_subsample`th picture.
+    VMAF_SUBSAMPLE_MODE_ADAPTIVE, ///< Up to `n_subsample` apart, see below.
+};
+
+/**
+ * With a `scale_filter`, distorted pictures of a different size than the
+ * reference, e.g. the lower renditions of an encoding ladder, are scaled to
+ * the reference size before extraction. All distorted pictures must have
+ * the same size, formats and bitdepths must match.
+ */
+enum VmafScaleFilter {
+    VMAF_SCALE_FILTER_NONE = 0, ///< Distorted pictures match the reference.
+    VMAF_SCALE_FILTER_BICUBIC, ///< Catmull-Rom, 4 taps when upscaling.
+    VMAF_SCALE_FILTER_LANCZOS, ///< Lanczos-3, 6 taps when upscaling.
+};
+
+/**
+ * With `VMAF_SUBSAMPLE_MODE_ADAPTIVE`, static content is scored every
+ * `n_subsample`th picture, and the stride shrinks down to every picture as
+ * consecutive reference pictures, or the detail lost in the distorted ones,
+ * differ more. Both pictures around a scene cut are scored. Pooling
+ * interpolates the scores of pictures in between, see
+ * `vmaf_subsample_report()`.
+ */
 typedef struct VmafConfiguration {
     enum VmafLogLevel log_level;
     unsigned n_threads;
     unsigned n_subsample;
     uint32_t cpumask;
+    unsigned preview; ///< Decimate input by 2 before extraction, 0 off.
+    enum VmafSubsampleMode subsample_mode;
+    enum VmafScaleFilter scale_filter;
+    unsigned max_in_flight; ///< Picture pairs being extracted, 0 unbounded.
 } VmafConfiguration;
 
 typedef struct VmafContext VmafContext;
 
+typedef struct VmafProfileTimer {
+    const char *name; ///< Feature extractor name, NULL for other stages.
+    unsigned long long cnt; ///< Number of timed calls.
+    double wall; ///< Summed monotonic wall time, in seconds.
+    double cpu; ///< Summed thread CPU time, in seconds. 0 for waits.
+} VmafProfileTimer;
+
+typedef struct VmafProfile {
+    double wall; ///< Seconds between the first and the last collected score.
+    double fps; ///< Pictures per second of `wall`.
+    VmafProfileTimer pool_wait; ///< Waiting for a feature extractor context.
+    VmafProfileTimer collector_wait; ///< Waiting for the collector lock.
+    struct {
+        unsigned max;
+        double mean;
+    } queue_depth; ///< Pending thread pool jobs, sampled on submission.
+    unsigned n_extractors; ///< See `vmaf_get_extractor_profile()`.
+} VmafProfile;
+
 /**
  * Allocate and open a VMAF instance.
  *
@@ -73,6 +122,8 @@ int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg);
  * This may be called multiple times using different models.
  * In this case, the registered feature extractors will form a set, and any
  * features required by multiple models will only be extracted once.
+ * With `VmafConfiguration.preview` set, the model must be loaded with the
+ * matching `VMAF_MODEL_FLAG_PREVIEW_2X` flag, and vice versa.
  *
  * @param vmaf  The VMAF context allocated with `vmaf_init()`.
  *
@@ -123,7 +174,7 @@ int vmaf_import_feature_score(VmafContext *vmaf, char *feature_name,
  * This should be called after feature extractors are registered via
  * `vmaf_use_features_from_model()` and/or `vmaf_use_feature()`.
  * `VmafContext` will take ownership of both `VmafPicture`s (`ref` and `dist`)
- * and `vmaf_picture_unref()`.
+ * and `vmaf_picture_unref()`, on error as well.
  *
  * @param vmaf  The VMAF context allocated with `vmaf_init()`.
  *
@@ -139,6 +190,262 @@ int vmaf_import_feature_score(VmafContext *vmaf, char *feature_name,
 int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
                        unsigned index);
 
+enum VmafSubmitFlags {
+    VMAF_SUBMIT_NONBLOCK = 1 << 0, ///< Return -EAGAIN instead of waiting.
+};
+
+/**
+ * Like `vmaf_read_pictures()`, with backpressure. With `n_threads`, picture
+ * pairs are extracted by the thread pool after this returns, and are in
+ * flight until their last feature extractor is done. With `max_in_flight`,
+ * a pair is only queued while fewer pairs are in flight, so a fast
+ * producer holds at most `max_in_flight` pairs of pictures in the context.
+ * `vmaf_read_pictures()` waits for a free slot as well.
+ *
+ * @param vmaf  The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param ref   Reference picture.
+ *
+ * @param dist  Distorted picture.
+ *
+ * @param index Picture index.
+ *
+ * @param flags `VmafSubmitFlags`, or 0 to wait for a free slot.
+ *
+ *
+ * @return 0 on success, -EAGAIN with `VMAF_SUBMIT_NONBLOCK` if no slot is
+ *         free, in which case the caller keeps ownership of both pictures,
+ *         or < 0 (a negative errno code) on error, in which case both
+ *         pictures have been released.
+ */
+int vmaf_submit_pictures(VmafContext *vmaf, VmafPicture *ref,
+                         VmafPicture *dist, unsigned index, unsigned flags);
+
+/**
+ * Check whether picture pair `index` is still in flight. A pair that is no
+ * longer in flight does not have all of its scores yet: temporal feature
+ * extractors write the scores of `index` once `index + 1` is extracted, or
+ * when the context is flushed, and scores of repeated and skipped pictures
+ * are only filled in then. All scores are there once `vmaf_score_pooled()`
+ * or `vmaf_write_output()` has flushed the context.
+ *
+ * @return 1 if its extraction is queued or running, 0 if it is not, which
+ *         includes pairs that were never submitted.
+ */
+int vmaf_poll_pictures(VmafContext *vmaf, unsigned index);
+
+/**
+ * Wait until picture pair `index` is no longer in flight, see
+ * `vmaf_poll_pictures()`. Returns at once if `index` is not in flight, also
+ * if it has not been submitted yet.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_wait_pictures(VmafContext *vmaf, unsigned index);
+
+/**
+ * Restrict a VMAF context to the segment [index_low, index_high) of a longer
+ * sequence, so that segments can be scored by independent contexts, in
+ * parallel, and merged with `vmaf_merge_segment()`.
+ * The pictures just outside of the segment, `index_low - 1` and `index_high`,
+ * must be read as well if they exist. Temporal feature extractors use them
+ * to rebuild their state at the segment boundaries, other feature extractors
+ * skip them. This should be called before the first picture is read.
+ *
+ * @param vmaf       The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param index_low  First picture index of the segment.
+ *
+ * @param index_high Picture index just past the end of the segment.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_set_segment(VmafContext *vmaf, unsigned index_low,
+                     unsigned index_high);
+
+typedef struct VmafActiveArea {
+    unsigned x, y, w, h; ///< In luma pixels, all even.
+} VmafActiveArea;
+
+/**
+ * Detect the active area of a picture, i.e. the area inside of black
+ * letterbox or pillarbox bars. If `area` is not empty, it is extended to
+ * cover the active area of `pic` as well, so that the area can be
+ * accumulated over pictures of several scenes. Black pictures, e.g. fades,
+ * leave it as it is.
+ *
+ * @param pic  Picture to detect the active area of, not consumed.
+ *
+ * @param area Active area, zeroed before the first call.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_detect_active_area(VmafPicture *pic, VmafActiveArea *area);
+
+/**
+ * Crop both pictures of every pair to an active area before extraction,
+ * without a copy, so that black bars neither cost compute nor skew the
+ * scores. The area is fixed for the context, since feature extractors
+ * keep their dimensions. Pictures with content outside of the area, e.g.
+ * a later scene without bars, are counted, see `vmaf_get_active_area()`.
+ * This should be called before the first picture is read.
+ *
+ * @param vmaf The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param area Active area, see `vmaf_detect_active_area()`.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_set_active_area(VmafContext *vmaf, VmafActiveArea area);
+
+/**
+ * Get the active area set with `vmaf_set_active_area()`.
+ *
+ * @param vmaf    The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param area    Active area, empty if none was set.
+ *
+ * @param exposed Pictures read with content outside of the area.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_get_active_area(VmafContext *vmaf, VmafActiveArea *area,
+                         unsigned *exposed);
+
+/**
+ * Get the planes which the registered feature extractors read. Most read
+ * luma only, in which case pictures may be allocated without chroma, see
+ * `vmaf_picture_alloc_planes()` and `vmaf_reader_set_planes()`. This should
+ * be called after the feature extractors are registered.
+ *
+ * @param vmaf   The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param planes Mask of `enum VmafPlane`.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_get_planes(VmafContext *vmaf, unsigned *planes);
+
+/**
+ * Cache the scores of reference-only feature extractors, such as motion, in
+ * a file keyed by the reference luma. When the same reference is scored
+ * against other distorted encodes, cached scores are reused and those
+ * feature extractors are skipped. New scores are appended to the file by
+ * `vmaf_close()`. This should be called after the feature extractors are
+ * registered and before the first picture is read.
+ *
+ * @param vmaf The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param path Cache file, created if it does not exist.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_use_reference_cache(VmafContext *vmaf, const char *path);
+
+/**
+ * Merge the scores of a segment into another VMAF context. Only scores inside
+ * of the segment set with `vmaf_set_segment()` are merged, so merging all
+ * segments of a sequence gives the same scores as a serial run.
+ *
+ * @param vmaf    The VMAF context which receives the scores.
+ *
+ * @param segment The VMAF context of a segment, it remains owned by the
+ *                caller and should be closed with `vmaf_close()`.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_merge_segment(VmafContext *vmaf, VmafContext *segment);
+
+/**
+ * Write the feature scores of a VMAF context as a partial result, a compact
+ * and versioned binary format which can be merged by another process with
+ * `vmaf_import_partial()`. If a segment is set with `vmaf_set_segment()`,
+ * only scores inside of the segment are written. Partial results may be
+ * concatenated, e.g. when several workers write into one pipe.
+ *
+ * @param vmaf    The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param outfile Output file or pipe, `fopen()`'d by calling application.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_export_partial(VmafContext *vmaf, FILE *outfile);
+
+/**
+ * Read one partial result written by `vmaf_export_partial()` and merge its
+ * scores, so that `vmaf_score_pooled()` can run over the union of several
+ * partial results without extracting features again.
+ *
+ * @param vmaf       The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param infile     Input file or pipe, `fopen()`'d by calling application.
+ *
+ * @param index_low  Optional, set to the first picture index of the partial.
+ *
+ * @param index_high Optional, set to the picture index just past the end of
+ *                   the partial.
+ *
+ *
+ * @return 0 on success, 1 if `infile` ended before a partial result,
+ *         or < 0 (a negative errno code) on error.
+ */
+int vmaf_import_partial(VmafContext *vmaf, FILE *infile,
+                        unsigned *index_low, unsigned *index_high);
+
+/**
+ * Get the built-in profile of a VMAF context. Pending feature extraction is
+ * flushed first, so the profile covers every picture read so far. Pool wait
+ * and queue depth are only recorded when `VmafConfiguration.n_threads` > 0.
+ *
+ * @param vmaf    The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param profile Profile of all feature extractors and stages.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_get_profile(VmafContext *vmaf, VmafProfile *profile);
+
+/**
+ * Get the time spent in the `extract` callback of a registered feature
+ * extractor, summed over all of its thread contexts.
+ *
+ * @param vmaf  The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param index Feature extractor index, < `VmafProfile.n_extractors`.
+ *
+ * @param timer Timer of the feature extractor, `name` stays valid until
+ *              `vmaf_close()`.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_get_extractor_profile(VmafContext *vmaf, unsigned index,
+                               VmafProfileTimer *timer);
+
+/**
+ * Write all trace spans recorded so far as Chrome trace-event JSON, to be
+ * loaded in chrome://tracing or Perfetto. Spans cover each `extract` call,
+ * thread pool job and wait, feature extractor context aquisition and
+ * prediction. With `-Denable_perf_counters=true` each span also carries
+ * the cycles, instructions, cache references and cache misses of its thread.
+ *
+ * @param outfile Output file.
+ *
+ *
+ * @return 0 on success, -ENOSYS if libvmaf was built without
+ *         `-Denable_trace=true`, or < 0 (a negative errno code) on error.
+ */
+int vmaf_write_trace(FILE *outfile);
+
 /**
  * Predict VMAF score at specific index.
  *
@@ -157,7 +464,8 @@ int vmaf_score_at_index(VmafContext *vmaf, VmafModel *model, double *score,
                         unsigned index);
 
 /**
- * Predict pooled VMAF score for a specific interval.
+ * Predict pooled VMAF score for a specific interval. With a fixed
+ * `n_subsample`, only the scored pictures of the interval are pooled.
  *
  * @param vmaf         The VMAF context allocated with `vmaf_init()`.
  *
@@ -178,6 +486,124 @@ int vmaf_score_pooled(VmafContext *vmaf, VmafModel *model,
                       enum VmafPoolingMethod pool_method, double *score,
                       unsigned index_low, unsigned index_high);
 
+typedef struct VmafSubsampleReport {
+    unsigned scored, pictures; ///< Pictures scored, out of all pooled.
+    double error; ///< Estimated error of the mean pooled score.
+} VmafSubsampleReport;
+
+/**
+ * Report how an interval was sampled by `VMAF_SUBSAMPLE_MODE_ADAPTIVE`.
+ * The error estimate assumes the score of each picture which was not
+ * scored may be off its linear interpolation by up to half the difference
+ * of the scored pictures around it.
+ *
+ * @param vmaf         The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param model        Opaque model context.
+ *
+ * @param report       Sampling report.
+ *
+ * @param index_low    Low picture index of pooling interval.
+ *
+ * @param index_high   High picture index of pooling interval.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_subsample_report(VmafContext *vmaf, VmafModel *model,
+                          VmafSubsampleReport *report,
+                          unsigned index_low, unsigned index_high);
+
+enum VmafGateDecision {
+    VMAF_GATE_UNDECIDED = 0,
+    VMAF_GATE_PASS, ///< Mean pooled score at or above the threshold.
+    VMAF_GATE_FAIL, ///< Mean pooled score below the threshold.
+};
+
+typedef struct VmafGateConfiguration {
+    double threshold; ///< Mean pooled score to decide against.
+    double confidence; ///< Of the decision, 0 for 0.95.
+    unsigned pic_cnt; ///< Pictures in the sequence.
+    unsigned stratum; ///< Pictures per stratum, 0 for 16.
+    unsigned seed; ///< Of the randomized order and of the bootstrap.
+} VmafGateConfiguration;
+
+typedef struct VmafGateStatus {
+    enum VmafGateDecision decision;
+    unsigned scored, strata; ///< Strata scored, out of all.
+    double score; ///< Estimated mean pooled score.
+    double ci_low, ci_high; ///< Confidence interval of the last look.
+} VmafGateStatus;
+
+/**
+ * A quality gate decides whether the mean pooled score of a sequence is
+ * above a threshold without scoring all of it. The sequence is split into
+ * strata of consecutive pictures, which are scored in a randomized order,
+ * see `vmaf_gate_next()`. Each stratum can be scored by a context of its
+ * own restricted with `vmaf_set_segment()` and merged, so that temporal
+ * feature extractors see consecutive pictures.
+ *
+ * The confidence interval of the score is bootstrapped from the stratum
+ * means, with a finite population correction. It is only checked at a
+ * few looks, when the number of scored strata reaches 8, 16, 32, ... and
+ * all of them, each at an equal share of the error rate, so that the
+ * decision holds at the configured confidence even though it is checked
+ * repeatedly.
+ */
+typedef struct VmafGate VmafGate;
+
+/**
+ * Allocate a quality gate.
+ *
+ * @param gate The gate to allocate.
+ *
+ * @param cfg  Gate configuration, `threshold` and `pic_cnt` are required.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_gate_init(VmafGate **gate, VmafGateConfiguration cfg);
+
+/**
+ * Get the next stratum to score, in randomized order.
+ *
+ * @param gate       The gate allocated with `vmaf_gate_init()`.
+ *
+ * @param index_low  First picture index of the stratum.
+ *
+ * @param index_high Picture index just past the end of the stratum.
+ *
+ *
+ * @return 0 on success, 1 when every stratum has been handed out, or < 0
+ *         (a negative errno code) on error.
+ */
+int vmaf_gate_next(VmafGate *gate, unsigned *index_low, unsigned *index_high);
+
+/**
+ * Update the gate with the strata handed out so far which are completely
+ * scored in `vmaf`, and decide if possible.
+ *
+ * @param gate   The gate allocated with `vmaf_gate_init()`.
+ *
+ * @param vmaf   The VMAF context holding the scores.
+ *
+ * @param model  Opaque model context.
+ *
+ * @param status Decision and current estimate.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_gate_check(VmafGate *gate, VmafContext *vmaf, VmafModel *model,
+                    VmafGateStatus *status);
+
+/**
+ * Free a quality gate.
+ *
+ * @param gate The gate allocated with `vmaf_gate_init()`.
+ */
+void vmaf_gate_close(VmafGate *gate);
+
 /**
  * Close a VMAF instance and free all associated memory.
  *
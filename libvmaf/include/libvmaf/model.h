@@ -26,6 +26,7 @@ enum VmafModelFlags {
     VMAF_MODEL_FLAG_DISABLE_CLIP = (1 << 0),
     VMAF_MODEL_FLAG_ENABLE_TRANSFORM = (1 << 1),
     VMAF_MODEL_FLAG_ENABLE_CONFIDENCE_INTERVAL = (1 << 2),
+    VMAF_MODEL_FLAG_PREVIEW_2X = (1 << 3),
 };
 
 typedef struct VmafModelConfig {
@@ -37,4 +38,14 @@ typedef struct VmafModelConfig {
 int vmaf_model_load_from_path(VmafModel **model, VmafModelConfig *cfg);
 void vmaf_model_destroy(VmafModel *model);
 
+/**
+ * Expected error of a model loaded with `VMAF_MODEL_FLAG_PREVIEW_2X`:
+ * the RMS difference, in score points, between its per-picture scores and
+ * those of the same model at full resolution.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error,
+ *         -EINVAL if the model is not a preview model.
+ */
+int vmaf_model_preview_error(VmafModel *model, double *error);
+
 #endif /* __VMAF_MODEL_H__ */
@@ -27,10 +27,25 @@ enum VmafPixelFormat {
     VMAF_PIX_FMT_YUV420P,
     VMAF_PIX_FMT_YUV422P,
     VMAF_PIX_FMT_YUV444P,
+    VMAF_PIX_FMT_NV12, ///< 4:2:0, chroma in one interleaved UV plane.
+    VMAF_PIX_FMT_P010, ///< NV12 in 16-bit words, 10 bits MSB-aligned.
 };
 
+enum VmafPlane {
+    VMAF_PLANE_Y = 1 << 0,
+    VMAF_PLANE_U = 1 << 1,
+    VMAF_PLANE_V = 1 << 2,
+};
+
+#define VMAF_PLANES_ALL (VMAF_PLANE_Y | VMAF_PLANE_U | VMAF_PLANE_V)
+
 typedef void pixel;
 
+/**
+ * Semi-planar formats (NV12, P010) keep U and V interleaved in plane 1.
+ * Plane 2 points one sample into plane 1 and shares its stride, `w[1]`
+ * and `w[2]` count the samples of one component. P010 has a `bpc` of 10.
+ */
 typedef struct {
     enum VmafPixelFormat pix_fmt;
     unsigned bpc;
@@ -38,11 +53,21 @@ typedef struct {
     ptrdiff_t stride[3];
     pixel *data[3];
     atomic_int *ref_cnt;
+    void *priv; ///< Private data, shared by all references.
 } VmafPicture;
 
 int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
                        unsigned bpc, unsigned w, unsigned h);
 
+/**
+ * Like vmaf_picture_alloc(), but only the planes in `planes`, a mask of
+ * enum VmafPlane, are allocated. Planes left out keep their dimensions,
+ * with a NULL data pointer and a stride of 0.
+ */
+int vmaf_picture_alloc_planes(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                              unsigned bpc, unsigned w, unsigned h,
+                              unsigned planes);
+
 int vmaf_picture_unref(VmafPicture *pic);
 
 #endif /* __VMAF_PICTURE_H__ */
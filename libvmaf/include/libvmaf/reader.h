@@ -0,0 +1,109 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_READER_H__
+#define __VMAF_READER_H__
+
+#include "libvmaf/picture.h"
+
+typedef struct VmafReader VmafReader;
+
+typedef struct {
+    enum VmafPixelFormat pix_fmt;
+    unsigned bpc;
+    unsigned w, h;
+    unsigned frame_cnt; ///< 0 if the input is not seekable.
+} VmafReaderInfo;
+
+/**
+ * Open a Y4M file. Only progressive frame headers without parameters
+ * ("FRAME\n") are supported, chroma is read as stored, without resampling.
+ *
+ * @param reader The reader to open.
+ *
+ * @param path   Path to the Y4M file.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_reader_open_y4m(VmafReader **reader, const char *path);
+
+/**
+ * Open a headerless planar YUV file.
+ *
+ * @param reader  The reader to open.
+ *
+ * @param path    Path to the YUV file.
+ *
+ * @param pix_fmt Pixel format of the file.
+ *
+ * @param bpc     Bitdepth, samples above 8 bits are little endian words.
+ *
+ * @param w       Width in pixels.
+ *
+ * @param h       Height in pixels.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_reader_open_yuv(VmafReader **reader, const char *path,
+                         enum VmafPixelFormat pix_fmt, unsigned bpc,
+                         unsigned w, unsigned h);
+
+int vmaf_reader_get_info(VmafReader *reader, VmafReaderInfo *info);
+
+/**
+ * Read only some planes, e.g. luma alone when no feature extractor in use
+ * reads chroma, see vmaf_get_planes(). The other planes are seeked past,
+ * or read and dropped for pipes, and pictures are allocated without them.
+ * All planes are read by default.
+ *
+ * @param reader The reader.
+ *
+ * @param planes Mask of enum VmafPlane, luma is required.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_reader_set_planes(VmafReader *reader, unsigned planes);
+
+/**
+ * Read frame `index` straight into a pooled picture. Regular files are read
+ * with positional reads, so any index may be requested, also concurrently
+ * from several threads. Pipes must be read in order. Release the picture
+ * with vmaf_picture_unref(), or hand it to vmaf_read_pictures().
+ *
+ * @param reader The reader.
+ *
+ * @param pic    Picture which receives the frame.
+ *
+ * @param index  Frame index.
+ *
+ * @return 0 on success, 1 past the last frame,
+ *         or < 0 (a negative errno code) on error.
+ */
+int vmaf_reader_read_picture(VmafReader *reader, VmafPicture *pic,
+                             unsigned index);
+
+/**
+ * Close the reader. Pictures which are still referenced stay valid.
+ *
+ * @param reader The reader to close.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_reader_close(VmafReader *reader);
+
+#endif /* __VMAF_READER_H__ */
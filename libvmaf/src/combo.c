@@ -29,7 +29,7 @@
 #include "common/convolution.h"
 #include "common/convolution_internal.h"
 #include "iqa/ssim_tools.h"
-#include "darray.h"
+#include "feature_table.h"
 #include "adm_options.h"
 #include "combo.h"
 #include "debug.h"
@@ -54,6 +54,48 @@ int compute_ms_ssim(const float *ref, const float *cmp, int w, int h, int ref_st
 
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 
+/*
+ * claims the ring slot of frame frm_idx, reads it in turn, then offsets and
+ * blurs it outside of any lock. Returns the read_frame() result, or -1 if the
+ * ring was stopped or frm_idx is past the end of input.
+ */
+static int read_and_blur_frame(VMAF_THREAD_STRUCT* thread_data, int frm_idx, float *temp_buf)
+{
+    BLUR_BUF_RING* ring = thread_data->blur_ring;
+    int w = thread_data->w;
+    int h = thread_data->h;
+    int stride = thread_data->stride;
+    float *ref_buf, *dis_buf, *blur_buf;
+
+    if (blur_ring_claim(ring, frm_idx, &ref_buf, &dis_buf, &blur_buf))
+        return -1;
+    if (blur_ring_begin_read(ring, frm_idx))
+        return -1;
+
+    // only this read is ordered between threads
+    int ret = thread_data->read_frame(ref_buf, dis_buf, temp_buf, stride, thread_data->user_data);
+    blur_ring_end_read(ring, frm_idx, ret);
+    if (ret)
+        return ret;
+
+    // ===============================================================
+    // offset pixel by OPT_RANGE_PIXEL_OFFSET
+    // ===============================================================
+    offset_image(ref_buf, OPT_RANGE_PIXEL_OFFSET, w, h, stride);
+    offset_image(dis_buf, OPT_RANGE_PIXEL_OFFSET, w, h, stride);
+
+    // ===============================================================
+    // filter
+    // apply filtering (to eliminate effects film grain)
+    // stride input to convolution_f32_c is in terms of (sizeof(float) bytes)
+    // since stride = ALIGN_CEIL(w * sizeof(float)), stride divides sizeof(float)
+    // ===============================================================
+    convolution_f32_c(FILTER_5, 5, ref_buf, blur_buf, temp_buf, w, h, stride / sizeof(float), stride / sizeof(float));
+
+    blur_ring_publish(ring, frm_idx);
+    return 0;
+}
+
 void* combo_threadfunc(void* vmaf_thread_data)
 {
     // this is our shared thread data
@@ -67,9 +109,10 @@ void* combo_threadfunc(void* vmaf_thread_data)
     int w = thread_data->w;
     int h = thread_data->h;
     char* errmsg = thread_data->errmsg;
-    void* user_data = thread_data->user_data;
     const char* fmt = thread_data->fmt;
     int n_subsample = thread_data->n_subsample;
+    FeatureTable *feature_table = thread_data->feature_table;
+    BLUR_BUF_RING* ring = thread_data->blur_ring;
 
     double score = 0;
     double score2 = 0;
@@ -87,8 +130,6 @@ void* combo_threadfunc(void* vmaf_thread_data)
     float *dis_buf = 0;
     float *prev_blur_buf = 0;
     float *blur_buf = 0;
-    float *next_ref_buf = 0;
-    float *next_dis_buf = 0;
     float *next_blur_buf = 0;
     float *temp_buf = 0;
 
@@ -101,6 +142,7 @@ void* combo_threadfunc(void* vmaf_thread_data)
     if (!(temp_buf = aligned_malloc(data_sz * 2, MAX_ALIGN)))
     {
         sprintf(errmsg, "aligned_malloc failed for temp_buf.\n");
+        ret = -1;
         goto fail_or_end;
     }
 
@@ -108,139 +150,46 @@ void* combo_threadfunc(void* vmaf_thread_data)
 
     while (1)
     {
+        // the next frame, handed out without locking
+        frm_idx = blur_ring_next_frame(ring);
 
-        pthread_mutex_lock(&thread_data->mutex_readframe);
-
-        if (thread_data->stop_threads)
+        if (feature_table_reserve(feature_table, frm_idx + 1))
         {
-            // this is the signal that another thread has reached the end of the input file, so we all quit
-            pthread_mutex_unlock(&thread_data->mutex_readframe);
+            sprintf(errmsg, "Feature table allocation failed.\n");
+            ret = -1;
             goto fail_or_end;
         }
 
-        // the next frame
-        frm_idx = thread_data->frm_idx;
-        thread_data->frm_idx++;
-
+        // frame 0 has no previous thread reading it ahead
         if (frm_idx == 0)
         {
-            // Allocating the free buffers from buffer array
-            blur_buf    = get_free_blur_buf_slot(&thread_data->blur_buf_array, frm_idx);
-            ref_buf     = get_free_blur_buf_slot(&thread_data->ref_buf_array, frm_idx);
-            dis_buf     = get_free_blur_buf_slot(&thread_data->dis_buf_array, frm_idx);
-		
-            if((NULL == blur_buf) || (NULL == ref_buf) || (NULL == dis_buf))
-            {
-                thread_data->stop_threads = 1;
-                sprintf(errmsg, "No free slot found for buffer allocation.\n");
-                pthread_mutex_unlock(&thread_data->mutex_readframe);
-                goto fail_or_end;
-            }
-
-            // read frame from file
-
-            ret = thread_data->read_frame(ref_buf, dis_buf, temp_buf, stride, user_data);
+            ret = read_and_blur_frame(thread_data, 0, temp_buf);
             if (ret == 1)
             {
-                thread_data->stop_threads = 1;
-                pthread_mutex_unlock(&thread_data->mutex_readframe);
-                goto fail_or_end;
-            }
-            if (ret == 2)
-            {
-                thread_data->stop_threads = 1;
-                pthread_mutex_unlock(&thread_data->mutex_readframe);
-                goto fail_or_end;
-            }
-
-            // ===============================================================
-            // offset pixel by OPT_RANGE_PIXEL_OFFSET
-            // ===============================================================
-            offset_image(ref_buf, OPT_RANGE_PIXEL_OFFSET, w, h, stride);
-            offset_image(dis_buf, OPT_RANGE_PIXEL_OFFSET, w, h, stride);
-
-            // ===============================================================
-            // filter
-            // apply filtering (to eliminate effects film grain)
-            // stride input to convolution_f32_c is in terms of (sizeof(float) bytes)
-            // since stride = ALIGN_CEIL(w * sizeof(float)), stride divides sizeof(float)
-            // ===============================================================
-            convolution_f32_c(FILTER_5, 5, ref_buf, blur_buf, temp_buf, w, h, stride / sizeof(float), stride / sizeof(float));
-
-        }
-        else
-        {
-            // retrieve from buffer array
-            ref_buf     = get_blur_buf(&thread_data->ref_buf_array, frm_idx);
-            dis_buf     = get_blur_buf(&thread_data->dis_buf_array, frm_idx);
-            blur_buf    = get_blur_buf(&thread_data->blur_buf_array, frm_idx);
-
-            if((NULL == ref_buf) || (NULL == dis_buf) || (NULL == blur_buf))
-            {
-                thread_data->stop_threads = 1;
-                sprintf(errmsg, "Data not available.\n");
-                pthread_mutex_unlock(&thread_data->mutex_readframe);
+                sprintf(errmsg, "read_frame failed.\n");
                 goto fail_or_end;
             }
+            if (ret)
+                goto end_of_input;
         }
 
-        // Allocate free buffer from the buffer array for next frame index
-        next_ref_buf 	= get_free_blur_buf_slot(&thread_data->ref_buf_array, frm_idx + 1);
-        next_dis_buf 	= get_free_blur_buf_slot(&thread_data->dis_buf_array, frm_idx + 1);
-        if((NULL == next_ref_buf) || (NULL == next_dis_buf))
-        {
-            thread_data->stop_threads = 1;
-            sprintf(errmsg, "No free slot found for next buffer.\n");
-            pthread_mutex_unlock(&thread_data->mutex_readframe);
-            goto fail_or_end;
-        }
-
-        ret = thread_data->read_frame(next_ref_buf, next_dis_buf, temp_buf, stride, user_data);
+        // read ahead the next frame, needed for motion2
+        ret = read_and_blur_frame(thread_data, frm_idx + 1, temp_buf);
         if (ret == 1)
         {
-            thread_data->stop_threads = 1;
-            pthread_mutex_unlock(&thread_data->mutex_readframe);
+            sprintf(errmsg, "read_frame failed.\n");
             goto fail_or_end;
         }
-        if (ret == 2)
-        {
-            thread_data->stop_threads = 1;
-            next_frame_read = false;
-        }
-        else
-        {
-            next_frame_read = true;
-        }
+        next_frame_read = (ret == 0);
 
-        if (next_frame_read)
+        // wait for this frame to be read and blurred by the previous thread
+        if (blur_ring_get(ring, frm_idx, &ref_buf, &dis_buf, &blur_buf))
         {
-            next_blur_buf     = get_free_blur_buf_slot(&thread_data->blur_buf_array, frm_idx + 1);
-            if(NULL == next_blur_buf)
-            {
-                thread_data->stop_threads = 1;
-                sprintf(errmsg, "No free slot found for blur buffer.\n");
-                goto fail_or_end;
-            }
-            // ===============================================================
-            // offset pixel by OPT_RANGE_PIXEL_OFFSET
-            // ===============================================================
-            offset_image(next_ref_buf, OPT_RANGE_PIXEL_OFFSET, w, h, stride);
-            offset_image(next_dis_buf, OPT_RANGE_PIXEL_OFFSET, w, h, stride);
-
-            // ===============================================================
-            // filter
-            // apply filtering (to eliminate effects film grain)
-            // stride input to convolution_f32_c is in terms of (sizeof(float) bytes)
-            // since stride = ALIGN_CEIL(w * sizeof(float)), stride divides sizeof(float)
-            // ===============================================================
-            convolution_f32_c(FILTER_5, 5, next_ref_buf, next_blur_buf, temp_buf, w, h, stride / sizeof(float), stride / sizeof(float));
-
+            ret = 0;
+            goto end_of_input;
         }
-
-        // release ref and dis buffer references after blur buf computation
-        release_blur_buf_reference(&thread_data->ref_buf_array, frm_idx + 1);
-        release_blur_buf_reference(&thread_data->dis_buf_array, frm_idx + 1);
-        pthread_mutex_unlock(&thread_data->mutex_readframe);
+        if (next_frame_read)
+            blur_ring_get(ring, frm_idx + 1, NULL, NULL, &next_blur_buf);
 
         dbg_printf("frame: %d, ", frm_idx);
 
@@ -251,14 +200,14 @@ void* combo_threadfunc(void* vmaf_thread_data)
         // ===============================================================
 
         // offset back the buffers only if required
-        if (frm_idx % n_subsample == 0 && ( (thread_data->psnr_array != NULL) || (thread_data->ssim_array != NULL) || (thread_data->ms_ssim_array != NULL) ))
+        if (frm_idx % n_subsample == 0 && (feature_table_has(feature_table, FEATURE_PSNR) || feature_table_has(feature_table, FEATURE_SSIM) || feature_table_has(feature_table, FEATURE_MS_SSIM)))
         {
             offset_image(ref_buf, -OPT_RANGE_PIXEL_OFFSET, w, h, stride);
             offset_image(dis_buf, -OPT_RANGE_PIXEL_OFFSET, w, h, stride);
             offset_flag = true;
 		}
 
-        if (frm_idx % n_subsample == 0 && thread_data->psnr_array != NULL)
+        if (frm_idx % n_subsample == 0 && feature_table_has(feature_table, FEATURE_PSNR))
         {
             /* =========== psnr ============== */
             ret = compute_psnr(ref_buf, dis_buf, w, h, stride, stride, &score, peak, psnr_max);
@@ -271,10 +220,10 @@ void* combo_threadfunc(void* vmaf_thread_data)
 
             dbg_printf("psnr: %.3f, ", score);
 
-            insert_array_at(thread_data->psnr_array, score, frm_idx);
+            feature_table_set(feature_table, FEATURE_PSNR, frm_idx, score);
         }
 
-        if (frm_idx % n_subsample == 0 && thread_data->ssim_array != NULL)
+        if (frm_idx % n_subsample == 0 && feature_table_has(feature_table, FEATURE_SSIM))
         {
 
             /* =========== ssim ============== */
@@ -286,10 +235,10 @@ void* combo_threadfunc(void* vmaf_thread_data)
 
             dbg_printf("ssim: %.3f, ", score);
 
-            insert_array_at(thread_data->ssim_array, score, frm_idx);
+            feature_table_set(feature_table, FEATURE_SSIM, frm_idx, score);
         }
 
-        if (frm_idx % n_subsample == 0 && thread_data->ms_ssim_array != NULL)
+        if (frm_idx % n_subsample == 0 && feature_table_has(feature_table, FEATURE_MS_SSIM))
         {
             /* =========== ms-ssim ============== */
             if ((ret = compute_ms_ssim(ref_buf, dis_buf, w, h, stride, stride, &score, l_scores, c_scores, s_scores)))
@@ -300,7 +249,7 @@ void* combo_threadfunc(void* vmaf_thread_data)
 
             dbg_printf("ms_ssim: %.3f, ", score);
 
-            insert_array_at(thread_data->ms_ssim_array, score, frm_idx);
+            feature_table_set(feature_table, FEATURE_MS_SSIM, frm_idx, score);
         }
 
         // ===============================================================
@@ -335,16 +284,16 @@ void* combo_threadfunc(void* vmaf_thread_data)
             dbg_printf("adm_num_scale3: %.3f, ", scores[6]);
             dbg_printf("adm_den_scale3: %.3f, ", scores[7]);
 
-            insert_array_at(thread_data->adm_num_array, score_num, frm_idx);
-            insert_array_at(thread_data->adm_den_array, score_den, frm_idx);
-            insert_array_at(thread_data->adm_num_scale0_array, scores[0], frm_idx);
-            insert_array_at(thread_data->adm_den_scale0_array, scores[1], frm_idx);
-            insert_array_at(thread_data->adm_num_scale1_array, scores[2], frm_idx);
-            insert_array_at(thread_data->adm_den_scale1_array, scores[3], frm_idx);
-            insert_array_at(thread_data->adm_num_scale2_array, scores[4], frm_idx);
-            insert_array_at(thread_data->adm_den_scale2_array, scores[5], frm_idx);
-            insert_array_at(thread_data->adm_num_scale3_array, scores[6], frm_idx);
-            insert_array_at(thread_data->adm_den_scale3_array, scores[7], frm_idx);
+            feature_table_set(feature_table, FEATURE_ADM_NUM, frm_idx, score_num);
+            feature_table_set(feature_table, FEATURE_ADM_DEN, frm_idx, score_den);
+            feature_table_set(feature_table, FEATURE_ADM_NUM_SCALE0, frm_idx, scores[0]);
+            feature_table_set(feature_table, FEATURE_ADM_DEN_SCALE0, frm_idx, scores[1]);
+            feature_table_set(feature_table, FEATURE_ADM_NUM_SCALE1, frm_idx, scores[2]);
+            feature_table_set(feature_table, FEATURE_ADM_DEN_SCALE1, frm_idx, scores[3]);
+            feature_table_set(feature_table, FEATURE_ADM_NUM_SCALE2, frm_idx, scores[4]);
+            feature_table_set(feature_table, FEATURE_ADM_DEN_SCALE2, frm_idx, scores[5]);
+            feature_table_set(feature_table, FEATURE_ADM_NUM_SCALE3, frm_idx, scores[6]);
+            feature_table_set(feature_table, FEATURE_ADM_DEN_SCALE3, frm_idx, scores[7]);
         }
 #ifdef COMPUTE_ANSNR
 
@@ -393,21 +342,18 @@ void* combo_threadfunc(void* vmaf_thread_data)
             }
             else
             {
-                // avoid multiple memory copies
-                prev_blur_buf = get_blur_buf(&thread_data->blur_buf_array, frm_idx - 1);
-                if(NULL == prev_blur_buf)
+                // avoid multiple memory copies, this only fails once
+                // another thread stopped the ring and reported its error
+                if (blur_ring_get(ring, frm_idx - 1, NULL, NULL, &prev_blur_buf))
                 {
-                    thread_data->stop_threads = 1;
-                    sprintf(errmsg, "Data not available for prev_blur_buf.\n");
-                    goto fail_or_end;
+                    ret = 0;
+                    goto end_of_input;
                 }
                 if ((ret = compute_motion(prev_blur_buf, blur_buf, w, h, stride, stride, &score)))
                 {
                     sprintf(errmsg, "compute_motion (prev) failed.\n");
                     goto fail_or_end;
                 }
-                release_blur_buf_reference(&thread_data->blur_buf_array, frm_idx - 1);
-
                 if (next_frame_read)
                 {
                     if ((ret = compute_motion(blur_buf, next_blur_buf, w, h, stride, stride, &score2)))
@@ -426,13 +372,10 @@ void* combo_threadfunc(void* vmaf_thread_data)
             dbg_printf("motion: %.3f, ", score);
             dbg_printf("motion2: %.3f, ", score2);
 
-            insert_array_at(thread_data->motion_array, score, frm_idx);
-            insert_array_at(thread_data->motion2_array, score2, frm_idx);
+            feature_table_set(feature_table, FEATURE_MOTION, frm_idx, score);
+            feature_table_set(feature_table, FEATURE_MOTION2, frm_idx, score2);
 
         }
-        /* Indicate that motion score computation for this frame is complete */
-        insert_array_at(thread_data->motion_score_compute_flag_array, 1.0, frm_idx);
-        release_blur_buf_reference(&thread_data->blur_buf_array, frm_idx + 1);
 
         /* =========== vif ============== */
 
@@ -456,109 +399,48 @@ void* combo_threadfunc(void* vmaf_thread_data)
             dbg_printf("vif_den_scale3: %.3f, ", scores[7]);
             dbg_printf("vif: %.3f, ", score);
 
-            insert_array_at(thread_data->vif_num_scale0_array, scores[0], frm_idx);
-            insert_array_at(thread_data->vif_den_scale0_array, scores[1], frm_idx);
-            insert_array_at(thread_data->vif_num_scale1_array, scores[2], frm_idx);
-            insert_array_at(thread_data->vif_den_scale1_array, scores[3], frm_idx);
-            insert_array_at(thread_data->vif_num_scale2_array, scores[4], frm_idx);
-            insert_array_at(thread_data->vif_den_scale2_array, scores[5], frm_idx);
-            insert_array_at(thread_data->vif_num_scale3_array, scores[6], frm_idx);
-            insert_array_at(thread_data->vif_den_scale3_array, scores[7], frm_idx);
-            insert_array_at(thread_data->vif_array, score, frm_idx);
+            feature_table_set(feature_table, FEATURE_VIF_NUM_SCALE0, frm_idx, scores[0]);
+            feature_table_set(feature_table, FEATURE_VIF_DEN_SCALE0, frm_idx, scores[1]);
+            feature_table_set(feature_table, FEATURE_VIF_NUM_SCALE1, frm_idx, scores[2]);
+            feature_table_set(feature_table, FEATURE_VIF_DEN_SCALE1, frm_idx, scores[3]);
+            feature_table_set(feature_table, FEATURE_VIF_NUM_SCALE2, frm_idx, scores[4]);
+            feature_table_set(feature_table, FEATURE_VIF_DEN_SCALE2, frm_idx, scores[5]);
+            feature_table_set(feature_table, FEATURE_VIF_NUM_SCALE3, frm_idx, scores[6]);
+            feature_table_set(feature_table, FEATURE_VIF_DEN_SCALE3, frm_idx, scores[7]);
+            feature_table_set(feature_table, FEATURE_VIF, frm_idx, score);
         }
 
         dbg_printf("\n");
 
-        //Release references to reference and distorted buffers
-        release_blur_buf_reference(&thread_data->ref_buf_array, frm_idx);
-        release_blur_buf_reference(&thread_data->dis_buf_array, frm_idx);
-        release_blur_buf_reference(&thread_data->blur_buf_array, frm_idx);
-        /*Loop through the slots and release slots if there are no more
-          reference till the current index. Not releasing next frame as
-          it may be required for the next loop						   */
-        for(int i = 0; i <= frm_idx; i++)
-        {
-            int ref_reference_count = get_blur_buf_reference_count(&thread_data->ref_buf_array, i);
-            int dis_reference_count = get_blur_buf_reference_count(&thread_data->dis_buf_array, i);
-
-            if((ref_reference_count == 0) && (dis_reference_count == 0))
-            {
-                release_blur_buf_slot(&thread_data->ref_buf_array, i);
-                release_blur_buf_slot(&thread_data->dis_buf_array, i);
-            }
-        }
-
-        /* Loop through the blur buffer array and release slots only till current index - 1 */
-        /* Only for those whose reference counter is zero */
-        for(int i = 0; i <= (frm_idx - 1); i++)
-        {
-            int reference_count = get_blur_buf_reference_count(&thread_data->blur_buf_array, i);
-            if(reference_count == 0)
-            {
-                /* Release buffer only if motion score is computed for current, previous and next frame */
-                if(
-                    (get_at(thread_data->motion_score_compute_flag_array, i)) &&
-                    (get_at(thread_data->motion_score_compute_flag_array, i + 1)) &&
-                    ((i == 0) || (get_at(thread_data->motion_score_compute_flag_array, i - 1)))
-                    )
-                {
-                    release_blur_buf_slot(&thread_data->blur_buf_array, i);
-                }
-            }
-        }
-
-        /* If this is the last frame then release any subsequent slots */
-        if (!next_frame_read)
-        {
-            release_blur_buf_slot(&thread_data->ref_buf_array, frm_idx + 1);
-            release_blur_buf_slot(&thread_data->dis_buf_array, frm_idx + 1);
-            release_blur_buf_slot(&thread_data->blur_buf_array, frm_idx);
-        }
-
-        if (!next_frame_read)
-        {
-            thread_data->stop_threads = 1;
-            goto fail_or_end;
-        }
+        /* Publish all features of this frame at once */
+        feature_table_commit(feature_table, frm_idx);
 
+        /* Release the previous, current and next frame, slots are reused
+           once all three frames referencing them are done */
+        if (frm_idx > 0)
+            blur_ring_release(ring, frm_idx - 1);
+        blur_ring_release(ring, frm_idx);
+        if (next_frame_read)
+            blur_ring_release(ring, frm_idx + 1);
     }
 
+end_of_input:
+    // running out of frames ends this thread only, others may still be busy
+    ret = 0;
+
 fail_or_end:
 
     aligned_free(temp_buf);
 
-    // when one thread ends we signal all other threads to also stop
-    thread_data->stop_threads = 1;
-    thread_data->ret = ret;
-    pthread_exit(&ret);
+    // an error in one thread stops all other threads
+    if (ret)
+        blur_ring_stop(ring);
+    pthread_exit((void *)(intptr_t)ret);
 
 }
 
 int combo(int (*read_frame)(float *ref_data, float *main_data, float *temp_data, int stride, void *user_data), void *user_data, int w, int h, const char *fmt,
-        DArray *adm_num_array,
-        DArray *adm_den_array,
-        DArray *adm_num_scale0_array,
-        DArray *adm_den_scale0_array,
-        DArray *adm_num_scale1_array,
-        DArray *adm_den_scale1_array,
-        DArray *adm_num_scale2_array,
-        DArray *adm_den_scale2_array,
-        DArray *adm_num_scale3_array,
-        DArray *adm_den_scale3_array,
-        DArray *motion_array,
-        DArray *motion2_array,
-        DArray *vif_num_scale0_array,
-        DArray *vif_den_scale0_array,
-        DArray *vif_num_scale1_array,
-        DArray *vif_den_scale1_array,
-        DArray *vif_num_scale2_array,
-        DArray *vif_den_scale2_array,
-        DArray *vif_num_scale3_array,
-        DArray *vif_den_scale3_array,
-        DArray *vif_array,
-        DArray *psnr_array,
-        DArray *ssim_array,
-        DArray *ms_ssim_array,
+        FeatureTable *feature_table,
         char *errmsg,
         int n_thread,
         int n_subsample
@@ -571,39 +453,10 @@ int combo(int (*read_frame)(float *ref_data, float *main_data, float *temp_data,
     combo_thread_data.w = w;
     combo_thread_data.h = h;
     combo_thread_data.fmt = fmt;
-    combo_thread_data.adm_num_array = adm_num_array;
-    combo_thread_data.adm_den_array = adm_den_array;
-    combo_thread_data.adm_num_scale0_array = adm_num_scale0_array;
-    combo_thread_data.adm_den_scale0_array = adm_den_scale0_array;
-    combo_thread_data.adm_num_scale1_array = adm_num_scale1_array;
-    combo_thread_data.adm_den_scale1_array = adm_den_scale1_array;
-    combo_thread_data.adm_num_scale2_array = adm_num_scale2_array;
-    combo_thread_data.adm_den_scale2_array = adm_den_scale2_array;
-    combo_thread_data.adm_num_scale3_array = adm_num_scale3_array;
-    combo_thread_data.adm_den_scale3_array = adm_den_scale3_array;
-    combo_thread_data.motion_array = motion_array;
-    combo_thread_data.motion2_array = motion2_array;
-    combo_thread_data.vif_num_scale0_array = vif_num_scale0_array;
-    combo_thread_data.vif_den_scale0_array = vif_den_scale0_array;
-    combo_thread_data.vif_num_scale1_array = vif_num_scale1_array;
-    combo_thread_data.vif_den_scale1_array = vif_den_scale1_array;
-    combo_thread_data.vif_num_scale2_array = vif_num_scale2_array;
-    combo_thread_data.vif_den_scale2_array = vif_den_scale2_array;
-    combo_thread_data.vif_num_scale3_array = vif_num_scale3_array;
-    combo_thread_data.vif_den_scale3_array = vif_den_scale3_array;
-    combo_thread_data.vif_array = vif_array;
-    combo_thread_data.psnr_array = psnr_array;
-    combo_thread_data.ssim_array = ssim_array;
-    combo_thread_data.ms_ssim_array = ms_ssim_array;
+    combo_thread_data.feature_table = feature_table;
     combo_thread_data.errmsg = errmsg;
-    combo_thread_data.frm_idx = 0;
-    combo_thread_data.stop_threads = 0;
     combo_thread_data.n_subsample = n_subsample;
 
-    DArray	motion_score_compute_flag_array;
-    init_array(&motion_score_compute_flag_array, 1000);
-    combo_thread_data.motion_score_compute_flag_array = &motion_score_compute_flag_array;
-
     // sanity check for width/height
     if (w <= 0 || h <= 0 || (size_t)w > ALIGN_FLOOR(INT_MAX) / sizeof(float))
     {
@@ -638,18 +491,15 @@ int combo(int (*read_frame)(float *ref_data, float *main_data, float *temp_data,
 
     // for motion analysis we compare to previous buffer and next buffer
     /*
-     *	In the multi-thread mode, allocate a fixed size buffer pool for the reference, distorted and blur buffers.
-     *	At any point, the no. of required ref and dis buffers is 1 more than the total no. of allotted threads,
-        to accomodate reading the next frame index.
-     *	At any point, one thread operates on the current, previous and next blur buffers, and hence, the no. of
-        required blur buffers will be three times the total no. of allotted threads.
+     *	Frame n lives in slot n % length of a ring of ref, dis and blur buffers. Threads work on
+        frames n - 1 to n + 1 and read ahead one frame, so three slots more than threads keep
+        them from waiting on each other.
      */
-    init_blur_array(&combo_thread_data.ref_buf_array, MIN(combo_thread_data.thread_count + 1, MAX_NUM_THREADS), combo_thread_data.data_sz, MAX_ALIGN);
-    init_blur_array(&combo_thread_data.dis_buf_array, MIN(combo_thread_data.thread_count + 1, MAX_NUM_THREADS), combo_thread_data.data_sz, MAX_ALIGN);
-    init_blur_array(&combo_thread_data.blur_buf_array, MIN(3 * (combo_thread_data.thread_count), MAX_NUM_THREADS), combo_thread_data.data_sz, MAX_ALIGN);
-
-    // initialize the mutex that protects the read_frame function
-    pthread_mutex_init(&combo_thread_data.mutex_readframe, NULL);
+    if (!init_blur_ring(&combo_thread_data.blur_ring, MIN(combo_thread_data.thread_count + 3, MAX_NUM_THREADS), combo_thread_data.data_sz, MAX_ALIGN))
+    {
+        sprintf(errmsg, "init_blur_ring failed.\n");
+        return -1;
+    }
 
     // create a joinable thread
     pthread_attr_t attr;
@@ -669,7 +519,8 @@ int combo(int (*read_frame)(float *ref_data, float *main_data, float *temp_data,
 
     pthread_attr_destroy(&attr);
 
-    // wait for all threads to finish
+    // wait for all threads to finish, the one which failed set errmsg
+    int ret = 0;
     for (t=0; t < combo_thread_data.thread_count; t++)
     {
         void* thread_ret;
@@ -677,18 +528,16 @@ int combo(int (*read_frame)(float *ref_data, float *main_data, float *temp_data,
 
         if (rc)
         {
-            printf("ERROR; return code from pthread_join() for thread[%d] is %d\n", t, (long)thread_ret);
+            printf("ERROR; return code from pthread_join() for thread[%d] is %d\n", t, rc);
             return -1;
         }
+        if ((intptr_t)thread_ret)
+            ret = -1;
     }
 
-    free_blur_buf(&combo_thread_data.ref_buf_array);
-    free_blur_buf(&combo_thread_data.dis_buf_array);
-    free_blur_buf(&combo_thread_data.blur_buf_array);
-
-    free_array(&motion_score_compute_flag_array);
+    free_blur_ring(combo_thread_data.blur_ring);
 
     free(thread);
 
-    return 0;
+    return ret;
 }
@@ -0,0 +1,129 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "crop.h"
+#include "libvmaf/libvmaf.rc.h"
+#include "libvmaf/picture.h"
+#include "picture.h"
+
+#define CROP_BLACK 32 ///< Brightest black, 8-bit, limited range black is 16.
+#define CROP_STEP 8 ///< Sparse grid of `vmaf_crop_exposed()`.
+
+static unsigned luma(VmafPicture *pic, unsigned x, unsigned y)
+{
+    const uint8_t *row = (uint8_t *) pic->data[0] + y * pic->stride[0];
+    return pic->bpc > 8 ? ((const uint16_t *) row)[x] : row[x];
+}
+
+static bool row_black(VmafPicture *pic, unsigned y, unsigned black)
+{
+    for (unsigned x = 0; x < pic->w[0]; x++) {
+        if (luma(pic, x, y) > black)
+            return false;
+    }
+    return true;
+}
+
+static bool col_black(VmafPicture *pic, unsigned x, unsigned y0,
+                      unsigned y1, unsigned black)
+{
+    for (unsigned y = y0; y < y1; y++) {
+        if (luma(pic, x, y) > black)
+            return false;
+    }
+    return true;
+}
+
+int vmaf_detect_active_area(VmafPicture *pic, VmafActiveArea *area)
+{
+    if (!pic) return -EINVAL;
+    if (!area) return -EINVAL;
+
+    const unsigned black = CROP_BLACK << (pic->bpc - 8 + vmaf_picture_shift(pic));
+    const unsigned w = pic->w[0], h = pic->h[0];
+
+    unsigned top = 0, bottom = h;
+    while (top < h && row_black(pic, top, black))
+        top++;
+    // black picture, e.g. a fade, leaves the area as it is
+    if (top == h)
+        return 0;
+    while (row_black(pic, bottom - 1, black))
+        bottom--;
+
+    unsigned left = 0, right = w;
+    while (col_black(pic, left, top, bottom, black))
+        left++;
+    while (col_black(pic, right - 1, top, bottom, black))
+        right--;
+
+    // even offsets and dimensions suit every chroma subsampling, rounded
+    // outwards to keep every active pixel
+    left &= ~1u;
+    top &= ~1u;
+    right = (right + 1) & ~1u;
+    bottom = (bottom + 1) & ~1u;
+    if (right > w) right = w & ~1u;
+    if (bottom > h) bottom = h & ~1u;
+    if (left >= right || top >= bottom)
+        return 0;
+
+    if (area->w && area->h) {
+        if (area->x < left) left = area->x;
+        if (area->y < top) top = area->y;
+        if (area->x + area->w > right) right = area->x + area->w;
+        if (area->y + area->h > bottom) bottom = area->y + area->h;
+    }
+    area->x = left;
+    area->y = top;
+    area->w = right - left;
+    area->h = bottom - top;
+    return 0;
+}
+
+static bool span_exposed(VmafPicture *pic, unsigned y, unsigned x0,
+                         unsigned x1, unsigned black)
+{
+    for (unsigned x = x0; x < x1; x += CROP_STEP) {
+        if (luma(pic, x, y) > black)
+            return true;
+    }
+    return false;
+}
+
+bool vmaf_crop_exposed(VmafPicture *pic, const VmafActiveArea *area)
+{
+    const unsigned black = CROP_BLACK << (pic->bpc - 8 + vmaf_picture_shift(pic));
+    const unsigned x1 = area->x + area->w, y1 = area->y + area->h;
+
+    for (unsigned y = 0; y < pic->h[0]; y += CROP_STEP) {
+        if (y < area->y || y >= y1) {
+            if (span_exposed(pic, y, 0, pic->w[0], black))
+                return true;
+        } else if (span_exposed(pic, y, 0, area->x, black) ||
+                   span_exposed(pic, y, x1, pic->w[0], black))
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -16,33 +16,18 @@
  *
  */
 
-#pragma once
+#ifndef __VMAF_CROP_H__
+#define __VMAF_CROP_H__
 
-#ifndef DARRAY_H_
-#define DARRAY_H_
+#include <stdbool.h>
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+#include "libvmaf/libvmaf.rc.h"
+#include "libvmaf/picture.h"
 
-#include <pthread.h>
-
-typedef struct
-{
-    double *array;
-    size_t used;
-    size_t size;
-    pthread_mutex_t mutex;
-} DArray;
-
-void init_array(DArray *a, size_t init_size);
-void insert_array(DArray *a, double e);
-void insert_array_at(DArray *a, double e, int pos);
-void free_array(DArray *a);
-double get_at(DArray *a, int pos);
-
-#ifdef __cplusplus
-}
-#endif
+/**
+ * Whether the luma of `pic` outside of `area` has content, sampled on a
+ * sparse grid. Used to tell when a fixed crop cuts into a later scene.
+ */
+bool vmaf_crop_exposed(VmafPicture *pic, const VmafActiveArea *area);
 
-#endif /* DARRAY_H_ */
+#endif /* __VMAF_CROP_H__ */
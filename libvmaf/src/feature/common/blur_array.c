@@ -5,238 +5,229 @@
  *      Author: thomas
  */
 
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <string.h>
 #include "blur_array.h"
 
+typedef struct
+{
+    float *ref_buf;
+    float *dis_buf;
+    float *blur_buf;
+    atomic_int frame_idx;       // frame held by this slot
+    atomic_int ready_idx;       // frame_idx once it is published
+    atomic_int reference_count;
+} BLUR_BUF_SLOT;
+
+struct BLUR_BUF_RING
+{
+    BLUR_BUF_SLOT slot[MAX_NUM_THREADS];
+    int length;
+    atomic_int next_frame;      // next frame index to hand out
+    atomic_int read_idx;        // next frame index to be read
+    atomic_int frame_cnt;       // INT_MAX until the end of input is read
+    atomic_int stop;
+    atomic_int waiters;
+    pthread_mutex_t lock;       // only for sleeping and waking up
+    pthread_cond_t cond;
+};
+
 /*
- * initializes an array of blurred buffers
+ * initializes the ring, slot i starts out as released frame i - length
  */
-int init_blur_array(BLUR_BUF_ARRAY* arr, int array_length, size_t size, size_t alignement)
+int init_blur_ring(BLUR_BUF_RING** ring, int length, size_t size, size_t alignement)
 {
     // we can't go beyond the max number of threads
-    if (array_length > MAX_NUM_THREADS)
+    if (length < 3 || length > MAX_NUM_THREADS)
+        return 0;
+
+    BLUR_BUF_RING* r = calloc(1, sizeof(*r));
+    if (!r)
         return 0;
 
-    for (int i = 0; i < array_length; i++)
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+
+    for (int i = 0; i < length; i++)
     {
-        arr->blur_buf_array[i].frame_idx = -1;
-        arr->blur_buf_array[i].blur_buf = aligned_malloc(size, alignement);
-		arr->blur_buf_array[i].reference_count	= 0;
-        if (arr->blur_buf_array[i].blur_buf == 0)
+        BLUR_BUF_SLOT* s = &r->slot[i];
+        s->ref_buf = aligned_malloc(size, alignement);
+        s->dis_buf = aligned_malloc(size, alignement);
+        s->blur_buf = aligned_malloc(size, alignement);
+        atomic_init(&s->frame_idx, i - length);
+        atomic_init(&s->ready_idx, i - length);
+        atomic_init(&s->reference_count, 0);
+        r->length = i + 1;
+        if (!s->ref_buf || !s->dis_buf || !s->blur_buf)
+        {
+            free_blur_ring(r);
             return 0;
-
-        arr->buffer_size = size;
-        arr->actual_length = i + 1;
+        }
     }
 
-    pthread_mutex_init(&arr->block, NULL);
+    atomic_init(&r->next_frame, 0);
+    atomic_init(&r->read_idx, 0);
+    atomic_init(&r->frame_cnt, INT_MAX);
+    atomic_init(&r->stop, 0);
+    atomic_init(&r->waiters, 0);
 
+    *ring = r;
     return 1;
 }
 
-/*
- * returns the blurred buffer for the frame index or 0 if the frame index was not found
- */
-float* get_blur_buf(BLUR_BUF_ARRAY* arr, int search_frame_idx)
+static BLUR_BUF_SLOT* get_slot(BLUR_BUF_RING* ring, int frame_idx)
 {
-    int array_length = arr->actual_length;
-    BLUR_BUF_STRUCT* s = arr->blur_buf_array;
-	float *ret = NULL;
-
-    pthread_mutex_lock(&arr->block);
-
-    for (int i = 0; i < array_length; i++)
-    {
-		if (s->frame_idx == search_frame_idx)
-		{
-			/* Increment reference counter */
-			s->reference_count++;
-			
-			ret = s->blur_buf;
-			break;
-		}
-
-		// next array item
-		s++;
-     }  
-
-    pthread_mutex_unlock(&arr->block);
-
-    return ret;
+    return &ring->slot[frame_idx % ring->length];
 }
 
 /*
- * finds a free slot in the array, assigns the new frame index and copies the buffer
+ * wakes up all waiters, the mutex is only taken if somebody sleeps
  */
-int put_blur_buf(BLUR_BUF_ARRAY* arr, int frame_idx, float* blur_buf)
+static void signal_ring(BLUR_BUF_RING* ring)
 {
-    int ret = 0;
-    int array_length = arr->actual_length;
-    size_t buf_size = arr->buffer_size;
-    BLUR_BUF_STRUCT* s = arr->blur_buf_array;
-
-    pthread_mutex_lock(&arr->block);
+    if (!atomic_load(&ring->waiters))
+        return;
 
-    for (int i = 0; i < array_length; i++)
-    {
-        if (s->frame_idx == -1)
-        {
-            memcpy(s->blur_buf, blur_buf, buf_size);
-            s->frame_idx = frame_idx;
-            ret = 1;
-            break;
-        }
-
-        // next array item
-        s++;
-    }
-
-    pthread_mutex_unlock(&arr->block);
-
-    return ret;
+    pthread_mutex_lock(&ring->lock);
+    pthread_cond_broadcast(&ring->cond);
+    pthread_mutex_unlock(&ring->lock);
 }
 
 /*
- * resets the slot in the array to -1 to indicate that the buffer can be used again
+ * waits until ready() returns 1, returns -1 if the ring was stopped or the
+ * frame is past the end of input
  */
-int release_blur_buf_slot(BLUR_BUF_ARRAY* arr, int search_frame_idx)
+static int wait_ring(BLUR_BUF_RING* ring, int frame_idx,
+                     int (*ready)(BLUR_BUF_RING* ring, int frame_idx))
 {
-    int ret = 0;
-    int array_length = arr->actual_length;
-    BLUR_BUF_STRUCT* s = arr->blur_buf_array;
-
-    pthread_mutex_lock(&arr->block);
-
-    for (int i = 0; i < array_length; i++)
-    {
-        if (s->frame_idx == search_frame_idx)
-        {
-			if(s->reference_count <= 0)
-			{
-				s->frame_idx = -1;
-				ret = 1;
-			}
-			else
-			{
-				ret = -1;
-			}
-            break;
-        }
-
-        // next struct
-        s++;
-    }
-
-    pthread_mutex_unlock(&arr->block);
-
-    return ret;
+    if (ready(ring, frame_idx))
+        goto done;
+
+    atomic_fetch_add(&ring->waiters, 1);
+    pthread_mutex_lock(&ring->lock);
+    while (!ready(ring, frame_idx))
+        pthread_cond_wait(&ring->cond, &ring->lock);
+    pthread_mutex_unlock(&ring->lock);
+    atomic_fetch_sub(&ring->waiters, 1);
+
+done:
+    if (atomic_load(&ring->stop) || frame_idx >= atomic_load(&ring->frame_cnt))
+        return -1;
+    return 0;
 }
 
-/*
- * gives the memory buffers of the complete array free again
- */
-void free_blur_buf(BLUR_BUF_ARRAY* arr)
+static int is_done(BLUR_BUF_RING* ring, int frame_idx)
 {
-    int array_length = arr->actual_length;
-    size_t buf_size = arr->buffer_size;
-    BLUR_BUF_STRUCT* s = arr->blur_buf_array;
-
-    for (int i = 0; i < array_length; i++)
-    {
-        aligned_free(s->blur_buf);
+    return atomic_load(&ring->stop) || frame_idx >= atomic_load(&ring->frame_cnt);
+}
 
-        // next struct
-        s++;
-    }
+static int is_slot_free(BLUR_BUF_RING* ring, int frame_idx)
+{
+    BLUR_BUF_SLOT* s = get_slot(ring, frame_idx);
+    return is_done(ring, frame_idx) ||
+           (atomic_load(&s->frame_idx) == frame_idx - ring->length &&
+            atomic_load(&s->reference_count) == 0);
+}
 
-    pthread_mutex_destroy(&arr->block);
+static int is_read_turn(BLUR_BUF_RING* ring, int frame_idx)
+{
+    return is_done(ring, frame_idx) || atomic_load(&ring->read_idx) == frame_idx;
 }
 
-/*
- * finds a free slot in the array, assigns the new frame index and returns the free buffer pointer
- * This increases the reference count for this slot
- */
-float* get_free_blur_buf_slot(BLUR_BUF_ARRAY* arr, int frame_idx)
-{
-    int array_length = arr->actual_length;
-    BLUR_BUF_STRUCT* s = arr->blur_buf_array;
-	float *ret = NULL;
-    pthread_mutex_lock(&arr->block);
-	
-    for (int i = 0; i < array_length; i++)
-    {
-        if (s->frame_idx == -1)
-        {			
-            s->frame_idx = frame_idx;
-			
-			/* Increment reference counter */
-			s->reference_count++;
-			
-			ret = s->blur_buf;
-			break;
-        }
+static int is_published(BLUR_BUF_RING* ring, int frame_idx)
+{
+    return is_done(ring, frame_idx) ||
+           atomic_load(&get_slot(ring, frame_idx)->ready_idx) == frame_idx;
+}
 
-        // next array item
-        s++;
-    }
-    pthread_mutex_unlock(&arr->block);
+int blur_ring_next_frame(BLUR_BUF_RING* ring)
+{
+    return atomic_fetch_add(&ring->next_frame, 1);
+}
 
-    return ret;
+int blur_ring_claim(BLUR_BUF_RING* ring, int frame_idx, float** ref_buf, float** dis_buf, float** blur_buf)
+{
+    if (wait_ring(ring, frame_idx, is_slot_free))
+        return -1;
+
+    // frame 0 has no predecessor referencing it
+    BLUR_BUF_SLOT* s = get_slot(ring, frame_idx);
+    atomic_store(&s->reference_count, frame_idx ? 3 : 2);
+    atomic_store(&s->frame_idx, frame_idx);
+
+    *ref_buf = s->ref_buf;
+    *dis_buf = s->dis_buf;
+    *blur_buf = s->blur_buf;
+    return 0;
 }
 
-/*
- * Returns the reference counter for the frame index if found, -1 otherwise
-*/
-int get_blur_buf_reference_count(BLUR_BUF_ARRAY* arr, int frame_idx)
+int blur_ring_begin_read(BLUR_BUF_RING* ring, int frame_idx)
 {
-    int array_length = arr->actual_length;
-    BLUR_BUF_STRUCT* s = arr->blur_buf_array;
-	int ret = -1;
+    return wait_ring(ring, frame_idx, is_read_turn);
+}
 
-    pthread_mutex_lock(&arr->block);
+void blur_ring_end_read(BLUR_BUF_RING* ring, int frame_idx, int read_ret)
+{
+    if (read_ret == 1)
+        atomic_store(&ring->stop, 1);
+    else if (read_ret)
+        atomic_store(&ring->frame_cnt, frame_idx);
+    else
+        atomic_store(&ring->read_idx, frame_idx + 1);
+    signal_ring(ring);
+}
 
-    for (int i = 0; i < array_length; i++)
-    {
-        if (s->frame_idx == frame_idx)
-        {
-			ret = s->reference_count;
-			break;
-        }
+void blur_ring_publish(BLUR_BUF_RING* ring, int frame_idx)
+{
+    atomic_store(&get_slot(ring, frame_idx)->ready_idx, frame_idx);
+    signal_ring(ring);
+}
 
-        // next array item
-        s++;
-    }
+int blur_ring_get(BLUR_BUF_RING* ring, int frame_idx, float** ref_buf, float** dis_buf, float** blur_buf)
+{
+    if (wait_ring(ring, frame_idx, is_published))
+        return -1;
+
+    BLUR_BUF_SLOT* s = get_slot(ring, frame_idx);
+    if (ref_buf)
+        *ref_buf = s->ref_buf;
+    if (dis_buf)
+        *dis_buf = s->dis_buf;
+    if (blur_buf)
+        *blur_buf = s->blur_buf;
+    return 0;
+}
 
-    pthread_mutex_unlock(&arr->block);
+void blur_ring_release(BLUR_BUF_RING* ring, int frame_idx)
+{
+    if (atomic_fetch_sub(&get_slot(ring, frame_idx)->reference_count, 1) == 1)
+        signal_ring(ring);
+}
 
-    return ret;
+void blur_ring_stop(BLUR_BUF_RING* ring)
+{
+    atomic_store(&ring->stop, 1);
+    signal_ring(ring);
 }
 
 /*
- * releases the reference for the slot in the array which matches the search frame index
+ * gives the memory buffers of the complete ring free again
  */
-int release_blur_buf_reference(BLUR_BUF_ARRAY* arr, int search_frame_idx)
+void free_blur_ring(BLUR_BUF_RING* ring)
 {
-    int ret = -1;
-    int array_length = arr->actual_length;
-    BLUR_BUF_STRUCT* s = arr->blur_buf_array;
+    if (!ring)
+        return;
 
-    pthread_mutex_lock(&arr->block);
-	
-    for (int i = 0; i < array_length; i++)
+    for (int i = 0; i < ring->length; i++)
     {
-        if (s->frame_idx == search_frame_idx)
-        {
-			s->reference_count--;
-			ret = 0;
-			break;
-		}
-
-        // next struct
-        s++;
+        aligned_free(ring->slot[i].ref_buf);
+        aligned_free(ring->slot[i].dis_buf);
+        aligned_free(ring->slot[i].blur_buf);
     }
 
-    pthread_mutex_unlock(&arr->block);
-
-    return ret;
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->cond);
+    free(ring);
 }
@@ -9,42 +9,50 @@
 #define VMAF_FEATURE_SRC_BLUR_ARRAY_H_
 
 #include <stdlib.h>
-#include <pthread.h>
 #include "mem.h"
 
 #define MAX_NUM_THREADS 128
-typedef struct
-{
-    int frame_idx;
-    float *blur_buf;
-    int reference_count;
 
+/*
+ * Frame indexed ring of ref, dis and blur buffers for the multithreaded
+ * combo() pipeline. Frame n lives in slot n % length, so slots are found
+ * without searching, and all bookkeeping uses atomics. Threads only sleep
+ * when the data they need is not there yet, reading frames is ordered by a
+ * ticket instead of a lock.
+ *
+ * Each frame is referenced by the threads processing frames n - 1 (which
+ * reads it and uses its blur for motion2), n and n + 1 (motion), a slot is
+ * reused once all of them released it.
+ */
+typedef struct BLUR_BUF_RING BLUR_BUF_RING;
 
-} BLUR_BUF_STRUCT;
-
-typedef struct
-{
-    BLUR_BUF_STRUCT blur_buf_array[MAX_NUM_THREADS];
-    int actual_length;
-    size_t buffer_size;
-    pthread_mutex_t block;
-
-} BLUR_BUF_ARRAY;
-
-int init_blur_array(BLUR_BUF_ARRAY* arr, int array_length, size_t size, size_t alignement);
-
-float* get_free_blur_buf_slot(BLUR_BUF_ARRAY* arr, int frame_idx);
-
-int get_blur_buf_reference_count(BLUR_BUF_ARRAY* arr, int frame_idx);
+/* returns 1 on success, 0 otherwise; length must be at least 3 */
+int init_blur_ring(BLUR_BUF_RING** ring, int length, size_t size, size_t alignement);
 
-int release_blur_buf_slot(BLUR_BUF_ARRAY* arr, int search_frame_idx);
+/* hands out frame indices in order */
+int blur_ring_next_frame(BLUR_BUF_RING* ring);
 
-int release_blur_buf_reference(BLUR_BUF_ARRAY* arr, int search_frame_idx);
+/*
+ * producer side: claim the slot of a frame, wait for the turn to read it,
+ * then publish it once ref, dis and blur are written. All return 0 on
+ * success, -1 if the ring was stopped or the frame is past the end.
+ */
+int blur_ring_claim(BLUR_BUF_RING* ring, int frame_idx, float** ref_buf, float** dis_buf, float** blur_buf);
+int blur_ring_begin_read(BLUR_BUF_RING* ring, int frame_idx);
+/* read_ret as returned by read_frame(): 0 read, 1 error, 2 end of input */
+void blur_ring_end_read(BLUR_BUF_RING* ring, int frame_idx, int read_ret);
+void blur_ring_publish(BLUR_BUF_RING* ring, int frame_idx);
 
-float* get_blur_buf(BLUR_BUF_ARRAY* arr, int search_frame_idx);
+/*
+ * consumer side: wait until a frame is published. Returns 0 on success,
+ * -1 if the ring was stopped or the frame is past the end.
+ */
+int blur_ring_get(BLUR_BUF_RING* ring, int frame_idx, float** ref_buf, float** dis_buf, float** blur_buf);
+void blur_ring_release(BLUR_BUF_RING* ring, int frame_idx);
 
-int put_blur_buf(BLUR_BUF_ARRAY* arr, int frame_idx, float* blur_buf);
+/* wakes up and fails all waiting and future calls, e.g. after an error */
+void blur_ring_stop(BLUR_BUF_RING* ring);
 
-void free_blur_buf(BLUR_BUF_ARRAY* arr);
+void free_blur_ring(BLUR_BUF_RING* ring);
 
 #endif /* VMAF_FEATURE_SRC_BLUR_ARRAY_H_ */
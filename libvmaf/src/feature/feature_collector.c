@@ -126,11 +126,16 @@ int vmaf_feature_collector_append(VmafFeatureCollector *feature_collector,
     if (!feature_collector) return -EINVAL;
     if (!feature_name) return -EINVAL;
 
-    pthread_mutex_lock(&(feature_collector->lock));
+    if (pthread_mutex_trylock(&(feature_collector->lock))) {
+        const uint64_t wait = vmaf_profile_wall();
+        pthread_mutex_lock(&(feature_collector->lock));
+        feature_collector->lock_wait.wall += vmaf_profile_wall() - wait;
+        feature_collector->lock_wait.cnt++;
+    }
     int err = 0;
 
     if (!feature_collector->timer.begin)
-        feature_collector->timer.begin = clock();
+        feature_collector->timer.begin = vmaf_profile_wall();
 
     FeatureVector *feature_vector =
         find_feature_vector(feature_collector, feature_name);
@@ -160,7 +165,7 @@ int vmaf_feature_collector_append(VmafFeatureCollector *feature_collector,
     err = feature_vector_append(feature_vector, picture_index, score);
 
 unlock:
-    feature_collector->timer.end = clock();
+    feature_collector->timer.end = vmaf_profile_wall();
     pthread_mutex_unlock(&(feature_collector->lock));
     return err;
 }
@@ -196,6 +201,45 @@ unlock:
     return err;
 }
 
+int vmaf_feature_collector_merge(VmafFeatureCollector *dst,
+                                 VmafFeatureCollector *src,
+                                 unsigned index_low, unsigned index_high)
+{
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+    if (dst == src) return -EINVAL;
+
+    pthread_mutex_lock(&(src->lock));
+    int err = 0;
+
+    for (unsigned i = 0; i < src->cnt; i++) {
+        FeatureVector *fv = src->feature_vector[i];
+        const unsigned high =
+            index_high < fv->capacity ? index_high : fv->capacity;
+        for (unsigned j = index_low; j < high; j++) {
+            if (!fv->score[j].written) continue;
+            err = vmaf_feature_collector_append(dst, fv->name,
+                                                fv->score[j].value, j);
+            if (err) goto unlock;
+        }
+    }
+
+    pthread_mutex_lock(&(dst->lock));
+    if (src->timer.begin &&
+        (!dst->timer.begin || src->timer.begin < dst->timer.begin))
+    {
+        dst->timer.begin = src->timer.begin;
+    }
+    if (src->timer.end > dst->timer.end)
+        dst->timer.end = src->timer.end;
+    vmaf_profile_counter_add(&dst->lock_wait, &src->lock_wait);
+    pthread_mutex_unlock(&(dst->lock));
+
+unlock:
+    pthread_mutex_unlock(&(src->lock));
+    return err;
+}
+
 void vmaf_feature_collector_destroy(VmafFeatureCollector *feature_collector)
 {
     if (!feature_collector) return;
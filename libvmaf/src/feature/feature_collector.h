@@ -21,7 +21,9 @@
 
 #include <pthread.h>
 #include <stdbool.h>
-#include <time.h>
+#include <stdint.h>
+
+#include "profile.h"
 
 typedef struct {
     char *name;
@@ -35,7 +37,8 @@ typedef struct {
 typedef struct VmafFeatureCollector {
     FeatureVector **feature_vector;
     unsigned cnt, capacity;
-    struct { clock_t begin, end; } timer;
+    struct { uint64_t begin, end; } timer; ///< Monotonic ns, first and last append.
+    VmafProfileCounter lock_wait; ///< Only contended locks are timed.
     pthread_mutex_t lock;
 } VmafFeatureCollector;
 
@@ -49,6 +52,10 @@ int vmaf_feature_collector_get_score(VmafFeatureCollector *feature_collector,
                                      char *feature_name, double *score,
                                      unsigned index);
 
+int vmaf_feature_collector_merge(VmafFeatureCollector *dst,
+                                 VmafFeatureCollector *src,
+                                 unsigned index_low, unsigned index_high);
+
 void vmaf_feature_collector_destroy(VmafFeatureCollector *feature_collector);
 
 #endif /* __VMAF_FEATURE_COLLECTOR_H__ */
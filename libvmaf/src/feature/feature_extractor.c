@@ -22,6 +22,7 @@
 #include <stdlib.h>
 
 #include "feature_extractor.h"
+#include "trace.h"
 
 extern VmafFeatureExtractor vmaf_fex_ssim;
 extern VmafFeatureExtractor vmaf_fex_float_ssim;
@@ -137,7 +138,36 @@ int vmaf_feature_extractor_context_extract(VmafFeatureExtractorContext *fex_ctx,
         if (err) return err;
     }
 
-    return fex_ctx->fex->extract(fex_ctx->fex, ref, dist, pic_index, vfc);
+    VmafTraceSpan span;
+    vmaf_trace_begin(&span, "extract", fex_ctx->fex->name, pic_index);
+    const uint64_t wall = vmaf_profile_wall();
+    const uint64_t cpu = vmaf_profile_cpu();
+    int err = fex_ctx->fex->extract(fex_ctx->fex, ref, dist, pic_index, vfc);
+    fex_ctx->profile.wall += vmaf_profile_wall() - wall;
+    fex_ctx->profile.cpu += vmaf_profile_cpu() - cpu;
+    fex_ctx->profile.cnt++;
+    vmaf_trace_end(&span);
+    return err;
+}
+
+int vmaf_feature_extractor_context_extract_identical(
+                                           VmafFeatureExtractorContext *fex_ctx,
+                                           VmafPicture *pic, unsigned pic_index,
+                                           VmafFeatureCollector *vfc)
+{
+    if (!fex_ctx) return -EINVAL;
+    if (!pic) return -EINVAL;
+    if (!vfc) return -EINVAL;
+    if (!fex_ctx->fex->extract_identical) return -EINVAL;
+
+    if (fex_ctx->fex->init && !fex_ctx->is_initialized) {
+        int err =
+            vmaf_feature_extractor_context_init(fex_ctx, pic->pix_fmt, pic->bpc,
+                                                pic->w[0], pic->h[0]);
+        if (err) return err;
+    }
+
+    return fex_ctx->fex->extract_identical(fex_ctx->fex, pic, pic_index, vfc);
 }
 
 int vmaf_feature_extractor_context_flush(VmafFeatureExtractorContext *fex_ctx,
@@ -327,6 +357,30 @@ int vmaf_fex_ctx_pool_flush(VmafFeatureExtractorContextPool *pool,
     return 0;
 }
 
+int vmaf_fex_ctx_pool_profile(VmafFeatureExtractorContextPool *pool,
+                              VmafFeatureExtractor *fex,
+                              VmafProfileCounter *profile)
+{
+    if (!pool) return -EINVAL;
+    if (!fex) return -EINVAL;
+    if (!profile) return -EINVAL;
+    pthread_mutex_lock(&(pool->lock));
+
+    for (unsigned i = 0; i < pool->length; i++) {
+        if (strcmp(fex->name, pool->fex_list[i].fex->name))
+            continue;
+        for (unsigned j = 0; j < atomic_load(&pool->fex_list[i].capacity); j++) {
+            VmafFeatureExtractorContext *fex_ctx =
+                pool->fex_list[i].ctx_list[j].fex_ctx;
+            if (!fex_ctx) continue;
+            vmaf_profile_counter_add(profile, &fex_ctx->profile);
+        }
+    }
+
+    pthread_mutex_unlock(&(pool->lock));
+    return 0;
+}
+
 int vmaf_fex_ctx_pool_destroy(VmafFeatureExtractorContextPool *pool)
 {
     if (!pool) return -EINVAL;
@@ -23,11 +23,24 @@
 #include <stdlib.h>
 
 #include "feature_collector.h"
+#include "picture.h"
+#include "profile.h"
 
 #include "libvmaf/picture.h"
 
 enum VmafFeatureExtractorFlags {
     VMAF_FEATURE_EXTRACTOR_TEMPORAL = 1 << 0,
+    /**
+     * Scores depend only on the reference luma of the current and up to two
+     * previous pictures, and are written to those pictures only. Such
+     * extractors are eligible for the reference cache, see ref_cache.h.
+     */
+    VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY = 1 << 1,
+    /**
+     * Reads the chroma planes. Without this flag only luma is read, and
+     * pictures may be allocated without chroma, see vmaf_get_planes().
+     */
+    VMAF_FEATURE_EXTRACTOR_CHROMA = 1 << 2,
 };
 
 typedef struct VmafFeatureExtractor {
@@ -58,6 +71,20 @@ typedef struct VmafFeatureExtractor {
     int (*extract)(struct VmafFeatureExtractor *fex,
                    VmafPicture *ref_pic, VmafPicture *dist_pic,
                    unsigned index, VmafFeatureCollector *feature_collector);
+    /**
+     * Identical pictures callback. Optional, called instead of `extract`
+     * when the reference and distorted pictures are identical, to write the
+     * closed-form scores. Not called when the VMAF_FEATURE_EXTRACTOR_TEMPORAL
+     * flag is set.
+     *
+     * @param               fex self.
+     * @param               pic Reference VmafPicture, same as distorted.
+     * @param             index Picture index.
+     * @param feature_collector VmafFeatureCollector used to write out scores.
+     */
+    int (*extract_identical)(struct VmafFeatureExtractor *fex,
+                             VmafPicture *pic, unsigned index,
+                             VmafFeatureCollector *feature_collector);
     /**
      * Buffer flush callback. Optional.
      * Called only when the VMAF_FEATURE_EXTRACTOR_TEMPORAL flag is set.
@@ -77,6 +104,23 @@ typedef struct VmafFeatureExtractor {
     size_t priv_size; ///< sizeof private data.
     uint64_t flags; ///< Feauture extraction flags, binary or'd.
     const char **provided_features; ///< Provided feature list, NULL terminated.
+    /**
+     * Picture intermediates used by `extract`, NULL terminated. Optional,
+     * intermediates are shared with every other feature extractor which
+     * uses them on the same picture.
+     */
+    const VmafPictureIntermediate **intermediates;
+    unsigned version; ///< Bump when scores change, keys the reference cache.
+    /**
+     * Temporal support, optional. The pictures before and after a picture
+     * which a VMAF_FEATURE_EXTRACTOR_TEMPORAL extractor needs to score it,
+     * e.g. one on either side for motion2. When declared, the extractor is
+     * only fed the windows around subsampled pictures, and must restart its
+     * temporal state when the picture index skips ahead.
+     */
+    struct {
+        unsigned past, future;
+    } window;
 } VmafFeatureExtractor;
 
 VmafFeatureExtractor *vmaf_get_feature_extractor_by_name(char *name);
@@ -85,6 +129,7 @@ VmafFeatureExtractor *vmaf_get_feature_extractor_by_feature_name(char *name);
 typedef struct VmafFeatureExtractorContext {
     bool is_initialized, is_closed;
     VmafFeatureExtractor *fex;
+    VmafProfileCounter profile; ///< Timing of the `extract` callback.
 } VmafFeatureExtractorContext;
 
 int vmaf_feature_extractor_context_create(VmafFeatureExtractorContext **fex_ctx,
@@ -99,12 +144,17 @@ int vmaf_feature_extractor_context_extract(VmafFeatureExtractorContext *fex_ctx,
                                            unsigned pic_index,
                                            VmafFeatureCollector *vfc);
 
+int vmaf_feature_extractor_context_extract_identical(
+                                           VmafFeatureExtractorContext *fex_ctx,
+                                           VmafPicture *pic, unsigned pic_index,
+                                           VmafFeatureCollector *vfc);
+
 int vmaf_feature_extractor_context_flush(VmafFeatureExtractorContext *fex_ctx,
                                          VmafFeatureCollector *vfc);
 
 int vmaf_feature_extractor_context_close(VmafFeatureExtractorContext *fex_ctx);
 
-int vmaf_feature_extractor_context_delete(VmafFeatureExtractorContext *fex_ctx);
+int vmaf_feature_extractor_context_destroy(VmafFeatureExtractorContext *fex_ctx);
 
 typedef struct VmafFeatureExtractorContextPool {
     struct fex_list_entry {
@@ -133,6 +183,10 @@ int vmaf_fex_ctx_pool_release(VmafFeatureExtractorContextPool *pool,
 int vmaf_fex_ctx_pool_flush(VmafFeatureExtractorContextPool *pool,
                             VmafFeatureCollector *feature_collector);
 
+int vmaf_fex_ctx_pool_profile(VmafFeatureExtractorContextPool *pool,
+                              VmafFeatureExtractor *fex,
+                              VmafProfileCounter *profile);
+
 int vmaf_fex_ctx_pool_destroy(VmafFeatureExtractorContextPool *pool);
 
 #endif /* __VMAF_FEATURE_EXTRACTOR_H__ */
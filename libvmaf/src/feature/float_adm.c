@@ -30,26 +30,19 @@
 
 typedef struct AdmState {
     size_t float_stride;
-    float *ref;
-    float *dist;
 } AdmState;
 
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
+    (void) pix_fmt;
+    (void) bpc;
+    (void) h;
+
     AdmState *s = fex->priv;
     s->float_stride = sizeof(float) * w;
-    s->ref = aligned_malloc(s->float_stride * h, 32);
-    if (!s->ref) goto fail;
-    s->dist = aligned_malloc(s->float_stride * h, 32);
-    if (!s->dist) goto free_ref;
 
     return 0;
-
-free_ref:
-    free(s->ref);
-fail:
-    return -ENOMEM;
 }
 
 static int extract(VmafFeatureExtractor *fex,
@@ -59,12 +52,15 @@ static int extract(VmafFeatureExtractor *fex,
     AdmState *s = fex->priv;
     int err = 0;
 
-    picture_copy(s->ref, ref_pic, -128, ref_pic->bpc);
-    picture_copy(s->dist, dist_pic, -128, dist_pic->bpc);
+    const float *ref, *dist;
+    err = picture_copy_shared(&ref, ref_pic, -128);
+    if (err) return err;
+    err = picture_copy_shared(&dist, dist_pic, -128);
+    if (err) return err;
 
     double score, score_num, score_den;
     double scores[8];
-    err = compute_adm(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+    err = compute_adm(ref, dist, ref_pic->w[0], ref_pic->h[0],
                       s->float_stride, s->float_stride, &score, &score_num,
                       &score_den, scores, ADM_BORDER_FACTOR);
     if (err) return err;
@@ -94,13 +90,10 @@ static int extract(VmafFeatureExtractor *fex,
     return 0;
 }
 
-static int close(VmafFeatureExtractor *fex)
-{
-    AdmState *s = fex->priv;
-    if (s->ref) aligned_free(s->ref);
-    if (s->dist) aligned_free(s->dist);
-    return 0;
-}
+static const VmafPictureIntermediate *intermediates[] = {
+    &vmaf_intermediate_float_luma_centered,
+    NULL
+};
 
 static const char *provided_features[] = {
     "'VMAF_feature_adm2_score'",
@@ -109,11 +102,29 @@ static const char *provided_features[] = {
     NULL
 };
 
+static int extract_identical(VmafFeatureExtractor *fex, VmafPicture *pic,
+                             unsigned index,
+                             VmafFeatureCollector *feature_collector)
+{
+    (void) fex;
+    (void) pic;
+
+    // every ADM ratio is 1 for identical pictures
+    for (unsigned i = 0; provided_features[i]; i++) {
+        int err = vmaf_feature_collector_append(feature_collector,
+                                                (char *) provided_features[i],
+                                                1., index);
+        if (err) return err;
+    }
+    return 0;
+}
+
 VmafFeatureExtractor vmaf_fex_float_adm = {
     .name = "float_adm",
     .init = init,
     .extract = extract,
-    .close = close,
+    .extract_identical = extract_identical,
     .priv_size = sizeof(AdmState),
     .provided_features = provided_features,
+    .intermediates = intermediates,
 };
@@ -31,10 +31,10 @@
 
 typedef struct MotionState {
     size_t float_stride;
-    float *ref;
     float *tmp;
     float *blur[3];
     unsigned index;
+    unsigned cnt; ///< Pictures seen, temporal state is built from the first.
     double score;
 } MotionState;
 
@@ -44,19 +44,17 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     MotionState *s = fex->priv;
 
     s->float_stride = sizeof(float) * w;
-    s->ref = aligned_malloc(s->float_stride * h, 32);
     s->tmp = aligned_malloc(s->float_stride * h, 32);
     s->blur[0] = aligned_malloc(s->float_stride * h, 32);
     s->blur[1] = aligned_malloc(s->float_stride * h, 32);
     s->blur[2] = aligned_malloc(s->float_stride * h, 32);
-    if (!s->ref || !s->tmp || !s->blur[0] || !s->blur[1] || !s->blur[2])
+    if (!s->tmp || !s->blur[0] || !s->blur[1] || !s->blur[2])
         goto fail;
 
     s->score = 0;
     return 0;
 
 fail:
-    if (s->ref) aligned_free(s->ref);
     if (s->blur[0]) aligned_free(s->blur[0]);
     if (s->blur[1]) aligned_free(s->blur[1]);
     if (s->blur[2]) aligned_free(s->blur[2]);
@@ -69,6 +67,9 @@ static int flush(VmafFeatureExtractor *fex,
                  VmafFeatureCollector *feature_collector)
 {
     MotionState *s = fex->priv;
+    // nothing to score since the last restart
+    if (s->cnt < 2)
+        return 1;
     int ret = vmaf_feature_collector_append(feature_collector,
                                             "'VMAF_feature_motion2_score'",
                                             s->score, s->index);
@@ -82,21 +83,32 @@ static int extract(VmafFeatureExtractor *fex,
     MotionState *s = fex->priv;
     int err = 0;
 
+    // a gap, see window, restarts like the first picture of a segment
+    if (s->cnt && index != s->index + 1)
+        s->cnt = 0;
     s->index = index;
     unsigned blur_idx_0 = (index + 0) % 3;
     unsigned blur_idx_1 = (index + 1) % 3;
     unsigned blur_idx_2 = (index + 2) % 3;
 
-    picture_copy(s->ref, ref_pic, -128, ref_pic->bpc);
-    convolution_f32_c_s(FILTER_5_s, 5, s->ref, s->blur[blur_idx_0], s->tmp,
+    const float *ref;
+    err = picture_copy_shared(&ref, ref_pic, -128);
+    if (err) return err;
+    convolution_f32_c_s(FILTER_5_s, 5, ref, s->blur[blur_idx_0], s->tmp,
                         ref_pic->w[0], ref_pic->h[0],
                         s->float_stride / sizeof(float),
                         s->float_stride / sizeof(float));
 
-    if (index == 0)
+    // the first picture of a segment which does not start the sequence is
+    // only there to seed the blur buffers, its score belongs to the
+    // previous segment
+    if (s->cnt++ == 0) {
+        if (index > 0)
+            return 0;
         return vmaf_feature_collector_append(feature_collector,
                                              "'VMAF_feature_motion2_score'",
                                              0., index);
+    }
 
     double score;
     err = compute_motion(s->blur[blur_idx_2], s->blur[blur_idx_0],
@@ -105,7 +117,7 @@ static int extract(VmafFeatureExtractor *fex,
     if (err) return err;
     s->score = score;
 
-    if (index == 1)
+    if (s->cnt == 2)
         return 0;
     
     double score2;
@@ -126,7 +138,6 @@ static int close(VmafFeatureExtractor *fex)
 {
     MotionState *s = fex->priv;
 
-    if (s->ref) aligned_free(s->ref);
     if (s->blur[0]) aligned_free(s->blur[0]);
     if (s->blur[1]) aligned_free(s->blur[1]);
     if (s->blur[2]) aligned_free(s->blur[2]);
@@ -134,6 +145,11 @@ static int close(VmafFeatureExtractor *fex)
     return 0;
 }
 
+static const VmafPictureIntermediate *intermediates[] = {
+    &vmaf_intermediate_float_luma_centered,
+    NULL
+};
+
 static const char *provided_features[] = {
     "'VMAF_feature_motion2_score'",
     NULL
@@ -147,5 +163,9 @@ VmafFeatureExtractor vmaf_fex_float_motion = {
     .close = close,
     .priv_size = sizeof(MotionState),
     .provided_features = provided_features,
-    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL,
+    .intermediates = intermediates,
+    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL |
+             VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY,
+    .version = 1,
+    .window = { .past = 1, .future = 1 },
 };
@@ -27,26 +27,19 @@
 
 typedef struct MsSsimState {
     size_t float_stride;
-    float *ref;
-    float *dist;
 } MsSsimState;
 
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
+    (void) pix_fmt;
+    (void) bpc;
+    (void) h;
+
     MsSsimState *s = fex->priv;
     s->float_stride = sizeof(float) * w;
-    s->ref = aligned_malloc(s->float_stride * h, 32);
-    if (!s->ref) goto fail;
-    s->dist = aligned_malloc(s->float_stride * h, 32);
-    if (!s->dist) goto free_ref;
 
     return 0;
-
-free_ref:
-    free(s->ref);
-fail:
-    return -ENOMEM;
 }
 
 static int extract(VmafFeatureExtractor *fex,
@@ -56,11 +49,14 @@ static int extract(VmafFeatureExtractor *fex,
     MsSsimState *s = fex->priv;
     int err = 0;
 
-    picture_copy(s->ref, ref_pic, 0, ref_pic->bpc);
-    picture_copy(s->dist, dist_pic, 0, dist_pic->bpc);
+    const float *ref, *dist;
+    err = picture_copy_shared(&ref, ref_pic, 0);
+    if (err) return err;
+    err = picture_copy_shared(&dist, dist_pic, 0);
+    if (err) return err;
 
     double score, l_scores[5], c_scores[5], s_scores[5];
-    err = compute_ms_ssim(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+    err = compute_ms_ssim(ref, dist, ref_pic->w[0], ref_pic->h[0],
                           s->float_stride, s->float_stride,
                           &score, l_scores, c_scores, s_scores);
     if (err) return err;
@@ -70,13 +66,10 @@ static int extract(VmafFeatureExtractor *fex,
     return 0;
 }
 
-static int close(VmafFeatureExtractor *fex)
-{
-    MsSsimState *s = fex->priv;
-    if (s->ref) aligned_free(s->ref);
-    if (s->dist) aligned_free(s->dist);
-    return 0;
-}
+static const VmafPictureIntermediate *intermediates[] = {
+    &vmaf_intermediate_float_luma,
+    NULL
+};
 
 static const char *provided_features[] = {
     "float_ms_ssim",
@@ -87,7 +80,7 @@ VmafFeatureExtractor vmaf_fex_float_ms_ssim = {
     .name = "float_ms_ssim",
     .init = init,
     .extract = extract,
-    .close = close,
     .priv_size = sizeof(MsSsimState),
     .provided_features = provided_features,
+    .intermediates = intermediates,
 };
@@ -29,8 +29,6 @@
 
 typedef struct PsnrState {
     size_t float_stride;
-    float *ref;
-    float *dist;
     double peak;
     double psnr_max;
 } PsnrState;
@@ -38,22 +36,16 @@ typedef struct PsnrState {
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
+    (void) pix_fmt;
+    (void) h;
+
     PsnrState *s = fex->priv;
     s->float_stride = sizeof(float) * w;
-    s->ref = aligned_malloc(s->float_stride * h, 32);
-    if (!s->ref) goto fail;
-    s->dist = aligned_malloc(s->float_stride * h, 32);
-    if (!s->dist) goto free_ref;
 
     s->peak = bpc == 8 ? 255.0 : 255.75;
     s->psnr_max = bpc == 8 ? 60.0 : 72.0;
 
     return 0;
-
-free_ref:
-    free(s->ref);
-fail:
-    return -ENOMEM;
 }
 
 static int extract(VmafFeatureExtractor *fex,
@@ -63,11 +55,14 @@ static int extract(VmafFeatureExtractor *fex,
     PsnrState *s = fex->priv;
     int err = 0;
 
-    picture_copy(s->ref, ref_pic, 0, ref_pic->bpc);
-    picture_copy(s->dist, dist_pic, 0, dist_pic->bpc);
+    const float *ref, *dist;
+    err = picture_copy_shared(&ref, ref_pic, 0);
+    if (err) return err;
+    err = picture_copy_shared(&dist, dist_pic, 0);
+    if (err) return err;
 
     double score;
-    err = compute_psnr(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+    err = compute_psnr(ref, dist, ref_pic->w[0], ref_pic->h[0],
                        s->float_stride, s->float_stride, &score,
                        s->peak, s->psnr_max);
 
@@ -78,14 +73,23 @@ static int extract(VmafFeatureExtractor *fex,
     return 0;
 }
 
-static int close(VmafFeatureExtractor *fex)
+static int extract_identical(VmafFeatureExtractor *fex, VmafPicture *pic,
+                             unsigned index,
+                             VmafFeatureCollector *feature_collector)
 {
+    (void) pic;
+
     PsnrState *s = fex->priv;
-    if (s->ref) aligned_free(s->ref);
-    if (s->dist) aligned_free(s->dist);
-    return 0;
+
+    return vmaf_feature_collector_append(feature_collector, "float_psnr",
+                                         s->psnr_max, index);
 }
 
+static const VmafPictureIntermediate *intermediates[] = {
+    &vmaf_intermediate_float_luma,
+    NULL
+};
+
 static const char *provided_features[] = {
     "float_psnr",
     NULL
@@ -95,7 +99,8 @@ VmafFeatureExtractor vmaf_fex_float_psnr = {
     .name = "float_psnr",
     .init = init,
     .extract = extract,
-    .close = close,
+    .extract_identical = extract_identical,
     .priv_size = sizeof(PsnrState),
     .provided_features = provided_features,
+    .intermediates = intermediates,
 };
@@ -30,26 +30,19 @@
 
 typedef struct VifState {
     size_t float_stride;
-    float *ref;
-    float *dist;
 } VifState;
 
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
+    (void) pix_fmt;
+    (void) bpc;
+    (void) h;
+
     VifState *s = fex->priv;
     s->float_stride = sizeof(float) * w;
-    s->ref = aligned_malloc(s->float_stride * h, 32);
-    if (!s->ref) goto fail;
-    s->dist = aligned_malloc(s->float_stride * h, 32);
-    if (!s->dist) goto free_ref;
 
     return 0;
-
-free_ref:
-    free(s->ref);
-fail:
-    return -ENOMEM;
 }
 
 static int extract(VmafFeatureExtractor *fex,
@@ -59,12 +52,15 @@ static int extract(VmafFeatureExtractor *fex,
     VifState *s = fex->priv;
     int err = 0;
 
-    picture_copy(s->ref, ref_pic, -128, ref_pic->bpc);
-    picture_copy(s->dist, dist_pic, -128, dist_pic->bpc);
+    const float *ref, *dist;
+    err = picture_copy_shared(&ref, ref_pic, -128);
+    if (err) return err;
+    err = picture_copy_shared(&dist, dist_pic, -128);
+    if (err) return err;
 
     double score, score_num, score_den;
     double scores[8];
-    err = compute_vif(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+    err = compute_vif(ref, dist, ref_pic->w[0], ref_pic->h[0],
                       s->float_stride, s->float_stride,
                       &score, &score_num, &score_den, scores);
     if (err) return err;
@@ -89,13 +85,10 @@ static int extract(VmafFeatureExtractor *fex,
     return 0;
 }
 
-static int close(VmafFeatureExtractor *fex)
-{
-    VifState *s = fex->priv;
-    if (s->ref) aligned_free(s->ref);
-    if (s->dist) aligned_free(s->dist);
-    return 0;
-}
+static const VmafPictureIntermediate *intermediates[] = {
+    &vmaf_intermediate_float_luma_centered,
+    NULL
+};
 
 static const char *provided_features[] = {
     "'VMAF_feature_vif_scale0_score'", "'VMAF_feature_vif_scale1_score'",
@@ -107,7 +100,7 @@ VmafFeatureExtractor vmaf_fex_float_vif = {
     .name = "float_vif",
     .init = init,
     .extract = extract,
-    .close = close,
     .priv_size = sizeof(VifState),
     .provided_features = provided_features,
+    .intermediates = intermediates,
 };
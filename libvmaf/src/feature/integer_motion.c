@@ -30,6 +30,7 @@ typedef struct Integer_MotionState {
     VmafPicture tmp;
     VmafPicture blur[3];
     unsigned index;
+    unsigned cnt; ///< Pictures seen, temporal state is built from the first.
     double score;
 } Integer_MotionState;
 
@@ -65,6 +66,9 @@ static int flush(VmafFeatureExtractor *fex,
                  VmafFeatureCollector *feature_collector)
 {
     Integer_MotionState *s = fex->priv;
+    // nothing to score since the last restart
+    if (s->cnt < 2)
+        return 1;
     int ret = vmaf_feature_collector_append(feature_collector,
                                             "'VMAF_feature_motion2_integer_score'",
                                             s->score, s->index);
@@ -78,6 +82,9 @@ static int extract(VmafFeatureExtractor *fex,
     Integer_MotionState *s = fex->priv;
     int err = 0;
 
+    // a gap, see window, restarts like the first picture of a segment
+    if (s->cnt && index != s->index + 1)
+        s->cnt = 0;
     s->index = index;
     unsigned blur_idx_0 = (index + 0) % 3;
     unsigned blur_idx_1 = (index + 1) % 3;
@@ -98,16 +105,24 @@ static int extract(VmafFeatureExtractor *fex,
         // 16 bit input and 16 bit output for integer_convolution_16
         // ref_pic->stride[0] >> 1 is pass as src_stride is in multiple of sizeof(uint8_t)
         // s->blur[blur_idx_0].stride[0] >> 1 is pass as dst_stride is in multiple of sizeof(uint16_t)
+        // MSB-aligned samples are shifted down by the convolution itself
         integer_convolution_16(INTEGER_FILTER_5_s, 5, ref_pic->data[0], s->blur[blur_idx_0].data[0], s->tmp.data[0],
                         ref_pic->w[0], ref_pic->h[0],
                         ref_pic->stride[0] >> 1,
-                        s->blur[blur_idx_0].stride[0] >> 1 , ref_pic->bpc);
+                        s->blur[blur_idx_0].stride[0] >> 1 ,
+                        ref_pic->bpc + vmaf_picture_shift(ref_pic));
     }
 
-    if (index == 0)
+    // the first picture of a segment which does not start the sequence is
+    // only there to seed the blur buffers, its score belongs to the
+    // previous segment
+    if (s->cnt++ == 0) {
+        if (index > 0)
+            return 0;
         return vmaf_feature_collector_append(feature_collector,
                                              "'VMAF_feature_motion2_integer_score'",
                                              0., index);
+    }
 
     double score;
     //the stride pass to integer_compute_motion is in multiple of sizeof(uint16_t)
@@ -117,7 +132,7 @@ static int extract(VmafFeatureExtractor *fex,
     if (err) return err;
     s->score = score;
 
-    if (index == 1)
+    if (s->cnt == 2)
         return 0;
     
     double score2;
@@ -159,5 +174,8 @@ VmafFeatureExtractor vmaf_fex_integer_motion = {
     .close = close,
     .priv_size = sizeof(Integer_MotionState),
     .provided_features = provided_features,
-    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL,
+    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL |
+             VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY,
+    .version = 1,
+    .window = { .past = 1, .future = 1 },
 };
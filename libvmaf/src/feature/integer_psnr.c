@@ -22,6 +22,7 @@
 
 #include "feature_collector.h"
 #include "feature_extractor.h"
+#include "picture.h"
 
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
@@ -34,11 +35,12 @@ static int psnr8(VmafPicture *ref_pic, VmafPicture *dist_pic,
     for (unsigned i = 0; i < 3; i++) {
         uint8_t *ref = ref_pic->data[i];
         uint8_t *dist = dist_pic->data[i];
+        const unsigned step = vmaf_picture_step(ref_pic, i);
 
         double noise = 0.;
         for (unsigned j = 0; j < ref_pic->h[i]; j++) {
             for (unsigned k = 0; k < ref_pic->w[i]; k++) {
-                double diff = ref[k] - dist[k];
+                double diff = ref[k * step] - dist[k * step];
                 noise += diff * diff;
             }
             ref += ref_pic->stride[i];
@@ -68,11 +70,14 @@ static int psnr10(VmafPicture *ref_pic, VmafPicture *dist_pic,
     for (unsigned i = 0; i < 3; i++) {
         uint16_t *ref = ref_pic->data[i];
         uint16_t *dist = dist_pic->data[i];
+        const unsigned step = vmaf_picture_step(ref_pic, i);
+        const unsigned shift = vmaf_picture_shift(ref_pic);
 
         double noise = 0.;
         for (unsigned j = 0; j < ref_pic->h[i]; j++) {
             for (unsigned k = 0; k < ref_pic->w[i]; k++) {
-                double diff = (ref[k] / 4.0) - (dist[k] / 4.0);
+                double diff = ((ref[k * step] >> shift) / 4.0) -
+                              ((dist[k * step] >> shift) / 4.0);
                 noise += diff * diff;
             }
             ref += (ref_pic->stride[i] / 2);
@@ -98,6 +103,8 @@ static int extract(VmafFeatureExtractor *fex,
                    VmafPicture *ref_pic, VmafPicture *dist_pic,
                    unsigned index, VmafFeatureCollector *feature_collector)
 {
+    (void) fex;
+
     switch(ref_pic->bpc) {
     case 8:
         return psnr8(ref_pic, dist_pic, index, feature_collector);
@@ -113,8 +120,37 @@ static const char *provided_features[] = {
     NULL
 };
 
+static int extract_identical(VmafFeatureExtractor *fex, VmafPicture *pic,
+                             unsigned index,
+                             VmafFeatureCollector *feature_collector)
+{
+    (void) fex;
+
+    double psnr_max;
+    switch(pic->bpc) {
+    case 8:
+        psnr_max = 60.;
+        break;
+    case 10:
+        psnr_max = 72.;
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    for (unsigned i = 0; provided_features[i]; i++) {
+        int err = vmaf_feature_collector_append(feature_collector,
+                                                (char *) provided_features[i],
+                                                psnr_max, index);
+        if (err) return err;
+    }
+    return 0;
+}
+
 VmafFeatureExtractor vmaf_fex_psnr = {
     .name = "psnr",
+    .flags = VMAF_FEATURE_EXTRACTOR_CHROMA,
     .extract = extract,
+    .extract_identical = extract_identical,
     .provided_features = provided_features,
 };
@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "feature_collector.h"
 #include "feature_extractor.h"
+#include "picture.h"
 
 #define KERNEL_SHIFT (8)
 #define KERNEL_WEIGHT (1<<KERNEL_SHIFT)
@@ -86,7 +87,8 @@ struct ssim_moments{
 #define SSIM_K2 (0.03*0.03)
 
 static double calc_ssim(const unsigned char *_src,int _systride,
- const unsigned char *_dst,int _dystride,double _par,int depth,int _w,int _h){
+ const unsigned char *_dst,int _dystride,double _par,int depth,int shift,
+ int _w,int _h){
   ssim_moments  *line_buf;
   ssim_moments **lines;
   double         ssim;
@@ -133,10 +135,10 @@ static double calc_ssim(const unsigned char *_src,int _systride,
           signed d;
           signed window;
           if (depth > 8) {
-            s = _src[(x-hkernel_offs+k)*2] +
-             (_src[(x-hkernel_offs+k)*2 + 1] << 8);
-            d = _dst[(x-hkernel_offs+k)*2] +
-             (_dst[(x-hkernel_offs+k)*2 + 1] << 8);
+            s = (_src[(x-hkernel_offs+k)*2] +
+             (_src[(x-hkernel_offs+k)*2 + 1] << 8)) >> shift;
+            d = (_dst[(x-hkernel_offs+k)*2] +
+             (_dst[(x-hkernel_offs+k)*2 + 1] << 8)) >> shift;
           } else {
             s=_src[(x-hkernel_offs+k)];
             d=_dst[(x-hkernel_offs+k)];
@@ -209,7 +211,7 @@ static int extract(VmafFeatureExtractor *fex,
     double score =
         calc_ssim(ref_pic->data[0], ref_pic->stride[0],
                   dist_pic->data[0], dist_pic->stride[0], 1.0, ref_pic->bpc,
-                  ref_pic->w[0], ref_pic->h[0]);
+                  vmaf_picture_shift(ref_pic), ref_pic->w[0], ref_pic->h[0]);
     int err =
         vmaf_feature_collector_append(feature_collector, "ssim", score, index);
     if (err) return err;
@@ -221,6 +223,16 @@ static int close(VmafFeatureExtractor *fex)
     return 0;
 }
 
+static int extract_identical(VmafFeatureExtractor *fex, VmafPicture *pic,
+                             unsigned index,
+                             VmafFeatureCollector *feature_collector)
+{
+    (void) fex;
+    (void) pic;
+
+    return vmaf_feature_collector_append(feature_collector, "ssim", 1., index);
+}
+
 static const char *provided_features[] = {
     "ssim",
     NULL
@@ -230,6 +242,7 @@ VmafFeatureExtractor vmaf_fex_ssim = {
     .name = "ssim",
     .init = init,
     .extract = extract,
+    .extract_identical = extract_identical,
     .close = close,
     .provided_features = provided_features,
 };
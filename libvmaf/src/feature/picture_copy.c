@@ -16,18 +16,26 @@
  *
  */
 
+#include <errno.h>
 #include <stdint.h>
 
 #include <libvmaf/picture.h>
 
+#include "cpu.h"
+#include "picture.h"
+#include "picture_copy.h"
+
+extern enum vmaf_cpu cpu;
+
 void picture_copy_hbd(float *dst, VmafPicture *src, int offset)
 {
     float *float_data = dst;
     uint16_t *data = src->data[0];
+    const unsigned shift = vmaf_picture_shift(src);
 
     for (unsigned i = 0; i < src->h[0]; i++) {
         for (unsigned j = 0; j < src->w[0]; j++) {
-            float_data[j] = (float) data[j] / 4.0 + offset;
+            float_data[j] = (float) (data[j] >> shift) / 4.0 + offset;
         }
         float_data += src->w[0];
         data += src->stride[0] / 2;
@@ -37,6 +45,12 @@ void picture_copy_hbd(float *dst, VmafPicture *src, int offset)
 
 void picture_copy(float *dst, VmafPicture *src, int offset, unsigned bpc)
 {
+    if (cpu >= VMAF_CPU_AVX) {
+        picture_copy_avx(dst, src->data[0], src->stride[0], src->w[0],
+                         src->h[0], offset, bpc, vmaf_picture_shift(src));
+        return;
+    }
+
     if (bpc > 8)
         return picture_copy_hbd(dst, src, offset);
 
@@ -53,3 +67,52 @@ void picture_copy(float *dst, VmafPicture *src, int offset, unsigned bpc)
 
     return;
 }
+
+static size_t float_luma_size(VmafPicture *pic)
+{
+    return sizeof(float) * pic->w[0] * pic->h[0];
+}
+
+static int float_luma_compute(VmafPicture *pic, void *data)
+{
+    picture_copy(data, pic, 0, pic->bpc);
+    return 0;
+}
+
+static int float_luma_centered_compute(VmafPicture *pic, void *data)
+{
+    picture_copy(data, pic, -128, pic->bpc);
+    return 0;
+}
+
+const VmafPictureIntermediate vmaf_intermediate_float_luma = {
+    .name = "float_luma",
+    .size = float_luma_size,
+    .compute = float_luma_compute,
+};
+
+const VmafPictureIntermediate vmaf_intermediate_float_luma_centered = {
+    .name = "float_luma_centered",
+    .size = float_luma_size,
+    .compute = float_luma_centered_compute,
+};
+
+int picture_copy_shared(const float **dst, VmafPicture *src, int offset)
+{
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+
+    const VmafPictureIntermediate *desc;
+    switch (offset) {
+    case 0:
+        desc = &vmaf_intermediate_float_luma;
+        break;
+    case -128:
+        desc = &vmaf_intermediate_float_luma_centered;
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    return vmaf_picture_intermediate(src, desc, (const void **) dst);
+}
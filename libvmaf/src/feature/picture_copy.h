@@ -16,4 +16,33 @@
  *
  */
 
+#ifndef __VMAF_PICTURE_COPY_H__
+#define __VMAF_PICTURE_COPY_H__
+
+#include <stddef.h>
+
+#include <libvmaf/picture.h>
+
+#include "picture.h"
+
+/* float luma planes, shifted by 0 and -128 */
+extern const VmafPictureIntermediate vmaf_intermediate_float_luma;
+extern const VmafPictureIntermediate vmaf_intermediate_float_luma_centered;
+
 void picture_copy(float *dst, VmafPicture *src, int offset, unsigned bpc);
+
+/* `shift` drops the low bits of MSB-aligned samples, see vmaf_picture_shift() */
+void picture_copy_avx(float *dst, const void *src, ptrdiff_t src_stride,
+                      unsigned w, unsigned h, int offset, unsigned bpc,
+                      unsigned shift);
+
+/**
+ * Get a float copy of the luma plane of `src`, shifted by `offset`, 0 or
+ * -128. The copy is a picture intermediate, it is made once per picture and
+ * is shared by every reference to `src`, it is released together with the
+ * last reference.
+ * The returned plane has a stride of `sizeof(float) * src->w[0]`.
+ */
+int picture_copy_shared(const float **dst, VmafPicture *src, int offset);
+
+#endif /* __VMAF_PICTURE_COPY_H__ */
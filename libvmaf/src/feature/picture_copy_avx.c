@@ -0,0 +1,71 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+void picture_copy_avx(float *dst, const void *src, ptrdiff_t src_stride,
+                      unsigned w, unsigned h, int offset, unsigned bpc,
+                      unsigned shift)
+{
+    const __m256 off = _mm256_set1_ps((float) offset);
+
+    if (bpc > 8) {
+        const __m256 scale = _mm256_set1_ps(0.25f);
+        const uint16_t *data = src;
+
+        for (unsigned i = 0; i < h; i++) {
+            unsigned j = 0;
+            for (; j + 8 <= w; j += 8) {
+                __m128i px = _mm_srl_epi16(
+                    _mm_loadu_si128((const __m128i *) (data + j)),
+                    _mm_cvtsi32_si128(shift));
+                __m128i lo = _mm_cvtepu16_epi32(px);
+                __m128i hi = _mm_cvtepu16_epi32(_mm_srli_si128(px, 8));
+                __m256 f = _mm256_cvtepi32_ps(
+                    _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+                _mm256_storeu_ps(dst + j, _mm256_add_ps(_mm256_mul_ps(f, scale),
+                                                        off));
+            }
+            for (; j < w; j++)
+                dst[j] = (float) (data[j] >> shift) / 4.0 + offset;
+            dst += w;
+            data += src_stride / 2;
+        }
+        return;
+    }
+
+    const uint8_t *data = src;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j + 8 <= w; j += 8) {
+            __m128i px = _mm_loadl_epi64((const __m128i *) (data + j));
+            __m128i lo = _mm_cvtepu8_epi32(px);
+            __m128i hi = _mm_cvtepu8_epi32(_mm_srli_si128(px, 4));
+            __m256 f = _mm256_cvtepi32_ps(
+                _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+            _mm256_storeu_ps(dst + j, _mm256_add_ps(f, off));
+        }
+        for (; j < w; j++)
+            dst[j] = (float) data[j] + offset;
+        dst += w;
+        data += src_stride;
+    }
+}
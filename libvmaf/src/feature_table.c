@@ -0,0 +1,152 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "feature_table.h"
+
+#define FEATURE_TABLE_CHUNK 1024
+#define FEATURE_TABLE_MAX_CHUNKS 8192
+
+typedef struct
+{
+    double column[FEATURE_COLUMN_CNT][FEATURE_TABLE_CHUNK];
+    atomic_int committed[FEATURE_TABLE_CHUNK];
+} FeatureTableChunk;
+
+struct FeatureTable
+{
+    unsigned columns;
+    atomic_int chunk_cnt;
+    pthread_mutex_t lock;
+    FeatureTableChunk *chunk[FEATURE_TABLE_MAX_CHUNKS];
+};
+
+int feature_table_init(FeatureTable **table, unsigned columns,
+                       size_t init_frames)
+{
+    FeatureTable *const t = calloc(1, sizeof(*t));
+    if (!t)
+        return -1;
+
+    t->columns = columns;
+    atomic_init(&t->chunk_cnt, 0);
+    pthread_mutex_init(&t->lock, NULL);
+    *table = t;
+
+    if (feature_table_reserve(t, init_frames))
+    {
+        feature_table_free(t);
+        *table = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int feature_table_has(const FeatureTable *table, enum FeatureColumn column)
+{
+    return !!(table->columns & FEATURE_COLUMN_BIT(column));
+}
+
+int feature_table_reserve(FeatureTable *table, size_t frame_cnt)
+{
+    // rounded up without overflowing for huge frame counts
+    const size_t chunk_cnt = frame_cnt / FEATURE_TABLE_CHUNK +
+                             !!(frame_cnt % FEATURE_TABLE_CHUNK);
+    if (chunk_cnt > FEATURE_TABLE_MAX_CHUNKS)
+        return -1;
+    if ((size_t) atomic_load(&table->chunk_cnt) >= chunk_cnt)
+        return 0;
+
+    int ret = 0;
+    pthread_mutex_lock(&table->lock);
+    for (size_t i = atomic_load(&table->chunk_cnt); i < chunk_cnt; i++)
+    {
+        // calloc() leaves all frames uncommitted
+        FeatureTableChunk *chunk = calloc(1, sizeof(*chunk));
+        if (!chunk)
+        {
+            ret = -1;
+            break;
+        }
+        table->chunk[i] = chunk;
+        // publishes the chunk to the lock-free check above
+        atomic_store(&table->chunk_cnt, i + 1);
+    }
+    pthread_mutex_unlock(&table->lock);
+    return ret;
+}
+
+void feature_table_set(FeatureTable *table, enum FeatureColumn column,
+                       size_t frame, double value)
+{
+    FeatureTableChunk *chunk = table->chunk[frame / FEATURE_TABLE_CHUNK];
+    chunk->column[column][frame % FEATURE_TABLE_CHUNK] = value;
+}
+
+double feature_table_get(const FeatureTable *table, enum FeatureColumn column,
+                         size_t frame)
+{
+    const FeatureTableChunk *chunk = table->chunk[frame / FEATURE_TABLE_CHUNK];
+    return chunk->column[column][frame % FEATURE_TABLE_CHUNK];
+}
+
+void feature_table_commit(FeatureTable *table, size_t frame)
+{
+    FeatureTableChunk *chunk = table->chunk[frame / FEATURE_TABLE_CHUNK];
+    atomic_store(&chunk->committed[frame % FEATURE_TABLE_CHUNK], 1);
+}
+
+int feature_table_is_committed(const FeatureTable *table, size_t frame)
+{
+    FeatureTableChunk *chunk = table->chunk[frame / FEATURE_TABLE_CHUNK];
+    return atomic_load(&chunk->committed[frame % FEATURE_TABLE_CHUNK]);
+}
+
+size_t feature_table_frame_cnt(const FeatureTable *table)
+{
+    const size_t capacity = atomic_load(&table->chunk_cnt) * FEATURE_TABLE_CHUNK;
+    size_t frame_cnt = 0;
+    for (size_t i = 0; i < capacity; i++)
+    {
+        if (feature_table_is_committed(table, i))
+            frame_cnt = i + 1;
+    }
+    return frame_cnt;
+}
+
+size_t feature_table_commit_cnt(const FeatureTable *table)
+{
+    const size_t capacity = atomic_load(&table->chunk_cnt) * FEATURE_TABLE_CHUNK;
+    size_t commit_cnt = 0;
+    for (size_t i = 0; i < capacity; i++)
+        commit_cnt += feature_table_is_committed(table, i);
+    return commit_cnt;
+}
+
+void feature_table_free(FeatureTable *table)
+{
+    if (!table)
+        return;
+    for (int i = 0; i < atomic_load(&table->chunk_cnt); i++)
+        free(table->chunk[i]);
+    pthread_mutex_destroy(&table->lock);
+    free(table);
+}
@@ -0,0 +1,102 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#pragma once
+
+#ifndef FEATURE_TABLE_H_
+#define FEATURE_TABLE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/*
+ * Columnar (frames x features) storage for the legacy combo() pipeline.
+ * Frames are stored in fixed size chunks which never move once allocated,
+ * within a chunk each feature is a contiguous column. Worker threads write
+ * their own frame without locking and publish it with a single atomic
+ * commit, only allocating a new chunk in feature_table_reserve() locks.
+ */
+
+enum FeatureColumn {
+    FEATURE_ADM_NUM,
+    FEATURE_ADM_DEN,
+    FEATURE_ADM_NUM_SCALE0,
+    FEATURE_ADM_DEN_SCALE0,
+    FEATURE_ADM_NUM_SCALE1,
+    FEATURE_ADM_DEN_SCALE1,
+    FEATURE_ADM_NUM_SCALE2,
+    FEATURE_ADM_DEN_SCALE2,
+    FEATURE_ADM_NUM_SCALE3,
+    FEATURE_ADM_DEN_SCALE3,
+    FEATURE_MOTION,
+    FEATURE_MOTION2,
+    FEATURE_VIF_NUM_SCALE0,
+    FEATURE_VIF_DEN_SCALE0,
+    FEATURE_VIF_NUM_SCALE1,
+    FEATURE_VIF_DEN_SCALE1,
+    FEATURE_VIF_NUM_SCALE2,
+    FEATURE_VIF_DEN_SCALE2,
+    FEATURE_VIF_NUM_SCALE3,
+    FEATURE_VIF_DEN_SCALE3,
+    FEATURE_VIF,
+    FEATURE_PSNR,
+    FEATURE_SSIM,
+    FEATURE_MS_SSIM,
+    FEATURE_COLUMN_CNT
+};
+
+#define FEATURE_COLUMN_BIT(column) (1u << (column))
+#define FEATURE_COLUMNS_REQUIRED (FEATURE_COLUMN_BIT(FEATURE_PSNR) - 1)
+
+typedef struct FeatureTable FeatureTable;
+
+/* columns is a mask of FEATURE_COLUMN_BIT(), init_frames are preallocated */
+int feature_table_init(FeatureTable **table, unsigned columns,
+                       size_t init_frames);
+int feature_table_has(const FeatureTable *table, enum FeatureColumn column);
+
+/*
+ * Make frames [0, frame_cnt) writable. Must happen-before any access to
+ * those frames from another thread, e.g. by reserving from the thread
+ * which writes the frame.
+ */
+int feature_table_reserve(FeatureTable *table, size_t frame_cnt);
+
+void feature_table_set(FeatureTable *table, enum FeatureColumn column,
+                       size_t frame, double value);
+double feature_table_get(const FeatureTable *table, enum FeatureColumn column,
+                         size_t frame);
+
+/* publish all columns of a frame written so far */
+void feature_table_commit(FeatureTable *table, size_t frame);
+int feature_table_is_committed(const FeatureTable *table, size_t frame);
+
+/* highest committed frame + 1, and the number of committed frames */
+size_t feature_table_frame_cnt(const FeatureTable *table);
+size_t feature_table_commit_cnt(const FeatureTable *table);
+
+void feature_table_free(FeatureTable *table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FEATURE_TABLE_H_ */
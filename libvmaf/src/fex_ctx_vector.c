@@ -17,6 +17,8 @@
  */
 
 #include <errno.h>
+#include <stdbool.h>
+#include <string.h>
 
 #include "feature/feature_extractor.h"
 #include "fex_ctx_vector.h"
@@ -32,6 +34,36 @@ int feature_extractor_vector_init(RegisteredFeatureExtractors *rfe)
     return 0;
 }
 
+static bool uses_intermediate(VmafFeatureExtractor *fex,
+                              const VmafPictureIntermediate *desc)
+{
+    for (unsigned i = 0; fex->intermediates && fex->intermediates[i]; i++) {
+        if (fex->intermediates[i] == desc)
+            return true;
+    }
+    return false;
+}
+
+/* distinct picture intermediates used once `fex` is registered */
+static unsigned intermediate_cnt(RegisteredFeatureExtractors *rfe,
+                                 VmafFeatureExtractor *fex)
+{
+    unsigned cnt = 0;
+    for (unsigned i = 0; i <= rfe->cnt; i++) {
+        VmafFeatureExtractor *f = i < rfe->cnt ? rfe->fex_ctx[i]->fex : fex;
+        for (unsigned j = 0; f->intermediates && f->intermediates[j]; j++) {
+            bool seen = false;
+            for (unsigned k = 0; k < i && !seen; k++)
+                seen = uses_intermediate(rfe->fex_ctx[k]->fex,
+                                         f->intermediates[j]);
+            for (unsigned k = 0; k < j && !seen; k++)
+                seen = f->intermediates[k] == f->intermediates[j];
+            cnt += !seen;
+        }
+    }
+    return cnt;
+}
+
 int feature_extractor_vector_append(RegisteredFeatureExtractors *rfe,
                                     VmafFeatureExtractorContext *fex_ctx)
 {
@@ -43,6 +75,10 @@ int feature_extractor_vector_append(RegisteredFeatureExtractors *rfe,
             return vmaf_feature_extractor_context_destroy(fex_ctx);
     }
 
+    // every intermediate needs a slot in the pictures
+    if (intermediate_cnt(rfe, fex_ctx->fex) > VMAF_PICTURE_INTERMEDIATE_CNT)
+        return -EINVAL;
+
     if (rfe->cnt >= rfe->capacity) {
         size_t capacity = rfe->capacity * 2;
         VmafFeatureExtractorContext **fex_ctx =
@@ -0,0 +1,273 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gate.h"
+#include "libvmaf/libvmaf.rc.h"
+
+#define GATE_FIRST_LOOK 8 ///< Fewer strata give no useful bootstrap.
+#define GATE_RESAMPLES 2000
+
+struct VmafGate {
+    VmafGateConfiguration cfg;
+    unsigned strata;
+    unsigned *order; ///< Randomized order of the strata.
+    unsigned next; ///< Strata handed out by `vmaf_gate_next()`.
+    double *score; ///< Per stratum, NAN until recorded.
+    unsigned scored;
+    unsigned looks; ///< Points at which a decision may be taken.
+    uint64_t rng;
+    VmafGateStatus status;
+};
+
+/* xorshift64*, reproducible across platforms unlike rand() */
+static uint64_t gate_rand(VmafGate *gate)
+{
+    gate->rng ^= gate->rng >> 12;
+    gate->rng ^= gate->rng << 25;
+    gate->rng ^= gate->rng >> 27;
+    return gate->rng * 0x2545f4914f6cdd1dull;
+}
+
+static unsigned gate_rand_below(VmafGate *gate, unsigned n)
+{
+    return (gate_rand(gate) >> 32) % n;
+}
+
+int vmaf_gate_init(VmafGate **gate, VmafGateConfiguration cfg)
+{
+    if (!gate) return -EINVAL;
+    if (!cfg.pic_cnt) return -EINVAL;
+    if (cfg.confidence < 0. || cfg.confidence >= 1.) return -EINVAL;
+
+    if (!cfg.confidence)
+        cfg.confidence = 0.95;
+    if (!cfg.stratum)
+        cfg.stratum = 16;
+
+    VmafGate *const g = *gate = malloc(sizeof(*g));
+    if (!g) return -ENOMEM;
+    memset(g, 0, sizeof(*g));
+    g->cfg = cfg;
+    g->strata = cfg.pic_cnt / cfg.stratum ? cfg.pic_cnt / cfg.stratum : 1;
+    g->rng = 0x9e3779b97f4a7c15ull ^ cfg.seed;
+
+    g->order = malloc(sizeof(*g->order) * g->strata);
+    if (!g->order) goto free_gate;
+    g->score = malloc(sizeof(*g->score) * g->strata);
+    if (!g->score) goto free_order;
+
+    for (unsigned i = 0; i < g->strata; i++) {
+        g->order[i] = i;
+        g->score[i] = NAN;
+    }
+    for (unsigned i = g->strata - 1; i > 0; i--) {
+        const unsigned j = gate_rand_below(g, i + 1);
+        const unsigned k = g->order[i];
+        g->order[i] = g->order[j];
+        g->order[j] = k;
+    }
+
+    for (unsigned n = GATE_FIRST_LOOK; n < g->strata; n *= 2)
+        g->looks++;
+    g->looks++;
+
+    g->status.strata = g->strata;
+    g->status.score = g->status.ci_low = g->status.ci_high = NAN;
+    return 0;
+
+free_order:
+    free(g->order);
+free_gate:
+    free(g);
+    *gate = NULL;
+    return -ENOMEM;
+}
+
+void vmaf_gate_stratum(VmafGate *gate, unsigned k, unsigned *index_low,
+                       unsigned *index_high)
+{
+    *index_low = (uint64_t) gate->cfg.pic_cnt * k / gate->strata;
+    *index_high = (uint64_t) gate->cfg.pic_cnt * (k + 1) / gate->strata;
+}
+
+int vmaf_gate_next(VmafGate *gate, unsigned *index_low, unsigned *index_high)
+{
+    if (!gate) return -EINVAL;
+    if (!index_low) return -EINVAL;
+    if (!index_high) return -EINVAL;
+
+    if (gate->next == gate->strata)
+        return 1;
+    vmaf_gate_stratum(gate, gate->order[gate->next++], index_low, index_high);
+    return 0;
+}
+
+int vmaf_gate_update(VmafGate *gate, unsigned k, double score)
+{
+    if (!gate) return -EINVAL;
+    if (k >= gate->strata) return -EINVAL;
+    if (isnan(score)) return -EINVAL;
+
+    if (isnan(gate->score[k]))
+        gate->scored++;
+    gate->score[k] = score;
+    return 0;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    const double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Strata differ by at most one picture, so they are weighted by length,
+ * which makes the estimate exact once every stratum is scored.
+ */
+static int bootstrap(VmafGate *gate, double alpha)
+{
+    const unsigned n = gate->scored;
+    unsigned *k = malloc(sizeof(*k) * n);
+    double *mean = malloc(sizeof(*mean) * GATE_RESAMPLES);
+    if (!k || !mean) {
+        free(k);
+        free(mean);
+        return -ENOMEM;
+    }
+    for (unsigned i = 0, j = 0; i < gate->strata; i++) {
+        if (!isnan(gate->score[i]))
+            k[j++] = i;
+    }
+
+    for (unsigned r = 0; r < GATE_RESAMPLES; r++) {
+        double sum = 0., len = 0.;
+        for (unsigned i = 0; i < n; i++) {
+            unsigned low, high;
+            const unsigned s = k[gate_rand_below(gate, n)];
+            vmaf_gate_stratum(gate, s, &low, &high);
+            sum += gate->score[s] * (high - low);
+            len += high - low;
+        }
+        mean[r] = sum / len;
+    }
+    qsort(mean, GATE_RESAMPLES, sizeof(*mean), compare_double);
+
+    // the bootstrap resamples with replacement, the strata are drawn
+    // without, which leaves less variance as the population is exhausted
+    const double fpc = sqrt((1. - (double) n / gate->strata) * n / (n - 1));
+    const unsigned lo = alpha / 2. * (GATE_RESAMPLES - 1);
+    const unsigned hi = (1. - alpha / 2.) * (GATE_RESAMPLES - 1);
+    const double score = gate->status.score;
+    gate->status.ci_low = score + (mean[lo] - score) * fpc;
+    gate->status.ci_high = score + (mean[hi] - score) * fpc;
+
+    free(mean);
+    free(k);
+    return 0;
+}
+
+static bool is_look(VmafGate *gate)
+{
+    const unsigned n = gate->scored;
+    if (n == gate->strata)
+        return true;
+    // the power of two at or above the first look
+    return n >= GATE_FIRST_LOOK && !(n & (n - 1));
+}
+
+int vmaf_gate_decide(VmafGate *gate, VmafGateStatus *status)
+{
+    if (!gate) return -EINVAL;
+    if (!status) return -EINVAL;
+
+    double sum = 0., len = 0.;
+    for (unsigned i = 0; i < gate->strata; i++) {
+        if (isnan(gate->score[i]))
+            continue;
+        unsigned low, high;
+        vmaf_gate_stratum(gate, i, &low, &high);
+        sum += gate->score[i] * (high - low);
+        len += high - low;
+    }
+    gate->status.scored = gate->scored;
+    gate->status.score = gate->scored ? sum / len : NAN;
+
+    if (!gate->status.decision && gate->scored && is_look(gate)) {
+        const double threshold = gate->cfg.threshold;
+        if (gate->scored == gate->strata) {
+            gate->status.ci_low = gate->status.ci_high = gate->status.score;
+            gate->status.decision = gate->status.score >= threshold ?
+                                    VMAF_GATE_PASS : VMAF_GATE_FAIL;
+        } else {
+            const double alpha = (1. - gate->cfg.confidence) / gate->looks;
+            int err = bootstrap(gate, alpha);
+            if (err) return err;
+            // strict, so that an interval collapsed onto the threshold,
+            // e.g. by clipped scores, needs more strata
+            if (gate->status.ci_low > threshold)
+                gate->status.decision = VMAF_GATE_PASS;
+            else if (gate->status.ci_high < threshold)
+                gate->status.decision = VMAF_GATE_FAIL;
+        }
+    }
+
+    *status = gate->status;
+    return 0;
+}
+
+int vmaf_gate_check(VmafGate *gate, VmafContext *vmaf, VmafModel *model,
+                    VmafGateStatus *status)
+{
+    if (!gate) return -EINVAL;
+    if (!vmaf) return -EINVAL;
+    if (!status) return -EINVAL;
+
+    for (unsigned i = 0; i < gate->next; i++) {
+        const unsigned k = gate->order[i];
+        if (!isnan(gate->score[k]))
+            continue;
+        unsigned low, high;
+        vmaf_gate_stratum(gate, k, &low, &high);
+        double score;
+        // strata which are not completely scored yet are left out
+        if (vmaf_score_pooled(vmaf, model, VMAF_POOL_METHOD_MEAN, &score,
+                              low, high))
+        {
+            continue;
+        }
+        int err = vmaf_gate_update(gate, k, score);
+        if (err) return err;
+    }
+
+    return vmaf_gate_decide(gate, status);
+}
+
+void vmaf_gate_close(VmafGate *gate)
+{
+    if (!gate) return;
+    free(gate->order);
+    free(gate->score);
+    free(gate);
+}
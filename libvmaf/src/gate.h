@@ -0,0 +1,40 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_GATE_H__
+#define __VMAF_GATE_H__
+
+#include "libvmaf/libvmaf.rc.h"
+
+/**
+ * Picture range [index_low, index_high) of stratum `k`.
+ */
+void vmaf_gate_stratum(VmafGate *gate, unsigned k, unsigned *index_low,
+                       unsigned *index_high);
+
+/**
+ * Record the mean pooled score of stratum `k`.
+ */
+int vmaf_gate_update(VmafGate *gate, unsigned k, double score);
+
+/**
+ * Decide from the strata recorded so far, see `vmaf_gate_check()`.
+ */
+int vmaf_gate_decide(VmafGate *gate, VmafGateStatus *status);
+
+#endif /* __VMAF_GATE_H__ */
@@ -17,6 +17,10 @@
  */
 
 #include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -28,12 +32,30 @@
 #include "feature/common/cpu.h"
 #include "feature/feature_extractor.h"
 #include "feature/feature_collector.h"
+#include "crop.h"
 #include "fex_ctx_vector.h"
 #include "model.h"
 #include "output.h"
+#include "partial.h"
 #include "picture.h"
 #include "predict.h"
+#include "preview.h"
+#include "profile.h"
+#include "ref_cache.h"
+#include "scale.h"
+#include "subsample.h"
 #include "thread_pool.h"
+#include "trace.h"
+
+typedef struct InFlight {
+    pthread_mutex_t lock;
+    pthread_cond_t done; ///< Signaled when a pair leaves.
+    struct {
+        unsigned index;
+        unsigned jobs; ///< Queued or running, plus one while queueing.
+    } *pic;
+    unsigned cnt, capacity;
+} InFlight;
 
 typedef struct VmafContext {
     VmafConfiguration cfg;
@@ -41,12 +63,46 @@ typedef struct VmafContext {
     RegisteredFeatureExtractors registered_feature_extractors;
     VmafFeatureExtractorContextPool *fex_ctx_pool;
     VmafThreadPool *thread_pool;
+    VmafRefCache *ref_cache;
+    VmafSubsampler *subsampler;
+    VmafScaler *scaler; ///< Built for the first distorted picture scaled.
+    InFlight in_flight; ///< Pairs with jobs in the thread pool.
     struct {
         unsigned w, h;
         enum VmafPixelFormat pix_fmt;
         unsigned bpc;
     } pic_params;
     unsigned pic_cnt;
+    struct {
+        VmafPicture ref, dist; ///< Last extracted picture pair.
+        unsigned source; ///< Picture index its scores are stored at.
+        bool valid;
+    } last;
+    struct {
+        struct {
+            unsigned index, source;
+        } *pic;
+        unsigned cnt, capacity;
+    } repeat; ///< Pictures waiting for `copy_repeats()`.
+    struct {
+        VmafPicture ref, dist;
+        unsigned index;
+        bool valid;
+    } held; ///< Last picture pair, while skipped, see `select_pictures()`.
+    struct {
+        unsigned low, high;
+    } segment; ///< Set by `vmaf_set_segment()`, high is 0 otherwise.
+    struct {
+        VmafActiveArea area; ///< Set by `vmaf_set_active_area()`, or empty.
+        unsigned exposed;
+    } crop;
+    struct {
+        VmafProfileCounter pool_wait;
+        struct {
+            unsigned max;
+            uint64_t sum, cnt;
+        } queue_depth;
+    } profile;
 } VmafContext;
 
 enum vmaf_cpu cpu;
@@ -57,6 +113,12 @@ enum vmaf_cpu cpu;
 int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg)
 {
     if (!vmaf) return -EINVAL;
+    if (cfg.preview > 1 && !vmaf_preview_factor_valid(cfg.preview))
+        return -EINVAL;
+    if (cfg.subsample_mode > VMAF_SUBSAMPLE_MODE_ADAPTIVE)
+        return -EINVAL;
+    if (cfg.scale_filter > VMAF_SCALE_FILTER_LANCZOS)
+        return -EINVAL;
     int err = 0;
 
     cpu = cpu_autodetect() & (~cfg.cpumask); //FIXME, see above
@@ -71,9 +133,19 @@ int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg)
     err = feature_extractor_vector_init(&(v->registered_feature_extractors));
     if (err) goto free_feature_collector;
 
+    if (v->cfg.subsample_mode == VMAF_SUBSAMPLE_MODE_ADAPTIVE) {
+        err = vmaf_subsampler_init(&v->subsampler, v->cfg.n_subsample);
+        if (err) goto free_feature_extractor_vector;
+    }
+
+    if (pthread_mutex_init(&v->in_flight.lock, NULL))
+        goto free_subsampler;
+    if (pthread_cond_init(&v->in_flight.done, NULL))
+        goto free_in_flight_lock;
+
     if (v->cfg.n_threads > 0) {
         err = vmaf_thread_pool_create(&v->thread_pool, v->cfg.n_threads);
-        if (err) goto free_feature_extractor_vector;
+        if (err) goto free_in_flight;
         err = vmaf_fex_ctx_pool_create(&v->fex_ctx_pool, v->cfg.n_threads);
         if (err) goto free_thread_pool;
     }
@@ -82,6 +154,12 @@ int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg)
 
 free_thread_pool:
     vmaf_thread_pool_destroy(v->thread_pool);
+free_in_flight:
+    pthread_cond_destroy(&v->in_flight.done);
+free_in_flight_lock:
+    pthread_mutex_destroy(&v->in_flight.lock);
+free_subsampler:
+    vmaf_subsampler_close(v->subsampler);
 free_feature_extractor_vector:
     feature_extractor_vector_destroy(&(v->registered_feature_extractors));
 free_feature_collector:
@@ -97,13 +175,28 @@ int vmaf_close(VmafContext *vmaf)
     if (!vmaf) return -EINVAL;
 
     vmaf_thread_pool_wait(vmaf->thread_pool);
+    const int err = vmaf->ref_cache ? vmaf_ref_cache_close(vmaf->ref_cache) : 0;
+    if (vmaf->last.valid) {
+        vmaf_picture_unref(&vmaf->last.ref);
+        vmaf_picture_unref(&vmaf->last.dist);
+    }
+    if (vmaf->held.valid) {
+        vmaf_picture_unref(&vmaf->held.ref);
+        vmaf_picture_unref(&vmaf->held.dist);
+    }
+    vmaf_subsampler_close(vmaf->subsampler);
+    vmaf_scaler_close(vmaf->scaler);
+    free(vmaf->repeat.pic);
     feature_extractor_vector_destroy(&(vmaf->registered_feature_extractors));
     vmaf_feature_collector_destroy(vmaf->feature_collector);
     vmaf_thread_pool_destroy(vmaf->thread_pool);
     vmaf_fex_ctx_pool_destroy(vmaf->fex_ctx_pool);
+    pthread_cond_destroy(&vmaf->in_flight.done);
+    pthread_mutex_destroy(&vmaf->in_flight.lock);
+    free(vmaf->in_flight.pic);
     free(vmaf);
 
-    return 0;
+    return err;
 }
 
 int vmaf_import_feature_score(VmafContext *vmaf, char *feature_name,
@@ -139,10 +232,16 @@ int vmaf_use_feature(VmafContext *vmaf, const char *feature_name)
     return err;
 }
 
+static unsigned preview_factor(VmafContext *vmaf)
+{
+    return vmaf->cfg.preview > 1 ? vmaf->cfg.preview : 0;
+}
+
 int vmaf_use_features_from_model(VmafContext *vmaf, VmafModel *model)
 {
     if (!vmaf) return -EINVAL;
     if (!model) return -EINVAL;
+    if (model->preview != preview_factor(vmaf)) return -EINVAL;
 
     int err = 0;
 
@@ -165,12 +264,276 @@ int vmaf_use_features_from_model(VmafContext *vmaf, VmafModel *model)
     return 0;
 }
 
+int vmaf_use_reference_cache(VmafContext *vmaf, const char *path)
+{
+    if (!vmaf) return -EINVAL;
+    if (!path) return -EINVAL;
+    if (vmaf->ref_cache) return -EINVAL;
+    if (vmaf->pic_cnt) return -EINVAL;
+
+    int err = vmaf_ref_cache_open(&vmaf->ref_cache, path);
+    if (err) return err;
+
+    RegisteredFeatureExtractors rfe = vmaf->registered_feature_extractors;
+    for (unsigned i = 0; i < rfe.cnt; i++) {
+        VmafFeatureExtractorContext *fex_ctx = rfe.fex_ctx[i];
+        if (!(fex_ctx->fex->flags & VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY))
+            continue;
+        err = vmaf_ref_cache_attach(vmaf->ref_cache, fex_ctx);
+        if (err) return err;
+    }
+    return 0;
+}
+
+static bool ref_cached(VmafContext *vmaf, VmafFeatureExtractor *fex)
+{
+    return vmaf->ref_cache &&
+           (fex->flags & VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY);
+}
+
+/* false for the pictures read just outside of the segment */
+static bool in_segment(VmafContext *vmaf, unsigned index)
+{
+    return !vmaf->segment.high ||
+           ((index >= vmaf->segment.low) && (index < vmaf->segment.high));
+}
+
+static bool index_skipped(VmafContext *vmaf, unsigned index)
+{
+    if (vmaf->subsampler) {
+        if (vmaf_subsampler_skipped(vmaf->subsampler, index))
+            return true;
+    } else if ((vmaf->cfg.n_subsample > 1) &&
+               (index % vmaf->cfg.n_subsample))
+    {
+        return true;
+    }
+    return !in_segment(vmaf, index);
+}
+
+/*
+ * Whether a temporal feature extractor needs picture `index`, because it is
+ * within the declared window of a picture which is scored. Adaptive
+ * subsampling selects pictures only as they are read, so it feeds every
+ * picture.
+ */
+static bool in_window(VmafContext *vmaf, VmafFeatureExtractor *fex,
+                      unsigned index)
+{
+    if (vmaf->subsampler || vmaf->cfg.n_subsample < 2)
+        return true;
+    if (!fex->window.past && !fex->window.future)
+        return true;
+
+    const unsigned low = index > fex->window.future ?
+                         index - fex->window.future : 0;
+    for (unsigned i = low; i <= index + fex->window.past; i++) {
+        if (!index_skipped(vmaf, i))
+            return true;
+    }
+    return false;
+}
+
+typedef struct {
+    bool identical; ///< Distorted picture is identical to the reference.
+    bool repeat; ///< Picture pair is identical to the last extracted pair.
+    bool late; ///< Extracted after the next pair, see `select_pictures()`.
+} PictureMatch;
+
+static bool skip_extraction(VmafContext *vmaf, VmafFeatureExtractor *fex,
+                            unsigned index, PictureMatch *match)
+{
+    // handled by the reference cache
+    if (ref_cached(vmaf, fex))
+        return true;
+    if (fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL)
+        return match->late || !in_window(vmaf, fex, index);
+    return index_skipped(vmaf, index);
+}
+
+static bool repeatable(VmafFeatureExtractor *fex)
+{
+    return !(fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL) &&
+           fex->provided_features;
+}
+
+/*
+ * Static slates and black or repeated frames do not need a full extraction.
+ * A picture pair which repeats the last extracted pair gets a copy of its
+ * scores, see `copy_repeats()`, and a distorted picture which is identical
+ * to the reference gets the closed-form scores. Temporal feature extractors
+ * always run, their state depends on every picture.
+ */
+static int match_pictures(VmafContext *vmaf, VmafPicture *ref,
+                          VmafPicture *dist, unsigned index, bool late,
+                          PictureMatch *match)
+{
+    memset(match, 0, sizeof(*match));
+    match->late = late;
+    if (index_skipped(vmaf, index))
+        return 0;
+
+    RegisteredFeatureExtractors rfe = vmaf->registered_feature_extractors;
+    bool fast_path = false;
+    for (unsigned i = 0; i < rfe.cnt; i++)
+        fast_path |= repeatable(rfe.fex_ctx[i]->fex);
+    if (!fast_path)
+        return 0;
+
+    if (vmaf->last.valid && vmaf_picture_equal(ref, &vmaf->last.ref) &&
+        vmaf_picture_equal(dist, &vmaf->last.dist))
+    {
+        if (vmaf->repeat.cnt == vmaf->repeat.capacity) {
+            const unsigned capacity =
+                vmaf->repeat.capacity ? vmaf->repeat.capacity * 2 : 64;
+            void *pic = realloc(vmaf->repeat.pic,
+                                sizeof(*vmaf->repeat.pic) * capacity);
+            if (!pic) return -ENOMEM;
+            vmaf->repeat.pic = pic;
+            vmaf->repeat.capacity = capacity;
+        }
+        vmaf->repeat.pic[vmaf->repeat.cnt].index = index;
+        vmaf->repeat.pic[vmaf->repeat.cnt++].source = vmaf->last.source;
+        match->repeat = true;
+        return 0;
+    }
+
+    match->identical = vmaf_picture_equal(ref, dist);
+    if (vmaf->last.valid) {
+        vmaf_picture_unref(&vmaf->last.ref);
+        vmaf_picture_unref(&vmaf->last.dist);
+    }
+    vmaf_picture_ref(&vmaf->last.ref, ref);
+    vmaf_picture_ref(&vmaf->last.dist, dist);
+    vmaf->last.source = index;
+    vmaf->last.valid = true;
+    return 0;
+}
+
+/* returns 1 if the scores are written without an extraction */
+static int extract_fast_path(VmafContext *vmaf,
+                             VmafFeatureExtractorContext *fex_ctx,
+                             PictureMatch *match, VmafPicture *ref,
+                             unsigned index)
+{
+    VmafFeatureExtractor *fex = fex_ctx->fex;
+    if (fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL)
+        return 0;
+    if (match->repeat && repeatable(fex))
+        return 1;
+    if (match->identical && fex->extract_identical) {
+        VmafFeatureCollector *fc = vmaf->feature_collector;
+        int err = vmaf_feature_extractor_context_extract_identical(fex_ctx, ref,
+                                                                   index, fc);
+        return err ? err : 1;
+    }
+    return 0;
+}
+
+/* copy the scores of repeated pictures once their source is extracted */
+static int copy_repeats(VmafContext *vmaf)
+{
+    RegisteredFeatureExtractors rfe = vmaf->registered_feature_extractors;
+    for (unsigned i = 0; i < vmaf->repeat.cnt; i++) {
+        const unsigned index = vmaf->repeat.pic[i].index;
+        const unsigned source = vmaf->repeat.pic[i].source;
+        for (unsigned j = 0; j < rfe.cnt; j++) {
+            VmafFeatureExtractor *fex = rfe.fex_ctx[j]->fex;
+            if (!repeatable(fex))
+                continue;
+            for (unsigned k = 0; fex->provided_features[k]; k++) {
+                char *name = (char *) fex->provided_features[k];
+                double score;
+                if (vmaf_feature_collector_get_score(vmaf->feature_collector,
+                                                     name, &score, source))
+                {
+                    continue;
+                }
+                int err = vmaf_feature_collector_append(vmaf->feature_collector,
+                                                        name, score, index);
+                if (err) return err;
+            }
+        }
+    }
+    vmaf->repeat.cnt = 0;
+    return 0;
+}
+
+/* the slot of `index`, or -1, with `f->lock` held */
+static int in_flight_find(InFlight *f, unsigned index)
+{
+    for (unsigned i = 0; i < f->cnt; i++) {
+        if (f->pic[i].index == index)
+            return i;
+    }
+    return -1;
+}
+
+static int in_flight_add(InFlight *f, unsigned index)
+{
+    int err = 0;
+    pthread_mutex_lock(&f->lock);
+    int i = in_flight_find(f, index);
+    if (i < 0 && f->cnt == f->capacity) {
+        const unsigned capacity = f->capacity ? f->capacity * 2 : 8;
+        void *pic = realloc(f->pic, sizeof(*f->pic) * capacity);
+        if (!pic) {
+            err = -ENOMEM;
+            goto unlock;
+        }
+        f->pic = pic;
+        f->capacity = capacity;
+    }
+    if (i < 0) {
+        i = f->cnt++;
+        f->pic[i].index = index;
+        f->pic[i].jobs = 0;
+    }
+    f->pic[i].jobs++;
+unlock:
+    pthread_mutex_unlock(&f->lock);
+    return err;
+}
+
+static void in_flight_release(InFlight *f, unsigned index)
+{
+    pthread_mutex_lock(&f->lock);
+    const int i = in_flight_find(f, index);
+    if (i >= 0 && !--f->pic[i].jobs) {
+        f->pic[i] = f->pic[--f->cnt];
+        pthread_cond_broadcast(&f->done);
+    }
+    pthread_mutex_unlock(&f->lock);
+}
+
+/* wait until fewer than `max_in_flight` pairs are in flight */
+static int in_flight_wait_slot(VmafContext *vmaf, unsigned flags)
+{
+    InFlight *f = &vmaf->in_flight;
+    const unsigned max = vmaf->cfg.max_in_flight;
+    if (!max || !vmaf->thread_pool)
+        return 0;
+
+    int err = 0;
+    pthread_mutex_lock(&f->lock);
+    while (f->cnt >= max) {
+        if (flags & VMAF_SUBMIT_NONBLOCK) {
+            err = -EAGAIN;
+            break;
+        }
+        pthread_cond_wait(&f->done, &f->lock);
+    }
+    pthread_mutex_unlock(&f->lock);
+    return err;
+}
+
 struct ThreadData {
     VmafFeatureExtractorContext *fex_ctx;
     VmafPicture ref, dist;
     unsigned index;
     VmafFeatureCollector *feature_collector;
     VmafFeatureExtractorContextPool *fex_ctx_pool;
+    InFlight *in_flight;
     int err;
 };
 
@@ -184,34 +547,57 @@ static void threaded_extract_func(void *e)
     f->err = vmaf_fex_ctx_pool_release(f->fex_ctx_pool, f->fex_ctx);
     vmaf_picture_unref(&f->ref);
     vmaf_picture_unref(&f->dist);
+    // the pictures are released before the slot
+    in_flight_release(f->in_flight, f->index);
+}
+
+/* undo a job that could not be queued, its slot was never taken */
+static void discard_job(struct ThreadData *f)
+{
+    vmaf_fex_ctx_pool_release(f->fex_ctx_pool, f->fex_ctx);
+    vmaf_picture_unref(&f->ref);
+    vmaf_picture_unref(&f->dist);
 }
 
 static int threaded_read_pictures(VmafContext *vmaf, VmafPicture *ref,
-                                  VmafPicture *dist, unsigned index)
+                                  VmafPicture *dist, unsigned index,
+                                  PictureMatch *match)
 {
     if (!vmaf) return -EINVAL;
     if (!ref) return -EINVAL;
     if (!dist) return -EINVAL;
 
-    int err = 0;
+    // held while queueing, so that early jobs do not retire the pair
+    int err = in_flight_add(&vmaf->in_flight, index);
+    if (err) return err;
 
     for (unsigned i = 0; i < vmaf->registered_feature_extractors.cnt; i++) {
-        VmafPicture pic_a, pic_b;
-        vmaf_picture_ref(&pic_a, ref);
-        vmaf_picture_ref(&pic_b, dist);
-
-        VmafFeatureExtractor *fex =
-            vmaf->registered_feature_extractors.fex_ctx[i]->fex;
+        VmafFeatureExtractorContext *rfe_ctx =
+            vmaf->registered_feature_extractors.fex_ctx[i];
+        VmafFeatureExtractor *fex = rfe_ctx->fex;
 
-        if ((vmaf->cfg.n_subsample > 1) && (index % vmaf->cfg.n_subsample) &&
-            !(fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL))
-        {
+        if (skip_extraction(vmaf, fex, index, match))
+            continue;
+        err = extract_fast_path(vmaf, rfe_ctx, match, ref, index);
+        if (err < 0) goto release;
+        if (err) {
+            err = 0;
             continue;
         }
 
         VmafFeatureExtractorContext *fex_ctx;
+        VmafTraceSpan span;
+        vmaf_trace_begin(&span, "fex_ctx_pool", fex->name, index);
+        const uint64_t wait = vmaf_profile_wall();
         err = vmaf_fex_ctx_pool_aquire(vmaf->fex_ctx_pool, fex, &fex_ctx);
-        if (err) return err;
+        vmaf_trace_end(&span);
+        if (err) goto release;
+        vmaf->profile.pool_wait.wall += vmaf_profile_wall() - wait;
+        vmaf->profile.pool_wait.cnt++;
+
+        VmafPicture pic_a, pic_b;
+        vmaf_picture_ref(&pic_a, ref);
+        vmaf_picture_ref(&pic_b, dist);
 
         struct ThreadData data = {
             .fex_ctx = fex_ctx,
@@ -220,15 +606,48 @@ static int threaded_read_pictures(VmafContext *vmaf, VmafPicture *ref,
             .index = index,
             .feature_collector = vmaf->feature_collector,
             .fex_ctx_pool = vmaf->fex_ctx_pool,
+            .in_flight = &vmaf->in_flight,
             .err = 0,
         };
 
+        err = in_flight_add(&vmaf->in_flight, index);
+        if (err) {
+            discard_job(&data);
+            goto release;
+        }
         err = vmaf_thread_pool_enqueue(vmaf->thread_pool, threaded_extract_func,
                                        &data, sizeof(data));
-        if (err) return err;
+        if (err) {
+            in_flight_release(&vmaf->in_flight, index);
+            discard_job(&data);
+            goto release;
+        }
+
+        const unsigned depth = vmaf_thread_pool_queue_depth(vmaf->thread_pool);
+        if (depth > vmaf->profile.queue_depth.max)
+            vmaf->profile.queue_depth.max = depth;
+        vmaf->profile.queue_depth.sum += depth;
+        vmaf->profile.queue_depth.cnt++;
     }
 
+    in_flight_release(&vmaf->in_flight, index);
     return vmaf_picture_unref(ref) | vmaf_picture_unref(dist);
+
+release:
+    in_flight_release(&vmaf->in_flight, index);
+    vmaf_picture_unref(ref);
+    vmaf_picture_unref(dist);
+    return err;
+}
+
+static unsigned used_planes(VmafContext *vmaf)
+{
+    RegisteredFeatureExtractors rfe = vmaf->registered_feature_extractors;
+    for (unsigned i = 0; i < rfe.cnt; i++) {
+        if (rfe.fex_ctx[i]->fex->flags & VMAF_FEATURE_EXTRACTOR_CHROMA)
+            return VMAF_PLANES_ALL;
+    }
+    return VMAF_PLANE_Y;
 }
 
 static int validate_pic_params(VmafContext *vmaf, VmafPicture *ref,
@@ -241,109 +660,586 @@ static int validate_pic_params(VmafContext *vmaf, VmafPicture *ref,
         vmaf->pic_params.bpc = ref->bpc;
     }
 
-    if ((ref->w[0] != dist->w[0]) || (ref->w[0] != vmaf->pic_params.w))
+    // a distorted picture of another size is scaled to the reference
+    const bool scaled = vmaf->cfg.scale_filter;
+    if ((!scaled && ref->w[0] != dist->w[0]) ||
+        (ref->w[0] != vmaf->pic_params.w))
+    {
         return -EINVAL;
-    if ((ref->h[0] != dist->h[0]) || (ref->h[0] != vmaf->pic_params.h))
+    }
+    if ((!scaled && ref->h[0] != dist->h[0]) ||
+        (ref->h[0] != vmaf->pic_params.h))
+    {
         return -EINVAL;
+    }
     if ((ref->pix_fmt != dist->pix_fmt) ||
         (ref->pix_fmt != vmaf->pic_params.pix_fmt))
     {
         return -EINVAL;
     }
-    if ((ref->bpc != dist->bpc) && (ref->bpc != vmaf->pic_params.bpc))
+    if ((ref->bpc != dist->bpc) || (ref->bpc != vmaf->pic_params.bpc))
+        return -EINVAL;
+    if (ref->pix_fmt == VMAF_PIX_FMT_NV12 && ref->bpc != 8)
+        return -EINVAL;
+    if (ref->pix_fmt == VMAF_PIX_FMT_P010 && ref->bpc != 10)
         return -EINVAL;
 
+    const unsigned planes = used_planes(vmaf);
+    if ((vmaf_picture_planes(ref) & planes) != planes ||
+        (vmaf_picture_planes(dist) & planes) != planes)
+    {
+        return -EINVAL;
+    }
+
     return 0;
 }
 
-int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
-                       unsigned index)
+static int crop_picture(VmafContext *vmaf, VmafPicture *dst,
+                        VmafPicture *src)
 {
-    if (!vmaf) return -EINVAL;
-    if (!ref) return -EINVAL;
-    if (!dist) return -EINVAL;
+    const VmafActiveArea *area = &vmaf->crop.area;
+    int err = vmaf_picture_view(dst, src, area->x, area->y, area->w, area->h);
+    if (err) return err;
+    return vmaf_picture_unref(src);
+}
 
-    int err = 0;
+static int scale_picture(VmafContext *vmaf, VmafPicture *dst,
+                         VmafPicture *src, VmafPicture *ref)
+{
+    int err;
+    if (!vmaf->scaler) {
+        err = vmaf_scaler_init(&vmaf->scaler, vmaf->cfg.scale_filter,
+                               src->pix_fmt, src->w[0], src->h[0],
+                               ref->w[0], ref->h[0]);
+        if (err) return err;
+    }
+    err = vmaf_picture_alloc_planes(dst, src->pix_fmt, src->bpc, ref->w[0],
+                                    ref->h[0], vmaf_picture_planes(src));
+    if (err) return err;
+    err = vmaf_scaler_scale(vmaf->scaler, dst, src);
+    if (err) {
+        vmaf_picture_unref(dst);
+        return err;
+    }
+    return vmaf_picture_unref(src);
+}
 
-    vmaf->pic_cnt++;
-    err = validate_pic_params(vmaf, ref, dist);
+static int decimate_picture(VmafContext *vmaf, VmafPicture *dst,
+                            VmafPicture *src)
+{
+    const unsigned factor = preview_factor(vmaf);
+    int err = vmaf_picture_alloc_planes(dst, src->pix_fmt, src->bpc,
+                                        src->w[0] / factor, src->h[0] / factor,
+                                        vmaf_picture_planes(src));
     if (err) return err;
+    err = vmaf_preview_decimate(dst, src, factor);
+    if (err) {
+        vmaf_picture_unref(dst);
+        return err;
+    }
+    return vmaf_picture_unref(src);
+}
+
+static int extract_pictures(VmafContext *vmaf, VmafPicture *ref,
+                            VmafPicture *dist, unsigned index, bool late)
+{
+    PictureMatch match;
+    int err = match_pictures(vmaf, ref, dist, index, late, &match);
+    if (err) goto unref;
 
     if (vmaf->thread_pool)
-        return threaded_read_pictures(vmaf, ref, dist, index);
+        return threaded_read_pictures(vmaf, ref, dist, index, &match);
 
     for (unsigned i = 0; i < vmaf->registered_feature_extractors.cnt; i++) {
         VmafFeatureExtractorContext *fex_ctx =
             vmaf->registered_feature_extractors.fex_ctx[i];
 
-        if ((vmaf->cfg.n_subsample > 1) && (index % vmaf->cfg.n_subsample) &&
-            !(fex_ctx->fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL))
-        {
+        if (skip_extraction(vmaf, fex_ctx->fex, index, &match))
             continue;
-        }
+        err = extract_fast_path(vmaf, fex_ctx, &match, ref, index);
+        if (err < 0) goto unref;
+        if (err) continue;
 
         err = vmaf_feature_extractor_context_extract(fex_ctx, ref, dist, index,
                                                      vmaf->feature_collector);
-        if (err) return err;
+        if (err) goto unref;
     }
 
-    err = vmaf_picture_unref(ref);
-    if (err) return err;
-    err = vmaf_picture_unref(dist);
+    err = copy_repeats(vmaf);
+
+unref:
+    // the pair is consumed on error as well
+    vmaf_picture_unref(ref);
+    vmaf_picture_unref(dist);
+    return err;
+}
+
+/*
+ * The picture before a scene cut is scored as well, so both sides of the
+ * cut are covered. The cut is only known once the next picture is read,
+ * so the last skipped pair is held and extracted late if needed, without
+ * the temporal extractors which have already moved on.
+ */
+static int extract_held(VmafContext *vmaf)
+{
+    vmaf->held.valid = false;
+    vmaf_subsampler_unskip(vmaf->subsampler, vmaf->held.index);
+    return extract_pictures(vmaf, &vmaf->held.ref, &vmaf->held.dist,
+                            vmaf->held.index, true);
+}
+
+static int select_pictures(VmafContext *vmaf, VmafPicture *ref,
+                           VmafPicture *dist, unsigned index)
+{
+    bool scored, cut;
+    int err = vmaf_subsampler_select(vmaf->subsampler, ref, dist, index,
+                                     &scored, &cut);
     if (err) return err;
 
+    if (vmaf->held.valid) {
+        if (cut && vmaf->held.index + 1 == index) {
+            err = extract_held(vmaf);
+            if (err) return err;
+        } else {
+            vmaf_picture_unref(&vmaf->held.ref);
+            vmaf_picture_unref(&vmaf->held.dist);
+            vmaf->held.valid = false;
+        }
+    }
+
+    if (!scored) {
+        vmaf_picture_ref(&vmaf->held.ref, ref);
+        vmaf_picture_ref(&vmaf->held.dist, dist);
+        vmaf->held.index = index;
+        vmaf->held.valid = true;
+    }
     return 0;
 }
 
-int vmaf_score_at_index(VmafContext *vmaf, VmafModel *model, double *score,
-                        unsigned index)
+int vmaf_submit_pictures(VmafContext *vmaf, VmafPicture *ref,
+                         VmafPicture *dist, unsigned index, unsigned flags)
 {
     if (!vmaf) return -EINVAL;
-    if (!score) return -EINVAL;
+    if (!ref) return -EINVAL;
+    if (!dist) return -EINVAL;
 
-    return vmaf_predict_score_at_index(model, vmaf->feature_collector, index,
-                                       score);
+    // nothing is taken over until there is a slot
+    int err = in_flight_wait_slot(vmaf, flags);
+    if (err) return err;
+
+    err = validate_pic_params(vmaf, ref, dist);
+    if (err) goto unref;
+
+    // the segment overlap is counted by the neighbouring segments
+    const bool counted = in_segment(vmaf, index);
+    vmaf->pic_cnt += counted;
+
+    /*
+     * Each step below consumes its input on success only, `ref` and `dist`
+     * always point to the pictures still held, released on error.
+     */
+
+    // from here on the distorted picture is extracted at the reference size
+    VmafPicture dist_scaled;
+    if (dist->w[0] != ref->w[0] || dist->h[0] != ref->h[0]) {
+        err = scale_picture(vmaf, &dist_scaled, dist, ref);
+        if (err) goto unref;
+        dist = &dist_scaled;
+    }
+
+    // from here on the active area is extracted in place of the input
+    VmafPicture ref_crop, dist_crop;
+    if (vmaf->crop.area.w) {
+        if (counted && vmaf_crop_exposed(ref, &vmaf->crop.area))
+            vmaf->crop.exposed++;
+        err = crop_picture(vmaf, &ref_crop, ref);
+        if (err) goto unref;
+        ref = &ref_crop;
+        err = crop_picture(vmaf, &dist_crop, dist);
+        if (err) goto unref;
+        dist = &dist_crop;
+    }
+
+    // from here on the decimated pair is extracted in place of the input
+    VmafPicture ref_preview, dist_preview;
+    if (preview_factor(vmaf)) {
+        err = decimate_picture(vmaf, &ref_preview, ref);
+        if (err) goto unref;
+        ref = &ref_preview;
+        err = decimate_picture(vmaf, &dist_preview, dist);
+        if (err) goto unref;
+        dist = &dist_preview;
+    }
+
+    if (vmaf->ref_cache) {
+        err = vmaf_ref_cache_extract(vmaf->ref_cache, ref, dist, index,
+                                     vmaf->feature_collector);
+        if (err) goto unref;
+    }
+
+    if (vmaf->subsampler) {
+        err = select_pictures(vmaf, ref, dist, index);
+        if (err) goto unref;
+    }
+
+    return extract_pictures(vmaf, ref, dist, index, false);
+
+unref:
+    vmaf_picture_unref(ref);
+    vmaf_picture_unref(dist);
+    return err;
 }
 
-int vmaf_score_pooled(VmafContext *vmaf, VmafModel *model,
-                      enum VmafPoolingMethod pool_method, double *score,
-                      unsigned index_low, unsigned index_high)
+int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
+                       unsigned index)
+{
+    return vmaf_submit_pictures(vmaf, ref, dist, index, 0);
+}
+
+int vmaf_poll_pictures(VmafContext *vmaf, unsigned index)
 {
     if (!vmaf) return -EINVAL;
-    if (!score) return -EINVAL;
-    if (index_low >= index_high) return -EINVAL;
-    if (!pool_method) return -EINVAL;
 
+    InFlight *f = &vmaf->in_flight;
+    pthread_mutex_lock(&f->lock);
+    const int pending = in_flight_find(f, index) >= 0;
+    pthread_mutex_unlock(&f->lock);
+    return pending;
+}
+
+int vmaf_wait_pictures(VmafContext *vmaf, unsigned index)
+{
+    if (!vmaf) return -EINVAL;
+
+    InFlight *f = &vmaf->in_flight;
+    pthread_mutex_lock(&f->lock);
+    while (in_flight_find(f, index) >= 0)
+        pthread_cond_wait(&f->done, &f->lock);
+    pthread_mutex_unlock(&f->lock);
+    return 0;
+}
+
+static void flush_context(VmafContext *vmaf)
+{
+    // the last picture is always scored
+    if (vmaf->held.valid)
+        extract_held(vmaf);
     vmaf_thread_pool_wait(vmaf->thread_pool);
+    if (vmaf->ref_cache)
+        vmaf_ref_cache_flush(vmaf->ref_cache, vmaf->feature_collector);
     RegisteredFeatureExtractors rfe = vmaf->registered_feature_extractors;
     for (unsigned i = 0; i < rfe.cnt; i++) {
+        if (ref_cached(vmaf, rfe.fex_ctx[i]->fex))
+            continue;
         vmaf_feature_extractor_context_flush(rfe.fex_ctx[i],
                                              vmaf->feature_collector);
     }
     vmaf_fex_ctx_pool_flush(vmaf->fex_ctx_pool, vmaf->feature_collector);
+    copy_repeats(vmaf);
+}
+
+static void extractor_profile(VmafContext *vmaf, VmafFeatureExtractor *fex,
+                              VmafProfileCounter *profile)
+{
+    memset(profile, 0, sizeof(*profile));
+    RegisteredFeatureExtractors rfe = vmaf->registered_feature_extractors;
+    for (unsigned i = 0; i < rfe.cnt; i++) {
+        if (!strcmp(rfe.fex_ctx[i]->fex->name, fex->name))
+            vmaf_profile_counter_add(profile, &rfe.fex_ctx[i]->profile);
+    }
+    if (vmaf->fex_ctx_pool)
+        vmaf_fex_ctx_pool_profile(vmaf->fex_ctx_pool, fex, profile);
+}
+
+static void profile_timer(const VmafProfileCounter *counter,
+                          VmafProfileTimer *timer)
+{
+    timer->cnt = counter->cnt;
+    timer->wall = counter->wall / 1e9;
+    timer->cpu = counter->cpu / 1e9;
+}
+
+int vmaf_get_profile(VmafContext *vmaf, VmafProfile *profile)
+{
+    if (!vmaf) return -EINVAL;
+    if (!profile) return -EINVAL;
+
+    flush_context(vmaf);
+    memset(profile, 0, sizeof(*profile));
+
+    VmafFeatureCollector *fc = vmaf->feature_collector;
+    pthread_mutex_lock(&(fc->lock));
+    profile->wall = (fc->timer.end - fc->timer.begin) / 1e9;
+    profile_timer(&fc->lock_wait, &profile->collector_wait);
+    pthread_mutex_unlock(&(fc->lock));
+    if (profile->wall > 0.)
+        profile->fps = vmaf->pic_cnt / profile->wall;
+
+    profile_timer(&vmaf->profile.pool_wait, &profile->pool_wait);
+    profile->queue_depth.max = vmaf->profile.queue_depth.max;
+    if (vmaf->profile.queue_depth.cnt) {
+        profile->queue_depth.mean = (double) vmaf->profile.queue_depth.sum /
+                                    vmaf->profile.queue_depth.cnt;
+    }
+    profile->n_extractors = vmaf->registered_feature_extractors.cnt;
+    return 0;
+}
+
+int vmaf_get_extractor_profile(VmafContext *vmaf, unsigned index,
+                               VmafProfileTimer *timer)
+{
+    if (!vmaf) return -EINVAL;
+    if (!timer) return -EINVAL;
+    if (index >= vmaf->registered_feature_extractors.cnt) return -EINVAL;
+
+    vmaf_thread_pool_wait(vmaf->thread_pool);
+    VmafFeatureExtractor *fex =
+        vmaf->registered_feature_extractors.fex_ctx[index]->fex;
+    VmafProfileCounter profile;
+    extractor_profile(vmaf, fex, &profile);
+    profile_timer(&profile, timer);
+    timer->name = fex->name;
+    return 0;
+}
+
+int vmaf_set_segment(VmafContext *vmaf, unsigned index_low,
+                     unsigned index_high)
+{
+    if (!vmaf) return -EINVAL;
+    if (index_low >= index_high) return -EINVAL;
+    if (vmaf->pic_cnt) return -EINVAL;
+
+    vmaf->segment.low = index_low;
+    vmaf->segment.high = index_high;
+    return 0;
+}
+
+int vmaf_set_active_area(VmafContext *vmaf, VmafActiveArea area)
+{
+    if (!vmaf) return -EINVAL;
+    if (!area.w || !area.h) return -EINVAL;
+    if ((area.x | area.y | area.w | area.h) & 1) return -EINVAL;
+    if (vmaf->pic_cnt) return -EINVAL;
+
+    vmaf->crop.area = area;
+    return 0;
+}
+
+int vmaf_get_active_area(VmafContext *vmaf, VmafActiveArea *area,
+                         unsigned *exposed)
+{
+    if (!vmaf) return -EINVAL;
+    if (!area) return -EINVAL;
+
+    *area = vmaf->crop.area;
+    if (exposed)
+        *exposed = vmaf->crop.exposed;
+    return 0;
+}
+
+int vmaf_get_planes(VmafContext *vmaf, unsigned *planes)
+{
+    if (!vmaf) return -EINVAL;
+    if (!planes) return -EINVAL;
+
+    *planes = used_planes(vmaf);
+    return 0;
+}
+
+int vmaf_merge_segment(VmafContext *vmaf, VmafContext *segment)
+{
+    if (!vmaf) return -EINVAL;
+    if (!segment) return -EINVAL;
+
+    flush_context(segment);
+
+    const unsigned low = segment->segment.low;
+    const unsigned high = segment->segment.high ? segment->segment.high :
+                                                  UINT_MAX;
+    int err = vmaf_feature_collector_merge(vmaf->feature_collector,
+                                           segment->feature_collector,
+                                           low, high);
+    if (err) return err;
+    if (vmaf->subsampler && segment->subsampler) {
+        err = vmaf_subsampler_merge(vmaf->subsampler, segment->subsampler,
+                                    low, high);
+        if (err) return err;
+    }
+
+    RegisteredFeatureExtractors rfe = vmaf->registered_feature_extractors;
+    for (unsigned i = 0; i < rfe.cnt; i++) {
+        VmafProfileCounter profile;
+        extractor_profile(segment, rfe.fex_ctx[i]->fex, &profile);
+        vmaf_profile_counter_add(&rfe.fex_ctx[i]->profile, &profile);
+    }
+    vmaf_profile_counter_add(&vmaf->profile.pool_wait,
+                             &segment->profile.pool_wait);
+    if (segment->profile.queue_depth.max > vmaf->profile.queue_depth.max)
+        vmaf->profile.queue_depth.max = segment->profile.queue_depth.max;
+    vmaf->profile.queue_depth.sum += segment->profile.queue_depth.sum;
+    vmaf->profile.queue_depth.cnt += segment->profile.queue_depth.cnt;
+
+    if (!vmaf->pic_params.w)
+        vmaf->pic_params = segment->pic_params;
+    vmaf->pic_cnt += segment->pic_cnt;
+    vmaf->crop.exposed += segment->crop.exposed;
+    return 0;
+}
+
+int vmaf_export_partial(VmafContext *vmaf, FILE *outfile)
+{
+    if (!vmaf) return -EINVAL;
+    if (!outfile) return -EINVAL;
+
+    flush_context(vmaf);
+
+    VmafPartialInfo info = {
+        .w = vmaf->pic_params.w,
+        .h = vmaf->pic_params.h,
+        .pix_fmt = vmaf->pic_params.pix_fmt,
+        .bpc = vmaf->pic_params.bpc,
+        .pic_cnt = vmaf->pic_cnt,
+        .index_low = vmaf->segment.low,
+        .index_high = vmaf->segment.high,
+    };
+    return vmaf_partial_write(vmaf->feature_collector, &info, outfile);
+}
+
+int vmaf_import_partial(VmafContext *vmaf, FILE *infile,
+                        unsigned *index_low, unsigned *index_high)
+{
+    if (!vmaf) return -EINVAL;
+    if (!infile) return -EINVAL;
+
+    VmafPartialInfo info;
+    int err = vmaf_partial_read_header(&info, infile);
+    if (err) return err;
+
+    const bool set = vmaf->pic_params.w;
+    if (set && info.w && ((info.w != vmaf->pic_params.w) ||
+                          (info.h != vmaf->pic_params.h) ||
+                          (info.pix_fmt != vmaf->pic_params.pix_fmt) ||
+                          (info.bpc != vmaf->pic_params.bpc)))
+    {
+        return -EINVAL;
+    }
+
+    err = vmaf_partial_read_scores(vmaf->feature_collector, &info, infile);
+    if (err) return err;
+
+    if (!set) {
+        vmaf->pic_params.w = info.w;
+        vmaf->pic_params.h = info.h;
+        vmaf->pic_params.pix_fmt = info.pix_fmt;
+        vmaf->pic_params.bpc = info.bpc;
+    }
+    vmaf->pic_cnt += info.pic_cnt;
+
+    if (index_low) *index_low = info.index_low;
+    if (index_high) *index_high = info.index_high;
+    return 0;
+}
+
+int vmaf_score_at_index(VmafContext *vmaf, VmafModel *model, double *score,
+                        unsigned index)
+{
+    if (!vmaf) return -EINVAL;
+    if (!score) return -EINVAL;
+    if (model && model->preview != preview_factor(vmaf)) return -EINVAL;
+
+    return vmaf_predict_score_at_index(model, vmaf->feature_collector, index,
+                                       score);
+}
+
+typedef struct {
+    double sum, i_sum, min;
+    unsigned cnt;
+} Pool;
+
+static void pool_add(Pool *pool, double score)
+{
+    if (!pool->cnt || (score < pool->min))
+        pool->min = score;
+    pool->sum += score;
+    pool->i_sum += 1. / (score + 1.);
+    pool->cnt++;
+}
+
+/*
+ * With adaptive subsampling the skipped pictures are pooled as well,
+ * interpolated linearly between their scored neighbours, so that long
+ * static stretches keep their weight. Each skipped picture may be off by
+ * up to half the difference of its neighbours, which sums to `error`.
+ */
+static int pool_scores(VmafContext *vmaf, VmafModel *model, Pool *pool,
+                       double *error, unsigned index_low, unsigned index_high)
+{
+    memset(pool, 0, sizeof(*pool));
+    *error = 0.;
+
+    const bool interpolate = !!vmaf->subsampler;
+    unsigned last = index_low;
+    double last_score = 0.;
+    bool scored = false;
 
-    double min, sum, i_sum = 0.;
     for (unsigned i = index_low; i < index_high; i++) {
-        if ((vmaf->cfg.n_subsample > 1) && (i % vmaf->cfg.n_subsample))
+        if (index_skipped(vmaf, i))
             continue;
         double vmaf_score;
         int err = vmaf_score_at_index(vmaf, model, &vmaf_score, i);
         if (err) return err;
-        sum += vmaf_score;
-        i_sum += 1. / (vmaf_score + 1.);
-        if ((i == index_low) || (min < vmaf_score))
-            min = vmaf_score;
+
+        if (interpolate) {
+            // before the first scored picture, the first score is held
+            const unsigned from = scored ? last + 1 : index_low;
+            for (unsigned j = from; j < i; j++) {
+                const double t = scored ? (double) (j - last) / (i - last) : 1.;
+                pool_add(pool, last_score + t * (vmaf_score - last_score));
+            }
+            if (scored)
+                *error += (i - from) * fabs(vmaf_score - last_score) / 2.;
+        }
+
+        pool_add(pool, vmaf_score);
+        last = i;
+        last_score = vmaf_score;
+        scored = true;
     }
 
+    if (!scored) return -EINVAL;
+    // after the last scored picture, the last score is held
+    for (unsigned j = last + 1; interpolate && j < index_high; j++)
+        pool_add(pool, last_score);
+
+    *error /= pool->cnt;
+    return 0;
+}
+
+int vmaf_score_pooled(VmafContext *vmaf, VmafModel *model,
+                      enum VmafPoolingMethod pool_method, double *score,
+                      unsigned index_low, unsigned index_high)
+{
+    if (!vmaf) return -EINVAL;
+    if (!score) return -EINVAL;
+    if (index_low >= index_high) return -EINVAL;
+    if (!pool_method) return -EINVAL;
+
+    flush_context(vmaf);
+
+    Pool pool;
+    double error;
+    int err = pool_scores(vmaf, model, &pool, &error, index_low, index_high);
+    if (err) return err;
+
     switch (pool_method) {
     case VMAF_POOL_METHOD_MEAN:
-        *score = sum / (index_high - index_low);
+        *score = pool.sum / pool.cnt;
         break;
     case VMAF_POOL_METHOD_MIN:
-        *score = min;
+        *score = pool.min;
         break;
     case VMAF_POOL_METHOD_HARMONIC_MEAN:
-        *score = (index_high - index_low) / i_sum - 1.0;
+        *score = pool.cnt / pool.i_sum - 1.0;
         break;
     default:
         return -EINVAL;
@@ -352,6 +1248,27 @@ int vmaf_score_pooled(VmafContext *vmaf, VmafModel *model,
     return 0;
 }
 
+int vmaf_subsample_report(VmafContext *vmaf, VmafModel *model,
+                          VmafSubsampleReport *report,
+                          unsigned index_low, unsigned index_high)
+{
+    if (!vmaf) return -EINVAL;
+    if (!report) return -EINVAL;
+    if (index_low >= index_high) return -EINVAL;
+    if (!vmaf->subsampler) return -EINVAL;
+
+    flush_context(vmaf);
+
+    memset(report, 0, sizeof(*report));
+    for (unsigned i = index_low; i < index_high; i++)
+        report->scored += !index_skipped(vmaf, i);
+    report->pictures = index_high - index_low;
+
+    Pool pool;
+    return pool_scores(vmaf, model, &pool, &report->error,
+                       index_low, index_high);
+}
+
 const char *vmaf_version(void)
 {
     return "RELEASE_CANDIDATE";
@@ -360,30 +1277,49 @@ const char *vmaf_version(void)
 int vmaf_write_output(VmafContext *vmaf, FILE *outfile,
                       enum VmafOutputFormat fmt)
 {
-    vmaf_thread_pool_wait(vmaf->thread_pool);
-    RegisteredFeatureExtractors rfe = vmaf->registered_feature_extractors;
-    for (unsigned i = 0; i < rfe.cnt; i++) {
-        vmaf_feature_extractor_context_flush(rfe.fex_ctx[i],
-                                             vmaf->feature_collector);
+    VmafProfile profile;
+    int err = vmaf_get_profile(vmaf, &profile);
+    if (err) return err;
+
+    VmafProfileTimer *extractor = NULL;
+    if (profile.n_extractors) {
+        extractor = malloc(sizeof(*extractor) * profile.n_extractors);
+        if (!extractor) return -ENOMEM;
+    }
+    for (unsigned i = 0; i < profile.n_extractors; i++)
+        vmaf_get_extractor_profile(vmaf, i, &extractor[i]);
+
+    VmafOutputSampling sampling = { .subsample = vmaf->cfg.n_subsample };
+    if (vmaf->subsampler) {
+        sampling.skipped = vmaf_subsampler_skip_map(vmaf->subsampler,
+                                                    &sampling.cnt);
     }
-    vmaf_fex_ctx_pool_flush(vmaf->fex_ctx_pool, vmaf->feature_collector);
-    const double fps = vmaf->pic_cnt /
-                ((double) (vmaf->feature_collector->timer.end -
-                vmaf->feature_collector->timer.begin) / CLOCKS_PER_SEC);
 
     switch (fmt) {
     case VMAF_OUTPUT_FORMAT_XML:
-        return vmaf_write_output_xml(vmaf->feature_collector, outfile,
-                                     vmaf->cfg.n_subsample,
-                                     vmaf->pic_params.w, vmaf->pic_params.h,
-                                     fps);
+        err = vmaf_write_output_xml(vmaf->feature_collector, outfile,
+                                    &sampling,
+                                    vmaf->pic_params.w, vmaf->pic_params.h,
+                                    &profile, extractor);
+        break;
     case VMAF_OUTPUT_FORMAT_JSON:
-        return vmaf_write_output_json(vmaf->feature_collector, outfile,
-                                      vmaf->cfg.n_subsample);
+        err = vmaf_write_output_json(vmaf->feature_collector, outfile,
+                                     &sampling,
+                                     &profile, extractor);
+        break;
     case VMAF_OUTPUT_FORMAT_CSV:
-        return vmaf_write_output_csv(vmaf->feature_collector, outfile,
-                                     vmaf->cfg.n_subsample);
+        err = vmaf_write_output_csv(vmaf->feature_collector, outfile,
+                                    &sampling);
+        break;
+    case VMAF_OUTPUT_FORMAT_BIN:
+        err = vmaf_write_output_bin(vmaf->feature_collector, outfile,
+                                    &sampling, vmaf->pic_params.w,
+                                    vmaf->pic_params.h);
+        break;
     default:
-        return 0;
+        break;
     }
+
+    free(extractor);
+    return err;
 }
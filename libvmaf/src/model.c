@@ -4,20 +4,31 @@
 
 #include <libvmaf/model.h>
 
+#include "feature/alias.h"
 #include "model.h"
+#include "preview.h"
 #include "svm.h"
 #include "unpickle.h"
 
+static unsigned preview_factor(enum VmafModelFlags flags)
+{
+    if (flags & VMAF_MODEL_FLAG_PREVIEW_2X)
+        return 2;
+    return 0;
+}
+
 char *generate_model_name(VmafModelConfig *cfg) {
 
     char *clip_phrase = "_clip_disabled";
     char *transform_phrase = "_score_transform_enabled";
+    char *preview_phrase = "_preview_2x";
     size_t name_sz;
     char *name;
 
     if (!cfg->name) {
         name_sz = strlen(cfg->path) + strlen(clip_phrase) +
-            strlen(transform_phrase) + 1 * sizeof(char);
+            strlen(transform_phrase) + strlen(preview_phrase) +
+            1 * sizeof(char);
     } else {
         name_sz = strlen(cfg->name) + 1 * sizeof(char);
     }
@@ -37,6 +48,9 @@ char *generate_model_name(VmafModelConfig *cfg) {
         if (cfg->flags && (cfg->flags & VMAF_MODEL_FLAG_ENABLE_TRANSFORM)) {
             strncat(name, transform_phrase, strlen(transform_phrase));
         }
+        if (cfg->flags && preview_factor(cfg->flags)) {
+            strcat(name, preview_phrase);
+        }
     } else {
         strcpy(name, cfg->name);
     }
@@ -45,6 +59,28 @@ char *generate_model_name(VmafModelConfig *cfg) {
 
 }
 
+/*
+ * Features are linearly rescaled before prediction, composing the preview
+ * correction into the rescale keeps prediction unchanged.
+ */
+static int preview_correct(VmafModel *model, unsigned factor)
+{
+    if (model->norm_type != VMAF_MODEL_NORMALIZATION_TYPE_LINEAR_RESCALE)
+        return -EINVAL;
+
+    for (unsigned i = 0; i < model->n_features; i++) {
+        VmafModelFeature *f = &model->feature[i];
+        const VmafPreviewCorrection *c =
+            vmaf_preview_correction(vmaf_feature_name_alias(f->name), factor);
+        if (!c) continue;
+        f->intercept += f->slope * c->intercept;
+        f->slope *= c->slope;
+    }
+    model->preview = factor;
+
+    return 0;
+}
+
 int vmaf_model_load_from_path(VmafModel **model, VmafModelConfig *cfg)
 {
     VmafModel *const m = *model = malloc(sizeof(*m));
@@ -73,8 +109,17 @@ int vmaf_model_load_from_path(VmafModel **model, VmafModelConfig *cfg)
     if (!m->svm) goto free_name;
     int err = vmaf_unpickle_model(m, m->path, cfg->flags);
     if (err) goto free_svm;
+    if (preview_factor(cfg->flags)) {
+        err = preview_correct(m, preview_factor(cfg->flags));
+        if (err) goto free_features;
+    }
     return 0;
 
+free_features:
+    for (unsigned i = 0; i < m->n_features; i++)
+        free(m->feature[i].name);
+    free(m->feature);
+
 free_svm:
     svm_free_and_destroy_model(&(m->svm));
 free_name:
@@ -98,3 +143,13 @@ void vmaf_model_destroy(VmafModel *model)
     free(model->feature);
     free(model);
 }
+
+int vmaf_model_preview_error(VmafModel *model, double *error)
+{
+    if (!model) return -EINVAL;
+    if (!error) return -EINVAL;
+    if (!model->preview) return -EINVAL;
+
+    *error = vmaf_preview_expected_error(model->preview);
+    return 0;
+}
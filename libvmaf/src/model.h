@@ -60,6 +60,7 @@ typedef struct VmafModel {
         bool out_lte_in, out_gte_in;
     } score_transform;
     struct svm_model *svm;
+    unsigned preview; ///< Decimation factor of preview input, 0 otherwise.
 } VmafModel;
 
 #endif /* __VMAF_SRC_MODEL_H__ */
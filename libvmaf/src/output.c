@@ -17,13 +17,112 @@
  */
 
 #include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "feature/alias.h"
 #include "feature/feature_collector.h"
+#include "output.h"
 
 #include <libvmaf/libvmaf.rc.h>
 
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+
+typedef struct {
+    FILE *file;
+    char *buf;
+    size_t len;
+    int err;
+} OutputBuffer;
+
+static int output_buffer_init(OutputBuffer *ob, FILE *file)
+{
+    ob->file = file;
+    ob->len = 0;
+    ob->err = 0;
+    ob->buf = malloc(OUTPUT_BUFFER_SIZE);
+    return ob->buf ? 0 : -ENOMEM;
+}
+
+static void output_buffer_flush(OutputBuffer *ob)
+{
+    if (ob->len && fwrite(ob->buf, ob->len, 1, ob->file) != 1)
+        ob->err = -EIO;
+    ob->len = 0;
+}
+
+static int output_buffer_close(OutputBuffer *ob)
+{
+    output_buffer_flush(ob);
+    free(ob->buf);
+    return ob->err;
+}
+
+static void output_buffer_write(OutputBuffer *ob, const void *data, size_t n)
+{
+    if (n > OUTPUT_BUFFER_SIZE - ob->len)
+        output_buffer_flush(ob);
+    if (n > OUTPUT_BUFFER_SIZE) {
+        if (fwrite(data, n, 1, ob->file) != 1)
+            ob->err = -EIO;
+        return;
+    }
+    memcpy(ob->buf + ob->len, data, n);
+    ob->len += n;
+}
+
+static void output_buffer_puts(OutputBuffer *ob, const char *str)
+{
+    output_buffer_write(ob, str, strlen(str));
+}
+
+static void output_buffer_printf(OutputBuffer *ob, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(ob->buf + ob->len, OUTPUT_BUFFER_SIZE - ob->len,
+                      fmt, args);
+    va_end(args);
+    if (n < 0) {
+        ob->err = -EINVAL;
+        return;
+    }
+    if ((size_t)n < OUTPUT_BUFFER_SIZE - ob->len) {
+        ob->len += n;
+        return;
+    }
+
+    output_buffer_flush(ob);
+    va_start(args, fmt);
+    if ((size_t)n < OUTPUT_BUFFER_SIZE) {
+        ob->len = vsnprintf(ob->buf, OUTPUT_BUFFER_SIZE, fmt, args);
+    } else if (vfprintf(ob->file, fmt, args) < 0) {
+        ob->err = -EIO;
+    }
+    va_end(args);
+}
+
+static void output_buffer_u32(OutputBuffer *ob, uint32_t v)
+{
+    const uint8_t b[4] = { v, v >> 8, v >> 16, v >> 24 };
+    output_buffer_write(ob, b, sizeof(b));
+}
+
+static void output_buffer_f64(OutputBuffer *ob, double v)
+{
+    uint64_t u;
+    memcpy(&u, &v, sizeof(u));
+    uint8_t b[8];
+    for (unsigned i = 0; i < 8; i++)
+        b[i] = u >> (8 * i);
+    output_buffer_write(ob, b, sizeof(b));
+}
+
 static unsigned max_capacity(VmafFeatureCollector *fc)
 {
     unsigned capacity = 0;
@@ -36,132 +135,312 @@ static unsigned max_capacity(VmafFeatureCollector *fc)
     return capacity;
 }
 
-int vmaf_write_output_xml(VmafFeatureCollector *fc, FILE *outfile,
-                          unsigned subsample, unsigned width, unsigned height,
-                          double fps)
+static inline bool score_written(FeatureVector *fv, unsigned index)
 {
-    if (!fc) return -EINVAL;
-    if (!outfile) return -EINVAL;
+    return index < fv->capacity && fv->score[index].written;
+}
 
-    fprintf(outfile, "<VMAF version=\"%s\">\n", vmaf_version());
-    fprintf(outfile, "  <params qualityWidth=\"%d\" qualityHeight=\"%d\" />\n",
-            width, height);
-    fprintf(outfile, "  <fyi fps=\"%.2f\" />\n", fps);
+static unsigned sampling_step(const VmafOutputSampling *sampling)
+{
+    if (sampling->skipped)
+        return 1;
+    return sampling->subsample > 1 ? sampling->subsample : 1;
+}
 
-    fprintf(outfile, "  <frames>\n");
-    for (unsigned i = 0 ; i < max_capacity(fc); i++) {
-        if ((subsample > 1) && (i % subsample))
-            continue;
+static inline bool picture_skipped(const VmafOutputSampling *sampling,
+                                   unsigned index)
+{
+    return sampling->skipped && index < sampling->cnt &&
+           sampling->skipped[index];
+}
 
-        unsigned cnt = 0;
+/* pictures with any score, and those of them which were not skipped */
+static void count_pictures(VmafFeatureCollector *fc,
+                           const VmafOutputSampling *sampling,
+                           unsigned *scored, unsigned *pictures)
+{
+    const unsigned capacity = max_capacity(fc);
+    *scored = *pictures = 0;
+    for (unsigned i = 0; i < capacity; i++) {
         for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
+            if (!score_written(fc->feature_vector[j], i))
                 continue;
-            if (fc->feature_vector[j]->score[i].written)
-                cnt++;
+            (*pictures)++;
+            *scored += !picture_skipped(sampling, i);
+            break;
         }
-        if (!cnt) continue;
+    }
+}
+
+static const char **feature_names(VmafFeatureCollector *fc)
+{
+    const char **name = malloc(sizeof(*name) * (fc->cnt ? fc->cnt : 1));
+    if (!name) return NULL;
+    for (unsigned j = 0; j < fc->cnt; j++)
+        name[j] = vmaf_feature_name_alias(fc->feature_vector[j]->name);
+    return name;
+}
+
+static void write_profile_xml(OutputBuffer *ob, VmafProfile *profile,
+                              VmafProfileTimer *extractor)
+{
+    output_buffer_printf(ob, "  <profile wall=\"%.6f\" ", profile->wall);
+    output_buffer_printf(ob, "poolWait=\"%.6f\" ", profile->pool_wait.wall);
+    output_buffer_printf(ob, "collectorWait=\"%.6f\" ",
+                         profile->collector_wait.wall);
+    output_buffer_printf(ob, "queueDepthMax=\"%u\" ",
+                         profile->queue_depth.max);
+    output_buffer_printf(ob, "queueDepthMean=\"%.2f\">\n",
+                         profile->queue_depth.mean);
+    for (unsigned i = 0; i < profile->n_extractors; i++) {
+        output_buffer_printf(ob, "    <extractor name=\"%s\" calls=\"%llu\" "
+                             "wall=\"%.6f\" cpu=\"%.6f\" />\n",
+                             extractor[i].name, extractor[i].cnt,
+                             extractor[i].wall, extractor[i].cpu);
+    }
+    output_buffer_puts(ob, "  </profile>\n");
+}
 
-        fprintf(outfile, "    <frame frameNum=\"%d\" ", i);
+static void write_profile_json(OutputBuffer *ob, VmafProfile *profile,
+                               VmafProfileTimer *extractor)
+{
+    output_buffer_puts(ob, "  \"profile\": {\n");
+    output_buffer_printf(ob, "    \"wall\": %.6f,\n", profile->wall);
+    output_buffer_printf(ob, "    \"fps\": %.2f,\n", profile->fps);
+    output_buffer_printf(ob, "    \"poolWait\": %.6f,\n",
+                         profile->pool_wait.wall);
+    output_buffer_printf(ob, "    \"collectorWait\": %.6f,\n",
+                         profile->collector_wait.wall);
+    output_buffer_printf(ob, "    \"queueDepthMax\": %u,\n",
+                         profile->queue_depth.max);
+    output_buffer_printf(ob, "    \"queueDepthMean\": %.2f,\n",
+                         profile->queue_depth.mean);
+    output_buffer_puts(ob, "    \"extractors\": {");
+    for (unsigned i = 0; i < profile->n_extractors; i++) {
+        output_buffer_puts(ob, i > 0 ? ",\n" : "\n");
+        output_buffer_printf(ob, "      \"%s\": { \"calls\": %llu, "
+                             "\"wall\": %.6f, \"cpu\": %.6f }",
+                             extractor[i].name, extractor[i].cnt,
+                             extractor[i].wall, extractor[i].cpu);
+    }
+    output_buffer_puts(ob, "\n    }\n");
+    output_buffer_puts(ob, "  }\n");
+}
+
+int vmaf_write_output_xml(VmafFeatureCollector *fc, FILE *outfile,
+                          const VmafOutputSampling *sampling,
+                          unsigned width, unsigned height,
+                          VmafProfile *profile, VmafProfileTimer *extractor)
+{
+    if (!fc) return -EINVAL;
+    if (!outfile) return -EINVAL;
+    if (!sampling) return -EINVAL;
+
+    OutputBuffer ob;
+    const char **name = feature_names(fc);
+    if (!name || output_buffer_init(&ob, outfile)) {
+        free(name);
+        return -ENOMEM;
+    }
+    const unsigned capacity = max_capacity(fc);
+    const unsigned step = sampling_step(sampling);
+
+    output_buffer_printf(&ob, "<VMAF version=\"%s\">\n", vmaf_version());
+    output_buffer_printf(&ob, "  <params qualityWidth=\"%d\" "
+                         "qualityHeight=\"%d\" />\n", width, height);
+    if (sampling->skipped) {
+        unsigned scored, pictures;
+        count_pictures(fc, sampling, &scored, &pictures);
+        output_buffer_printf(&ob, "  <subsample mode=\"adaptive\" "
+                             "scored=\"%u\" pictures=\"%u\" />\n",
+                             scored, pictures);
+    }
+    output_buffer_printf(&ob, "  <fyi fps=\"%.2f\" />\n", profile->fps);
+    write_profile_xml(&ob, profile, extractor);
+
+    output_buffer_puts(&ob, "  <frames>\n");
+    for (unsigned i = 0; i < capacity; i += step) {
+        if (picture_skipped(sampling, i))
+            continue;
+        unsigned cnt = 0;
         for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
+            FeatureVector *fv = fc->feature_vector[j];
+            if (!score_written(fv, i))
                 continue;
-            if (!fc->feature_vector[j]->score[i].written)
-                continue;
-            fprintf(outfile, "%s=\"%.6f\" ",
-                vmaf_feature_name_alias(fc->feature_vector[j]->name),
-                fc->feature_vector[j]->score[i].value
-            );
+            if (!cnt++)
+                output_buffer_printf(&ob, "    <frame frameNum=\"%u\" ", i);
+            output_buffer_printf(&ob, "%s=\"%.6f\" ", name[j],
+                                 fv->score[i].value);
         }
-        fprintf(outfile, "/>\n");
+        if (cnt)
+            output_buffer_puts(&ob, "/>\n");
     }
-    fprintf(outfile, "  </frames>\n");
+    output_buffer_puts(&ob, "  </frames>\n");
 
-    fprintf(outfile, "</VMAF>\n");
+    output_buffer_puts(&ob, "</VMAF>\n");
 
-    return 0;
+    free(name);
+    return output_buffer_close(&ob);
 }
 
 int vmaf_write_output_json(VmafFeatureCollector *fc, FILE *outfile,
-                           unsigned subsample)
+                           const VmafOutputSampling *sampling,
+                           VmafProfile *profile, VmafProfileTimer *extractor)
 {
-    fprintf(outfile, "{\n");
-    fprintf(outfile, "  \"version\": \"%s\",\n", vmaf_version());
-    fprintf(outfile, "  \"frames\": [");
+    if (!fc) return -EINVAL;
+    if (!outfile) return -EINVAL;
+    if (!sampling) return -EINVAL;
 
-    for (unsigned i = 0 ; i < max_capacity(fc); i++) {
-        if ((subsample > 1) && (i % subsample))
-            continue;
+    OutputBuffer ob;
+    const char **name = feature_names(fc);
+    if (!name || output_buffer_init(&ob, outfile)) {
+        free(name);
+        return -ENOMEM;
+    }
+    const unsigned capacity = max_capacity(fc);
+    const unsigned step = sampling_step(sampling);
 
+    output_buffer_puts(&ob, "{\n");
+    output_buffer_printf(&ob, "  \"version\": \"%s\",\n", vmaf_version());
+    if (sampling->skipped) {
+        unsigned scored, pictures;
+        count_pictures(fc, sampling, &scored, &pictures);
+        output_buffer_printf(&ob, "  \"subsample\": { "
+                             "\"mode\": \"adaptive\", \"scored\": %u, "
+                             "\"pictures\": %u },\n", scored, pictures);
+    }
+    output_buffer_puts(&ob, "  \"frames\": [");
+
+    unsigned frame_cnt = 0;
+    for (unsigned i = 0; i < capacity; i += step) {
+        if (picture_skipped(sampling, i))
+            continue;
         unsigned cnt = 0;
         for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
+            FeatureVector *fv = fc->feature_vector[j];
+            if (!score_written(fv, i))
                 continue;
-            if (fc->feature_vector[j]->score[i].written)
-                cnt++;
+            if (!cnt++) {
+                output_buffer_puts(&ob, frame_cnt++ ? ",\n" : "\n");
+                output_buffer_puts(&ob, "    {\n");
+                output_buffer_printf(&ob, "      \"frameNum\": %u,\n", i);
+                output_buffer_puts(&ob, "      \"metrics\": {\n");
+            } else {
+                output_buffer_puts(&ob, ",\n");
+            }
+            output_buffer_printf(&ob, "        \"%s\": %.6f", name[j],
+                                 fv->score[i].value);
         }
-        if (!cnt) continue;
-        fprintf(outfile, "%s", i > 0 ? ",\n" : "\n");
-
-        fprintf(outfile, "    {\n");
-        fprintf(outfile, "      \"frameNum\": %d,\n", i);
-        fprintf(outfile, "      \"metrics\": {\n");
-
-        unsigned cnt2 = 0;
-        for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
-                continue;
-            if (!fc->feature_vector[j]->score[i].written)
-                continue;
-            cnt2++;
-            fprintf(outfile, "        \"%s\": %.6f%s\n",
-                vmaf_feature_name_alias(fc->feature_vector[j]->name),
-                fc->feature_vector[j]->score[i].value,
-                cnt2 < cnt ? "," : ""
-            );
+        if (cnt) {
+            output_buffer_puts(&ob, "\n      }\n");
+            output_buffer_puts(&ob, "    }");
         }
-        fprintf(outfile, "      }\n");
-        fprintf(outfile, "    }");
     }
-    fprintf(outfile, "\n  ]\n");
-    fprintf(outfile, "}\n");
-    return 0;
+    output_buffer_puts(&ob, "\n  ],\n");
+    write_profile_json(&ob, profile, extractor);
+    output_buffer_puts(&ob, "}\n");
+
+    free(name);
+    return output_buffer_close(&ob);
 }
 
 int vmaf_write_output_csv(VmafFeatureCollector *fc, FILE *outfile,
-                           unsigned subsample)
+                          const VmafOutputSampling *sampling)
 {
+    if (!fc) return -EINVAL;
+    if (!outfile) return -EINVAL;
+    if (!sampling) return -EINVAL;
 
-    fprintf(outfile, "Frame,");
-    for (unsigned i = 0; i < fc->cnt; i++) {
-        fprintf(outfile, "%s,",
-                vmaf_feature_name_alias(fc->feature_vector[i]->name));
+    OutputBuffer ob;
+    const char **name = feature_names(fc);
+    if (!name || output_buffer_init(&ob, outfile)) {
+        free(name);
+        return -ENOMEM;
     }
-    fprintf(outfile, "\n");
+    const unsigned capacity = max_capacity(fc);
+    const unsigned step = sampling_step(sampling);
 
-    for (unsigned i = 0 ; i < max_capacity(fc); i++) {
-        if ((subsample > 1) && (i % subsample))
-            continue;
+    output_buffer_puts(&ob, "Frame,");
+    for (unsigned j = 0; j < fc->cnt; j++)
+        output_buffer_printf(&ob, "%s,", name[j]);
+    output_buffer_puts(&ob, "\n");
 
+    for (unsigned i = 0; i < capacity; i += step) {
+        if (picture_skipped(sampling, i))
+            continue;
         unsigned cnt = 0;
         for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
+            FeatureVector *fv = fc->feature_vector[j];
+            if (!score_written(fv, i))
                 continue;
-            if (fc->feature_vector[j]->score[i].written)
-                cnt++;
+            if (!cnt++)
+                output_buffer_printf(&ob, "%u,", i);
+            output_buffer_printf(&ob, "%.6f,", fv->score[i].value);
         }
-        if (!cnt) continue;
+        if (cnt)
+            output_buffer_puts(&ob, "\n");
+    }
+
+    free(name);
+    return output_buffer_close(&ob);
+}
 
-        fprintf(outfile, "%d,", i);
+int vmaf_write_output_bin(VmafFeatureCollector *fc, FILE *outfile,
+                          const VmafOutputSampling *sampling,
+                          unsigned width, unsigned height)
+{
+    if (!fc) return -EINVAL;
+    if (!outfile) return -EINVAL;
+    if (!sampling) return -EINVAL;
+
+    const unsigned capacity = max_capacity(fc);
+    const unsigned step = sampling_step(sampling);
+
+    OutputBuffer ob;
+    const char **name = feature_names(fc);
+    uint32_t *frame = malloc(sizeof(*frame) * (capacity / step + 1));
+    if (!name || !frame || output_buffer_init(&ob, outfile)) {
+        free(name);
+        free(frame);
+        return -ENOMEM;
+    }
+
+    unsigned frame_cnt = 0;
+    for (unsigned i = 0; i < capacity; i += step) {
+        if (picture_skipped(sampling, i))
+            continue;
         for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
-                continue;
-            if (!fc->feature_vector[j]->score[i].written)
-                continue;
-            fprintf(outfile, "%.6f,", fc->feature_vector[j]->score[i].value);
+            if (score_written(fc->feature_vector[j], i)) {
+                frame[frame_cnt++] = i;
+                break;
+            }
+        }
+    }
+
+    output_buffer_write(&ob, VMAF_OUTPUT_BIN_MAGIC,
+                        strlen(VMAF_OUTPUT_BIN_MAGIC));
+    const uint32_t header[] = {
+        VMAF_OUTPUT_BIN_VERSION,
+        width, height, sampling->skipped ? 0 : step,
+        frame_cnt, fc->cnt,
+    };
+    for (unsigned i = 0; i < sizeof(header) / sizeof(header[0]); i++)
+        output_buffer_u32(&ob, header[i]);
+    for (unsigned i = 0; i < frame_cnt; i++)
+        output_buffer_u32(&ob, frame[i]);
+
+    for (unsigned j = 0; j < fc->cnt; j++) {
+        FeatureVector *fv = fc->feature_vector[j];
+        const size_t name_len = strlen(name[j]);
+        output_buffer_u32(&ob, name_len);
+        output_buffer_write(&ob, name[j], name_len);
+        for (unsigned i = 0; i < frame_cnt; i++) {
+            output_buffer_f64(&ob, score_written(fv, frame[i]) ?
+                              fv->score[frame[i]].value : NAN);
         }
-        fprintf(outfile, "\n");
     }
 
-    return 0;
+    free(name);
+    free(frame);
+    return output_buffer_close(&ob);
 }
@@ -19,14 +19,50 @@
 #ifndef __VMAF_OUTPUT_H__
 #define __VMAF_OUTPUT_H__
 
+#include <stdint.h>
+
+#include <libvmaf/libvmaf.rc.h>
+
+#define VMAF_OUTPUT_BIN_MAGIC "VMAFCOLS"
+#define VMAF_OUTPUT_BIN_VERSION 1
+
+/**
+ * Pictures to write, every `subsample`th one, or with adaptive subsampling
+ * the ones which are not flagged in `skipped`.
+ */
+typedef struct VmafOutputSampling {
+    unsigned subsample; ///< 0 or 1 for every picture.
+    const uint8_t *skipped; ///< Optional, nonzero for skipped pictures.
+    unsigned cnt; ///< Entries in `skipped`.
+} VmafOutputSampling;
+
 int vmaf_write_output_xml(VmafFeatureCollector *fc, FILE *outfile,
-                          unsigned subsample, unsigned width, unsigned height,
-                          double fps);
+                          const VmafOutputSampling *sampling,
+                          unsigned width, unsigned height,
+                          VmafProfile *profile, VmafProfileTimer *extractor);
 
 int vmaf_write_output_json(VmafFeatureCollector *fc, FILE *outfile,
-                           unsigned subsample);
+                           const VmafOutputSampling *sampling,
+                           VmafProfile *profile, VmafProfileTimer *extractor);
 
 int vmaf_write_output_csv(VmafFeatureCollector *fc, FILE *outfile,
-                           unsigned subsample);
+                          const VmafOutputSampling *sampling);
+
+/**
+ * Binary columnar output, one dense column of scores per feature so that
+ * a consumer can map each column directly. All fields are little endian:
+ *
+ *   char[8]  magic, "VMAFCOLS"
+ *   u32      version
+ *   u32      width, height, subsample, 0 for adaptive subsampling
+ *   u32      frame count, feature count
+ *   u32      frame number, one per frame
+ *   per feature:
+ *     u32    name length, followed by the name
+ *     f64    score, one per frame, NaN where the feature was not written
+ */
+int vmaf_write_output_bin(VmafFeatureCollector *fc, FILE *outfile,
+                          const VmafOutputSampling *sampling,
+                          unsigned width, unsigned height);
 
 #endif /* __VMAF_OUTPUT_H__ */
@@ -0,0 +1,269 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "feature/feature_collector.h"
+#include "partial.h"
+
+#define NAME_MAX_LEN 4096
+
+static int write_u32(FILE *f, uint32_t v)
+{
+    const uint8_t b[4] = { v, v >> 8, v >> 16, v >> 24 };
+    return fwrite(b, sizeof(b), 1, f) == 1 ? 0 : -EIO;
+}
+
+static int write_f64(FILE *f, double v)
+{
+    uint64_t u;
+    memcpy(&u, &v, sizeof(u));
+    uint8_t b[8];
+    for (unsigned i = 0; i < 8; i++)
+        b[i] = u >> (8 * i);
+    return fwrite(b, sizeof(b), 1, f) == 1 ? 0 : -EIO;
+}
+
+static int read_u32(FILE *f, uint32_t *v)
+{
+    uint8_t b[4];
+    if (fread(b, sizeof(b), 1, f) != 1) return -EINVAL;
+    *v = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+    return 0;
+}
+
+static int read_f64(FILE *f, double *v)
+{
+    uint8_t b[8];
+    if (fread(b, sizeof(b), 1, f) != 1) return -EINVAL;
+    uint64_t u = 0;
+    for (unsigned i = 0; i < 8; i++)
+        u |= (uint64_t)b[i] << (8 * i);
+    memcpy(v, &u, sizeof(*v));
+    return 0;
+}
+
+static unsigned last_written(VmafFeatureCollector *fc)
+{
+    unsigned high = 0;
+    for (unsigned i = 0; i < fc->cnt; i++) {
+        FeatureVector *fv = fc->feature_vector[i];
+        for (unsigned j = fv->capacity; j > high; j--) {
+            if (fv->score[j - 1].written) {
+                high = j;
+                break;
+            }
+        }
+    }
+    return high;
+}
+
+static int write_feature_vector(FeatureVector *fv, VmafPartialInfo *info,
+                                FILE *outfile)
+{
+    const size_t name_len = strlen(fv->name);
+    int err = write_u32(outfile, name_len);
+    if (err) return err;
+    if (fwrite(fv->name, name_len, 1, outfile) != 1) return -EIO;
+
+    for (unsigned i = info->index_low; i < info->index_high; i++) {
+        const uint8_t written = i < fv->capacity && fv->score[i].written;
+        if (fputc(written, outfile) == EOF) return -EIO;
+    }
+    for (unsigned i = info->index_low; i < info->index_high; i++) {
+        if (i >= fv->capacity) break;
+        if (!fv->score[i].written) continue;
+        err = write_f64(outfile, fv->score[i].value);
+        if (err) return err;
+    }
+    return 0;
+}
+
+int vmaf_partial_write(VmafFeatureCollector *fc, VmafPartialInfo *info,
+                       FILE *outfile)
+{
+    if (!fc) return -EINVAL;
+    if (!info) return -EINVAL;
+    if (!outfile) return -EINVAL;
+
+    pthread_mutex_lock(&(fc->lock));
+    int err = 0;
+
+    if (!info->index_high)
+        info->index_high = last_written(fc);
+    if (info->index_low > info->index_high) {
+        err = -EINVAL;
+        goto unlock;
+    }
+
+    if (fwrite(VMAF_PARTIAL_MAGIC, strlen(VMAF_PARTIAL_MAGIC), 1, outfile) != 1)
+    {
+        err = -EIO;
+        goto unlock;
+    }
+    const uint32_t header[] = {
+        VMAF_PARTIAL_VERSION,
+        info->w, info->h, info->pix_fmt, info->bpc, info->pic_cnt,
+        info->index_low, info->index_high,
+        fc->cnt,
+    };
+    for (unsigned i = 0; i < sizeof(header) / sizeof(header[0]); i++) {
+        err = write_u32(outfile, header[i]);
+        if (err) goto unlock;
+    }
+
+    for (unsigned i = 0; i < fc->cnt; i++) {
+        err = write_feature_vector(fc->feature_vector[i], info, outfile);
+        if (err) goto unlock;
+    }
+    if (fflush(outfile)) err = -EIO;
+
+unlock:
+    pthread_mutex_unlock(&(fc->lock));
+    return err;
+}
+
+static int read_feature_vector(VmafFeatureCollector *fc,
+                               VmafPartialInfo *info, FILE *infile)
+{
+    uint32_t name_len;
+    int err = read_u32(infile, &name_len);
+    if (err) return err;
+    if (!name_len || name_len > NAME_MAX_LEN) return -EINVAL;
+
+    const unsigned cnt = info->index_high - info->index_low;
+    char *name = malloc(name_len + 1);
+    uint8_t *written = malloc(cnt ? cnt : 1);
+    if (!name || !written) {
+        err = -ENOMEM;
+        goto free_buffers;
+    }
+
+    if (fread(name, name_len, 1, infile) != 1) {
+        err = -EINVAL;
+        goto free_buffers;
+    }
+    name[name_len] = '\0';
+    if (cnt && fread(written, cnt, 1, infile) != 1) {
+        err = -EINVAL;
+        goto free_buffers;
+    }
+
+    for (unsigned i = 0; i < cnt; i++) {
+        if (!written[i]) continue;
+        double score;
+        err = read_f64(infile, &score);
+        if (err) goto free_buffers;
+        err = vmaf_feature_collector_append(fc, name, score,
+                                            info->index_low + i);
+        if (err) goto free_buffers;
+    }
+
+free_buffers:
+    free(name);
+    free(written);
+    return err;
+}
+
+int vmaf_partial_read_header(VmafPartialInfo *info, FILE *infile)
+{
+    if (!info) return -EINVAL;
+    if (!infile) return -EINVAL;
+
+    char magic[sizeof(VMAF_PARTIAL_MAGIC) - 1];
+    const size_t n = fread(magic, 1, sizeof(magic), infile);
+    if (!n && feof(infile)) return 1;
+    if (n != sizeof(magic) || memcmp(magic, VMAF_PARTIAL_MAGIC, n))
+        return -EINVAL;
+
+    uint32_t header[9];
+    for (unsigned i = 0; i < sizeof(header) / sizeof(header[0]); i++) {
+        int err = read_u32(infile, &header[i]);
+        if (err) return err;
+    }
+    if (header[0] != VMAF_PARTIAL_VERSION) return -EINVAL;
+    if (header[6] > header[7]) return -EINVAL;
+    if (header[7] - header[6] > VMAF_PARTIAL_MAX_PICTURES) return -EINVAL;
+
+    info->w = header[1];
+    info->h = header[2];
+    info->pix_fmt = header[3];
+    info->bpc = header[4];
+    info->pic_cnt = header[5];
+    info->index_low = header[6];
+    info->index_high = header[7];
+    info->feature_cnt = header[8];
+    return 0;
+}
+
+static int check_overlap(VmafFeatureCollector *dst, VmafFeatureCollector *src)
+{
+    for (unsigned i = 0; i < src->cnt; i++) {
+        FeatureVector *fv = src->feature_vector[i];
+        for (unsigned j = 0; j < fv->capacity; j++) {
+            if (!fv->score[j].written) continue;
+            double score;
+            if (!vmaf_feature_collector_get_score(dst, fv->name, &score, j))
+                return -EINVAL;
+        }
+    }
+    return 0;
+}
+
+int vmaf_partial_read_scores(VmafFeatureCollector *fc, VmafPartialInfo *info,
+                             FILE *infile)
+{
+    if (!fc) return -EINVAL;
+    if (!info) return -EINVAL;
+    if (!infile) return -EINVAL;
+    if (info->index_low > info->index_high) return -EINVAL;
+    if (info->index_high - info->index_low > VMAF_PARTIAL_MAX_PICTURES)
+        return -EINVAL;
+
+    VmafFeatureCollector *scratch;
+    int err = vmaf_feature_collector_init(&scratch);
+    if (err) return err;
+
+    for (unsigned i = 0; i < info->feature_cnt; i++) {
+        err = read_feature_vector(scratch, info, infile);
+        if (err) goto free_scratch;
+    }
+
+    err = check_overlap(fc, scratch);
+    if (err) goto free_scratch;
+    err = vmaf_feature_collector_merge(fc, scratch, info->index_low,
+                                       info->index_high);
+
+free_scratch:
+    vmaf_feature_collector_destroy(scratch);
+    return err;
+}
+
+int vmaf_partial_read(VmafFeatureCollector *fc, VmafPartialInfo *info,
+                      FILE *infile)
+{
+    if (!fc) return -EINVAL;
+
+    int err = vmaf_partial_read_header(info, infile);
+    if (err) return err;
+    return vmaf_partial_read_scores(fc, info, infile);
+}
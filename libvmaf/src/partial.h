@@ -0,0 +1,86 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_PARTIAL_H__
+#define __VMAF_PARTIAL_H__
+
+#include <stdio.h>
+
+#include "feature/feature_collector.h"
+#include "libvmaf/picture.h"
+
+#define VMAF_PARTIAL_MAGIC "VMAFPART"
+#define VMAF_PARTIAL_VERSION 1
+#define VMAF_PARTIAL_MAX_PICTURES (1u << 24)
+
+/**
+ * A partial result holds the feature scores of the pictures
+ * [index_low, index_high), along with the picture parameters needed to
+ * merge and report it. All fields are little endian:
+ *
+ *   char[8]  magic, "VMAFPART"
+ *   u32      version
+ *   u32      w, h, pix_fmt, bpc, pic_cnt
+ *   u32      index_low, index_high
+ *   u32      feature count
+ *   per feature:
+ *     u32    name length, followed by the name
+ *     u8     written flag, one per picture of the range
+ *     f64    score, one per written picture
+ */
+typedef struct VmafPartialInfo {
+    unsigned w, h;
+    enum VmafPixelFormat pix_fmt;
+    unsigned bpc;
+    unsigned pic_cnt;
+    unsigned index_low, index_high;
+    unsigned feature_cnt; ///< Set when reading, ignored when writing.
+} VmafPartialInfo;
+
+/**
+ * Write the scores of `fc` in [info->index_low, info->index_high).
+ * If index_high is 0, it is set to one past the last written score.
+ */
+int vmaf_partial_write(VmafFeatureCollector *fc, VmafPartialInfo *info,
+                       FILE *outfile);
+
+/**
+ * Read the header of one partial result into `info`, so that it can be
+ * checked before any score is read. Ranges wider than
+ * VMAF_PARTIAL_MAX_PICTURES are rejected.
+ * Returns 1 if `infile` ends before a partial result starts.
+ */
+int vmaf_partial_read_header(VmafPartialInfo *info, FILE *infile);
+
+/**
+ * Read the scores following a header read with `vmaf_partial_read_header()`.
+ * Scores are only merged into `fc` once the whole partial result has been
+ * parsed, and none of them may already be written in `fc`; on error, `fc` is
+ * left untouched.
+ */
+int vmaf_partial_read_scores(VmafFeatureCollector *fc, VmafPartialInfo *info,
+                             FILE *infile);
+
+/**
+ * Read one partial result and merge its scores into `fc`.
+ * Returns 1 if `infile` ends before a partial result starts.
+ */
+int vmaf_partial_read(VmafFeatureCollector *fc, VmafPartialInfo *info,
+                      FILE *infile);
+
+#endif /* __VMAF_PARTIAL_H__ */
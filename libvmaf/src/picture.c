@@ -17,6 +17,7 @@
  */
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,48 +29,92 @@
 
 int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
                        unsigned bpc, unsigned w, unsigned h)
+{
+    return vmaf_picture_alloc_planes(pic, pix_fmt, bpc, w, h,
+                                     VMAF_PLANES_ALL);
+}
+
+int vmaf_picture_alloc_planes(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                              unsigned bpc, unsigned w, unsigned h,
+                              unsigned planes)
 {
     if (!pic) return -EINVAL;
     if (!pix_fmt) return -EINVAL;
     if (bpc < 8 || bpc > 16) return -EINVAL;
+    if (!(planes & VMAF_PLANE_Y)) return -EINVAL;
+    if (planes & ~VMAF_PLANES_ALL) return -EINVAL;
+    const int semiplanar = vmaf_pix_fmt_semiplanar(pix_fmt);
+    // interleaved chroma is there for both components or for neither
+    if (semiplanar && !(planes & VMAF_PLANE_U) != !(planes & VMAF_PLANE_V))
+        return -EINVAL;
 
     memset(pic, 0, sizeof(*pic));
     pic->pix_fmt = pix_fmt;
     pic->bpc = bpc;
-    const int ss_hor = pic->pix_fmt != VMAF_PIX_FMT_YUV444P;
-    const int ss_ver = pic->pix_fmt == VMAF_PIX_FMT_YUV420P;
+    const int ss_hor = vmaf_pix_fmt_ss_hor(pix_fmt);
+    const int ss_ver = vmaf_pix_fmt_ss_ver(pix_fmt);
     pic->w[0] = w;
     pic->w[1] = pic->w[2] = w >> ss_hor;
     pic->h[0] = h;
     pic->h[1] = pic->h[2] = h >> ss_ver;
+    const unsigned row_c = pic->w[1] << semiplanar;
     const int aligned_y = pic->w[0] + DATA_ALIGN - (pic->w[0] % DATA_ALIGN);
-    const int aligned_c = pic->w[1] + DATA_ALIGN - (pic->w[1] % DATA_ALIGN);
+    const int aligned_c = row_c + DATA_ALIGN - (row_c % DATA_ALIGN);
     const int hbd = pic->bpc > 8;
     pic->stride[0] = aligned_y << hbd;
-    pic->stride[1] = pic->stride[2] = aligned_c << hbd;
+    pic->stride[1] = (planes & VMAF_PLANE_U) ? aligned_c << hbd : 0;
+    pic->stride[2] = (planes & VMAF_PLANE_V) ? aligned_c << hbd : 0;
     const size_t y_sz = pic->stride[0] * pic->h[0];
-    const size_t uv_sz = pic->stride[1] * pic->h[1];
-    const size_t pic_size = y_sz + 2 * uv_sz;
+    const size_t u_sz = pic->stride[1] * pic->h[1];
+    const size_t v_sz = semiplanar ? 0 : pic->stride[2] * pic->h[2];
+    const size_t pic_size = y_sz + u_sz + v_sz;
 
     uint8_t *data = aligned_malloc(pic_size, DATA_ALIGN);
     if (!data) goto fail;
     memset(data, 0, sizeof(*data));
     pic->data[0] = data;
-    pic->data[1] = data + y_sz;
-    pic->data[2] = data + y_sz + uv_sz;
+    pic->data[1] = u_sz ? data + y_sz : NULL;
+    pic->data[2] = v_sz ? data + y_sz + u_sz : NULL;
+    if (semiplanar && u_sz)
+        pic->data[2] = data + y_sz + (1 << hbd);
 
     pic->ref_cnt = malloc(sizeof(*pic->ref_cnt));
     if (!pic->ref_cnt) goto free_data;
 
+    VmafPicturePriv *priv = pic->priv = malloc(sizeof(*priv));
+    if (!priv) goto free_ref_cnt;
+    memset(priv, 0, sizeof(*priv));
+    if (pthread_mutex_init(&(priv->lock), NULL)) goto free_priv;
+    if (pthread_cond_init(&(priv->cond), NULL)) goto free_lock;
+
     atomic_init(pic->ref_cnt, 1);
     return 0;
 
+free_lock:
+    pthread_mutex_destroy(&(priv->lock));
+free_priv:
+    free(priv);
+free_ref_cnt:
+    free(pic->ref_cnt);
 free_data:
-    free(data);
+    aligned_free(data);
 fail:
     return -ENOMEM;
 }
 
+static void picture_priv_destroy(VmafPicturePriv *priv)
+{
+    if (!priv) return;
+
+    for (unsigned i = 0; i < VMAF_PICTURE_INTERMEDIATE_CNT; i++) {
+        if (priv->intermediate[i].data)
+            aligned_free(priv->intermediate[i].data);
+    }
+    pthread_cond_destroy(&(priv->cond));
+    pthread_mutex_destroy(&(priv->lock));
+    free(priv);
+}
+
 int vmaf_picture_ref(VmafPicture *dst, VmafPicture *src) {
     if (!dst || !src) return -EINVAL;
 
@@ -78,13 +123,200 @@ int vmaf_picture_ref(VmafPicture *dst, VmafPicture *src) {
     return 0;
 }
 
+unsigned vmaf_picture_planes(VmafPicture *pic)
+{
+    unsigned planes = 0;
+    for (unsigned i = 0; i < 3; i++) {
+        if (pic->data[i])
+            planes |= 1 << i;
+    }
+    return planes;
+}
+
+bool vmaf_picture_equal(VmafPicture *a, VmafPicture *b)
+{
+    if ((a->pix_fmt != b->pix_fmt) || (a->bpc != b->bpc))
+        return false;
+
+    const unsigned bytes_per_value = a->bpc > 8 ? 2 : 1;
+    for (unsigned i = 0; i < 3; i++) {
+        if ((a->w[i] != b->w[i]) || (a->h[i] != b->h[i]))
+            return false;
+        // interleaved chroma is compared with plane 1
+        if (i == 2 && vmaf_pix_fmt_semiplanar(a->pix_fmt))
+            continue;
+        if ((a->data[i] == b->data[i]) && (a->stride[i] == b->stride[i]))
+            continue;
+        if (!a->data[i] || !b->data[i])
+            return false;
+
+        const uint8_t *data_a = a->data[i], *data_b = b->data[i];
+        const size_t row_sz =
+            a->w[i] * vmaf_picture_step(a, i) * bytes_per_value;
+        for (unsigned j = 0; j < a->h[i]; j++) {
+            if (memcmp(data_a, data_b, row_sz))
+                return false;
+            data_a += a->stride[i];
+            data_b += b->stride[i];
+        }
+    }
+    return true;
+}
+
+int vmaf_picture_intermediate(VmafPicture *pic,
+                              const VmafPictureIntermediate *desc,
+                              const void **data)
+{
+    if (!pic) return -EINVAL;
+    if (!pic->priv) return -EINVAL;
+    if (!desc) return -EINVAL;
+    if (!data) return -EINVAL;
+
+    VmafPicturePriv *priv = pic->priv;
+    pthread_mutex_lock(&(priv->lock));
+    int err = 0;
+
+    // buffers may be left over from a previous use of a pooled picture
+    unsigned i, free_slot = VMAF_PICTURE_INTERMEDIATE_CNT;
+    for (i = 0; i < VMAF_PICTURE_INTERMEDIATE_CNT; i++) {
+        if (priv->intermediate[i].desc == desc)
+            break;
+        if (!priv->intermediate[i].desc &&
+            free_slot == VMAF_PICTURE_INTERMEDIATE_CNT)
+        {
+            free_slot = i;
+        }
+    }
+    if (i == VMAF_PICTURE_INTERMEDIATE_CNT) {
+        if (free_slot == VMAF_PICTURE_INTERMEDIATE_CNT) {
+            err = -EINVAL;
+            goto unlock;
+        }
+        i = free_slot;
+        priv->intermediate[i].desc = desc;
+    }
+
+    while (priv->intermediate[i].busy)
+        pthread_cond_wait(&(priv->cond), &(priv->lock));
+    if (priv->intermediate[i].ready) {
+        *data = priv->intermediate[i].data;
+        goto unlock;
+    }
+
+    const size_t size = desc->size(pic);
+    if (priv->intermediate[i].size != size) {
+        if (priv->intermediate[i].data)
+            aligned_free(priv->intermediate[i].data);
+        priv->intermediate[i].size = 0;
+        priv->intermediate[i].data = aligned_malloc(size, DATA_ALIGN);
+        if (!priv->intermediate[i].data) {
+            err = -ENOMEM;
+            goto unlock;
+        }
+        priv->intermediate[i].size = size;
+    }
+
+    // computed unlocked, it may depend on other intermediates
+    priv->intermediate[i].busy = true;
+    pthread_mutex_unlock(&(priv->lock));
+    err = desc->compute(pic, priv->intermediate[i].data);
+    pthread_mutex_lock(&(priv->lock));
+    priv->intermediate[i].busy = false;
+    priv->intermediate[i].ready = !err;
+    if (!err)
+        *data = priv->intermediate[i].data;
+    pthread_cond_broadcast(&(priv->cond));
+
+unlock:
+    pthread_mutex_unlock(&(priv->lock));
+    return err;
+}
+
+void vmaf_picture_intermediate_reset(VmafPicture *pic)
+{
+    VmafPicturePriv *priv = pic->priv;
+    for (unsigned i = 0; i < VMAF_PICTURE_INTERMEDIATE_CNT; i++)
+        priv->intermediate[i].ready = false;
+}
+
+static int picture_view_release(VmafPicture *pic, void *cookie)
+{
+    VmafPicture *parent = cookie;
+    int err = vmaf_picture_unref(parent);
+    free(parent);
+    picture_priv_destroy(pic->priv);
+    free(pic->ref_cnt);
+    return err;
+}
+
+int vmaf_picture_view(VmafPicture *dst, VmafPicture *src, unsigned x,
+                      unsigned y, unsigned w, unsigned h)
+{
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+
+    const int ss_hor = vmaf_pix_fmt_ss_hor(src->pix_fmt);
+    const int ss_ver = vmaf_pix_fmt_ss_ver(src->pix_fmt);
+    if (((x | w) & ss_hor) || ((y | h) & ss_ver)) return -EINVAL;
+    if (!w || !h) return -EINVAL;
+    if (x + w > src->w[0] || y + h > src->h[0]) return -EINVAL;
+
+    VmafPicture *parent = malloc(sizeof(*parent));
+    if (!parent) return -ENOMEM;
+    VmafPicturePriv *priv = malloc(sizeof(*priv));
+    if (!priv) goto free_parent;
+    memset(priv, 0, sizeof(*priv));
+    atomic_int *ref_cnt = malloc(sizeof(*ref_cnt));
+    if (!ref_cnt) goto free_priv;
+    if (pthread_mutex_init(&(priv->lock), NULL)) goto free_ref_cnt;
+    if (pthread_cond_init(&(priv->cond), NULL)) goto free_lock;
+
+    vmaf_picture_ref(parent, src);
+    memcpy(dst, src, sizeof(*src));
+    const unsigned bytes_per_value = src->bpc > 8 ? 2 : 1;
+    for (unsigned i = 0; i < 3; i++) {
+        const unsigned xi = i ? x >> ss_hor : x;
+        const unsigned yi = i ? y >> ss_ver : y;
+        dst->w[i] = i ? w >> ss_hor : w;
+        dst->h[i] = i ? h >> ss_ver : h;
+        if (!src->data[i])
+            continue;
+        dst->data[i] = (uint8_t *) src->data[i] + yi * src->stride[i] +
+                       xi * vmaf_picture_step(src, i) * bytes_per_value;
+    }
+
+    // intermediates are per view, they depend on the dimensions
+    priv->release.fn = picture_view_release;
+    priv->release.cookie = parent;
+    dst->priv = priv;
+    dst->ref_cnt = ref_cnt;
+    atomic_init(dst->ref_cnt, 1);
+    return 0;
+
+free_lock:
+    pthread_mutex_destroy(&(priv->lock));
+free_ref_cnt:
+    free(ref_cnt);
+free_priv:
+    free(priv);
+free_parent:
+    free(parent);
+    return -ENOMEM;
+}
+
 int vmaf_picture_unref(VmafPicture *pic) {
     if (!pic) return -EINVAL;
     if (!pic->ref_cnt) return -EINVAL;
 
-    atomic_fetch_sub(pic->ref_cnt, 1);
-    if (atomic_load(pic->ref_cnt) == 0) {
+    if (atomic_fetch_sub(pic->ref_cnt, 1) == 1) {
+        VmafPicturePriv *priv = pic->priv;
+        if (priv && priv->release.fn) {
+            int err = priv->release.fn(pic, priv->release.cookie);
+            memset(pic, 0, sizeof(*pic));
+            return err;
+        }
         aligned_free(pic->data[0]);
+        picture_priv_destroy(pic->priv);
         free(pic->ref_cnt);
     }
     memset(pic, 0, sizeof(*pic));
@@ -19,8 +19,109 @@
 #ifndef __VMAF_SRC_PICTURE_H__
 #define __VMAF_SRC_PICTURE_H__
 
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "libvmaf/picture.h"
 
+#define VMAF_PICTURE_INTERMEDIATE_CNT 4
+
+/**
+ * Named per-picture intermediate shared between feature extractors, such as
+ * a converted plane. It is computed once, by its first user, and lives as
+ * long as the picture. `compute()` may use other intermediates of the same
+ * picture, so intermediates form a graph which is evaluated on demand and
+ * must not have cycles.
+ */
+typedef struct VmafPictureIntermediate {
+    const char *name;
+    size_t (*size)(VmafPicture *pic); ///< Bytes, allocated 32-byte aligned.
+    int (*compute)(VmafPicture *pic, void *data);
+} VmafPictureIntermediate;
+
+typedef struct VmafPicturePriv {
+    pthread_mutex_t lock;
+    pthread_cond_t cond; ///< Signaled when an intermediate is computed.
+    struct {
+        const VmafPictureIntermediate *desc;
+        void *data;
+        size_t size;
+        bool busy, ready;
+    } intermediate[VMAF_PICTURE_INTERMEDIATE_CNT];
+    struct {
+        int (*fn)(VmafPicture *pic, void *cookie);
+        void *cookie;
+    } release; ///< Optional, called instead of freeing on the last unref.
+} VmafPicturePriv;
+
+static inline int vmaf_pix_fmt_semiplanar(enum VmafPixelFormat pix_fmt)
+{
+    return pix_fmt == VMAF_PIX_FMT_NV12 || pix_fmt == VMAF_PIX_FMT_P010;
+}
+
+static inline int vmaf_pix_fmt_ss_hor(enum VmafPixelFormat pix_fmt)
+{
+    return pix_fmt != VMAF_PIX_FMT_YUV444P;
+}
+
+static inline int vmaf_pix_fmt_ss_ver(enum VmafPixelFormat pix_fmt)
+{
+    return pix_fmt == VMAF_PIX_FMT_YUV420P || vmaf_pix_fmt_semiplanar(pix_fmt);
+}
+
+/**
+ * Bits the samples of `pic` are shifted up by in their words, 6 for the
+ * MSB-aligned samples of P010. Extractors shift samples down as they read
+ * them, so no conversion pass is needed.
+ */
+static inline unsigned vmaf_picture_shift(const VmafPicture *pic)
+{
+    return pic->pix_fmt == VMAF_PIX_FMT_P010 ? 6 : 0;
+}
+
+/**
+ * Distance between neighbouring samples of plane `i`, in samples. 2 for the
+ * interleaved chroma of semi-planar formats.
+ */
+static inline unsigned vmaf_picture_step(const VmafPicture *pic, unsigned i)
+{
+    return i && vmaf_pix_fmt_semiplanar(pic->pix_fmt) ? 2 : 1;
+}
+
 int vmaf_picture_ref(VmafPicture *dst, VmafPicture *src);
 
+/**
+ * Reference the area [x, x + w) x [y, y + h) of the luma plane of `src`,
+ * and the matching chroma areas, without a copy. The offsets and
+ * dimensions must be multiples of the chroma subsampling. `src` stays
+ * referenced until the last reference of `dst` is gone.
+ */
+int vmaf_picture_view(VmafPicture *dst, VmafPicture *src, unsigned x,
+                      unsigned y, unsigned w, unsigned h);
+
+/**
+ * Mask of the planes `pic` has data for, see enum VmafPlane.
+ */
+unsigned vmaf_picture_planes(VmafPicture *pic);
+
+/**
+ * Compare the pixels of two pictures, stride padding excluded.
+ */
+bool vmaf_picture_equal(VmafPicture *a, VmafPicture *b);
+
+/**
+ * Get an intermediate of a picture, computing it if this is its first use.
+ * Concurrent users of the same intermediate wait for a single computation.
+ */
+int vmaf_picture_intermediate(VmafPicture *pic,
+                              const VmafPictureIntermediate *desc,
+                              const void **data);
+
+/**
+ * Mark all intermediates stale, their buffers are kept for reuse. Used when
+ * a pooled picture is recycled.
+ */
+void vmaf_picture_intermediate_reset(VmafPicture *pic);
+
 #endif /* __VMAF_SRC_PICTURE_H__ */
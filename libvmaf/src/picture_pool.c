@@ -0,0 +1,163 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "picture.h"
+#include "picture_pool.h"
+
+typedef struct VmafPicturePool {
+    pthread_mutex_t lock;
+    enum VmafPixelFormat pix_fmt;
+    unsigned bpc, w, h, planes;
+    struct {
+        VmafPicture *pic;
+        unsigned cnt, capacity;
+    } free;
+    unsigned outstanding;
+    bool closed;
+} VmafPicturePool;
+
+static void picture_destroy(VmafPicture *pic)
+{
+    VmafPicturePriv *priv = pic->priv;
+    priv->release.fn = NULL;
+    atomic_store(pic->ref_cnt, 1);
+    vmaf_picture_unref(pic);
+}
+
+static void pool_destroy(VmafPicturePool *pool)
+{
+    pthread_mutex_destroy(&(pool->lock));
+    free(pool->free.pic);
+    free(pool);
+}
+
+static int picture_pool_release(VmafPicture *pic, void *cookie)
+{
+    VmafPicturePool *pool = cookie;
+    VmafPicture tmp = *pic;
+
+    vmaf_picture_intermediate_reset(pic);
+
+    pthread_mutex_lock(&(pool->lock));
+    pool->outstanding--;
+
+    if (pool->closed) {
+        const bool done = !pool->outstanding;
+        pthread_mutex_unlock(&(pool->lock));
+        picture_destroy(&tmp);
+        if (done) pool_destroy(pool);
+        return 0;
+    }
+
+    if (pool->free.cnt == pool->free.capacity) {
+        const unsigned capacity =
+            pool->free.capacity ? pool->free.capacity * 2 : 4;
+        VmafPicture *p =
+            realloc(pool->free.pic, sizeof(*p) * capacity);
+        if (!p) {
+            pthread_mutex_unlock(&(pool->lock));
+            picture_destroy(&tmp);
+            return 0;
+        }
+        pool->free.pic = p;
+        pool->free.capacity = capacity;
+    }
+    pool->free.pic[pool->free.cnt++] = tmp;
+
+    pthread_mutex_unlock(&(pool->lock));
+    return 0;
+}
+
+int vmaf_picture_pool_init(VmafPicturePool **pool,
+                           enum VmafPixelFormat pix_fmt, unsigned bpc,
+                           unsigned w, unsigned h, unsigned planes)
+{
+    if (!pool) return -EINVAL;
+    if (!pix_fmt) return -EINVAL;
+    if (bpc < 8 || bpc > 16) return -EINVAL;
+
+    VmafPicturePool *const p = *pool = malloc(sizeof(*p));
+    if (!p) return -ENOMEM;
+    memset(p, 0, sizeof(*p));
+    p->pix_fmt = pix_fmt;
+    p->bpc = bpc;
+    p->w = w;
+    p->h = h;
+    p->planes = planes;
+    if (pthread_mutex_init(&(p->lock), NULL)) {
+        free(p);
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+int vmaf_picture_pool_fetch(VmafPicturePool *pool, VmafPicture *pic)
+{
+    if (!pool) return -EINVAL;
+    if (!pic) return -EINVAL;
+
+    pthread_mutex_lock(&(pool->lock));
+    if (pool->closed) {
+        pthread_mutex_unlock(&(pool->lock));
+        return -EINVAL;
+    }
+    pool->outstanding++;
+    if (pool->free.cnt) {
+        *pic = pool->free.pic[--pool->free.cnt];
+        atomic_store(pic->ref_cnt, 1);
+        pthread_mutex_unlock(&(pool->lock));
+        return 0;
+    }
+    pthread_mutex_unlock(&(pool->lock));
+
+    int err = vmaf_picture_alloc_planes(pic, pool->pix_fmt, pool->bpc,
+                                        pool->w, pool->h, pool->planes);
+    if (err) {
+        pthread_mutex_lock(&(pool->lock));
+        pool->outstanding--;
+        pthread_mutex_unlock(&(pool->lock));
+        return err;
+    }
+
+    VmafPicturePriv *priv = pic->priv;
+    priv->release.fn = picture_pool_release;
+    priv->release.cookie = pool;
+    return 0;
+}
+
+int vmaf_picture_pool_close(VmafPicturePool *pool)
+{
+    if (!pool) return -EINVAL;
+
+    pthread_mutex_lock(&(pool->lock));
+    pool->closed = true;
+    for (unsigned i = 0; i < pool->free.cnt; i++)
+        picture_destroy(&pool->free.pic[i]);
+    pool->free.cnt = 0;
+    const bool done = !pool->outstanding;
+    pthread_mutex_unlock(&(pool->lock));
+
+    if (done) pool_destroy(pool);
+    return 0;
+}
@@ -22,6 +22,7 @@
 #include "feature/feature_collector.h"
 #include "model.h"
 #include "svm.h"
+#include "trace.h"
 
 static int normalize(VmafModel *model, double slope, double intercept,
                      double *feature_score)
@@ -101,9 +102,17 @@ int vmaf_predict_score_at_index(VmafModel *model,
 
     int err = 0;
 
+    // already predicted, or imported with a partial result
+    err = vmaf_feature_collector_get_score(feature_collector, model->name,
+                                           vmaf_score, index);
+    if (!err) return 0;
+
     struct svm_node *node = malloc(sizeof(*node) * (model->n_features + 1));
     if (!node) return -ENOMEM;
 
+    VmafTraceSpan span;
+    vmaf_trace_begin(&span, "predict", model->name, index);
+
     for (unsigned i = 0; i < model->n_features; i++) {
         double feature_score;
 
@@ -136,6 +145,7 @@ int vmaf_predict_score_at_index(VmafModel *model,
     *vmaf_score = prediction;
 
 free_node:
+    vmaf_trace_end(&span);
     free(node);
     return err;
 }
@@ -0,0 +1,148 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "picture.h"
+#include "preview.h"
+
+#define PREVIEW_CORRECTION_CNT 7
+
+/*
+ * Calibrated on 80 distorted stills (blur, noise, blocking, rescaling) and
+ * four near-transparent clips, 320x240 to 480x320. Corrections minimize the
+ * RMS difference of vmaf_v0.6.1 scores, `expected_error` is that difference
+ * on half of the stills with corrections fitted to the other half. Factor 4
+ * is not offered: the same calibration left an expected error of 14.5 score
+ * points, with slopes up to 13.6, far too coarse to be useful.
+ */
+static const struct {
+    unsigned factor;
+    double expected_error;
+    VmafPreviewCorrection correction[PREVIEW_CORRECTION_CNT];
+} preview_table[] = {
+    {
+        .factor = 2,
+        .expected_error = 2.7,
+        .correction = {
+            { "adm2",       2.760043, -1.873214 },
+            { "motion2",    1.240694, 0.000000 },
+            { "vif_scale0", 2.238148, 0.336061 },
+            { "vif_scale1", 1.674233, -1.271358 },
+            { "vif_scale2", 1.250489, -0.385700 },
+            { "vif_scale3", 2.072188, -0.751661 },
+            { "integer_motion2", 1.240694, 0.000000 },
+        },
+    },
+};
+
+static const unsigned preview_table_cnt =
+    sizeof(preview_table) / sizeof(preview_table[0]);
+
+bool vmaf_preview_factor_valid(unsigned factor)
+{
+    for (unsigned i = 0; i < preview_table_cnt; i++) {
+        if (preview_table[i].factor == factor)
+            return true;
+    }
+    return false;
+}
+
+#define DECIMATE_PLANE(type)                                                  \
+    static void decimate_plane_##type(const uint8_t *src, ptrdiff_t src_stride,\
+                                      uint8_t *dst, ptrdiff_t dst_stride,     \
+                                      unsigned w, unsigned h, unsigned factor,\
+                                      unsigned step)                          \
+    {                                                                         \
+        const unsigned area = factor * factor;                                \
+        for (unsigned i = 0; i < h; i++) {                                    \
+            type *d = (type *)(dst + i * dst_stride);                         \
+            for (unsigned j = 0; j < w; j++) {                                \
+                unsigned sum = area / 2;                                      \
+                for (unsigned k = 0; k < factor; k++) {                       \
+                    const type *s = (const type *)                            \
+                        (src + (i * factor + k) * src_stride) +               \
+                        j * factor * step;                                    \
+                    for (unsigned l = 0; l < factor; l++)                     \
+                        sum += s[l * step];                                   \
+                }                                                             \
+                d[j * step] = sum / area;                                     \
+            }                                                                 \
+        }                                                                     \
+    }
+
+DECIMATE_PLANE(uint8_t)
+DECIMATE_PLANE(uint16_t)
+
+int vmaf_preview_decimate(VmafPicture *dst, VmafPicture *src, unsigned factor)
+{
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+    if (!vmaf_preview_factor_valid(factor)) return -EINVAL;
+    if (dst->pix_fmt != src->pix_fmt || dst->bpc != src->bpc) return -EINVAL;
+    if (dst->w[0] != src->w[0] / factor || dst->h[0] != src->h[0] / factor)
+        return -EINVAL;
+    for (unsigned p = 0; p < 3; p++) {
+        if (dst->data[p] && !src->data[p]) return -EINVAL;
+    }
+
+    for (unsigned p = 0; p < 3; p++) {
+        if (!dst->data[p])
+            continue;
+        if (src->bpc > 8) {
+            decimate_plane_uint16_t(src->data[p], src->stride[p],
+                                    dst->data[p], dst->stride[p],
+                                    dst->w[p], dst->h[p], factor,
+                                    vmaf_picture_step(src, p));
+        } else {
+            decimate_plane_uint8_t(src->data[p], src->stride[p],
+                                   dst->data[p], dst->stride[p],
+                                   dst->w[p], dst->h[p], factor,
+                                   vmaf_picture_step(src, p));
+        }
+    }
+
+    return 0;
+}
+
+const VmafPreviewCorrection *vmaf_preview_correction(const char *feature_name,
+                                                     unsigned factor)
+{
+    for (unsigned i = 0; i < preview_table_cnt; i++) {
+        if (preview_table[i].factor != factor)
+            continue;
+        for (unsigned j = 0; j < PREVIEW_CORRECTION_CNT; j++) {
+            const VmafPreviewCorrection *c = &preview_table[i].correction[j];
+            if (c->feature_name && !strcmp(c->feature_name, feature_name))
+                return c;
+        }
+    }
+    return NULL;
+}
+
+double vmaf_preview_expected_error(unsigned factor)
+{
+    for (unsigned i = 0; i < preview_table_cnt; i++) {
+        if (preview_table[i].factor == factor)
+            return preview_table[i].expected_error;
+    }
+    return 0.;
+}
@@ -0,0 +1,60 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_SRC_PREVIEW_H__
+#define __VMAF_SRC_PREVIEW_H__
+
+#include <stdbool.h>
+
+#include "libvmaf/picture.h"
+
+/**
+ * Preview mode extracts features from pictures decimated by 2 in both
+ * dimensions. Preview feature scores differ systematically from full
+ * resolution ones, a linear correction per feature is composed into the
+ * normalization of a model loaded with a preview flag.
+ */
+typedef struct VmafPreviewCorrection {
+    const char *feature_name; ///< Alias, see `vmaf_feature_name_alias()`.
+    double slope, intercept; ///< full ~= slope * preview + intercept
+} VmafPreviewCorrection;
+
+bool vmaf_preview_factor_valid(unsigned factor);
+
+/**
+ * Fill `dst` with `src` decimated by `factor`, `dst` is allocated by the
+ * caller with the same format and the decimated dimensions. Every plane
+ * is box averaged over `factor` x `factor` blocks.
+ */
+int vmaf_preview_decimate(VmafPicture *dst, VmafPicture *src, unsigned factor);
+
+/**
+ * Correction of a feature at `factor`, NULL if its preview score is used
+ * as is.
+ */
+const VmafPreviewCorrection *vmaf_preview_correction(const char *feature_name,
+                                                     unsigned factor);
+
+/**
+ * RMS difference, in VMAF score points, between per-picture scores of a
+ * corrected preview model and the full resolution model, measured when the
+ * corrections were calibrated.
+ */
+double vmaf_preview_expected_error(unsigned factor);
+
+#endif /* __VMAF_SRC_PREVIEW_H__ */
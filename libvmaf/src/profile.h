@@ -0,0 +1,64 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_SRC_PROFILE_H__
+#define __VMAF_SRC_PROFILE_H__
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Counters are only updated by the thread which owns them, e.g. the thread
+ * running a feature extractor context or holding the collector lock, and
+ * only read after `vmaf_thread_pool_wait()`, so they need no atomics.
+ */
+typedef struct VmafProfileCounter {
+    uint64_t cnt; ///< Number of timed calls.
+    uint64_t wall, cpu; ///< Summed wall and thread CPU time, in ns.
+} VmafProfileCounter;
+
+static inline uint64_t vmaf_profile_time(clockid_t clock_id)
+{
+    struct timespec ts;
+    if (clock_gettime(clock_id, &ts)) return 0;
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline uint64_t vmaf_profile_wall(void)
+{
+    return vmaf_profile_time(CLOCK_MONOTONIC);
+}
+
+static inline uint64_t vmaf_profile_cpu(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    return vmaf_profile_time(CLOCK_THREAD_CPUTIME_ID);
+#else
+    return 0;
+#endif
+}
+
+static inline void vmaf_profile_counter_add(VmafProfileCounter *dst,
+                                            const VmafProfileCounter *src)
+{
+    dst->cnt += src->cnt;
+    dst->wall += src->wall;
+    dst->cpu += src->cpu;
+}
+
+#endif /* __VMAF_SRC_PROFILE_H__ */
@@ -0,0 +1,408 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "libvmaf/reader.h"
+#include "picture.h"
+#include "picture_pool.h"
+
+#define Y4M_MAGIC "YUV4MPEG2 "
+#define Y4M_FRAME_HEADER "FRAME\n"
+#define Y4M_HEADER_MAX_SZ 1024
+#define READER_IOV_CNT 256
+
+typedef struct VmafReader {
+    int fd;
+    bool seekable;
+    VmafReaderInfo info;
+    off_t data_offset; ///< Offset of the first frame.
+    size_t frame_hdr_sz;
+    size_t frame_sz; ///< Frame size in the file, including the header.
+    unsigned w[3], h[3]; ///< Plane dimensions as stored in the file.
+    unsigned planes; ///< Planes which are read, see enum VmafPlane.
+    void *discard; ///< Rows which are not kept, odd dimensions or planes.
+    VmafPicturePool *pool;
+    pthread_mutex_t lock; ///< Serializes reads from unseekable inputs.
+    unsigned next_index;
+} VmafReader;
+
+static int reader_init(VmafReader *r, enum VmafPixelFormat pix_fmt,
+                       unsigned bpc, unsigned w, unsigned h)
+{
+    if (!pix_fmt) return -EINVAL;
+    if (bpc < 8 || bpc > 16) return -EINVAL;
+    if (!w || !h) return -EINVAL;
+    if (pix_fmt == VMAF_PIX_FMT_NV12 && bpc != 8) return -EINVAL;
+    if (pix_fmt == VMAF_PIX_FMT_P010 && bpc != 10) return -EINVAL;
+    const int semiplanar = vmaf_pix_fmt_semiplanar(pix_fmt);
+    if (semiplanar && ((w | h) & 1)) return -EINVAL;
+
+    r->info.pix_fmt = pix_fmt;
+    r->info.bpc = bpc;
+    r->info.w = w;
+    r->info.h = h;
+
+    const int ss_hor = vmaf_pix_fmt_ss_hor(pix_fmt);
+    const int ss_ver = vmaf_pix_fmt_ss_ver(pix_fmt);
+    const size_t bytes_per_sample = bpc > 8 ? 2 : 1;
+    r->w[0] = w;
+    r->h[0] = h;
+    r->w[1] = r->w[2] = (w + ss_hor) >> ss_hor;
+    r->h[1] = r->h[2] = (h + ss_ver) >> ss_ver;
+    // interleaved chroma is read as one plane of twice the width
+    if (semiplanar) {
+        r->w[1] <<= 1;
+        r->w[2] = r->h[2] = 0;
+    }
+    r->frame_sz = r->frame_hdr_sz;
+    for (unsigned i = 0; i < 3; i++)
+        r->frame_sz += bytes_per_sample * r->w[i] * r->h[i];
+
+    if ((h & ss_ver) || (w & ss_hor)) {
+        r->discard = malloc(bytes_per_sample * r->w[1]);
+        if (!r->discard) return -ENOMEM;
+    }
+
+    struct stat st;
+    if (fstat(r->fd, &st)) return -errno;
+    r->seekable = S_ISREG(st.st_mode);
+    if (r->seekable && st.st_size > r->data_offset)
+        r->info.frame_cnt = (st.st_size - r->data_offset) / r->frame_sz;
+
+    r->planes = VMAF_PLANES_ALL;
+    int err = vmaf_picture_pool_init(&r->pool, pix_fmt, bpc, w, h,
+                                     r->planes);
+    if (err) return err;
+    if (pthread_mutex_init(&(r->lock), NULL)) {
+        vmaf_picture_pool_close(r->pool);
+        r->pool = NULL;
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+static int reader_alloc(VmafReader **reader, const char *path)
+{
+    if (!reader) return -EINVAL;
+    if (!path) return -EINVAL;
+
+    VmafReader *const r = *reader = malloc(sizeof(*r));
+    if (!r) return -ENOMEM;
+    memset(r, 0, sizeof(*r));
+    r->fd = open(path, O_RDONLY);
+    if (r->fd < 0) {
+        const int err = -errno;
+        free(r);
+        return err;
+    }
+    return 0;
+}
+
+static void reader_free(VmafReader *r)
+{
+    close(r->fd);
+    free(r->discard);
+    free(r);
+}
+
+static int parse_colorspace(const char *tag, enum VmafPixelFormat *pix_fmt,
+                            unsigned *bpc)
+{
+    if (!strncmp(tag, "420", 3))
+        *pix_fmt = VMAF_PIX_FMT_YUV420P;
+    else if (!strncmp(tag, "422", 3))
+        *pix_fmt = VMAF_PIX_FMT_YUV422P;
+    else if (!strncmp(tag, "444", 3))
+        *pix_fmt = VMAF_PIX_FMT_YUV444P;
+    else
+        return -EINVAL;
+    tag += 3;
+
+    // 420jpeg, 420paldv and 420mpeg2 only differ in chroma siting
+    if (!*tag || !strcmp(tag, "jpeg") || !strcmp(tag, "paldv") ||
+        !strcmp(tag, "mpeg2")) {
+        *bpc = 8;
+        return 0;
+    }
+    if (*tag != 'p') return -EINVAL;
+    char *end;
+    *bpc = strtoul(tag + 1, &end, 10);
+    return *end ? -EINVAL : 0;
+}
+
+static int parse_y4m_header(VmafReader *r, enum VmafPixelFormat *pix_fmt,
+                            unsigned *bpc, unsigned *w, unsigned *h)
+{
+    char header[Y4M_HEADER_MAX_SZ];
+    size_t sz = 0;
+
+    // byte by byte, pipes can not be rewound
+    for (;;) {
+        if (sz == sizeof(header)) return -EINVAL;
+        ssize_t n = read(r->fd, header + sz, 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -errno;
+        if (!n) return -EINVAL;
+        if (header[sz++] == '\n') break;
+    }
+    header[sz - 1] = '\0';
+    r->data_offset = sz;
+
+    if (strncmp(header, Y4M_MAGIC, strlen(Y4M_MAGIC))) return -EINVAL;
+
+    *pix_fmt = VMAF_PIX_FMT_YUV420P;
+    *bpc = 8;
+    *w = *h = 0;
+
+    char *save;
+    for (char *tag = strtok_r(header + strlen(Y4M_MAGIC), " ", &save); tag;
+         tag = strtok_r(NULL, " ", &save))
+    {
+        int err = 0;
+        switch (tag[0]) {
+        case 'W':
+            *w = strtoul(tag + 1, NULL, 10);
+            break;
+        case 'H':
+            *h = strtoul(tag + 1, NULL, 10);
+            break;
+        case 'C':
+            err = parse_colorspace(tag + 1, pix_fmt, bpc);
+            break;
+        case 'I':
+            if (tag[1] != 'p' && tag[1] != '?') err = -EINVAL;
+            break;
+        default:
+            break;
+        }
+        if (err) return err;
+    }
+
+    return 0;
+}
+
+int vmaf_reader_open_y4m(VmafReader **reader, const char *path)
+{
+    int err = reader_alloc(reader, path);
+    if (err) return err;
+    VmafReader *const r = *reader;
+
+    enum VmafPixelFormat pix_fmt;
+    unsigned bpc, w, h;
+    err = parse_y4m_header(r, &pix_fmt, &bpc, &w, &h);
+    if (err) goto fail;
+
+    r->frame_hdr_sz = strlen(Y4M_FRAME_HEADER);
+    err = reader_init(r, pix_fmt, bpc, w, h);
+    if (err) goto fail;
+
+    if (r->seekable && r->info.frame_cnt) {
+        char frame_hdr[sizeof(Y4M_FRAME_HEADER)];
+        if (pread(r->fd, frame_hdr, r->frame_hdr_sz, r->data_offset) !=
+            (ssize_t)r->frame_hdr_sz ||
+            memcmp(frame_hdr, Y4M_FRAME_HEADER, r->frame_hdr_sz))
+        {
+            vmaf_reader_close(r);
+            return -EINVAL;
+        }
+    }
+
+    return 0;
+
+fail:
+    reader_free(r);
+    return err;
+}
+
+int vmaf_reader_open_yuv(VmafReader **reader, const char *path,
+                         enum VmafPixelFormat pix_fmt, unsigned bpc,
+                         unsigned w, unsigned h)
+{
+    int err = reader_alloc(reader, path);
+    if (err) return err;
+
+    err = reader_init(*reader, pix_fmt, bpc, w, h);
+    if (err) reader_free(*reader);
+    return err;
+}
+
+int vmaf_reader_get_info(VmafReader *reader, VmafReaderInfo *info)
+{
+    if (!reader) return -EINVAL;
+    if (!info) return -EINVAL;
+
+    *info = reader->info;
+    return 0;
+}
+
+int vmaf_reader_set_planes(VmafReader *reader, unsigned planes)
+{
+    if (!reader) return -EINVAL;
+    if (!(planes & VMAF_PLANE_Y)) return -EINVAL;
+    if (planes & ~VMAF_PLANES_ALL) return -EINVAL;
+
+    VmafReader *const r = reader;
+    if (planes == r->planes) return 0;
+
+    if (!r->discard) {
+        const size_t bytes_per_sample = r->info.bpc > 8 ? 2 : 1;
+        r->discard = malloc(bytes_per_sample * r->w[1]);
+        if (!r->discard) return -ENOMEM;
+    }
+
+    VmafPicturePool *pool;
+    int err = vmaf_picture_pool_init(&pool, r->info.pix_fmt, r->info.bpc,
+                                     r->info.w, r->info.h, planes);
+    if (err) return err;
+    vmaf_picture_pool_close(r->pool);
+    r->pool = pool;
+    r->planes = planes;
+    return 0;
+}
+
+static int readv_full(VmafReader *r, struct iovec *iov, int cnt,
+                      off_t *offset)
+{
+    while (cnt) {
+        ssize_t n;
+        if (r->seekable) {
+#ifdef HAVE_PREADV
+            n = preadv(r->fd, iov, cnt, *offset);
+#else
+            n = pread(r->fd, iov->iov_base, iov->iov_len, *offset);
+#endif
+        } else {
+            n = readv(r->fd, iov, cnt);
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -errno;
+        if (!n) return 1;
+
+        *offset += n;
+        while (cnt && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt) {
+            iov->iov_base = (uint8_t*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return 0;
+}
+
+static int read_frame(VmafReader *r, VmafPicture *pic, off_t offset)
+{
+    struct iovec iov[READER_IOV_CNT];
+    char frame_hdr[sizeof(Y4M_FRAME_HEADER)];
+    const size_t bytes_per_sample = r->info.bpc > 8 ? 2 : 1;
+    int cnt = 0, err;
+
+    if (r->frame_hdr_sz) {
+        iov[cnt].iov_base = frame_hdr;
+        iov[cnt++].iov_len = r->frame_hdr_sz;
+    }
+
+    // one scatter read per batch of rows, straight into the strided planes
+    for (unsigned i = 0; i < 3; i++) {
+        uint8_t *data = pic->data[i];
+        const size_t row_sz = bytes_per_sample * r->w[i];
+
+        // planes which are not kept are seeked past, pipes read them anyway
+        if (!data && r->seekable) {
+            if (cnt) {
+                err = readv_full(r, iov, cnt, &offset);
+                if (err) return err;
+                cnt = 0;
+            }
+            offset += row_sz * r->h[i];
+            continue;
+        }
+
+        for (unsigned j = 0; j < r->h[i]; j++) {
+            iov[cnt].iov_base = data && j < pic->h[i] ? data : r->discard;
+            iov[cnt++].iov_len = row_sz;
+            if (data)
+                data += pic->stride[i];
+            if (cnt < READER_IOV_CNT) continue;
+            err = readv_full(r, iov, cnt, &offset);
+            if (err) return err;
+            cnt = 0;
+        }
+    }
+    if (cnt) {
+        err = readv_full(r, iov, cnt, &offset);
+        if (err) return err;
+    }
+
+    if (r->frame_hdr_sz && memcmp(frame_hdr, Y4M_FRAME_HEADER, r->frame_hdr_sz))
+        return -EINVAL;
+    return 0;
+}
+
+int vmaf_reader_read_picture(VmafReader *reader, VmafPicture *pic,
+                             unsigned index)
+{
+    if (!reader) return -EINVAL;
+    if (!pic) return -EINVAL;
+
+    VmafReader *const r = reader;
+    if (r->seekable && index >= r->info.frame_cnt) return 1;
+
+    int err = vmaf_picture_pool_fetch(r->pool, pic);
+    if (err) return err;
+
+    if (r->seekable) {
+        const off_t offset = r->data_offset + (off_t)index * r->frame_sz;
+        err = read_frame(r, pic, offset);
+    } else {
+        pthread_mutex_lock(&(r->lock));
+        if (index == r->next_index) {
+            err = read_frame(r, pic, 0);
+            r->next_index += !err;
+        } else {
+            err = -EINVAL;
+        }
+        pthread_mutex_unlock(&(r->lock));
+    }
+
+    if (err) vmaf_picture_unref(pic);
+    return err;
+}
+
+int vmaf_reader_close(VmafReader *reader)
+{
+    if (!reader) return -EINVAL;
+
+    pthread_mutex_destroy(&(reader->lock));
+    vmaf_picture_pool_close(reader->pool);
+    reader_free(reader);
+    return 0;
+}
@@ -0,0 +1,623 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "feature/feature_collector.h"
+#include "feature/feature_extractor.h"
+#include "picture.h"
+#include "ref_cache.h"
+
+#define NAME_MAX_LEN 4096
+#define SCORE_MAX_CNT 1024
+#define HISTORY_LEN 2
+#define FLUSH_KEY 0x68737566ULL
+
+typedef struct {
+    unsigned name;
+    int32_t offset;
+    double value;
+} RefCacheScore;
+
+typedef struct {
+    uint64_t key;
+    unsigned cnt;
+    RefCacheScore *score;
+} RefCacheRecord;
+
+typedef struct {
+    VmafFeatureExtractorContext *fex_ctx;
+    uint64_t base_key;
+    uint64_t last_key;
+    unsigned last_index;
+    bool has_last, flushed;
+    struct {
+        VmafPicture pic;
+        unsigned index;
+    } history[HISTORY_LEN]; ///< Pictures skipped since the last extract().
+    unsigned history_cnt;
+} RefCacheExtractor;
+
+struct VmafRefCache {
+    char *path;
+    bool has_header;
+    struct {
+        char **name;
+        unsigned cnt;
+    } names;
+    struct {
+        RefCacheRecord *record;
+        unsigned cnt, capacity, loaded;
+    } records;
+    struct {
+        unsigned *slot; ///< Record index + 1, 0 if empty.
+        unsigned capacity;
+    } table;
+    RefCacheExtractor *fex;
+    unsigned fex_cnt;
+    VmafFeatureCollector *scratch;
+    uint64_t luma_hash[HISTORY_LEN]; ///< Previous pictures, latest first.
+    unsigned seen;
+};
+
+static uint64_t hash_finalize(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+static uint64_t hash_combine(uint64_t h, uint64_t v)
+{
+    return hash_finalize(h ^ (v + 0x9e3779b97f4a7c15ULL));
+}
+
+static uint64_t hash_bytes(uint64_t h, const uint8_t *data, size_t sz)
+{
+    size_t i = 0;
+    for (; i + 8 <= sz; i += 8) {
+        uint64_t v;
+        memcpy(&v, data + i, sizeof(v));
+        h = (h ^ v) * 0x9e3779b97f4a7c15ULL;
+        h = (h << 31) | (h >> 33);
+    }
+    for (; i < sz; i++)
+        h = (h ^ data[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+static uint64_t luma_hash(VmafPicture *pic)
+{
+    const size_t row_sz = pic->w[0] * (pic->bpc > 8 ? 2 : 1);
+    const uint8_t *row = pic->data[0];
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned y = 0; y < pic->h[0]; y++, row += pic->stride[0])
+        h = hash_bytes(h, row, row_sz);
+    return hash_finalize(h);
+}
+
+static int write_u32(FILE *f, uint32_t v)
+{
+    const uint8_t b[4] = { v, v >> 8, v >> 16, v >> 24 };
+    return fwrite(b, sizeof(b), 1, f) == 1 ? 0 : -EIO;
+}
+
+static int write_f64(FILE *f, double v)
+{
+    uint64_t u;
+    memcpy(&u, &v, sizeof(u));
+    uint8_t b[8];
+    for (unsigned i = 0; i < 8; i++)
+        b[i] = u >> (8 * i);
+    return fwrite(b, sizeof(b), 1, f) == 1 ? 0 : -EIO;
+}
+
+static int read_u32(FILE *f, uint32_t *v)
+{
+    uint8_t b[4];
+    if (fread(b, sizeof(b), 1, f) != 1) return -EINVAL;
+    *v = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+    return 0;
+}
+
+static int read_f64(FILE *f, double *v)
+{
+    uint8_t b[8];
+    if (fread(b, sizeof(b), 1, f) != 1) return -EINVAL;
+    uint64_t u = 0;
+    for (unsigned i = 0; i < 8; i++)
+        u |= (uint64_t)b[i] << (8 * i);
+    memcpy(v, &u, sizeof(*v));
+    return 0;
+}
+
+static int name_index(VmafRefCache *c, const char *name, unsigned *index)
+{
+    for (unsigned i = 0; i < c->names.cnt; i++) {
+        if (!strcmp(c->names.name[i], name)) {
+            *index = i;
+            return 0;
+        }
+    }
+
+    char **names = realloc(c->names.name,
+                           sizeof(*names) * (c->names.cnt + 1));
+    if (!names) return -ENOMEM;
+    c->names.name = names;
+    char *n = malloc(strlen(name) + 1);
+    if (!n) return -ENOMEM;
+    strcpy(n, name);
+    names[c->names.cnt] = n;
+    *index = c->names.cnt++;
+    return 0;
+}
+
+static RefCacheRecord *record_find(VmafRefCache *c, uint64_t key)
+{
+    if (!c->table.capacity) return NULL;
+
+    const unsigned mask = c->table.capacity - 1;
+    for (unsigned i = key & mask; c->table.slot[i]; i = (i + 1) & mask) {
+        RefCacheRecord *record = &c->records.record[c->table.slot[i] - 1];
+        if (record->key == key)
+            return record;
+    }
+    return NULL;
+}
+
+static void table_put(VmafRefCache *c, unsigned record_index)
+{
+    const unsigned mask = c->table.capacity - 1;
+    unsigned i = c->records.record[record_index].key & mask;
+    while (c->table.slot[i])
+        i = (i + 1) & mask;
+    c->table.slot[i] = record_index + 1;
+}
+
+static int table_grow(VmafRefCache *c)
+{
+    const unsigned capacity = c->table.capacity ? c->table.capacity * 2 : 1024;
+    unsigned *slot = calloc(capacity, sizeof(*slot));
+    if (!slot) return -ENOMEM;
+    free(c->table.slot);
+    c->table.slot = slot;
+    c->table.capacity = capacity;
+    for (unsigned i = 0; i < c->records.cnt; i++)
+        table_put(c, i);
+    return 0;
+}
+
+/* takes ownership of record->score, duplicate keys keep the first record */
+static int record_insert(VmafRefCache *c, RefCacheRecord *record)
+{
+    if (record_find(c, record->key)) {
+        free(record->score);
+        return 0;
+    }
+
+    int err = 0;
+    if (c->records.cnt == c->records.capacity) {
+        const unsigned capacity =
+            c->records.capacity ? c->records.capacity * 2 : 1024;
+        RefCacheRecord *r =
+            realloc(c->records.record, sizeof(*r) * capacity);
+        if (!r) {
+            err = -ENOMEM;
+            goto fail;
+        }
+        c->records.record = r;
+        c->records.capacity = capacity;
+    }
+    if (2 * (c->records.cnt + 1) > c->table.capacity) {
+        err = table_grow(c);
+        if (err) goto fail;
+    }
+
+    c->records.record[c->records.cnt] = *record;
+    table_put(c, c->records.cnt++);
+    return 0;
+
+fail:
+    free(record->score);
+    return err;
+}
+
+static int record_push(VmafRefCache *c, RefCacheRecord *record,
+                       const char *name, int32_t offset, double value)
+{
+    unsigned index;
+    int err = name_index(c, name, &index);
+    if (err) return err;
+    RefCacheScore *score =
+        realloc(record->score, sizeof(*score) * (record->cnt + 1));
+    if (!score) return -ENOMEM;
+    record->score = score;
+    score[record->cnt++] = (RefCacheScore) {
+        .name = index, .offset = offset, .value = value,
+    };
+    return 0;
+}
+
+static int record_import(VmafRefCache *c, RefCacheRecord *record,
+                         unsigned index, VmafFeatureCollector *fc)
+{
+    for (unsigned i = 0; i < record->cnt; i++) {
+        RefCacheScore *score = &record->score[i];
+        if (score->offset < 0 && (unsigned)-score->offset > index)
+            continue;
+        int err = vmaf_feature_collector_append(fc, c->names.name[score->name],
+                                                score->value,
+                                                index + score->offset);
+        if (err) return err;
+    }
+    return 0;
+}
+
+/*
+ * Move the scores that an extractor wrote to the scratch collector while
+ * handling picture `index` to `fc`, and to `record` if set. Reference-only
+ * extractors write to the current and the two previous pictures only.
+ */
+static int drain_scratch(VmafRefCache *c, unsigned index,
+                         VmafFeatureCollector *fc, RefCacheRecord *record)
+{
+    VmafFeatureCollector *scratch = c->scratch;
+    const unsigned low = index > HISTORY_LEN ? index - HISTORY_LEN : 0;
+
+    for (unsigned j = 0; j < scratch->cnt; j++) {
+        FeatureVector *fv = scratch->feature_vector[j];
+        for (unsigned i = low; i <= index && i < fv->capacity; i++) {
+            if (!fv->score[i].written)
+                continue;
+            fv->score[i].written = false;
+            if (!fc)
+                continue;
+            int err = vmaf_feature_collector_append(fc, fv->name,
+                                                    fv->score[i].value, i);
+            if (err) return err;
+            if (!record)
+                continue;
+            err = record_push(c, record, fv->name, (int32_t)(i - index),
+                              fv->score[i].value);
+            if (err) return err;
+        }
+    }
+    return 0;
+}
+
+/* feed the extractor the pictures it skipped, their scores are known */
+static int catch_up(VmafRefCache *c, RefCacheExtractor *e)
+{
+    int err = 0;
+    for (unsigned i = 0; i < e->history_cnt; i++) {
+        VmafPicture *pic = &e->history[i].pic;
+        const unsigned index = e->history[i].index;
+        if (!err)
+            err = vmaf_feature_extractor_context_extract(e->fex_ctx, pic, pic,
+                                                         index, c->scratch);
+        if (!err)
+            err = drain_scratch(c, index, NULL, NULL);
+        vmaf_picture_unref(pic);
+    }
+    e->history_cnt = 0;
+    return err;
+}
+
+static int history_push(RefCacheExtractor *e, VmafPicture *pic,
+                        unsigned index)
+{
+    if (e->history_cnt == HISTORY_LEN) {
+        vmaf_picture_unref(&e->history[0].pic);
+        memmove(&e->history[0], &e->history[1],
+                sizeof(e->history[0]) * (HISTORY_LEN - 1));
+        e->history_cnt--;
+    }
+    e->history[e->history_cnt].index = index;
+    return vmaf_picture_ref(&e->history[e->history_cnt++].pic, pic);
+}
+
+static uint64_t frame_key(VmafRefCache *c, RefCacheExtractor *e,
+                          VmafPicture *ref, uint64_t luma, unsigned index)
+{
+    const unsigned depth = c->seen < HISTORY_LEN ? c->seen : HISTORY_LEN;
+    uint64_t key = hash_combine(e->base_key, ref->w[0]);
+    key = hash_combine(key, ref->h[0]);
+    key = hash_combine(key, ref->bpc);
+    key = hash_combine(key, ref->pix_fmt);
+    key = hash_combine(key, depth);
+    key = hash_combine(key, index == 0);
+    for (unsigned i = 0; i < depth; i++)
+        key = hash_combine(key, c->luma_hash[i]);
+    return hash_combine(key, luma);
+}
+
+static int extract(VmafRefCache *c, RefCacheExtractor *e, VmafPicture *ref,
+                   VmafPicture *dist, unsigned index, uint64_t key,
+                   VmafFeatureCollector *fc)
+{
+    RefCacheRecord *hit = record_find(c, key);
+    if (hit) {
+        int err = record_import(c, hit, index, fc);
+        if (err) return err;
+        return history_push(e, ref, index);
+    }
+
+    int err = catch_up(c, e);
+    if (err) return err;
+    err = vmaf_feature_extractor_context_extract(e->fex_ctx, ref, dist, index,
+                                                 c->scratch);
+    if (err) return err;
+    RefCacheRecord record = { .key = key };
+    err = drain_scratch(c, index, fc, &record);
+    if (err) {
+        free(record.score);
+        return err;
+    }
+    return record_insert(c, &record);
+}
+
+int vmaf_ref_cache_extract(VmafRefCache *cache, VmafPicture *ref,
+                           VmafPicture *dist, unsigned index,
+                           VmafFeatureCollector *feature_collector)
+{
+    if (!cache) return -EINVAL;
+    if (!ref) return -EINVAL;
+    if (!dist) return -EINVAL;
+    if (!feature_collector) return -EINVAL;
+    if (!cache->fex_cnt) return 0;
+
+    const uint64_t luma = luma_hash(ref);
+    for (unsigned i = 0; i < cache->fex_cnt; i++) {
+        RefCacheExtractor *e = &cache->fex[i];
+        const uint64_t key = frame_key(cache, e, ref, luma, index);
+        int err = extract(cache, e, ref, dist, index, key, feature_collector);
+        if (err) return err;
+        e->last_key = key;
+        e->last_index = index;
+        e->has_last = true;
+        e->flushed = false;
+    }
+
+    for (unsigned i = HISTORY_LEN - 1; i > 0; i--)
+        cache->luma_hash[i] = cache->luma_hash[i - 1];
+    cache->luma_hash[0] = luma;
+    cache->seen++;
+    return 0;
+}
+
+int vmaf_ref_cache_flush(VmafRefCache *cache,
+                         VmafFeatureCollector *feature_collector)
+{
+    if (!cache) return -EINVAL;
+    if (!feature_collector) return -EINVAL;
+
+    for (unsigned i = 0; i < cache->fex_cnt; i++) {
+        RefCacheExtractor *e = &cache->fex[i];
+        if (!e->has_last || e->flushed)
+            continue;
+        e->flushed = true;
+
+        const uint64_t key = hash_combine(e->last_key, FLUSH_KEY);
+        RefCacheRecord *hit = record_find(cache, key);
+        if (hit) {
+            int err = record_import(cache, hit, e->last_index,
+                                    feature_collector);
+            if (err) return err;
+            continue;
+        }
+
+        int err = catch_up(cache, e);
+        if (err) return err;
+        err = vmaf_feature_extractor_context_flush(e->fex_ctx,
+                                                   cache->scratch);
+        if (err) return err;
+        RefCacheRecord record = { .key = key };
+        err = drain_scratch(cache, e->last_index, feature_collector, &record);
+        if (err) {
+            free(record.score);
+            return err;
+        }
+        err = record_insert(cache, &record);
+        if (err) return err;
+    }
+    return 0;
+}
+
+int vmaf_ref_cache_attach(VmafRefCache *cache,
+                          VmafFeatureExtractorContext *fex_ctx)
+{
+    if (!cache) return -EINVAL;
+    if (!fex_ctx) return -EINVAL;
+    if (!(fex_ctx->fex->flags & VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY))
+        return -EINVAL;
+    if (cache->seen) return -EINVAL;
+
+    RefCacheExtractor *fex =
+        realloc(cache->fex, sizeof(*fex) * (cache->fex_cnt + 1));
+    if (!fex) return -ENOMEM;
+    cache->fex = fex;
+
+    RefCacheExtractor *e = &fex[cache->fex_cnt++];
+    memset(e, 0, sizeof(*e));
+    e->fex_ctx = fex_ctx;
+    const char *name = fex_ctx->fex->name;
+    e->base_key = hash_bytes(0xcbf29ce484222325ULL, (const uint8_t *)name,
+                             strlen(name));
+    e->base_key = hash_combine(e->base_key, fex_ctx->fex->version);
+    return 0;
+}
+
+static int read_record(VmafRefCache *c, FILE *f, RefCacheRecord *record)
+{
+    uint32_t key_lo, key_hi, cnt;
+    if (read_u32(f, &key_lo) || read_u32(f, &key_hi) || read_u32(f, &cnt))
+        return -EINVAL;
+    if (cnt > SCORE_MAX_CNT) return -EINVAL;
+
+    record->key = key_lo | ((uint64_t)key_hi << 32);
+    record->cnt = 0;
+    record->score = NULL;
+
+    char name[NAME_MAX_LEN + 1];
+    for (unsigned i = 0; i < cnt; i++) {
+        uint32_t name_len, offset;
+        double value;
+        int err = read_u32(f, &name_len);
+        if (err || !name_len || name_len > NAME_MAX_LEN) goto fail;
+        if (fread(name, name_len, 1, f) != 1) goto fail;
+        name[name_len] = '\0';
+        if (read_u32(f, &offset) || read_f64(f, &value)) goto fail;
+        err = record_push(c, record, name, (int32_t)offset, value);
+        if (err) goto fail;
+    }
+    return 0;
+
+fail:
+    free(record->score);
+    return -EINVAL;
+}
+
+static int load(VmafRefCache *c, FILE *f)
+{
+    char magic[8];
+    const size_t n = fread(magic, 1, sizeof(magic), f);
+    if (!n) return 0;
+    if (n != sizeof(magic)) return -EINVAL;
+    if (memcmp(magic, VMAF_REF_CACHE_MAGIC, sizeof(magic))) return -EINVAL;
+    uint32_t version;
+    if (read_u32(f, &version)) return -EINVAL;
+    if (version != VMAF_REF_CACHE_VERSION) return -EINVAL;
+    c->has_header = true;
+
+    // a truncated last record is dropped, it is the tail of an interrupted
+    // append
+    RefCacheRecord record;
+    while (!read_record(c, f, &record)) {
+        int err = record_insert(c, &record);
+        if (err) return err;
+    }
+    c->records.loaded = c->records.cnt;
+    return 0;
+}
+
+static int write_record(VmafRefCache *c, FILE *f, RefCacheRecord *record)
+{
+    int err = write_u32(f, record->key);
+    err |= write_u32(f, record->key >> 32);
+    err |= write_u32(f, record->cnt);
+    for (unsigned i = 0; i < record->cnt; i++) {
+        const char *name = c->names.name[record->score[i].name];
+        const size_t name_len = strlen(name);
+        err |= write_u32(f, name_len);
+        if (fwrite(name, name_len, 1, f) != 1) return -EIO;
+        err |= write_u32(f, (uint32_t)record->score[i].offset);
+        err |= write_f64(f, record->score[i].value);
+    }
+    return err ? -EIO : 0;
+}
+
+static int store(VmafRefCache *c)
+{
+    if (c->records.cnt == c->records.loaded) return 0;
+
+    FILE *f = fopen(c->path, "ab");
+    if (!f) return -EIO;
+
+    int err = 0;
+    if (!c->has_header) {
+        if (fwrite(VMAF_REF_CACHE_MAGIC, strlen(VMAF_REF_CACHE_MAGIC), 1, f)
+            != 1)
+        {
+            err = -EIO;
+        }
+        if (!err)
+            err = write_u32(f, VMAF_REF_CACHE_VERSION);
+    }
+    for (unsigned i = c->records.loaded; !err && i < c->records.cnt; i++)
+        err = write_record(c, f, &c->records.record[i]);
+    if (fclose(f)) err = -EIO;
+    return err;
+}
+
+static void cache_free(VmafRefCache *c)
+{
+    for (unsigned i = 0; i < c->fex_cnt; i++) {
+        RefCacheExtractor *e = &c->fex[i];
+        for (unsigned j = 0; j < e->history_cnt; j++)
+            vmaf_picture_unref(&e->history[j].pic);
+    }
+    free(c->fex);
+    for (unsigned i = 0; i < c->records.cnt; i++)
+        free(c->records.record[i].score);
+    free(c->records.record);
+    free(c->table.slot);
+    for (unsigned i = 0; i < c->names.cnt; i++)
+        free(c->names.name[i]);
+    free(c->names.name);
+    if (c->scratch)
+        vmaf_feature_collector_destroy(c->scratch);
+    free(c->path);
+    free(c);
+}
+
+int vmaf_ref_cache_open(VmafRefCache **cache, const char *path)
+{
+    if (!cache) return -EINVAL;
+    if (!path) return -EINVAL;
+
+    VmafRefCache *const c = *cache = malloc(sizeof(*c));
+    if (!c) return -ENOMEM;
+    memset(c, 0, sizeof(*c));
+
+    int err = -ENOMEM;
+    c->path = malloc(strlen(path) + 1);
+    if (!c->path) goto fail;
+    strcpy(c->path, path);
+    err = vmaf_feature_collector_init(&c->scratch);
+    if (err) goto fail;
+
+    FILE *f = fopen(path, "rb");
+    if (f) {
+        err = load(c, f);
+        fclose(f);
+        if (err) goto fail;
+    }
+    return 0;
+
+fail:
+    cache_free(c);
+    *cache = NULL;
+    return err;
+}
+
+int vmaf_ref_cache_close(VmafRefCache *cache)
+{
+    if (!cache) return -EINVAL;
+
+    const int err = store(cache);
+    cache_free(cache);
+    return err;
+}
@@ -0,0 +1,84 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_REF_CACHE_H__
+#define __VMAF_REF_CACHE_H__
+
+#include <stdint.h>
+
+#include "feature/feature_collector.h"
+#include "feature/feature_extractor.h"
+#include "libvmaf/picture.h"
+
+#define VMAF_REF_CACHE_MAGIC "VMAFRCCH"
+#define VMAF_REF_CACHE_VERSION 1
+
+/**
+ * On-disk cache of the scores of reference-only feature extractors, see
+ * VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY. Every extract() call is keyed by
+ * the extractor name and version, the picture parameters and a hash of the
+ * reference luma of the current and the two previous pictures. On a hit, the
+ * cached scores are imported and the extractor is skipped; the skipped
+ * pictures are kept so that the extractor can catch up on the next miss.
+ * New records are appended to the file by `vmaf_ref_cache_close()`.
+ * All fields are little endian:
+ *
+ *   char[8]  magic, "VMAFRCCH"
+ *   u32      version
+ *   per record:
+ *     u32    key, low half
+ *     u32    key, high half
+ *     u32    score count
+ *     per score:
+ *       u32  name length, followed by the name
+ *       u32  picture index, relative to the keyed picture, two's complement
+ *       f64  score
+ */
+typedef struct VmafRefCache VmafRefCache;
+
+int vmaf_ref_cache_open(VmafRefCache **cache, const char *path);
+
+/**
+ * Route a reference-only feature extractor through the cache. It should
+ * not be run by anything else from here on.
+ */
+int vmaf_ref_cache_attach(VmafRefCache *cache,
+                          VmafFeatureExtractorContext *fex_ctx);
+
+/**
+ * Extract, or import from the cache, the scores of every attached feature
+ * extractor for one picture pair. Pictures must be read in order.
+ */
+int vmaf_ref_cache_extract(VmafRefCache *cache, VmafPicture *ref,
+                           VmafPicture *dist, unsigned index,
+                           VmafFeatureCollector *feature_collector);
+
+/**
+ * Flush every attached feature extractor, see
+ * `vmaf_feature_extractor_context_flush()`. Repeated calls do nothing until
+ * the next picture is read.
+ */
+int vmaf_ref_cache_flush(VmafRefCache *cache,
+                         VmafFeatureCollector *feature_collector);
+
+/**
+ * Append new records to the cache file and free the cache.
+ */
+int vmaf_ref_cache_close(VmafRefCache *cache);
+
+#endif /* __VMAF_REF_CACHE_H__ */
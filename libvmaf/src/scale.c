@@ -0,0 +1,295 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "feature/common/cpu.h"
+#include "picture.h"
+#include "scale.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+extern enum vmaf_cpu cpu;
+
+typedef struct ScaleFilter {
+    unsigned taps; ///< Per output sample.
+    unsigned *pos; ///< Source offset of each tap, in samples.
+    float *coef; ///< Weight of each tap, they sum up to 1.
+} ScaleFilter;
+
+struct VmafScaler {
+    enum VmafPixelFormat pix_fmt;
+    struct {
+        unsigned src_w, src_h, dst_w, dst_h;
+        ScaleFilter hor, ver;
+    } plane[2]; ///< Luma and chroma.
+    float *tmp; ///< Horizontally filtered rows of one plane.
+    float *line; ///< One vertically filtered row.
+    const float **rows; ///< Rows of `tmp` under the vertical taps.
+};
+
+static double bicubic(double x)
+{
+    // Keys' cubic with a = -0.5
+    const double a = -0.5;
+    x = fabs(x);
+    if (x < 1.)
+        return ((a + 2.) * x - (a + 3.)) * x * x + 1.;
+    if (x < 2.)
+        return ((a * x - 5. * a) * x + 8. * a) * x - 4. * a;
+    return 0.;
+}
+
+static double sinc(double x)
+{
+    if (x == 0.)
+        return 1.;
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+static double lanczos(double x)
+{
+    return fabs(x) < 3. ? sinc(x) * sinc(x / 3.) : 0.;
+}
+
+static int filter_init(ScaleFilter *f, enum VmafScaleFilter filter,
+                       unsigned src_n, unsigned dst_n, unsigned step)
+{
+    double (*const kernel)(double) =
+        filter == VMAF_SCALE_FILTER_LANCZOS ? lanczos : bicubic;
+    const double support = filter == VMAF_SCALE_FILTER_LANCZOS ? 3. : 2.;
+    // downscaling stretches the kernel over the source samples it covers
+    const double ratio = (double) src_n / dst_n;
+    const double stretch = ratio > 1. ? ratio : 1.;
+    const double radius = support * stretch;
+
+    f->taps = 2 * (unsigned) ceil(radius);
+    f->pos = malloc(sizeof(*f->pos) * f->taps * dst_n);
+    f->coef = malloc(sizeof(*f->coef) * f->taps * dst_n);
+    if (!f->pos || !f->coef) return -ENOMEM;
+
+    for (unsigned i = 0; i < dst_n; i++) {
+        const double center = (i + 0.5) * ratio - 0.5;
+        const long first = (long) floor(center - radius) + 1;
+        unsigned *pos = f->pos + i * f->taps;
+        float *coef = f->coef + i * f->taps;
+
+        double sum = 0.;
+        for (unsigned k = 0; k < f->taps; k++)
+            sum += kernel((first + (long) k - center) / stretch);
+        for (unsigned k = 0; k < f->taps; k++) {
+            long x = first + (long) k;
+            coef[k] = kernel((x - center) / stretch) / sum;
+            // the edge samples are repeated
+            x = x < 0 ? 0 : x >= (long) src_n ? (long) src_n - 1 : x;
+            pos[k] = x * step;
+        }
+    }
+    return 0;
+}
+
+static void filter_close(ScaleFilter *f)
+{
+    free(f->pos);
+    free(f->coef);
+}
+
+int vmaf_scaler_init(VmafScaler **s, enum VmafScaleFilter filter,
+                     enum VmafPixelFormat pix_fmt, unsigned src_w,
+                     unsigned src_h, unsigned dst_w, unsigned dst_h)
+{
+    if (!s) return -EINVAL;
+    if (filter != VMAF_SCALE_FILTER_BICUBIC &&
+        filter != VMAF_SCALE_FILTER_LANCZOS)
+    {
+        return -EINVAL;
+    }
+    if (!pix_fmt) return -EINVAL;
+
+    const int ss_hor = vmaf_pix_fmt_ss_hor(pix_fmt);
+    const int ss_ver = vmaf_pix_fmt_ss_ver(pix_fmt);
+    if (!(src_w >> ss_hor) || !(src_h >> ss_ver)) return -EINVAL;
+    if (!(dst_w >> ss_hor) || !(dst_h >> ss_ver)) return -EINVAL;
+
+    VmafScaler *const sc = *s = malloc(sizeof(*sc));
+    if (!sc) return -ENOMEM;
+    memset(sc, 0, sizeof(*sc));
+    sc->pix_fmt = pix_fmt;
+
+    size_t tmp_sz = 0;
+    unsigned line_sz = 0, taps = 0;
+    for (unsigned p = 0; p < 2; p++) {
+        const int sh = p ? ss_hor : 0, sv = p ? ss_ver : 0;
+        const unsigned step = p && vmaf_pix_fmt_semiplanar(pix_fmt) ? 2 : 1;
+        sc->plane[p].src_w = src_w >> sh;
+        sc->plane[p].src_h = src_h >> sv;
+        sc->plane[p].dst_w = dst_w >> sh;
+        sc->plane[p].dst_h = dst_h >> sv;
+
+        int err = filter_init(&sc->plane[p].hor, filter, sc->plane[p].src_w,
+                              sc->plane[p].dst_w, step);
+        if (!err)
+            err = filter_init(&sc->plane[p].ver, filter, sc->plane[p].src_h,
+                              sc->plane[p].dst_h, 1);
+        if (err) {
+            vmaf_scaler_close(sc);
+            return err;
+        }
+
+        const size_t sz = (size_t) sc->plane[p].src_h * sc->plane[p].dst_w;
+        tmp_sz = sz > tmp_sz ? sz : tmp_sz;
+        if (sc->plane[p].dst_w > line_sz) line_sz = sc->plane[p].dst_w;
+        if (sc->plane[p].ver.taps > taps) taps = sc->plane[p].ver.taps;
+    }
+
+    sc->tmp = malloc(sizeof(*sc->tmp) * tmp_sz);
+    sc->line = malloc(sizeof(*sc->line) * line_sz);
+    sc->rows = malloc(sizeof(*sc->rows) * taps);
+    if (!sc->tmp || !sc->line || !sc->rows) {
+        vmaf_scaler_close(sc);
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+static void scale_rows(float *tmp, const ScaleFilter *f, VmafPicture *src,
+                       unsigned i, unsigned h, unsigned w)
+{
+    const unsigned shift = vmaf_picture_shift(src);
+
+    for (unsigned y = 0; y < h; y++) {
+        const uint8_t *row = (uint8_t *) src->data[i] + y * src->stride[i];
+        float *t = tmp + y * w;
+        const unsigned *pos = f->pos;
+        const float *coef = f->coef;
+
+        if (src->bpc > 8) {
+            const uint16_t *row16 = (const uint16_t *) row;
+            for (unsigned x = 0; x < w; x++) {
+                float sum = 0.f;
+                for (unsigned k = 0; k < f->taps; k++)
+                    sum += coef[k] * (row16[pos[k]] >> shift);
+                t[x] = sum;
+                pos += f->taps;
+                coef += f->taps;
+            }
+        } else {
+            for (unsigned x = 0; x < w; x++) {
+                float sum = 0.f;
+                for (unsigned k = 0; k < f->taps; k++)
+                    sum += coef[k] * row[pos[k]];
+                t[x] = sum;
+                pos += f->taps;
+                coef += f->taps;
+            }
+        }
+    }
+}
+
+static void scale_vertical(float *dst, const float *const *rows,
+                           const float *coef, unsigned taps, unsigned w)
+{
+    for (unsigned x = 0; x < w; x++) {
+        float sum = rows[0][x] * coef[0];
+        for (unsigned k = 1; k < taps; k++)
+            sum += rows[k][x] * coef[k];
+        dst[x] = sum;
+    }
+}
+
+static void scale_columns(VmafScaler *s, const ScaleFilter *f,
+                          VmafPicture *dst, unsigned i, unsigned h,
+                          unsigned w)
+{
+    const unsigned step = vmaf_picture_step(dst, i);
+    const unsigned shift = vmaf_picture_shift(dst);
+    const float max = (1 << dst->bpc) - 1;
+
+    for (unsigned y = 0; y < h; y++) {
+        const unsigned *pos = f->pos + y * f->taps;
+        const float *coef = f->coef + y * f->taps;
+        for (unsigned k = 0; k < f->taps; k++)
+            s->rows[k] = s->tmp + pos[k] * w;
+
+        if (cpu >= VMAF_CPU_AVX)
+            scale_vertical_avx(s->line, s->rows, coef, f->taps, w);
+        else
+            scale_vertical(s->line, s->rows, coef, f->taps, w);
+
+        // negative lobes over- and undershoot at edges
+        uint8_t *row = (uint8_t *) dst->data[i] + y * dst->stride[i];
+        for (unsigned x = 0; x < w; x++) {
+            const float v = s->line[x] < 0.f ? 0.f :
+                            s->line[x] > max ? max : s->line[x];
+            const unsigned q = (unsigned) (v + 0.5f) << shift;
+            if (dst->bpc > 8)
+                ((uint16_t *) row)[x * step] = q;
+            else
+                row[x * step] = q;
+        }
+    }
+}
+
+int vmaf_scaler_scale(VmafScaler *s, VmafPicture *dst, VmafPicture *src)
+{
+    if (!s) return -EINVAL;
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+    if (src->pix_fmt != s->pix_fmt || dst->pix_fmt != s->pix_fmt)
+        return -EINVAL;
+    if (src->bpc != dst->bpc) return -EINVAL;
+    if (src->w[0] != s->plane[0].src_w || src->h[0] != s->plane[0].src_h)
+        return -EINVAL;
+    if (dst->w[0] != s->plane[0].dst_w || dst->h[0] != s->plane[0].dst_h)
+        return -EINVAL;
+
+    for (unsigned i = 0; i < 3; i++) {
+        if (!dst->data[i])
+            continue;
+        if (!src->data[i])
+            return -EINVAL;
+
+        const unsigned p = i ? 1 : 0;
+        scale_rows(s->tmp, &s->plane[p].hor, src, i, s->plane[p].src_h,
+                   s->plane[p].dst_w);
+        scale_columns(s, &s->plane[p].ver, dst, i, s->plane[p].dst_h,
+                      s->plane[p].dst_w);
+    }
+    return 0;
+}
+
+void vmaf_scaler_close(VmafScaler *s)
+{
+    if (!s) return;
+
+    for (unsigned p = 0; p < 2; p++) {
+        filter_close(&s->plane[p].hor);
+        filter_close(&s->plane[p].ver);
+    }
+    free(s->tmp);
+    free(s->line);
+    free(s->rows);
+    free(s);
+}
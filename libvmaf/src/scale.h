@@ -0,0 +1,53 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_SRC_SCALE_H__
+#define __VMAF_SRC_SCALE_H__
+
+#include "libvmaf/libvmaf.rc.h"
+#include "libvmaf/picture.h"
+
+/**
+ * Separable resampling of whole pictures, see `VmafScaleFilter`. Filter
+ * taps and source positions are computed once per geometry. Rows are
+ * filtered horizontally into a float buffer, which is then filtered
+ * vertically 8 samples at a time with AVX. Chroma samples are taken as
+ * centered, which differs from the left siting of most 4:2:0 sources by a
+ * fraction of a chroma sample.
+ */
+typedef struct VmafScaler VmafScaler;
+
+int vmaf_scaler_init(VmafScaler **s, enum VmafScaleFilter filter,
+                     enum VmafPixelFormat pix_fmt, unsigned src_w,
+                     unsigned src_h, unsigned dst_w, unsigned dst_h);
+
+/**
+ * Fill `dst` with `src` resampled, `dst` is allocated by the caller with
+ * the same format and the destination dimensions of `s`. Planes missing
+ * from `dst` are skipped. One picture at a time, the filter buffers are
+ * shared.
+ */
+int vmaf_scaler_scale(VmafScaler *s, VmafPicture *dst, VmafPicture *src);
+
+void vmaf_scaler_close(VmafScaler *s);
+
+/* one output row, the weighted sum of `taps` rows of `w` floats */
+void scale_vertical_avx(float *dst, const float *const *rows,
+                        const float *coef, unsigned taps, unsigned w);
+
+#endif /* __VMAF_SRC_SCALE_H__ */
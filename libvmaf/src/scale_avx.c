@@ -0,0 +1,42 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+
+void scale_vertical_avx(float *dst, const float *const *rows,
+                        const float *coef, unsigned taps, unsigned w)
+{
+    unsigned x = 0;
+    for (; x + 8 <= w; x += 8) {
+        __m256 sum = _mm256_mul_ps(_mm256_loadu_ps(rows[0] + x),
+                                   _mm256_set1_ps(coef[0]));
+        for (unsigned k = 1; k < taps; k++) {
+            sum = _mm256_add_ps(sum,
+                                _mm256_mul_ps(_mm256_loadu_ps(rows[k] + x),
+                                              _mm256_set1_ps(coef[k])));
+        }
+        _mm256_storeu_ps(dst + x, sum);
+    }
+
+    for (; x < w; x++) {
+        float sum = rows[0][x] * coef[0];
+        for (unsigned k = 1; k < taps; k++)
+            sum += rows[k][x] * coef[k];
+        dst[x] = sum;
+    }
+}
@@ -0,0 +1,236 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "picture.h"
+#include "subsample.h"
+
+#define SUBSAMPLE_GRID 16 ///< Grid spacing, in luma pixels.
+#define SUBSAMPLE_PATCH 4 ///< Patch size, averaged to suppress noise.
+#define SUBSAMPLE_ACTIVITY 2. ///< Difference which halves the stride.
+#define SUBSAMPLE_CUT_MIN 12. ///< Smallest difference taken as a scene cut.
+#define SUBSAMPLE_CUT_RATIO 4. ///< Times the recent average difference.
+
+struct VmafSubsampler {
+    unsigned n_subsample;
+    struct {
+        float *cur, *prev;
+        unsigned w, h;
+    } grid;
+    double mean_diff; ///< Recent average motion, scene cuts capped.
+    unsigned since; ///< Pictures since the last scored one.
+    bool started;
+    struct {
+        uint8_t *skipped;
+        unsigned capacity;
+    } pic;
+};
+
+int vmaf_subsampler_init(VmafSubsampler **s, unsigned n_subsample)
+{
+    if (!s) return -EINVAL;
+
+    VmafSubsampler *const sub = *s = malloc(sizeof(*sub));
+    if (!sub) return -ENOMEM;
+    memset(sub, 0, sizeof(*sub));
+    sub->n_subsample = n_subsample > 1 ? n_subsample : 1;
+    return 0;
+}
+
+static int grid_alloc(VmafSubsampler *s, VmafPicture *ref)
+{
+    s->grid.w = ref->w[0] / SUBSAMPLE_GRID;
+    s->grid.h = ref->h[0] / SUBSAMPLE_GRID;
+    const size_t sz = sizeof(float) * 2 * (s->grid.w * s->grid.h + 1);
+    s->grid.cur = malloc(sz);
+    s->grid.prev = malloc(sz);
+    if (!s->grid.cur || !s->grid.prev) {
+        free(s->grid.cur);
+        free(s->grid.prev);
+        s->grid.cur = s->grid.prev = NULL;
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+/* mean and mean absolute horizontal gradient of the patch at (x, y) */
+static void patch_sample(VmafPicture *pic, unsigned x, unsigned y,
+                         float *mean, float *detail)
+{
+    unsigned sum = 0, grad = 0;
+    for (unsigned k = 0; k < SUBSAMPLE_PATCH; k++) {
+        const uint8_t *row = (uint8_t *) pic->data[0] +
+                             (y + k) * pic->stride[0];
+        int last = 0;
+        for (unsigned l = 0; l < SUBSAMPLE_PATCH; l++) {
+            const int v = pic->bpc > 8 ? ((const uint16_t *) row)[x + l] :
+                                         row[x + l];
+            if (l) grad += abs(v - last);
+            sum += v;
+            last = v;
+        }
+    }
+    const float scale = 1.f / (1 << (pic->bpc - 8 + vmaf_picture_shift(pic)));
+    *mean = scale * sum / (SUBSAMPLE_PATCH * SUBSAMPLE_PATCH);
+    *detail = scale * grad / (SUBSAMPLE_PATCH * (SUBSAMPLE_PATCH - 1));
+}
+
+/*
+ * The first half of the grid holds the reference patch means, the second
+ * half the loss of detail of the distorted patches. The latter changes when
+ * the distortion does, e.g. at a bitrate switch, even on static content.
+ */
+static void grid_sample(VmafSubsampler *s, VmafPicture *ref, VmafPicture *dist)
+{
+    const unsigned offset = (SUBSAMPLE_GRID - SUBSAMPLE_PATCH) / 2;
+    const unsigned cnt = s->grid.w * s->grid.h;
+
+    for (unsigned i = 0; i < s->grid.h; i++) {
+        for (unsigned j = 0; j < s->grid.w; j++) {
+            const unsigned x = j * SUBSAMPLE_GRID + offset;
+            const unsigned y = i * SUBSAMPLE_GRID + offset;
+            float mean, dist_mean, ref_detail, dist_detail;
+            patch_sample(ref, x, y, &mean, &ref_detail);
+            patch_sample(dist, x, y, &dist_mean, &dist_detail);
+            s->grid.cur[i * s->grid.w + j] = mean;
+            s->grid.cur[cnt + i * s->grid.w + j] = ref_detail - dist_detail;
+        }
+    }
+}
+
+/* mean absolute difference to the previous grid, of either half */
+static double grid_diff(VmafSubsampler *s, unsigned half)
+{
+    const unsigned cnt = s->grid.w * s->grid.h;
+    if (!cnt) return 0.;
+
+    const float *cur = s->grid.cur + half * cnt;
+    const float *prev = s->grid.prev + half * cnt;
+    double sum = 0.;
+    for (unsigned i = 0; i < cnt; i++)
+        sum += fabsf(cur[i] - prev[i]);
+    return sum / cnt;
+}
+
+static int pic_reserve(VmafSubsampler *s, unsigned cnt)
+{
+    if (cnt <= s->pic.capacity)
+        return 0;
+
+    unsigned capacity = s->pic.capacity ? s->pic.capacity : 256;
+    while (capacity < cnt)
+        capacity *= 2;
+    uint8_t *skipped = realloc(s->pic.skipped, capacity);
+    if (!skipped) return -ENOMEM;
+    memset(skipped + s->pic.capacity, 0, capacity - s->pic.capacity);
+    s->pic.skipped = skipped;
+    s->pic.capacity = capacity;
+    return 0;
+}
+
+int vmaf_subsampler_select(VmafSubsampler *s, VmafPicture *ref,
+                           VmafPicture *dist, unsigned index,
+                           bool *scored, bool *cut)
+{
+    if (!s) return -EINVAL;
+    if (!ref) return -EINVAL;
+    if (!dist) return -EINVAL;
+    if (!scored) return -EINVAL;
+    if (!cut) return -EINVAL;
+
+    int err = pic_reserve(s, index + 1);
+    if (err) return err;
+    if (!s->grid.cur) {
+        err = grid_alloc(s, ref);
+        if (err) return err;
+    }
+
+    grid_sample(s, ref, dist);
+    const double diff = s->started ? grid_diff(s, 0) : 0.;
+    *cut = s->started && (diff > SUBSAMPLE_CUT_MIN) &&
+           (diff > SUBSAMPLE_CUT_RATIO * s->mean_diff);
+    // a cut counts as the smallest one, so that sustained motion which
+    // starts with a cut is learned quickly, without masking the next cut
+    const double d = *cut ? SUBSAMPLE_CUT_MIN : diff;
+    s->mean_diff = s->started ? 0.75 * s->mean_diff + 0.25 * d : d;
+
+    const double loss = s->started ? grid_diff(s, 1) : 0.;
+    const double activity = diff > loss ? diff : loss;
+    const double stride =
+        s->n_subsample / (1. + activity / SUBSAMPLE_ACTIVITY);
+    *scored = !s->started || *cut || (++s->since >= stride);
+    if (*scored)
+        s->since = 0;
+    s->started = true;
+
+    float *const grid = s->grid.prev;
+    s->grid.prev = s->grid.cur;
+    s->grid.cur = grid;
+
+    s->pic.skipped[index] = !*scored;
+    return 0;
+}
+
+void vmaf_subsampler_unskip(VmafSubsampler *s, unsigned index)
+{
+    if (index < s->pic.capacity)
+        s->pic.skipped[index] = 0;
+}
+
+bool vmaf_subsampler_skipped(VmafSubsampler *s, unsigned index)
+{
+    return index < s->pic.capacity && s->pic.skipped[index];
+}
+
+const uint8_t *vmaf_subsampler_skip_map(VmafSubsampler *s, unsigned *cnt)
+{
+    *cnt = s->pic.capacity;
+    return s->pic.skipped;
+}
+
+int vmaf_subsampler_merge(VmafSubsampler *dst, VmafSubsampler *src,
+                          unsigned index_low, unsigned index_high)
+{
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+
+    if (index_high > src->pic.capacity)
+        index_high = src->pic.capacity;
+    if (index_low >= index_high)
+        return 0;
+
+    int err = pic_reserve(dst, index_high);
+    if (err) return err;
+    memcpy(dst->pic.skipped + index_low, src->pic.skipped + index_low,
+           index_high - index_low);
+    return 0;
+}
+
+void vmaf_subsampler_close(VmafSubsampler *s)
+{
+    if (!s) return;
+    free(s->grid.cur);
+    free(s->grid.prev);
+    free(s->pic.skipped);
+    free(s);
+}
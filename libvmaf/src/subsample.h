@@ -0,0 +1,75 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_SUBSAMPLE_H__
+#define __VMAF_SUBSAMPLE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "libvmaf/picture.h"
+
+/**
+ * Picture selection for `VMAF_SUBSAMPLE_MODE_ADAPTIVE`. Each picture pair
+ * is reduced to a sparse grid of patches. The mean absolute difference of
+ * the reference patch means to the previous grid, in 8-bit units, stands in
+ * for motion, the change of the detail lost in the distorted patches for a
+ * change of distortion. For the larger of both, d, the stride between
+ * scored pictures is `n_subsample / (1 + d / SUBSAMPLE_ACTIVITY)`, so static
+ * content is scored sparsely and fast motion on every picture. A motion
+ * well above the recent average marks a scene cut, which is always scored.
+ */
+typedef struct VmafSubsampler VmafSubsampler;
+
+int vmaf_subsampler_init(VmafSubsampler **s, unsigned n_subsample);
+
+/**
+ * Decide whether picture `index` is scored. `cut` is set if it starts a
+ * new scene. Pictures must be read in order.
+ */
+int vmaf_subsampler_select(VmafSubsampler *s, VmafPicture *ref,
+                           VmafPicture *dist, unsigned index,
+                           bool *scored, bool *cut);
+
+/**
+ * Score picture `index` after all, used to extract the picture before a
+ * scene cut once the cut is detected.
+ */
+void vmaf_subsampler_unskip(VmafSubsampler *s, unsigned index);
+
+/**
+ * True for pictures which were read and not selected. Pictures which were
+ * not read through `s`, e.g. imported ones, are not skipped.
+ */
+bool vmaf_subsampler_skipped(VmafSubsampler *s, unsigned index);
+
+/**
+ * Per picture flags, nonzero for skipped pictures, `cnt` entries.
+ */
+const uint8_t *vmaf_subsampler_skip_map(VmafSubsampler *s, unsigned *cnt);
+
+/**
+ * Take over the selection of pictures [index_low, index_high) from `src`,
+ * the subsampler of a segment.
+ */
+int vmaf_subsampler_merge(VmafSubsampler *dst, VmafSubsampler *src,
+                          unsigned index_low, unsigned index_high);
+
+void vmaf_subsampler_close(VmafSubsampler *s);
+
+#endif /* __VMAF_SUBSAMPLE_H__ */
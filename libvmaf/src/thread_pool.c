@@ -22,6 +22,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "trace.h"
+
 typedef struct VmafThreadPoolJob {
     void (*func)(void *data);
     void *data;
@@ -33,6 +35,7 @@ typedef struct VmafTreadPool {
         pthread_mutex_t lock;
         pthread_cond_t empty;
         VmafThreadPoolJob *head, *tail;
+        unsigned cnt;
     } queue;
     pthread_cond_t working;
     unsigned n_threads;
@@ -46,6 +49,7 @@ static VmafThreadPoolJob *vmaf_thread_pool_fetch_job(VmafThreadPool *pool)
     if (!pool->queue.head) return NULL;
 
     VmafThreadPoolJob *job = pool->queue.head;
+    pool->queue.cnt--;
     if (!job->next) {
         pool->queue.head = NULL;
         pool->queue.tail = NULL;
@@ -75,7 +79,10 @@ static void *vmaf_thread_pool_runner(void *p)
         pool->n_working++;
         pthread_mutex_unlock(&(pool->queue.lock));
         if (job) {
+            VmafTraceSpan span;
+            vmaf_trace_begin(&span, "thread_pool", "job", VMAF_TRACE_NO_INDEX);
             job->func(job->data);
+            vmaf_trace_end(&span);
             vmaf_thread_pool_job_destroy(job);
         }
         pthread_mutex_lock(&(pool->queue.lock));
@@ -140,6 +147,7 @@ int vmaf_thread_pool_enqueue(VmafThreadPool *pool, void (*func)(void *data),
         pool->queue.tail->next = job;
         pool->queue.tail = job;
     }
+    pool->queue.cnt++;
 
     pthread_cond_broadcast(&(pool->queue.empty));
     pthread_mutex_unlock(&(pool->queue.lock));
@@ -155,12 +163,26 @@ int vmaf_thread_pool_wait(VmafThreadPool *pool)
 {
     if (!pool) return -EINVAL;
 
+    VmafTraceSpan span;
+    vmaf_trace_begin(&span, "thread_pool", "wait", VMAF_TRACE_NO_INDEX);
     pthread_mutex_lock(&(pool->queue.lock));
-    while((!pool->stop && pool->n_working) || (pool->stop && pool->n_threads))
+    while((!pool->stop && (pool->n_working || pool->queue.head)) ||
+          (pool->stop && pool->n_threads))
         pthread_cond_wait(&(pool->working), &(pool->queue.lock));
     pthread_mutex_unlock(&(pool->queue.lock));
+    vmaf_trace_end(&span);
     return 0;
 }
+unsigned vmaf_thread_pool_queue_depth(VmafThreadPool *pool)
+{
+    if (!pool) return 0;
+
+    pthread_mutex_lock(&(pool->queue.lock));
+    const unsigned cnt = pool->queue.cnt;
+    pthread_mutex_unlock(&(pool->queue.lock));
+    return cnt;
+}
+
 int vmaf_thread_pool_destroy(VmafThreadPool *pool)
 {
     if (!pool) return -EINVAL;
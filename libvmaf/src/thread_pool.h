@@ -30,6 +30,11 @@ int vmaf_thread_pool_enqueue(VmafThreadPool *pool, void (*func)(void *data),
 
 int vmaf_thread_pool_wait(VmafThreadPool *pool);
 
+/**
+ * Number of enqueued jobs which have not been picked up by a worker yet.
+ */
+unsigned vmaf_thread_pool_queue_depth(VmafThreadPool *pool);
+
 int vmaf_thread_pool_destroy(VmafThreadPool *tpool);
 
 #endif /* __VMAF_THREAD_POOL_H__ */
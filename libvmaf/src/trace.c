@@ -0,0 +1,272 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdio.h>
+
+#include <libvmaf/libvmaf.rc.h>
+
+#include "trace.h"
+
+#ifdef VMAF_TRACE
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+
+#ifdef VMAF_TRACE_PERF_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define TRACE_COUNTER_CNT 4
+
+static const char *counter_name[TRACE_COUNTER_CNT] = {
+    "cycles", "instructions", "cache_references", "cache_misses",
+};
+
+typedef struct TraceEvent {
+    char cat[16], name[48];
+    unsigned index, tid;
+    uint64_t begin, end;
+    bool has_counters;
+    uint64_t counter[TRACE_COUNTER_CNT];
+} TraceEvent;
+
+typedef struct TraceThread {
+    unsigned tid;
+    int perf_fd[TRACE_COUNTER_CNT]; ///< perf_fd[0] leads the group, or is -1.
+} TraceThread;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_once_t once;
+    pthread_key_t thread_key;
+    unsigned thread_cnt;
+    TraceEvent *event;
+    size_t cnt, capacity;
+} trace = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .once = PTHREAD_ONCE_INIT,
+};
+
+#ifdef VMAF_TRACE_PERF_COUNTERS
+
+static void perf_open(TraceThread *t)
+{
+    static const uint64_t config[TRACE_COUNTER_CNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_REFERENCES,
+        PERF_COUNT_HW_CACHE_MISSES,
+    };
+
+    for (unsigned i = 0; i < TRACE_COUNTER_CNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config[i];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        t->perf_fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1,
+                                i ? t->perf_fd[0] : -1, 0);
+        if (t->perf_fd[i] >= 0) continue;
+
+        // counters are optional, e.g. perf_event_paranoid may forbid them
+        for (unsigned j = 0; j < i; j++)
+            close(t->perf_fd[j]);
+        for (unsigned j = 0; j < TRACE_COUNTER_CNT; j++)
+            t->perf_fd[j] = -1;
+        return;
+    }
+}
+
+static void perf_close(TraceThread *t)
+{
+    for (unsigned i = 0; i < TRACE_COUNTER_CNT; i++) {
+        if (t->perf_fd[i] >= 0)
+            close(t->perf_fd[i]);
+    }
+}
+
+static bool perf_read(TraceThread *t, uint64_t *counter)
+{
+    if (t->perf_fd[0] < 0) return false;
+
+    struct {
+        uint64_t nr;
+        uint64_t value[TRACE_COUNTER_CNT];
+    } data;
+    if (read(t->perf_fd[0], &data, sizeof(data)) != sizeof(data)) {
+        perf_close(t);
+        for (unsigned i = 0; i < TRACE_COUNTER_CNT; i++)
+            t->perf_fd[i] = -1;
+        return false;
+    }
+    memcpy(counter, data.value, sizeof(data.value));
+    return true;
+}
+
+#else
+
+static void perf_open(TraceThread *t)
+{
+    for (unsigned i = 0; i < TRACE_COUNTER_CNT; i++)
+        t->perf_fd[i] = -1;
+}
+
+static void perf_close(TraceThread *t)
+{
+    (void) t;
+}
+
+static bool perf_read(TraceThread *t, uint64_t *counter)
+{
+    (void) t;
+    (void) counter;
+    return false;
+}
+
+#endif /* VMAF_TRACE_PERF_COUNTERS */
+
+static void thread_destroy(void *t)
+{
+    perf_close(t);
+    free(t);
+}
+
+static void trace_init(void)
+{
+    pthread_key_create(&trace.thread_key, thread_destroy);
+}
+
+static TraceThread *get_thread(void)
+{
+    pthread_once(&trace.once, trace_init);
+
+    TraceThread *t = pthread_getspecific(trace.thread_key);
+    if (t) return t;
+
+    t = malloc(sizeof(*t));
+    if (!t) return NULL;
+    pthread_mutex_lock(&trace.lock);
+    t->tid = ++trace.thread_cnt;
+    pthread_mutex_unlock(&trace.lock);
+    perf_open(t);
+    pthread_setspecific(trace.thread_key, t);
+    return t;
+}
+
+void vmaf_trace_begin(VmafTraceSpan *span, const char *cat, const char *name,
+                      unsigned index)
+{
+    span->cat = cat;
+    span->name = name;
+    span->index = index;
+
+    TraceThread *t = get_thread();
+    if (t) perf_read(t, span->counter);
+    span->begin = vmaf_profile_wall();
+}
+
+void vmaf_trace_end(VmafTraceSpan *span)
+{
+    const uint64_t end = vmaf_profile_wall();
+    TraceThread *t = get_thread();
+    if (!t) return;
+
+    TraceEvent e;
+    memset(&e, 0, sizeof(e));
+    snprintf(e.cat, sizeof(e.cat), "%s", span->cat);
+    snprintf(e.name, sizeof(e.name), "%s", span->name);
+    e.index = span->index;
+    e.tid = t->tid;
+    e.begin = span->begin;
+    e.end = end;
+    e.has_counters = perf_read(t, e.counter);
+    for (unsigned i = 0; e.has_counters && i < TRACE_COUNTER_CNT; i++)
+        e.counter[i] -= span->counter[i];
+
+    pthread_mutex_lock(&trace.lock);
+    if (trace.cnt == trace.capacity) {
+        const size_t capacity = trace.capacity ? trace.capacity * 2 : 1024;
+        TraceEvent *event =
+            realloc(trace.event, sizeof(*trace.event) * capacity);
+        if (!event) goto unlock;
+        trace.event = event;
+        trace.capacity = capacity;
+    }
+    trace.event[trace.cnt++] = e;
+
+unlock:
+    pthread_mutex_unlock(&trace.lock);
+}
+
+int vmaf_write_trace(FILE *outfile)
+{
+    if (!outfile) return -EINVAL;
+
+    pthread_mutex_lock(&trace.lock);
+
+    uint64_t epoch = UINT64_MAX;
+    for (size_t i = 0; i < trace.cnt; i++) {
+        if (trace.event[i].begin < epoch)
+            epoch = trace.event[i].begin;
+    }
+
+    fprintf(outfile, "{\n");
+    fprintf(outfile, "  \"traceEvents\": [");
+    for (size_t i = 0; i < trace.cnt; i++) {
+        TraceEvent *e = &trace.event[i];
+        fprintf(outfile, "%s\n    ", i > 0 ? "," : "");
+        fprintf(outfile, "{ \"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", "
+                "\"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f, "
+                "\"args\": {", e->name, e->cat, e->tid,
+                (e->begin - epoch) / 1e3, (e->end - e->begin) / 1e3);
+        unsigned cnt = 0;
+        if (e->index != VMAF_TRACE_NO_INDEX)
+            fprintf(outfile, " \"index\": %u", (cnt++, e->index));
+        for (unsigned j = 0; e->has_counters && j < TRACE_COUNTER_CNT; j++) {
+            fprintf(outfile, "%s \"%s\": %llu", cnt++ ? "," : "",
+                    counter_name[j], (unsigned long long) e->counter[j]);
+        }
+        fprintf(outfile, " } }");
+    }
+    fprintf(outfile, "\n  ],\n");
+    fprintf(outfile, "  \"displayTimeUnit\": \"ms\"\n");
+    fprintf(outfile, "}\n");
+
+    pthread_mutex_unlock(&trace.lock);
+    return 0;
+}
+
+#else
+
+int vmaf_write_trace(FILE *outfile)
+{
+    (void) outfile;
+    return -ENOSYS;
+}
+
+#endif /* VMAF_TRACE */
@@ -0,0 +1,63 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_SRC_TRACE_H__
+#define __VMAF_SRC_TRACE_H__
+
+#include <stdint.h>
+
+#define VMAF_TRACE_NO_INDEX (~0u)
+
+/**
+ * Span of a traced event, e.g. one `extract` call. Spans are recorded only
+ * when libvmaf is built with `-Denable_trace=true`, otherwise
+ * `vmaf_trace_begin()` and `vmaf_trace_end()` compile to nothing.
+ */
+typedef struct VmafTraceSpan {
+    const char *cat, *name;
+    unsigned index;
+    uint64_t begin;
+    uint64_t counter[4]; ///< perf_event_open counters at `begin`.
+} VmafTraceSpan;
+
+#ifdef VMAF_TRACE
+
+void vmaf_trace_begin(VmafTraceSpan *span, const char *cat, const char *name,
+                      unsigned index);
+
+void vmaf_trace_end(VmafTraceSpan *span);
+
+#else
+
+static inline void vmaf_trace_begin(VmafTraceSpan *span, const char *cat,
+                                    const char *name, unsigned index)
+{
+    (void) span;
+    (void) cat;
+    (void) name;
+    (void) index;
+}
+
+static inline void vmaf_trace_end(VmafTraceSpan *span)
+{
+    (void) span;
+}
+
+#endif /* VMAF_TRACE */
+
+#endif /* __VMAF_SRC_TRACE_H__ */
@@ -44,6 +44,25 @@
 template <class T> static inline T min(T x,T y) { return (x<y)?x:y; }
 #endif
 
+/* indexed by VmafModelFeature: model_dict name, result key */
+static const struct {
+    const char *name;
+    const char *key;
+} model_features[MODEL_FEATURE_CNT] = {
+    { "'VMAF_feature_adm2_score'",       "adm2" },
+    { "'VMAF_feature_adm_scale0_score'", "adm_scale0" },
+    { "'VMAF_feature_adm_scale1_score'", "adm_scale1" },
+    { "'VMAF_feature_adm_scale2_score'", "adm_scale2" },
+    { "'VMAF_feature_adm_scale3_score'", "adm_scale3" },
+    { "'VMAF_feature_motion_score'",     "motion" },
+    { "'VMAF_feature_vif_scale0_score'", "vif_scale0" },
+    { "'VMAF_feature_vif_scale1_score'", "vif_scale1" },
+    { "'VMAF_feature_vif_scale2_score'", "vif_scale2" },
+    { "'VMAF_feature_vif_scale3_score'", "vif_scale3" },
+    { "'VMAF_feature_vif_score'",        "vif" },
+    { "'VMAF_feature_motion2_score'",    "motion2" },
+};
+
 inline double _round_to_digit(double val, int digit);
 std::string _get_file_name(const std::string& s);
 
@@ -148,6 +167,8 @@ void LibsvmNusvrTrainTestModel::load_model()
     const char *libsvm_model_path = libsvm_model_path_.c_str();
     dbg_printf("Read input model (libsvm) at %s ...\n", libsvm_model_path);
     svm_model_ptr = _read_and_assert_svm_model(libsvm_model_path);
+
+    _compile_model();
 }
 
 std::unique_ptr<svm_model, SvmDelete> LibsvmNusvrTrainTestModel::_read_and_assert_svm_model(const char* libsvm_model_path)
@@ -160,122 +181,61 @@ std::unique_ptr<svm_model, SvmDelete> LibsvmNusvrTrainTestModel::_read_and_asser
     return svm_model_ptr;
 }
 
-void LibsvmNusvrTrainTestModel::populate_and_normalize_nodes_at_frm(size_t i_frm,
-        svm_node*& nodes, StatVector& adm2,
-        StatVector& adm_scale0, StatVector& adm_scale1,
-        StatVector& adm_scale2, StatVector& adm_scale3, StatVector& motion,
-        StatVector& vif_scale0, StatVector& vif_scale1, StatVector& vif_scale2,
-        StatVector& vif_scale3, StatVector& vif, StatVector& motion2) {
-    if (VAL_EQUAL_STR(norm_type, "'linear_rescale'")) {
-        for (size_t j = 0; j < feature_names.length(); j++) {
-            nodes[j].index = j + 1;
-            if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_adm2_score'") == 0)
-                nodes[j].value = double(slopes[j + 1]) * adm2.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_adm_scale0_score'") == 0)
-                nodes[j].value = double(slopes[j + 1])
-                        * adm_scale0.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_adm_scale1_score'") == 0)
-                nodes[j].value = double(slopes[j + 1])
-                        * adm_scale1.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_adm_scale2_score'") == 0)
-                nodes[j].value = double(slopes[j + 1])
-                        * adm_scale2.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_adm_scale3_score'") == 0)
-                nodes[j].value = double(slopes[j + 1])
-                        * adm_scale3.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_motion_score'") == 0)
-                nodes[j].value = double(slopes[j + 1]) * motion.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_vif_scale0_score'") == 0)
-                nodes[j].value = double(slopes[j + 1])
-                        * vif_scale0.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_vif_scale1_score'") == 0)
-                nodes[j].value = double(slopes[j + 1])
-                        * vif_scale1.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_vif_scale2_score'") == 0)
-                nodes[j].value = double(slopes[j + 1])
-                        * vif_scale2.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_vif_scale3_score'") == 0)
-                nodes[j].value = double(slopes[j + 1])
-                        * vif_scale3.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_vif_score'") == 0)
-                nodes[j].value = double(slopes[j + 1]) * vif.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_motion2_score'") == 0)
-                nodes[j].value = double(slopes[j + 1]) * motion2.at(i_frm)
-                        + double(intercepts[j + 1]);
-            else {
-                printf("Unknown feature name: %s.\n",
-                        Stringize(feature_names[j]).c_str());
-                throw VmafException("Unknown feature name");
-            }
+void LibsvmNusvrTrainTestModel::_compile_model()
+{
+    size_t num_features = feature_names.length();
+    bool linear_rescale = VAL_EQUAL_STR(norm_type, "'linear_rescale'");
+
+    feature_index.resize(num_features);
+    feature_slopes.resize(num_features);
+    feature_intercepts.resize(num_features);
+    for (size_t j = 0; j < num_features; j++) {
+        std::string name = Stringize(feature_names[j]);
+        int k;
+        for (k = 0; k < MODEL_FEATURE_CNT; k++) {
+            if (strcmp(name.c_str(), model_features[k].name) == 0)
+                break;
         }
-    } else {
-        for (size_t j = 0; j < feature_names.length(); j++) {
-            nodes[j].index = j + 1;
-            if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_adm2_score'") == 0)
-                nodes[j].value = adm2.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_adm_scale0_score'") == 0)
-                nodes[j].value = adm_scale0.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_adm_scale1_score'") == 0)
-                nodes[j].value = adm_scale1.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_adm_scale2_score'") == 0)
-                nodes[j].value = adm_scale2.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_adm_scale3_score'") == 0)
-                nodes[j].value = adm_scale3.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_motion_score'") == 0)
-                nodes[j].value = motion.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_vif_scale0_score'") == 0)
-                nodes[j].value = vif_scale0.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_vif_scale1_score'") == 0)
-                nodes[j].value = vif_scale1.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_vif_scale2_score'") == 0)
-                nodes[j].value = vif_scale2.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_vif_scale3_score'") == 0)
-                nodes[j].value = vif_scale3.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_vif_score'") == 0)
-                nodes[j].value = vif.at(i_frm);
-            else if (strcmp(Stringize(feature_names[j]).c_str(),
-                    "'VMAF_feature_motion2_score'") == 0)
-                nodes[j].value = motion2.at(i_frm);
-            else {
-                printf("Unknown feature name: %s.\n",
-                        Stringize(feature_names[j]).c_str());
-                throw VmafException("Unknown feature name");
-            }
+        if (k == MODEL_FEATURE_CNT) {
+            printf("Unknown feature name: %s.\n", name.c_str());
+            throw VmafException("Unknown feature name");
         }
+        feature_index[j] = (VmafModelFeature) k;
+        feature_slopes[j] = linear_rescale ? double(slopes[j + 1]) : 1.0;
+        feature_intercepts[j] = linear_rescale ? double(intercepts[j + 1]) : 0.0;
+    }
+    score_slope = linear_rescale ? double(slopes[0]) : 1.0;
+    score_intercept = linear_rescale ? double(intercepts[0]) : 0.0;
+
+    has_score_clip = !VAL_IS_NONE(score_clip);
+    if (has_score_clip) {
+        score_clip_min = double(score_clip[0]);
+        score_clip_max = double(score_clip[1]);
+    }
+
+    has_score_transform = !VAL_IS_NONE(score_transform);
+    if (has_score_transform) {
+        static const char *p_keys[3] = { "p0", "p1", "p2" };
+        for (int k = 0; k < 3; k++) {
+            has_transform_p[k] = !VAL_IS_NONE(score_transform[p_keys[k]]);
+            transform_p[k] = has_transform_p[k] ?
+                    double(score_transform[p_keys[k]]) : 0.0;
+        }
+        transform_out_lte_in = !VAL_IS_NONE(score_transform["out_lte_in"])
+                && VAL_EQUAL_STR(score_transform["out_lte_in"], "'true'");
+        transform_out_gte_in = !VAL_IS_NONE(score_transform["out_gte_in"])
+                && VAL_EQUAL_STR(score_transform["out_gte_in"], "'true'");
+    }
+}
+
+void LibsvmNusvrTrainTestModel::populate_and_normalize_nodes_at_frm(size_t i_frm,
+        svm_node*& nodes, StatVector* const features[MODEL_FEATURE_CNT]) {
+    size_t num_features = feature_index.size();
+    for (size_t j = 0; j < num_features; j++) {
+        nodes[j].index = j + 1;
+        nodes[j].value = feature_slopes[j]
+                * features[feature_index[j]]->at(i_frm)
+                + feature_intercepts[j];
     }
 }
 
@@ -293,13 +253,7 @@ VmafPredictionStruct LibsvmNusvrTrainTestModel::predict(svm_node* nodes) {
 }
 
 void LibsvmNusvrTrainTestModel::_denormalize_prediction(double& prediction) {
-    if (VAL_EQUAL_STR(norm_type, "'linear_rescale'")) {
-        /* denormalize */
-        prediction = (prediction - double(intercepts[0]))
-                / double(slopes[0]);
-    } else {
-        ;
-    }
+    prediction = (prediction - score_intercept) / score_slope;
 }
 
 std::string BootstrapLibsvmNusvrTrainTestModel::_get_model_i_filename(const char* model_path, int i_model)
@@ -379,6 +333,7 @@ void BootstrapLibsvmNusvrTrainTestModel::load_model()
         }
     }
 
+    _compile_model();
 }
 
 VmafPredictionStruct BootstrapLibsvmNusvrTrainTestModel::predict(svm_node* nodes) {
@@ -406,30 +361,27 @@ VmafPredictionStruct BootstrapLibsvmNusvrTrainTestModel::predict(svm_node* nodes
 
 void VmafQualityRunner::_transform_value(LibsvmNusvrTrainTestModel& model,
         double& prediction) {
-    if (!VAL_IS_NONE(model.score_transform)) {
+    if (model.has_score_transform) {
         double value = 0.0;
 
         /* quadratic transform */
-        if (!VAL_IS_NONE(model.score_transform["p0"])) {
-            value += double(model.score_transform["p0"]);
+        if (model.has_transform_p[0]) {
+            value += model.transform_p[0];
         }
-        if (!VAL_IS_NONE(model.score_transform["p1"])) {
-            value += double(model.score_transform["p1"]) * prediction;
+        if (model.has_transform_p[1]) {
+            value += model.transform_p[1] * prediction;
         }
-        if (!VAL_IS_NONE(model.score_transform["p2"])) {
-            value += double(model.score_transform["p2"]) * prediction
-                    * prediction;
+        if (model.has_transform_p[2]) {
+            value += model.transform_p[2] * prediction * prediction;
         }
 
         /* rectification */
-        if (!VAL_IS_NONE(model.score_transform["out_lte_in"])
-                && VAL_EQUAL_STR(model.score_transform["out_lte_in"], "'true'")) {
+        if (model.transform_out_lte_in) {
             if (value > prediction) {
                 value = prediction;
             }
         }
-        if (!VAL_IS_NONE(model.score_transform["out_gte_in"])
-                && VAL_EQUAL_STR(model.score_transform["out_gte_in"], "'true'")) {
+        if (model.transform_out_gte_in) {
             if (value < prediction) {
                 value = prediction;
             }
@@ -441,11 +393,11 @@ void VmafQualityRunner::_transform_value(LibsvmNusvrTrainTestModel& model,
 
 void VmafQualityRunner::_clip_value(LibsvmNusvrTrainTestModel& model,
         double& prediction) {
-    if (!VAL_IS_NONE(model.score_clip)) {
-        if (prediction < double(model.score_clip[0])) {
-            prediction = double(model.score_clip[0]);
-        } else if (prediction > double(model.score_clip[1])) {
-            prediction = double(model.score_clip[1]);
+    if (model.has_score_clip) {
+        if (prediction < model.score_clip_min) {
+            prediction = model.score_clip_min;
+        } else if (prediction > model.score_clip_max) {
+            prediction = model.score_clip_max;
         }
     }
 }
@@ -476,25 +428,19 @@ void VmafQualityRunner::_postproc_transform_clip(
 
 void VmafQualityRunner::_normalize_predict_denormalize_transform_clip(
         LibsvmNusvrTrainTestModel& model, size_t num_frms,
-        StatVector& adm2, StatVector& adm_scale0, StatVector& adm_scale1,
-        StatVector& adm_scale2, StatVector& adm_scale3, StatVector& motion,
-        StatVector& vif_scale0, StatVector& vif_scale1, StatVector& vif_scale2,
-        StatVector& vif_scale3, StatVector& vif, StatVector& motion2,
-        bool enable_transform, bool disable_clip,
+        StatVector* const features[MODEL_FEATURE_CNT], bool enable_transform, bool disable_clip,
         std::vector<VmafPredictionStruct>& predictionStructs) {
 
     /* IMPORTANT: always allocate one more spot and put a -1 at the last one's
      * index, so that libsvm will stop looping when seeing the -1 !!!
      * see https://github.com/cjlin1/libsvm */
     svm_node* nodes = (svm_node*) alloca(
-            sizeof(svm_node) * (model.feature_names.length() + 1));
-    nodes[model.feature_names.length()].index = -1;
+            sizeof(svm_node) * (model.feature_index.size() + 1));
+    nodes[model.feature_index.size()].index = -1;
 
     size_t i_subsampled;
     for (size_t i_frm=0; i_frm<num_frms; i_frm++) {
-        model.populate_and_normalize_nodes_at_frm(i_frm, nodes, adm2,
-                adm_scale0, adm_scale1, adm_scale2, adm_scale3, motion,
-                vif_scale0, vif_scale1, vif_scale2, vif_scale3, vif, motion2);
+        model.populate_and_normalize_nodes_at_frm(i_frm, nodes, features);
 
         VmafPredictionStruct predictionStruct = model.predict(nodes);
 
@@ -511,18 +457,10 @@ void VmafQualityRunner::_normalize_predict_denormalize_transform_clip(
         _postproc_transform_clip(predictionStruct);
 
         dbg_printf("frame: %zu, ", i_frm);
-        dbg_printf("adm2: %f, ", adm2.at(i_frm));
-        dbg_printf("adm_scale0: %f, ", adm_scale0.at(i_frm));
-        dbg_printf("adm_scale1: %f, ", adm_scale1.at(i_frm));
-        dbg_printf("adm_scale2: %f, ", adm_scale2.at(i_frm));
-        dbg_printf("adm_scale3: %f, ", adm_scale3.at(i_frm));
-        dbg_printf("motion: %f, ", motion.at(i_frm));
-        dbg_printf("vif_scale0: %f, ", vif_scale0.at(i_frm));
-        dbg_printf("vif_scale1: %f, ", vif_scale1.at(i_frm));
-        dbg_printf("vif_scale2: %f, ", vif_scale2.at(i_frm));
-        dbg_printf("vif_scale3: %f, ", vif_scale3.at(i_frm));
-        dbg_printf("vif: %f, ", vif.at(i_frm));
-        dbg_printf("motion2: %f, ", motion2.at(i_frm));
+        for (int k = 0; k < MODEL_FEATURE_CNT; k++) {
+            dbg_printf("%s: %f, ", model_features[k].key,
+                    features[k]->at(i_frm));
+        }
 
         dbg_printf("\n");
 
@@ -561,116 +499,35 @@ Result VmafQualityRunner::run(Asset asset, int (*read_frame)(float *ref_data, fl
     int h = asset.getHeight();
     const char* fmt = asset.getFmt();
     char errmsg[1024];
-    DArray adm_num_array, adm_den_array, adm_num_scale0_array,
-            adm_den_scale0_array, adm_num_scale1_array, adm_den_scale1_array,
-            adm_num_scale2_array, adm_den_scale2_array, adm_num_scale3_array,
-            adm_den_scale3_array, motion_array, motion2_array,
-            vif_num_scale0_array, vif_den_scale0_array, vif_num_scale1_array,
-            vif_den_scale1_array, vif_num_scale2_array, vif_den_scale2_array,
-            vif_num_scale3_array, vif_den_scale3_array, vif_array, psnr_array,
-            ssim_array, ms_ssim_array;
-    /* use the following ptrs as flags to turn on/off optional metrics */
-    DArray *psnr_array_ptr, *ssim_array_ptr, *ms_ssim_array_ptr;
-    init_array(&adm_num_array, INIT_FRAMES);
-    init_array(&adm_den_array, INIT_FRAMES);
-    init_array(&adm_num_scale0_array, INIT_FRAMES);
-    init_array(&adm_den_scale0_array, INIT_FRAMES);
-    init_array(&adm_num_scale1_array, INIT_FRAMES);
-    init_array(&adm_den_scale1_array, INIT_FRAMES);
-    init_array(&adm_num_scale2_array, INIT_FRAMES);
-    init_array(&adm_den_scale2_array, INIT_FRAMES);
-    init_array(&adm_num_scale3_array, INIT_FRAMES);
-    init_array(&adm_den_scale3_array, INIT_FRAMES);
-    init_array(&motion_array, INIT_FRAMES);
-    init_array(&motion2_array, INIT_FRAMES);
-    init_array(&vif_num_scale0_array, INIT_FRAMES);
-    init_array(&vif_den_scale0_array, INIT_FRAMES);
-    init_array(&vif_num_scale1_array, INIT_FRAMES);
-    init_array(&vif_den_scale1_array, INIT_FRAMES);
-    init_array(&vif_num_scale2_array, INIT_FRAMES);
-    init_array(&vif_den_scale2_array, INIT_FRAMES);
-    init_array(&vif_num_scale3_array, INIT_FRAMES);
-    init_array(&vif_den_scale3_array, INIT_FRAMES);
-    init_array(&vif_array, INIT_FRAMES);
-    init_array(&psnr_array, INIT_FRAMES);
-    init_array(&ssim_array, INIT_FRAMES);
-    init_array(&ms_ssim_array, INIT_FRAMES);
-    /* optional output arrays */
+    unsigned columns = FEATURE_COLUMNS_REQUIRED;
+    /* optional columns */
     if (do_psnr) {
-        psnr_array_ptr = &psnr_array;
-    } else {
-        psnr_array_ptr = NULL;
+        columns |= FEATURE_COLUMN_BIT(FEATURE_PSNR);
     }
     if (do_ssim) {
-        ssim_array_ptr = &ssim_array;
-    } else {
-        ssim_array_ptr = NULL;
+        columns |= FEATURE_COLUMN_BIT(FEATURE_SSIM);
     }
     if (do_ms_ssim) {
-        ms_ssim_array_ptr = &ms_ssim_array;
-    } else {
-        ms_ssim_array_ptr = NULL;
+        columns |= FEATURE_COLUMN_BIT(FEATURE_MS_SSIM);
+    }
+    FeatureTable *table;
+    if (feature_table_init(&table, columns, INIT_FRAMES)) {
+        throw VmafException("Feature table allocation failed");
     }
+    std::unique_ptr<FeatureTable, void (*)(FeatureTable *)> table_ptr(
+            table, feature_table_free);
     dbg_printf("Extract atom features...\n");
-    int ret = combo(read_frame, user_data, w, h, fmt, &adm_num_array,
-            &adm_den_array, &adm_num_scale0_array, &adm_den_scale0_array,
-            &adm_num_scale1_array, &adm_den_scale1_array, &adm_num_scale2_array,
-            &adm_den_scale2_array, &adm_num_scale3_array, &adm_den_scale3_array,
-            &motion_array, &motion2_array, &vif_num_scale0_array,
-            &vif_den_scale0_array, &vif_num_scale1_array, &vif_den_scale1_array,
-            &vif_num_scale2_array, &vif_den_scale2_array, &vif_num_scale3_array,
-            &vif_den_scale3_array, &vif_array, psnr_array_ptr, ssim_array_ptr,
-            ms_ssim_array_ptr, errmsg, n_thread, n_subsample);
+    int ret = combo(read_frame, user_data, w, h, fmt, table, errmsg, n_thread,
+            n_subsample);
     if (ret) {
         throw VmafException(errmsg);
     }
-    size_t num_frms = motion_array.used;
-    bool num_frms_is_consistent = (adm_num_array.used == num_frms)
-            && (adm_den_array.used == num_frms)
-            && (motion2_array.used == num_frms)
-            && (adm_num_scale0_array.used == num_frms)
-            && (adm_den_scale0_array.used == num_frms)
-            && (adm_num_scale1_array.used == num_frms)
-            && (adm_den_scale1_array.used == num_frms)
-            && (adm_num_scale2_array.used == num_frms)
-            && (adm_den_scale2_array.used == num_frms)
-            && (adm_num_scale3_array.used == num_frms)
-            && (adm_den_scale3_array.used == num_frms)
-            && (vif_num_scale0_array.used == num_frms)
-            && (vif_den_scale0_array.used == num_frms)
-            && (vif_num_scale1_array.used == num_frms)
-            && (vif_den_scale1_array.used == num_frms)
-            && (vif_num_scale2_array.used == num_frms)
-            && (vif_den_scale2_array.used == num_frms)
-            && (vif_num_scale3_array.used == num_frms)
-            && (vif_den_scale3_array.used == num_frms)
-            && (vif_array.used == num_frms);
-    if (psnr_array_ptr != NULL) {
-        num_frms_is_consistent = num_frms_is_consistent
-                && (psnr_array.used == num_frms);
-    }
-    if (ssim_array_ptr != NULL) {
-        num_frms_is_consistent = num_frms_is_consistent
-                && (ssim_array.used == num_frms);
-    }
-    if (ms_ssim_array_ptr != NULL) {
-        num_frms_is_consistent = num_frms_is_consistent
-                && (ms_ssim_array.used == num_frms);
-    }
-    if (!num_frms_is_consistent) {
+    size_t num_frms = feature_table_frame_cnt(table);
+    size_t num_commits = feature_table_commit_cnt(table);
+    if (num_commits != num_frms) {
         sprintf(errmsg,
-                "Output feature vectors are of inconsistent dimensions: motion (%zu), motion2 (%zu), adm_num (%zu), adm_den (%zu), vif_num_scale0 (%zu), vif_den_scale0 (%zu), vif_num_scale1 (%zu), vif_den_scale1 (%zu), vif_num_scale2 (%zu), vif_den_scale2 (%zu), vif_num_scale3 (%zu), vif_den_scale3 (%zu), vif (%zu), psnr (%zu), ssim (%zu), ms_ssim (%zu), adm_num_scale0 (%zu), adm_den_scale0 (%zu), adm_num_scale1 (%zu), adm_den_scale1 (%zu), adm_num_scale2 (%zu), adm_den_scale2 (%zu), adm_num_scale3 (%zu), adm_den_scale3 (%zu)",
-                motion_array.used, motion2_array.used, adm_num_array.used,
-                adm_den_array.used, vif_num_scale0_array.used,
-                vif_den_scale0_array.used, vif_num_scale1_array.used,
-                vif_den_scale1_array.used, vif_num_scale2_array.used,
-                vif_den_scale2_array.used, vif_num_scale3_array.used,
-                vif_num_scale3_array.used, vif_array.used, psnr_array.used,
-                ssim_array.used, ms_ssim_array.used, adm_num_scale0_array.used,
-                adm_den_scale0_array.used, adm_num_scale1_array.used,
-                adm_den_scale1_array.used, adm_num_scale2_array.used,
-                adm_den_scale2_array.used, adm_num_scale3_array.used,
-                adm_num_scale3_array.used);
+                "Output feature table is incomplete: %zu of %zu frames committed",
+                num_commits, num_frms);
         throw VmafException(errmsg);
     }
     dbg_printf(
@@ -684,44 +541,44 @@ Result VmafQualityRunner::run(Asset asset, int (*read_frame)(float *ref_data, fl
     std::vector<VmafPredictionStruct> predictionStructs;
     for (size_t i = 0; i < num_frms; i += n_subsample) {
         adm2.append(
-                (get_at(&adm_num_array, i) + ADM2_CONSTANT)
-                        / (get_at(&adm_den_array, i) + ADM2_CONSTANT));
+                (feature_table_get(table, FEATURE_ADM_NUM, i) + ADM2_CONSTANT)
+                        / (feature_table_get(table, FEATURE_ADM_DEN, i) + ADM2_CONSTANT));
         adm_scale0.append(
-                (get_at(&adm_num_scale0_array, i) + ADM_SCALE_CONSTANT)
-                        / (get_at(&adm_den_scale0_array, i) + ADM_SCALE_CONSTANT));
+                (feature_table_get(table, FEATURE_ADM_NUM_SCALE0, i) + ADM_SCALE_CONSTANT)
+                        / (feature_table_get(table, FEATURE_ADM_DEN_SCALE0, i) + ADM_SCALE_CONSTANT));
         adm_scale1.append(
-                (get_at(&adm_num_scale1_array, i) + ADM_SCALE_CONSTANT)
-                        / (get_at(&adm_den_scale1_array, i) + ADM_SCALE_CONSTANT));
+                (feature_table_get(table, FEATURE_ADM_NUM_SCALE1, i) + ADM_SCALE_CONSTANT)
+                        / (feature_table_get(table, FEATURE_ADM_DEN_SCALE1, i) + ADM_SCALE_CONSTANT));
         adm_scale2.append(
-                (get_at(&adm_num_scale2_array, i) + ADM_SCALE_CONSTANT)
-                        / (get_at(&adm_den_scale2_array, i) + ADM_SCALE_CONSTANT));
+                (feature_table_get(table, FEATURE_ADM_NUM_SCALE2, i) + ADM_SCALE_CONSTANT)
+                        / (feature_table_get(table, FEATURE_ADM_DEN_SCALE2, i) + ADM_SCALE_CONSTANT));
         adm_scale3.append(
-                (get_at(&adm_num_scale3_array, i) + ADM_SCALE_CONSTANT)
-                        / (get_at(&adm_den_scale3_array, i) + ADM_SCALE_CONSTANT));
-        motion.append(get_at(&motion_array, i));
-        motion2.append(get_at(&motion2_array, i));
+                (feature_table_get(table, FEATURE_ADM_NUM_SCALE3, i) + ADM_SCALE_CONSTANT)
+                        / (feature_table_get(table, FEATURE_ADM_DEN_SCALE3, i) + ADM_SCALE_CONSTANT));
+        motion.append(feature_table_get(table, FEATURE_MOTION, i));
+        motion2.append(feature_table_get(table, FEATURE_MOTION2, i));
         vif_scale0.append(
-                get_at(&vif_num_scale0_array, i)
-                        / get_at(&vif_den_scale0_array, i));
+                feature_table_get(table, FEATURE_VIF_NUM_SCALE0, i)
+                        / feature_table_get(table, FEATURE_VIF_DEN_SCALE0, i));
         vif_scale1.append(
-                get_at(&vif_num_scale1_array, i)
-                        / get_at(&vif_den_scale1_array, i));
+                feature_table_get(table, FEATURE_VIF_NUM_SCALE1, i)
+                        / feature_table_get(table, FEATURE_VIF_DEN_SCALE1, i));
         vif_scale2.append(
-                get_at(&vif_num_scale2_array, i)
-                        / get_at(&vif_den_scale2_array, i));
+                feature_table_get(table, FEATURE_VIF_NUM_SCALE2, i)
+                        / feature_table_get(table, FEATURE_VIF_DEN_SCALE2, i));
         vif_scale3.append(
-                get_at(&vif_num_scale3_array, i)
-                        / get_at(&vif_den_scale3_array, i));
-        vif.append(get_at(&vif_array, i));
+                feature_table_get(table, FEATURE_VIF_NUM_SCALE3, i)
+                        / feature_table_get(table, FEATURE_VIF_DEN_SCALE3, i));
+        vif.append(feature_table_get(table, FEATURE_VIF, i));
 
-        if (psnr_array_ptr != NULL) {
-            psnr.append(get_at(&psnr_array, i));
+        if (do_psnr) {
+            psnr.append(feature_table_get(table, FEATURE_PSNR, i));
         }
-        if (ssim_array_ptr != NULL) {
-            ssim.append(get_at(&ssim_array, i));
+        if (do_ssim) {
+            ssim.append(feature_table_get(table, FEATURE_SSIM, i));
         }
-        if (ms_ssim_array_ptr != NULL) {
-            ms_ssim.append(get_at(&ms_ssim_array, i));
+        if (do_ms_ssim) {
+            ms_ssim.append(feature_table_get(table, FEATURE_MS_SSIM, i));
         }
     }
     dbg_printf(
@@ -730,94 +587,30 @@ Result VmafQualityRunner::run(Asset asset, int (*read_frame)(float *ref_data, fl
     for (size_t i = 0; i < num_frms; i += n_subsample) {
         num_frms_subsampled++;
     }
+    StatVector* const features[MODEL_FEATURE_CNT] = {
+        &adm2, &adm_scale0, &adm_scale1, &adm_scale2, &adm_scale3, &motion,
+        &vif_scale0, &vif_scale1, &vif_scale2, &vif_scale3, &vif, &motion2,
+    };
     _normalize_predict_denormalize_transform_clip(model, num_frms_subsampled,
-            adm2, adm_scale0, adm_scale1, adm_scale2, adm_scale3, motion,
-            vif_scale0, vif_scale1, vif_scale2, vif_scale3, vif, motion2,
-            enable_transform, disable_clip, predictionStructs);
+            features, enable_transform, disable_clip, predictionStructs);
     Result result { };
-    for (size_t j = 0; j < model.feature_names.length(); j++) {
-
-        if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_adm2_score'") == 0)
-            result.set_scores("adm2", adm2);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_adm_scale0_score'") == 0)
-            result.set_scores("adm_scale0", adm_scale0);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_adm_scale1_score'") == 0)
-            result.set_scores("adm_scale1", adm_scale1);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_adm_scale2_score'") == 0)
-            result.set_scores("adm_scale2", adm_scale2);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_adm_scale3_score'") == 0)
-            result.set_scores("adm_scale3", adm_scale3);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_motion_score'") == 0)
-            result.set_scores("motion", motion);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_vif_scale0_score'") == 0)
-            result.set_scores("vif_scale0", vif_scale0);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_vif_scale1_score'") == 0)
-            result.set_scores("vif_scale1", vif_scale1);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_vif_scale2_score'") == 0)
-            result.set_scores("vif_scale2", vif_scale2);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_vif_scale3_score'") == 0)
-            result.set_scores("vif_scale3", vif_scale3);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_vif_score'") == 0)
-            result.set_scores("vif", vif);
-        else if (strcmp(Stringize(model.feature_names[j]).c_str(),
-                "'VMAF_feature_motion2_score'") == 0)
-            result.set_scores("motion2", motion2);
-        else {
-            printf("Unknown feature name: %s.\n",
-                    Stringize(model.feature_names[j]).c_str());
-            throw VmafException("Unknown feature name");
-
-        }
+    for (size_t j = 0; j < model.feature_index.size(); j++) {
+        VmafModelFeature k = model.feature_index[j];
+        result.set_scores(model_features[k].key, *features[k]);
     }
 
-    if (psnr_array_ptr != NULL) {
+    if (do_psnr) {
         result.set_scores("psnr", psnr);
     }
-    if (ssim_array_ptr != NULL) {
+    if (do_ssim) {
         result.set_scores("ssim", ssim);
     }
-    if (ms_ssim_array_ptr != NULL) {
+    if (do_ms_ssim) {
         result.set_scores("ms_ssim", ms_ssim);
     }
 
     _set_prediction_result(predictionStructs, result);
 
-    free_array(&adm_num_array);
-    free_array(&adm_den_array);
-    free_array(&adm_num_scale0_array);
-    free_array(&adm_den_scale0_array);
-    free_array(&adm_num_scale1_array);
-    free_array(&adm_den_scale1_array);
-    free_array(&adm_num_scale2_array);
-    free_array(&adm_den_scale2_array);
-    free_array(&adm_num_scale3_array);
-    free_array(&adm_den_scale3_array);
-    free_array(&motion_array);
-    free_array(&motion2_array);
-    free_array(&vif_num_scale0_array);
-    free_array(&vif_den_scale0_array);
-    free_array(&vif_num_scale1_array);
-    free_array(&vif_den_scale1_array);
-    free_array(&vif_num_scale2_array);
-    free_array(&vif_den_scale2_array);
-    free_array(&vif_num_scale3_array);
-    free_array(&vif_den_scale3_array);
-    free_array(&vif_array);
-    free_array(&psnr_array);
-    free_array(&ssim_array);
-    free_array(&ms_ssim_array);
-
     return result;
 }
 
@@ -1005,6 +798,16 @@ double RunVmaf(const char* fmt, int width, int height,
 
     std::vector<std::string> result_keys = result.get_keys();
 
+    /* fetch every column once; get_scores() returns a copy */
+    std::vector<StatVector> result_columns;
+    if (log_path != NULL)
+    {
+        for (size_t j=0; j<result_keys.size(); j++)
+        {
+            result_columns.push_back(result.get_scores(result_keys[j]));
+        }
+    }
+
     double aggregate_bagging = 0.0, aggregate_stddev = 0.0, aggregate_ci95_low = 0.0, aggregate_ci95_high = 0.0;
     if (result.has_scores("bagging"))
         aggregate_bagging = result.get_score("bagging");
@@ -1087,7 +890,7 @@ double RunVmaf(const char* fmt, int width, int height,
             OTab metrics_scores;
             for (size_t j=0; j<result_keys.size(); j++)
             {
-                value = result.get_scores(result_keys[j].c_str()).at(i_subsampled);
+                value = result_columns[j].at(i_subsampled);
                 value = _round_to_digit(value, 5);
                 metrics_scores[result_keys[j].c_str()] = value;
             }
@@ -1138,7 +941,7 @@ double RunVmaf(const char* fmt, int width, int height,
 			fprintf(csv, "%d,%d,%d,", frameNum, width, height);
 			for (size_t j = 0; j<result_keys.size(); j++)
 			{
-				fprintf(csv, "%4.4f,", (float)result.get_scores(result_keys[j].c_str()).at(i_subsampled));
+				fprintf(csv, "%4.4f,", (float)result_columns[j].at(i_subsampled));
 			}
 			fprintf(csv, "\n");
 		}
@@ -1191,7 +994,7 @@ double RunVmaf(const char* fmt, int width, int height,
             node.append_attribute("frameNum") = (int)i_subsampled * n_subsample;
             for (size_t j=0; j<result_keys.size(); j++)
             {
-                node.append_attribute(result_keys[j].c_str()) = result.get_scores(result_keys[j].c_str()).at(i_subsampled);
+                node.append_attribute(result_keys[j].c_str()) = result_columns[j].at(i_subsampled);
             }
         }
 
@@ -35,7 +35,7 @@
 
 #include "svm.h"
 #include "chooseser.h"
-#include "darray.h"
+#include "feature_table.h"
 
 #ifndef WINCE
 #define TIME_TEST_ENABLE 		1 // 1: memory leak test enable 0: disable
@@ -150,6 +150,25 @@ enum VmafPredictionReturnType
     MINUS_DELTA
 };
 
+/* features a model may reference; VmafQualityRunner::run() hands the
+ * model one StatVector per entry, in this order */
+enum VmafModelFeature
+{
+    MODEL_FEATURE_ADM2,
+    MODEL_FEATURE_ADM_SCALE0,
+    MODEL_FEATURE_ADM_SCALE1,
+    MODEL_FEATURE_ADM_SCALE2,
+    MODEL_FEATURE_ADM_SCALE3,
+    MODEL_FEATURE_MOTION,
+    MODEL_FEATURE_VIF_SCALE0,
+    MODEL_FEATURE_VIF_SCALE1,
+    MODEL_FEATURE_VIF_SCALE2,
+    MODEL_FEATURE_VIF_SCALE3,
+    MODEL_FEATURE_VIF,
+    MODEL_FEATURE_MOTION2,
+    MODEL_FEATURE_CNT
+};
+
 struct VmafPredictionStruct
 {
     std::map<VmafPredictionReturnType, double> vmafPrediction;
@@ -161,15 +180,22 @@ class LibsvmNusvrTrainTestModel
 public:
     LibsvmNusvrTrainTestModel(const char *model_path): model_path(model_path) {}
     Val feature_names, norm_type, slopes, intercepts, score_clip, score_transform;
+    /* compiled from the Val fields above by load_model(), so that per-frame
+     * prediction never touches Val; 'none' normalization compiles to a
+     * slope of 1 and an intercept of 0 */
+    std::vector<VmafModelFeature> feature_index;
+    std::vector<double> feature_slopes, feature_intercepts;
+    double score_slope, score_intercept;
+    bool has_score_clip;
+    double score_clip_min, score_clip_max;
+    bool has_score_transform;
+    bool has_transform_p[3];
+    double transform_p[3];
+    bool transform_out_lte_in, transform_out_gte_in;
     virtual void load_model();
     virtual VmafPredictionStruct predict(svm_node* nodes);
     void populate_and_normalize_nodes_at_frm(size_t i_frm,
-            svm_node*& nodes, StatVector& adm2,
-            StatVector& adm_scale0, StatVector& adm_scale1,
-            StatVector& adm_scale2, StatVector& adm_scale3, StatVector& motion,
-            StatVector& vif_scale0, StatVector& vif_scale1,
-            StatVector& vif_scale2, StatVector& vif_scale3, StatVector& vif,
-            StatVector& motion2);
+            svm_node*& nodes, StatVector* const features[MODEL_FEATURE_CNT]);
     virtual ~LibsvmNusvrTrainTestModel() {}
 protected:
     const char *model_path;
@@ -178,6 +204,7 @@ protected:
             Val& intercepts, Val& score_clip, Val& score_transform);
     std::unique_ptr<svm_model, SvmDelete> _read_and_assert_svm_model(const char* libsvm_model_path);
     void _denormalize_prediction(double& prediction);
+    void _compile_model();
 
 private:
     virtual void _assert_model_type(Val model_type);
@@ -220,12 +247,8 @@ private:
     virtual void _clip_score(LibsvmNusvrTrainTestModel& model, VmafPredictionStruct& predictionStruct);
     virtual void _postproc_transform_clip(VmafPredictionStruct& predictionStruct);
     void _normalize_predict_denormalize_transform_clip(LibsvmNusvrTrainTestModel& model,
-            size_t num_frms, StatVector& adm2,
-            StatVector& adm_scale0, StatVector& adm_scale1,
-            StatVector& adm_scale2, StatVector& adm_scale3, StatVector& motion,
-            StatVector& vif_scale0, StatVector& vif_scale1,
-            StatVector& vif_scale2, StatVector& vif_scale3, StatVector& vif,
-            StatVector& motion2, bool enable_transform, bool disable_clip,
+            size_t num_frms, StatVector* const features[MODEL_FEATURE_CNT],
+            bool enable_transform, bool disable_clip,
             std::vector<VmafPredictionStruct>& predictionStructs);
 };
 
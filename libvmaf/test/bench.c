@@ -0,0 +1,368 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+
+enum vmaf_cpu cpu;
+
+#define RESULT_FMT \
+    "{\"kernel\": \"%s\", \"cpu\": \"%s\", \"width\": %u, \"height\": %u, " \
+    "\"bpc\": %u, \"iterations\": %u, \"median_ns\": %.0f, \"min_ns\": %.0f}"
+
+#define RESULT_SCAN_FMT \
+    "{\"kernel\": \"%63[^\"]\", \"cpu\": \"%15[^\"]\", \"width\": %u, " \
+    "\"height\": %u, \"bpc\": %u, \"iterations\": %u, \"median_ns\": %lf, " \
+    "\"min_ns\": %lf}"
+
+static const struct {
+    const char *name;
+    unsigned w, h;
+} resolutions[] = {
+    { "480p", 854, 480 },
+    { "720p", 1280, 720 },
+    { "1080p", 1920, 1080 },
+    { "2160p", 3840, 2160 },
+    { "4320p", 7680, 4320 },
+};
+
+#define N_RESOLUTIONS (sizeof(resolutions) / sizeof(resolutions[0]))
+
+static const char *cpu_names[] = {
+    [VMAF_CPU_NONE] = "c",
+    [VMAF_CPU_SSE2] = "sse2",
+    [VMAF_CPU_AVX] = "avx",
+};
+
+typedef struct BenchResult {
+    char kernel[64], cpu[16];
+    unsigned w, h, bpc, iterations;
+    double median_ns, min_ns;
+} BenchResult;
+
+typedef struct BenchSettings {
+    const char *kernel[16];
+    unsigned n_kernels;
+    unsigned resolution_mask;
+    const char *output_path, *baseline_path;
+    double tolerance, min_time;
+} BenchSettings;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    const double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static int run_kernel(const BenchKernel *kernel, const BenchParams *params,
+                      double min_time, BenchResult *result)
+{
+    void *state;
+    int err = kernel->init(&state, params);
+    if (err) return err;
+
+    unsigned capacity = 64, cnt = 0;
+    double *sample = malloc(sizeof(*sample) * capacity);
+    if (!sample) {
+        err = -ENOMEM;
+        goto close;
+    }
+
+    kernel->run(state, params);
+    const uint64_t begin = now_ns();
+    while (cnt < 3 || (now_ns() - begin) < min_time * 1e9) {
+        if (cnt == capacity) {
+            double *s = realloc(sample, sizeof(*sample) * capacity * 2);
+            if (!s) {
+                err = -ENOMEM;
+                goto free_sample;
+            }
+            sample = s;
+            capacity *= 2;
+        }
+        const uint64_t t = now_ns();
+        kernel->run(state, params);
+        sample[cnt++] = now_ns() - t;
+    }
+
+    qsort(sample, cnt, sizeof(*sample), cmp_double);
+    memset(result, 0, sizeof(*result));
+    snprintf(result->kernel, sizeof(result->kernel), "%s", kernel->name);
+    snprintf(result->cpu, sizeof(result->cpu), "%s", cpu_names[params->cpu]);
+    result->w = params->w;
+    result->h = params->h;
+    result->bpc = params->bpc;
+    result->iterations = cnt;
+    result->median_ns = sample[cnt / 2];
+    result->min_ns = sample[0];
+
+free_sample:
+    free(sample);
+close:
+    kernel->close(state);
+    return err;
+}
+
+static BenchResult *baseline_find(BenchResult *baseline, unsigned n,
+                                  const BenchResult *r)
+{
+    for (unsigned i = 0; i < n; i++) {
+        if (strcmp(baseline[i].kernel, r->kernel)) continue;
+        if (strcmp(baseline[i].cpu, r->cpu)) continue;
+        if (baseline[i].w != r->w || baseline[i].h != r->h) continue;
+        if (baseline[i].bpc != r->bpc) continue;
+        return &baseline[i];
+    }
+    return NULL;
+}
+
+/**
+ * A baseline is the output of a previous run, or several of them
+ * concatenated. Every line holding a result is read, everything else is
+ * ignored.
+ */
+static int baseline_read(const char *path, BenchResult **baseline,
+                         unsigned *n)
+{
+    FILE *in = fopen(path, "r");
+    if (!in) return -errno;
+
+    unsigned capacity = 64;
+    BenchResult *b = *baseline = malloc(sizeof(*b) * capacity);
+    if (!b) goto fail;
+    *n = 0;
+
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        const char *s = strchr(line, '{');
+        if (!s) continue;
+        BenchResult r;
+        if (sscanf(s, RESULT_SCAN_FMT, r.kernel, r.cpu, &r.w, &r.h, &r.bpc,
+                   &r.iterations, &r.median_ns, &r.min_ns) != 8)
+        {
+            continue;
+        }
+        if (*n == capacity) {
+            BenchResult *t = realloc(b, sizeof(*b) * capacity * 2);
+            if (!t) goto free_baseline;
+            *baseline = b = t;
+            capacity *= 2;
+        }
+        b[(*n)++] = r;
+    }
+
+    fclose(in);
+    return 0;
+
+free_baseline:
+    free(b);
+fail:
+    fclose(in);
+    return -ENOMEM;
+}
+
+static void usage(const char *app)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        " --kernel/-k $name:     run only this kernel, may be repeated\n"
+        " --resolution/-r $name: run only this resolution, may be repeated\n"
+        "                        (480p, 720p, 1080p, 2160p, 4320p)\n"
+        " --output/-o $path:     write JSON results to $path\n"
+        " --baseline/-b $path:   compare against the results of a previous "
+        "run\n"
+        " --tolerance/-t $frac:  allowed slowdown vs. baseline, default 0.10\n"
+        " --min-time/-m $sec:    minimum time per measurement, default 0.25\n",
+        app);
+}
+
+static int parse_settings(BenchSettings *s, int argc, char *argv[])
+{
+    static const struct option long_opts[] = {
+        { "kernel", 1, NULL, 'k' },
+        { "resolution", 1, NULL, 'r' },
+        { "output", 1, NULL, 'o' },
+        { "baseline", 1, NULL, 'b' },
+        { "tolerance", 1, NULL, 't' },
+        { "min-time", 1, NULL, 'm' },
+        { NULL, 0, NULL, 0 },
+    };
+
+    memset(s, 0, sizeof(*s));
+    s->tolerance = 0.10;
+    s->min_time = 0.25;
+
+    int o;
+    while ((o = getopt_long(argc, argv, "k:r:o:b:t:m:", long_opts, NULL)) >= 0) {
+        switch (o) {
+        case 'k':
+            if (s->n_kernels == sizeof(s->kernel) / sizeof(s->kernel[0]))
+                return -EINVAL;
+            s->kernel[s->n_kernels++] = optarg;
+            break;
+        case 'r': {
+            unsigned i;
+            for (i = 0; i < N_RESOLUTIONS; i++) {
+                if (!strcmp(optarg, resolutions[i].name)) break;
+            }
+            if (i == N_RESOLUTIONS) return -EINVAL;
+            s->resolution_mask |= 1 << i;
+            break;
+        }
+        case 'o':
+            s->output_path = optarg;
+            break;
+        case 'b':
+            s->baseline_path = optarg;
+            break;
+        case 't':
+            s->tolerance = atof(optarg);
+            break;
+        case 'm':
+            s->min_time = atof(optarg);
+            break;
+        default:
+            return -EINVAL;
+        }
+    }
+
+    if (!s->resolution_mask)
+        s->resolution_mask = (1 << N_RESOLUTIONS) - 1;
+    return 0;
+}
+
+static int kernel_selected(const BenchSettings *s, const BenchKernel *kernel)
+{
+    if (!s->n_kernels) return 1;
+    for (unsigned i = 0; i < s->n_kernels; i++) {
+        if (!strcmp(s->kernel[i], kernel->name)) return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchSettings s;
+    int err = parse_settings(&s, argc, argv);
+    if (err) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    BenchResult *baseline = NULL;
+    unsigned n_baseline = 0;
+    if (s.baseline_path) {
+        err = baseline_read(s.baseline_path, &baseline, &n_baseline);
+        if (err) {
+            fprintf(stderr, "could not read baseline %s\n", s.baseline_path);
+            return 1;
+        }
+    }
+
+    FILE *out = s.output_path ? fopen(s.output_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "could not open %s\n", s.output_path);
+        free(baseline);
+        return 1;
+    }
+
+    const enum vmaf_cpu cpu_max = cpu_autodetect();
+    unsigned n_results = 0, n_regressions = 0;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"results\": [");
+    for (unsigned k = 0; bench_kernels[k].name; k++) {
+        const BenchKernel *kernel = &bench_kernels[k];
+        if (!kernel_selected(&s, kernel)) continue;
+
+        for (enum vmaf_cpu c = VMAF_CPU_NONE; c <= cpu_max; c++) {
+            if (c == VMAF_CPU_SSE2) continue;
+            if ((kernel->flags & BENCH_AVX_ONLY) && c < VMAF_CPU_AVX)
+                continue;
+            if (!(kernel->flags & (BENCH_AVX_ONLY | BENCH_CPU_DISPATCH)) &&
+                c < cpu_max)
+            {
+                continue;
+            }
+            cpu = c;
+
+            for (unsigned i = 0; i < N_RESOLUTIONS; i++) {
+                if (!(s.resolution_mask & (1 << i))) continue;
+
+                for (unsigned b = 0; b < 2 && kernel->bpc[b]; b++) {
+                    BenchParams params = {
+                        .w = resolutions[i].w,
+                        .h = resolutions[i].h,
+                        .bpc = kernel->bpc[b],
+                        .cpu = c,
+                    };
+                    if (kernel->flags & BENCH_NO_RESOLUTION)
+                        params.w = params.h = 0;
+
+                    BenchResult r;
+                    err = run_kernel(kernel, &params, s.min_time, &r);
+                    if (err) {
+                        fprintf(stderr, "%s failed: %d\n", kernel->name, err);
+                        goto fail;
+                    }
+
+                    fprintf(out, "%s\n    ", n_results++ ? "," : "");
+                    fprintf(out, RESULT_FMT, r.kernel, r.cpu, r.w, r.h, r.bpc,
+                            r.iterations, r.median_ns, r.min_ns);
+
+                    fprintf(stderr, "%-24s %-4s %5ux%-5u %2u-bit %12.0f ns",
+                            r.kernel, r.cpu, r.w, r.h, r.bpc, r.median_ns);
+                    BenchResult *base = baseline_find(baseline, n_baseline, &r);
+                    if (base) {
+                        const double ratio = r.median_ns / base->median_ns;
+                        const int regression = ratio > 1. + s.tolerance;
+                        n_regressions += regression;
+                        fprintf(stderr, " %+6.1f%%%s", (ratio - 1.) * 100.,
+                                regression ? " REGRESSION" : "");
+                    }
+                    fprintf(stderr, "\n");
+                }
+                if (kernel->flags & BENCH_NO_RESOLUTION) break;
+            }
+        }
+    }
+    fprintf(out, "\n  ]\n");
+    fprintf(out, "}\n");
+
+fail:
+    if (out != stdout) fclose(out);
+    free(baseline);
+    if (n_regressions)
+        fprintf(stderr, "%u regression(s) vs. %s\n", n_regressions,
+                s.baseline_path);
+    return err || n_regressions;
+}
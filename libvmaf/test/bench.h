@@ -0,0 +1,52 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_BENCH_H__
+#define __VMAF_BENCH_H__
+
+#include "feature/common/cpu.h"
+
+enum BenchKernelFlags {
+    BENCH_AVX_ONLY = 1 << 0, ///< Kernel has no C fallback.
+    BENCH_NO_RESOLUTION = 1 << 1, ///< Runtime does not depend on the frame.
+    BENCH_CPU_DISPATCH = 1 << 2, ///< Kernel has a path per CPU tier.
+};
+
+typedef struct BenchParams {
+    unsigned w, h, bpc;
+    enum vmaf_cpu cpu;
+} BenchParams;
+
+typedef struct BenchKernel {
+    const char *name;
+    unsigned flags;
+    unsigned bpc[2]; ///< Bitdepths to run, 0 terminates.
+    /**
+     * Allocate and fill all buffers used by `run`, so that only the kernel
+     * itself is timed.
+     *
+     * @return 0 on success, or < 0 (a negative errno code) on error.
+     */
+    int (*init)(void **state, const BenchParams *params);
+    void (*run)(void *state, const BenchParams *params);
+    void (*close)(void *state);
+} BenchKernel;
+
+extern const BenchKernel bench_kernels[]; ///< Terminated by a NULL name.
+
+#endif /* __VMAF_BENCH_H__ */
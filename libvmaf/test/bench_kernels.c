@@ -0,0 +1,445 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "mem.h"
+#include "model.h"
+#include "svm.h"
+#include "feature/adm_options.h"
+#include "feature/adm_tools.h"
+#include "feature/feature_collector.h"
+#include "feature/feature_extractor.h"
+#include "feature/integer_motion_function.h"
+#include "feature/picture_copy.h"
+#include "feature/vif_tools.h"
+#include "feature/common/convolution.h"
+
+#include <libvmaf/model.h>
+#include <libvmaf/picture.h>
+
+static unsigned rand_state = 1;
+
+static unsigned next_rand(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return (rand_state >> 16) & 0x7fff;
+}
+
+static float *float_plane(unsigned w, unsigned h, int *stride)
+{
+    *stride = ALIGN_CEIL(w * sizeof(float));
+    float *buf = aligned_malloc((size_t) *stride * h, MAX_ALIGN);
+    if (!buf) return NULL;
+    for (unsigned i = 0; i < h; i++) {
+        float *row = buf + (size_t) i * (*stride / sizeof(float));
+        for (unsigned j = 0; j < w; j++)
+            row[j] = (float) (next_rand() & 255) - 128.f;
+    }
+    return buf;
+}
+
+static int fill_picture(VmafPicture *pic, unsigned bpc, unsigned w, unsigned h)
+{
+    int err = vmaf_picture_alloc(pic, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+    if (err) return err;
+    const unsigned max = (1 << bpc) - 1;
+    for (unsigned i = 0; i < h; i++) {
+        uint8_t *row = (uint8_t *) pic->data[0] + (size_t) i * pic->stride[0];
+        for (unsigned j = 0; j < w; j++) {
+            if (bpc > 8)
+                ((uint16_t *) row)[j] = next_rand() & max;
+            else
+                row[j] = next_rand() & max;
+        }
+    }
+    return 0;
+}
+
+/* convolution_f32_avx_s, vif_filter1d_s */
+
+typedef struct FilterState {
+    float *src, *dst, *tmp;
+    int stride;
+} FilterState;
+
+static int filter_init(void **state, const BenchParams *p)
+{
+    FilterState *s = *state = malloc(sizeof(*s));
+    if (!s) return -ENOMEM;
+    memset(s, 0, sizeof(*s));
+    s->src = float_plane(p->w, p->h, &s->stride);
+    s->dst = float_plane(p->w, p->h, &s->stride);
+    s->tmp = float_plane(p->w, p->h, &s->stride);
+    return s->src && s->dst && s->tmp ? 0 : -ENOMEM;
+}
+
+static void convolution_run(void *state, const BenchParams *p)
+{
+    FilterState *s = state;
+    const int px_stride = s->stride / sizeof(float);
+    convolution_f32_avx_s(vif_filter1d_table_s[0], vif_filter1d_width[0],
+                          s->src, s->dst, s->tmp, p->w, p->h, px_stride,
+                          px_stride);
+}
+
+static void vif_filter1d_run(void *state, const BenchParams *p)
+{
+    FilterState *s = state;
+    vif_filter1d_s(vif_filter1d_table_s[0], s->src, s->dst, s->tmp, p->w,
+                   p->h, s->stride, s->stride, vif_filter1d_width[0]);
+}
+
+static void filter_close(void *state)
+{
+    FilterState *s = state;
+    aligned_free(s->src);
+    aligned_free(s->dst);
+    aligned_free(s->tmp);
+    free(s);
+}
+
+/* adm_dwt2_s, adm_cm_s */
+
+typedef struct AdmState {
+    float *src;
+    int src_stride, buf_stride;
+    adm_dwt_band_t_s band[3];
+    int *ind_y[4], *ind_x[4];
+} AdmState;
+
+static int adm_init(void **state, const BenchParams *p)
+{
+    AdmState *s = *state = malloc(sizeof(*s));
+    if (!s) return -ENOMEM;
+    memset(s, 0, sizeof(*s));
+
+    const unsigned w = (p->w + 1) / 2, h = (p->h + 1) / 2;
+    s->src = float_plane(p->w, p->h, &s->src_stride);
+    if (!s->src) return -ENOMEM;
+    for (unsigned i = 0; i < 3; i++) {
+        if (!(s->band[i].band_a = float_plane(w, h, &s->buf_stride)) ||
+            !(s->band[i].band_v = float_plane(w, h, &s->buf_stride)) ||
+            !(s->band[i].band_h = float_plane(w, h, &s->buf_stride)) ||
+            !(s->band[i].band_d = float_plane(w, h, &s->buf_stride)))
+        {
+            return -ENOMEM;
+        }
+    }
+    for (unsigned i = 0; i < 4; i++) {
+        s->ind_y[i] = aligned_malloc(ALIGN_CEIL(h * sizeof(int)), MAX_ALIGN);
+        s->ind_x[i] = aligned_malloc(ALIGN_CEIL(w * sizeof(int)), MAX_ALIGN);
+        if (!s->ind_y[i] || !s->ind_x[i]) return -ENOMEM;
+    }
+    dwt2_src_indices_filt_s(s->ind_y, s->ind_x, p->w, p->h);
+    return 0;
+}
+
+static void adm_dwt2_run(void *state, const BenchParams *p)
+{
+    AdmState *s = state;
+    adm_dwt2_s(s->src, &s->band[0], s->ind_y, s->ind_x, p->w, p->h,
+               s->src_stride, s->buf_stride);
+}
+
+static void adm_cm_run(void *state, const BenchParams *p)
+{
+    AdmState *s = state;
+    adm_cm_s(&s->band[0], &s->band[1], &s->band[2], (p->w + 1) / 2,
+             (p->h + 1) / 2, s->buf_stride, s->buf_stride, s->buf_stride,
+             ADM_BORDER_FACTOR, 0);
+}
+
+static void adm_close(void *state)
+{
+    AdmState *s = state;
+    aligned_free(s->src);
+    for (unsigned i = 0; i < 3; i++) {
+        aligned_free(s->band[i].band_a);
+        aligned_free(s->band[i].band_v);
+        aligned_free(s->band[i].band_h);
+        aligned_free(s->band[i].band_d);
+    }
+    for (unsigned i = 0; i < 4; i++) {
+        aligned_free(s->ind_y[i]);
+        aligned_free(s->ind_x[i]);
+    }
+    free(s);
+}
+
+/* vif_statistic_s */
+
+typedef struct VifStatisticState {
+    float *buf[8]; ///< mu1_sq, mu2_sq, mu1_mu2, xx, yy, xy, num, den
+    int stride;
+} VifStatisticState;
+
+static int vif_statistic_init(void **state, const BenchParams *p)
+{
+    VifStatisticState *s = *state = malloc(sizeof(*s));
+    if (!s) return -ENOMEM;
+    memset(s, 0, sizeof(*s));
+    for (unsigned i = 0; i < 8; i++) {
+        s->buf[i] = float_plane(p->w, p->h, &s->stride);
+        if (!s->buf[i]) return -ENOMEM;
+    }
+    return 0;
+}
+
+static void vif_statistic_run(void *state, const BenchParams *p)
+{
+    VifStatisticState *s = state;
+    const int st = s->stride;
+    vif_statistic_s(s->buf[0], s->buf[1], s->buf[2], s->buf[3], s->buf[4],
+                    s->buf[5], s->buf[6], s->buf[7], p->w, p->h,
+                    st, st, st, st, st, st, st, st);
+}
+
+static void vif_statistic_close(void *state)
+{
+    VifStatisticState *s = state;
+    for (unsigned i = 0; i < 8; i++)
+        aligned_free(s->buf[i]);
+    free(s);
+}
+
+/* integer_convolution_8, integer_convolution_16, picture_copy */
+
+typedef struct PictureState {
+    VmafPicture src, dst, tmp;
+    float *copy;
+} PictureState;
+
+static int picture_init(void **state, const BenchParams *p)
+{
+    PictureState *s = *state = malloc(sizeof(*s));
+    if (!s) return -ENOMEM;
+    memset(s, 0, sizeof(*s));
+    int err = fill_picture(&s->src, p->bpc, p->w, p->h);
+    err |= vmaf_picture_alloc(&s->dst, VMAF_PIX_FMT_YUV420P, 16, p->w, p->h);
+    err |= vmaf_picture_alloc(&s->tmp, VMAF_PIX_FMT_YUV420P, 16, p->w, p->h);
+    if (err) return err;
+    s->copy = aligned_malloc(sizeof(float) * p->w * p->h, MAX_ALIGN);
+    return s->copy ? 0 : -ENOMEM;
+}
+
+static void integer_convolution_run(void *state, const BenchParams *p)
+{
+    PictureState *s = state;
+    if (p->bpc == 8) {
+        integer_convolution_8(INTEGER_FILTER_5_s, 5, s->src.data[0],
+                              s->dst.data[0], s->tmp.data[0], p->w, p->h,
+                              s->src.stride[0], s->dst.stride[0] >> 1,
+                              p->bpc);
+    } else {
+        integer_convolution_16(INTEGER_FILTER_5_s, 5, s->src.data[0],
+                               s->dst.data[0], s->tmp.data[0], p->w, p->h,
+                               s->src.stride[0] >> 1, s->dst.stride[0] >> 1,
+                               p->bpc);
+    }
+}
+
+static void picture_copy_run(void *state, const BenchParams *p)
+{
+    PictureState *s = state;
+    picture_copy(s->copy, &s->src, -128, p->bpc);
+}
+
+static void picture_close(void *state)
+{
+    PictureState *s = state;
+    if (s->src.ref_cnt) vmaf_picture_unref(&s->src);
+    if (s->dst.ref_cnt) vmaf_picture_unref(&s->dst);
+    if (s->tmp.ref_cnt) vmaf_picture_unref(&s->tmp);
+    aligned_free(s->copy);
+    free(s);
+}
+
+/* calc_ssim, timed through the integer "ssim" feature extractor */
+
+typedef struct SsimState {
+    VmafFeatureExtractorContext *fex_ctx;
+    VmafFeatureCollector *fc;
+    VmafPicture ref, dist;
+    unsigned index;
+} SsimState;
+
+static int ssim_init(void **state, const BenchParams *p)
+{
+    SsimState *s = *state = malloc(sizeof(*s));
+    if (!s) return -ENOMEM;
+    memset(s, 0, sizeof(*s));
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name("ssim");
+    if (!fex) return -EINVAL;
+    int err = vmaf_feature_extractor_context_create(&s->fex_ctx, fex);
+    if (err) return err;
+    err = vmaf_feature_collector_init(&s->fc);
+    if (err) return err;
+    err = fill_picture(&s->ref, p->bpc, p->w, p->h);
+    if (err) return err;
+    return fill_picture(&s->dist, p->bpc, p->w, p->h);
+}
+
+static void ssim_run(void *state, const BenchParams *p)
+{
+    (void) p;
+    SsimState *s = state;
+    vmaf_feature_extractor_context_extract(s->fex_ctx, &s->ref, &s->dist,
+                                           s->index++, s->fc);
+}
+
+static void ssim_close(void *state)
+{
+    SsimState *s = state;
+    if (s->fex_ctx) {
+        vmaf_feature_extractor_context_close(s->fex_ctx);
+        vmaf_feature_extractor_context_destroy(s->fex_ctx);
+    }
+    vmaf_feature_collector_destroy(s->fc);
+    if (s->ref.ref_cnt) vmaf_picture_unref(&s->ref);
+    if (s->dist.ref_cnt) vmaf_picture_unref(&s->dist);
+    free(s);
+}
+
+/* svm_predict */
+
+typedef struct SvmState {
+    VmafModel *model;
+    struct svm_node *node;
+} SvmState;
+
+static int svm_init(void **state, const BenchParams *p)
+{
+    (void) p;
+    SvmState *s = *state = malloc(sizeof(*s));
+    if (!s) return -ENOMEM;
+    memset(s, 0, sizeof(*s));
+    VmafModelConfig cfg = {
+        .path = "../../model/vmaf_v0.6.1.pkl",
+        .name = "vmaf",
+        .flags = VMAF_MODEL_FLAGS_DEFAULT,
+    };
+    int err = vmaf_model_load_from_path(&s->model, &cfg);
+    if (err) return err;
+    s->node = malloc(sizeof(*s->node) * (s->model->n_features + 1));
+    if (!s->node) return -ENOMEM;
+    for (unsigned i = 0; i < s->model->n_features; i++) {
+        s->node[i].index = i + 1;
+        s->node[i].value = (next_rand() & 1023) / 1023.;
+    }
+    s->node[s->model->n_features].index = -1;
+    return 0;
+}
+
+static void svm_run(void *state, const BenchParams *p)
+{
+    (void) p;
+    SvmState *s = state;
+    svm_predict(s->model->svm, s->node);
+}
+
+static void svm_close(void *state)
+{
+    SvmState *s = state;
+    if (s->model) vmaf_model_destroy(s->model);
+    free(s->node);
+    free(s);
+}
+
+const BenchKernel bench_kernels[] = {
+    {
+        .name = "convolution_f32_avx_s",
+        .flags = BENCH_AVX_ONLY,
+        .bpc = { 8 },
+        .init = filter_init,
+        .run = convolution_run,
+        .close = filter_close,
+    },
+    {
+        .name = "adm_dwt2_s",
+        .bpc = { 8 },
+        .init = adm_init,
+        .run = adm_dwt2_run,
+        .close = adm_close,
+    },
+    {
+        .name = "adm_cm_s",
+        .bpc = { 8 },
+        .init = adm_init,
+        .run = adm_cm_run,
+        .close = adm_close,
+    },
+    {
+        .name = "vif_filter1d_s",
+        .flags = BENCH_CPU_DISPATCH,
+        .bpc = { 8 },
+        .init = filter_init,
+        .run = vif_filter1d_run,
+        .close = filter_close,
+    },
+    {
+        .name = "vif_statistic_s",
+        .bpc = { 8 },
+        .init = vif_statistic_init,
+        .run = vif_statistic_run,
+        .close = vif_statistic_close,
+    },
+    {
+        .name = "integer_convolution_8",
+        .bpc = { 8 },
+        .init = picture_init,
+        .run = integer_convolution_run,
+        .close = picture_close,
+    },
+    {
+        .name = "integer_convolution_16",
+        .bpc = { 10 },
+        .init = picture_init,
+        .run = integer_convolution_run,
+        .close = picture_close,
+    },
+    {
+        .name = "calc_ssim",
+        .bpc = { 8, 10 },
+        .init = ssim_init,
+        .run = ssim_run,
+        .close = ssim_close,
+    },
+    {
+        .name = "svm_predict",
+        .flags = BENCH_NO_RESOLUTION,
+        .bpc = { 8 },
+        .init = svm_init,
+        .run = svm_run,
+        .close = svm_close,
+    },
+    {
+        .name = "picture_copy",
+        .flags = BENCH_CPU_DISPATCH,
+        .bpc = { 8, 10 },
+        .init = picture_init,
+        .run = picture_copy_run,
+        .close = picture_close,
+    },
+    { .name = NULL },
+};
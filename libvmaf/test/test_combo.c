@@ -0,0 +1,204 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "test.h"
+#include "combo.h"
+#include "mem.h"
+#include "psnr_tools.h"
+
+#define W 320
+#define H 240
+
+typedef struct {
+    unsigned frame, frame_cnt, error_at;
+} Input;
+
+/* 0 read, 1 error, 2 end of input, as read_frame() in tools/read_frame.c */
+static int read_frame(float *ref, float *dis, float *temp, int stride,
+                      void *user_data)
+{
+    (void) temp;
+    Input *in = user_data;
+    if (in->frame == in->error_at) return 1;
+    if (in->frame == in->frame_cnt) return 2;
+
+    uint32_t seed = in->frame * 2654435761u + 1;
+    for (unsigned i = 0; i < H; i++) {
+        float *r = ref + i * (stride / sizeof(float));
+        float *d = dis + i * (stride / sizeof(float));
+        for (unsigned j = 0; j < W; j++) {
+            seed = seed * 1664525u + 1013904223u;
+            r[j] = ((j * 3 + i * 5 + in->frame * 7) & 127) + (seed >> 28);
+            d[j] = r[j] + (int) ((seed >> 20) & 15) - 8;
+        }
+    }
+    in->frame++;
+    return 0;
+}
+
+static const unsigned columns = FEATURE_COLUMNS_REQUIRED |
+    FEATURE_COLUMN_BIT(FEATURE_PSNR) | FEATURE_COLUMN_BIT(FEATURE_SSIM) |
+    FEATURE_COLUMN_BIT(FEATURE_MS_SSIM);
+
+static int run_combo(FeatureTable **table, Input in, int n_thread)
+{
+    char errmsg[1024];
+    int err = feature_table_init(table, columns, 0);
+    if (err) return err;
+    return combo(read_frame, &in, W, H, "yuv420p", *table, errmsg, n_thread,
+                 1);
+}
+
+/* combo() caps n_thread at the core count, so drive its workers directly */
+static int run_threads(FeatureTable **table, Input in, int n_thread)
+{
+    char errmsg[1024];
+    int err = feature_table_init(table, columns, 0);
+    if (err) return err;
+
+    VMAF_THREAD_STRUCT data = {
+        .read_frame = read_frame, .user_data = &in, .w = W, .h = H,
+        .fmt = "yuv420p", .feature_table = *table, .errmsg = errmsg,
+        .n_subsample = 1, .stride = ALIGN_CEIL(W * sizeof(float)),
+        .thread_count = n_thread,
+    };
+    data.data_sz = (size_t) data.stride * H;
+    err = psnr_constants(data.fmt, &data.peak, &data.psnr_max);
+    if (err) return err;
+    const int length = n_thread + 3 < MAX_NUM_THREADS ?
+                       n_thread + 3 : MAX_NUM_THREADS;
+    if (!init_blur_ring(&data.blur_ring, length, data.data_sz, MAX_ALIGN))
+        return -ENOMEM;
+
+    pthread_t thread[MAX_NUM_THREADS];
+    for (int t = 0; t < n_thread; t++)
+        pthread_create(&thread[t], NULL, combo_threadfunc, &data);
+    for (int t = 0; t < n_thread; t++) {
+        void *ret;
+        pthread_join(thread[t], &ret);
+        if (ret) err = -1;
+    }
+
+    free_blur_ring(data.blur_ring);
+    return err;
+}
+
+static int tables_match(FeatureTable *a, FeatureTable *b, size_t frame_cnt)
+{
+    for (size_t i = 0; i < frame_cnt; i++) {
+        if (!feature_table_is_committed(b, i)) continue;
+        if (!feature_table_is_committed(a, i)) return 0;
+        for (unsigned c = 0; c < FEATURE_COLUMN_CNT; c++) {
+            const double va = feature_table_get(a, c, i);
+            const double vb = feature_table_get(b, c, i);
+            if (memcmp(&va, &vb, sizeof(va))) return 0;
+        }
+    }
+    return 1;
+}
+
+static const int n_threads[] = { 1, 2, MAX_NUM_THREADS };
+
+static char *test_combo_end_of_input()
+{
+    int err;
+
+    const unsigned frame_cnts[] = { 0, 1, 2, 20 };
+    for (unsigned i = 0; i < sizeof(frame_cnts) / sizeof(*frame_cnts); i++) {
+        const Input in = { .frame_cnt = frame_cnts[i], .error_at = -1 };
+        FeatureTable *expected;
+        err = run_combo(&expected, in, 1);
+        mu_assert("problem during combo", !err);
+        mu_assert("every frame should be committed",
+                  feature_table_frame_cnt(expected) == in.frame_cnt &&
+                  feature_table_commit_cnt(expected) == in.frame_cnt);
+
+        for (unsigned t = 0; t < sizeof(n_threads) / sizeof(*n_threads); t++) {
+            FeatureTable *table;
+            err = run_threads(&table, in, n_threads[t]);
+            mu_assert("problem during threaded combo", !err);
+            mu_assert("every frame should be committed",
+                      feature_table_frame_cnt(table) == in.frame_cnt &&
+                      feature_table_commit_cnt(table) == in.frame_cnt);
+            mu_assert("threaded features should match a single thread",
+                      tables_match(expected, table, in.frame_cnt));
+            feature_table_free(table);
+        }
+        feature_table_free(expected);
+    }
+
+    return NULL;
+}
+
+static char *test_combo_read_error()
+{
+    int err;
+
+    const Input ok = { .frame_cnt = 20, .error_at = -1 };
+    FeatureTable *expected;
+    err = run_combo(&expected, ok, 1);
+    mu_assert("problem during combo", !err);
+
+    const unsigned error_at[] = { 0, 1, 10 };
+    for (unsigned i = 0; i < sizeof(error_at) / sizeof(*error_at); i++) {
+        const Input in = { .frame_cnt = 20, .error_at = error_at[i] };
+        FeatureTable *table;
+        err = run_combo(&table, in, 1);
+        mu_assert("read error should fail combo", err);
+        feature_table_free(table);
+        for (unsigned t = 0; t < sizeof(n_threads) / sizeof(*n_threads); t++) {
+            FeatureTable *table;
+            err = run_threads(&table, in, n_threads[t]);
+            mu_assert("read error should fail combo", err);
+            mu_assert("frames past a read error should not be committed",
+                      feature_table_frame_cnt(table) <= in.error_at);
+            mu_assert("committed features should match a single thread",
+                      tables_match(expected, table, in.error_at));
+            feature_table_free(table);
+        }
+    }
+
+    feature_table_free(expected);
+    return NULL;
+}
+
+static char *test_blur_ring_length()
+{
+    BLUR_BUF_RING *ring;
+    mu_assert("ring shorter than 3 slots should be rejected",
+              !init_blur_ring(&ring, 2, 64, 32));
+    mu_assert("ring longer than MAX_NUM_THREADS should be rejected",
+              !init_blur_ring(&ring, MAX_NUM_THREADS + 1, 64, 32));
+    mu_assert("problem during init_blur_ring",
+              init_blur_ring(&ring, MAX_NUM_THREADS, 64, 32));
+    free_blur_ring(ring);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_blur_ring_length);
+    mu_run_test(test_combo_end_of_input);
+    mu_run_test(test_combo_read_error);
+    return NULL;
+}
@@ -16,6 +16,10 @@
  *
  */
 
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+
 #include "test.h"
 #include "libvmaf/libvmaf.rc.h"
 
@@ -23,20 +27,260 @@ static char *test_context_init_and_close()
 {
     int err = 0;
     VmafContext *vmaf;
-    VmafConfiguration cfg;
+    VmafConfiguration cfg = { .log_level = VMAF_LOG_LEVEL_NONE };
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+/* distortion grows with the index, so that scores differ between pictures */
+static int alloc_pictures(VmafPicture *ref, VmafPicture *dist, unsigned index)
+{
+    const unsigned w = 176, h = 144;
+    int err = vmaf_picture_alloc(ref, VMAF_PIX_FMT_YUV420P, 8, w, h);
+    if (err) return err;
+    err = vmaf_picture_alloc(dist, VMAF_PIX_FMT_YUV420P, 8, w, h);
+    if (err) return err;
+
+    uint32_t seed = index + 1;
+    for (unsigned i = 0; i < h; i++) {
+        uint8_t *r = (uint8_t *) ref->data[0] + i * ref->stride[0];
+        uint8_t *d = (uint8_t *) dist->data[0] + i * dist->stride[0];
+        for (unsigned j = 0; j < w; j++) {
+            seed = seed * 1664525u + 1013904223u;
+            r[j] = 64 + ((i * 7 + j * 3 + index * 5) & 127);
+            d[j] = r[j] + (int) (seed >> 24) % (4 * index + 1) - 2 * index;
+        }
+    }
+    for (unsigned p = 1; p < 3; p++) {
+        for (unsigned i = 0; i < ref->h[p]; i++) {
+            uint8_t *r = (uint8_t *) ref->data[p] + i * ref->stride[p];
+            uint8_t *d = (uint8_t *) dist->data[p] + i * dist->stride[p];
+            for (unsigned j = 0; j < ref->w[p]; j++)
+                r[j] = d[j] = 128;
+        }
+    }
+    return 0;
+}
+
+static char *test_context_pool_fixed_subsample()
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = {
+        .log_level = VMAF_LOG_LEVEL_NONE, .n_subsample = 3,
+    };
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+
+    VmafModel *model;
+    VmafModelConfig model_cfg = { .path = "../../model/vmaf_v0.6.1.pkl" };
+    err = vmaf_model_load_from_path(&model, &model_cfg);
+    mu_assert("problem during vmaf_model_load_from_path", !err);
+    err = vmaf_use_features_from_model(vmaf, model);
+    mu_assert("problem during vmaf_use_features_from_model", !err);
+
+    const unsigned pic_cnt = 8;
+    for (unsigned i = 0; i < pic_cnt; i++) {
+        VmafPicture ref, dist;
+        err = alloc_pictures(&ref, &dist, i);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        err = vmaf_read_pictures(vmaf, &ref, &dist, i);
+        mu_assert("problem during vmaf_read_pictures", !err);
+    }
+    /* only every third picture is scored, and only those are pooled */
+    double sum = 0., i_sum = 0., min = INFINITY, max = -INFINITY;
+    unsigned cnt = 0;
+    for (unsigned i = 0; i < pic_cnt; i += cfg.n_subsample) {
+        double score;
+        err = vmaf_score_at_index(vmaf, model, &score, i);
+        mu_assert("problem during vmaf_score_at_index", !err);
+        sum += score;
+        i_sum += 1. / (score + 1.);
+        min = score < min ? score : min;
+        max = score > max ? score : max;
+        cnt++;
+    }
+    mu_assert("scores should differ between pictures", min < max);
+    double skipped;
+    err = vmaf_score_at_index(vmaf, model, &skipped, 1);
+    mu_assert("skipped picture should not be scored", err);
+
+    double mean, pooled_min, harmonic_mean;
+    err = vmaf_score_pooled(vmaf, model, VMAF_POOL_METHOD_MEAN, &mean,
+                            0, pic_cnt);
+    err |= vmaf_score_pooled(vmaf, model, VMAF_POOL_METHOD_MIN, &pooled_min,
+                             0, pic_cnt);
+    err |= vmaf_score_pooled(vmaf, model, VMAF_POOL_METHOD_HARMONIC_MEAN,
+                             &harmonic_mean, 0, pic_cnt);
+    mu_assert("problem during vmaf_score_pooled", !err);
+    mu_assert("mean should be over scored pictures only",
+              fabs(mean - sum / cnt) < 1e-9);
+    mu_assert("min pooling should pick the minimum", pooled_min == min);
+    mu_assert("harmonic mean should be over scored pictures only",
+              fabs(harmonic_mean - (cnt / i_sum - 1.)) < 1e-9);
+
+    vmaf_model_destroy(model);
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+    return NULL;
+}
+
+static char *test_context_submit_error_releases()
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { .log_level = VMAF_LOG_LEVEL_NONE };
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+
+    /* without a scale filter, pictures of different sizes are rejected */
+    VmafPicture ref, dist;
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 176, 144);
+    err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 88, 72);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_submit_pictures(vmaf, &ref, &dist, 0, 0);
+    mu_assert("pictures of different sizes should be rejected",
+              err == -EINVAL);
+    mu_assert("rejected pictures should be released",
+              !ref.ref_cnt && !dist.ref_cnt);
 
-    vmaf_default_configuration(&cfg);
+    /* nor are pictures of different bit depths */
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 176, 144);
+    err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 10, 176, 144);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_submit_pictures(vmaf, &ref, &dist, 0, 0);
+    mu_assert("pictures of different bit depths should be rejected",
+              err == -EINVAL);
 
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+    return NULL;
+}
+
+static char *test_context_submit_in_flight()
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = {
+        .log_level = VMAF_LOG_LEVEL_NONE, .n_threads = 1, .max_in_flight = 1,
+    };
     err = vmaf_init(&vmaf, cfg);
     mu_assert("problem during vmaf_init", !err);
+
+    VmafModel *model;
+    VmafModelConfig model_cfg = { .path = "../../model/vmaf_v0.6.1.pkl" };
+    err = vmaf_model_load_from_path(&model, &model_cfg);
+    mu_assert("problem during vmaf_model_load_from_path", !err);
+    err = vmaf_use_features_from_model(vmaf, model);
+    mu_assert("problem during vmaf_use_features_from_model", !err);
+
+    const unsigned pic_cnt = 8;
+    unsigned again = 0;
+    for (unsigned i = 0; i < pic_cnt; i++) {
+        VmafPicture ref, dist;
+        err = alloc_pictures(&ref, &dist, i);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        err = vmaf_submit_pictures(vmaf, &ref, &dist, i, VMAF_SUBMIT_NONBLOCK);
+        if (err == -EAGAIN) {
+            /* the previous pair still holds the only slot */
+            mu_assert("pictures should be left to the caller",
+                      ref.ref_cnt && dist.ref_cnt);
+            again++;
+            err = vmaf_submit_pictures(vmaf, &ref, &dist, i, 0);
+        }
+        mu_assert("problem during vmaf_submit_pictures", !err);
+        if (i) {
+            mu_assert("at most one pair should be in flight",
+                      !vmaf_poll_pictures(vmaf, i - 1));
+        }
+    }
+    mu_assert("a full context should return -EAGAIN", again);
+
+    err = vmaf_wait_pictures(vmaf, pic_cnt - 1);
+    mu_assert("problem during vmaf_wait_pictures", !err);
+    mu_assert("waited pair should not be in flight",
+              !vmaf_poll_pictures(vmaf, pic_cnt - 1));
+    /* pairs never submitted are not in flight, so this returns at once */
+    err = vmaf_wait_pictures(vmaf, pic_cnt);
+    mu_assert("problem during vmaf_wait_pictures", !err);
+    mu_assert("unknown pair should not be in flight",
+              !vmaf_poll_pictures(vmaf, pic_cnt));
+
+    double score;
+    err = vmaf_score_pooled(vmaf, model, VMAF_POOL_METHOD_MEAN, &score,
+                            0, pic_cnt - 1);
+    mu_assert("problem during vmaf_score_pooled", !err);
+
+    vmaf_model_destroy(model);
     err = vmaf_close(vmaf);
     mu_assert("problem during vmaf_close", !err);
+    return NULL;
+}
 
+static char *test_context_merge_segment_overlap()
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { .log_level = VMAF_LOG_LEVEL_NONE };
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_use_feature(vmaf, "psnr");
+    mu_assert("problem during vmaf_use_feature", !err);
+
+    /* every picture has content outside of this area */
+    const VmafActiveArea area = { .x = 8, .y = 8, .w = 160, .h = 128 };
+    const unsigned pic_cnt = 6, split = 3;
+    for (unsigned s = 0; s < 2; s++) {
+        const unsigned low = s ? split : 0, high = s ? pic_cnt : split;
+        VmafContext *segment;
+        err = vmaf_init(&segment, cfg);
+        mu_assert("problem during vmaf_init", !err);
+        err = vmaf_use_feature(segment, "psnr");
+        mu_assert("problem during vmaf_use_feature", !err);
+        err = vmaf_set_segment(segment, low, high);
+        mu_assert("problem during vmaf_set_segment", !err);
+        err = vmaf_set_active_area(segment, area);
+        mu_assert("problem during vmaf_set_active_area", !err);
+
+        /* one picture of overlap on each side */
+        const unsigned from = low ? low - 1 : low;
+        const unsigned to = high < pic_cnt ? high + 1 : high;
+        for (unsigned i = from; i < to; i++) {
+            VmafPicture ref, dist;
+            err = alloc_pictures(&ref, &dist, i);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            err = vmaf_read_pictures(segment, &ref, &dist, i);
+            mu_assert("problem during vmaf_read_pictures", !err);
+        }
+        err = vmaf_merge_segment(vmaf, segment);
+        mu_assert("problem during vmaf_merge_segment", !err);
+        err = vmaf_close(segment);
+        mu_assert("problem during vmaf_close", !err);
+    }
+
+    VmafActiveArea merged;
+    unsigned exposed;
+    err = vmaf_get_active_area(vmaf, &merged, &exposed);
+    mu_assert("problem during vmaf_get_active_area", !err);
+    mu_assert("overlap pictures should be counted once",
+              exposed == pic_cnt);
+
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
     return NULL;
 }
 
 char *run_tests()
 {
     mu_run_test(test_context_init_and_close);
+    mu_run_test(test_context_pool_fixed_subsample);
+    mu_run_test(test_context_submit_error_releases);
+    mu_run_test(test_context_submit_in_flight);
+    mu_run_test(test_context_merge_segment_overlap);
     return NULL;
 }
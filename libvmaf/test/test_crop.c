@@ -0,0 +1,112 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "test.h"
+#include "crop.h"
+#include "libvmaf/libvmaf.rc.h"
+#include "libvmaf/picture.h"
+
+static void fill_luma(VmafPicture *pic, unsigned x, unsigned y, unsigned w,
+                      unsigned h, uint8_t value)
+{
+    for (unsigned i = y; i < y + h; i++)
+        memset((uint8_t *)pic->data[0] + i * pic->stride[0] + x, value, w);
+}
+
+static char *test_detect_active_area()
+{
+    int err;
+
+    VmafPicture pic;
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV420P, 8, 64, 48);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+
+    // letterbox with a dark, but not black, edge inside the active area
+    fill_luma(&pic, 0, 0, 64, 48, 16);
+    fill_luma(&pic, 0, 6, 64, 36, 128);
+    fill_luma(&pic, 0, 6, 64, 1, 40);
+    VmafActiveArea area = { 0 };
+    err = vmaf_detect_active_area(&pic, &area);
+    mu_assert("problem during vmaf_detect_active_area", !err);
+    mu_assert("letterbox is not detected",
+              area.x == 0 && area.y == 6 && area.w == 64 && area.h == 36);
+
+    // pillarbox at odd offsets is rounded outwards
+    fill_luma(&pic, 0, 0, 64, 48, 16);
+    fill_luma(&pic, 7, 0, 49, 48, 128);
+    area = (VmafActiveArea) { 0 };
+    err = vmaf_detect_active_area(&pic, &area);
+    mu_assert("problem during vmaf_detect_active_area", !err);
+    mu_assert("pillarbox is not detected",
+              area.x == 6 && area.y == 0 && area.w == 50 && area.h == 48);
+
+    // detection over several pictures keeps the union
+    fill_luma(&pic, 0, 0, 64, 48, 16);
+    fill_luma(&pic, 8, 4, 48, 40, 128);
+    err = vmaf_detect_active_area(&pic, &area);
+    mu_assert("problem during vmaf_detect_active_area", !err);
+    mu_assert("active area is not the union",
+              area.x == 6 && area.y == 0 && area.w == 50 && area.h == 48);
+
+    // a black picture tells nothing
+    fill_luma(&pic, 0, 0, 64, 48, 16);
+    err = vmaf_detect_active_area(&pic, &area);
+    mu_assert("problem during vmaf_detect_active_area", !err);
+    mu_assert("black picture should leave the area as it is",
+              area.x == 6 && area.y == 0 && area.w == 50 && area.h == 48);
+
+    err = vmaf_detect_active_area(&pic, NULL);
+    mu_assert("area should be required", err == -EINVAL);
+
+    vmaf_picture_unref(&pic);
+    return NULL;
+}
+
+static char *test_crop_exposed()
+{
+    int err;
+
+    VmafPicture pic;
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV420P, 8, 64, 48);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+
+    const VmafActiveArea area = { .x = 0, .y = 8, .w = 64, .h = 32 };
+    fill_luma(&pic, 0, 0, 64, 48, 16);
+    fill_luma(&pic, 0, 8, 64, 32, 128);
+    mu_assert("black bars should not be exposed",
+              !vmaf_crop_exposed(&pic, &area));
+
+    // a later scene filling the frame
+    fill_luma(&pic, 0, 0, 64, 48, 128);
+    mu_assert("content outside of the area should be exposed",
+              vmaf_crop_exposed(&pic, &area));
+
+    vmaf_picture_unref(&pic);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_detect_active_area);
+    mu_run_test(test_crop_exposed);
+    return NULL;
+}
@@ -16,12 +16,14 @@
  *
  */
 
+#include <math.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "feature/feature_extractor.h"
 #include "feature/feature_collector.h"
 #include "feature/common/cpu.h"
+#include "feature/picture_copy.h"
 #include "test.h"
 #include "picture.h"
 #include "libvmaf/picture.h"
@@ -71,10 +73,17 @@ static char *test_feature_extractor_context_pool()
     }
 
     for (unsigned i = 0; i < n_threads; i++) {
+        fex_ctx[i]->profile.cnt = i;
         err = vmaf_fex_ctx_pool_release(pool, fex_ctx[i]);
         mu_assert("problem during vmaf_fex_ctx_pool_release", !err);
     }
 
+    VmafProfileCounter profile = { 0 };
+    err = vmaf_fex_ctx_pool_profile(pool, fex, &profile);
+    mu_assert("problem during vmaf_fex_ctx_pool_profile", !err);
+    mu_assert("pool profile should sum all ssim contexts",
+              profile.cnt == n_threads * (n_threads - 1) / 2);
+
     err = vmaf_fex_ctx_pool_destroy(pool);
     mu_assert("problem during vmaf_fex_ctx_pool_destroy", !err);
 
@@ -116,6 +125,8 @@ static char *test_feature_extractor_flush()
     mu_assert("problem during vmaf_feature_extractor_context_flush", !err);
     err = vmaf_feature_extractor_context_flush(fex_ctx, vfc);
     mu_assert("problem during vmaf_feature_extractor_context_flush", !err);
+    mu_assert("extract calls should be profiled",
+              fex_ctx->profile.cnt == 2 && fex_ctx->profile.wall > 0);
     err = vmaf_feature_collector_get_score(vfc, "'VMAF_feature_motion2_score'",
                                            &score, 1);
     mu_assert("problem during vmaf_feature_collector_get_score", !err);
@@ -123,10 +134,264 @@ static char *test_feature_extractor_flush()
     return NULL;
 }
 
+/* texture 0 is flat, 1 is a faint checkerboard, 2 is textured */
+static void fill_picture(VmafPicture *pic, unsigned texture)
+{
+    for (unsigned i = 0; i < 3; i++) {
+        uint8_t *data = pic->data[i];
+        for (unsigned y = 0; y < pic->h[i]; y++) {
+            for (unsigned x = 0; x < pic->w[i]; x++) {
+                const unsigned v = texture > 1 ? x * x + 3 * y * i :
+                                   texture ? 128 + (x / 16 + y / 16) % 2 : 128;
+                data[y * pic->stride[i] + x] = v & 0xff;
+            }
+        }
+    }
+}
+
+static char *check_identical(VmafFeatureExtractor *fex, VmafPicture *pic)
+{
+    int err;
+
+    VmafFeatureExtractorContext *fex_ctx;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex);
+    mu_assert("problem during vmaf_feature_extractor_context_create", !err);
+    VmafFeatureCollector *extracted, *closed_form;
+    err = vmaf_feature_collector_init(&extracted);
+    err |= vmaf_feature_collector_init(&closed_form);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    err = vmaf_feature_extractor_context_extract(fex_ctx, pic, pic, 0,
+                                                 extracted);
+    mu_assert("problem during vmaf_feature_extractor_context_extract", !err);
+    err = vmaf_feature_extractor_context_extract_identical(fex_ctx, pic, 0,
+                                                           closed_form);
+    mu_assert("problem during "
+              "vmaf_feature_extractor_context_extract_identical", !err);
+
+    for (unsigned i = 0; fex->provided_features[i]; i++) {
+        char *feature_name = (char *) fex->provided_features[i];
+        double a, b;
+        err = vmaf_feature_collector_get_score(extracted, feature_name, &a, 0);
+        err |= vmaf_feature_collector_get_score(closed_form, feature_name,
+                                                &b, 0);
+        mu_assert("problem during vmaf_feature_collector_get_score", !err);
+        mu_assert("closed form should match extraction", a == b);
+    }
+
+    vmaf_feature_collector_destroy(extracted);
+    vmaf_feature_collector_destroy(closed_form);
+    vmaf_feature_extractor_context_close(fex_ctx);
+    vmaf_feature_extractor_context_destroy(fex_ctx);
+    return NULL;
+}
+
+static char *test_feature_extractor_identical()
+{
+    int err = 0;
+
+    const unsigned w = 176, h = 144;
+    VmafPicture pic;
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV420P, 8, w, h);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+
+    char *name[] = {
+        "ssim", "float_ssim", "psnr", "float_psnr", "float_adm", "float_vif",
+        "motion", "float_motion", "float_ms_ssim",
+    };
+    unsigned closed_form_cnt = 0;
+    for (unsigned texture = 0; texture < 3; texture++) {
+        fill_picture(&pic, texture);
+        for (unsigned i = 0; i < sizeof(name) / sizeof(name[0]); i++) {
+            VmafFeatureExtractor *fex =
+                vmaf_get_feature_extractor_by_name(name[i]);
+            mu_assert("problem during vmaf_get_feature_extractor_by_name",
+                      fex);
+            if (!fex->extract_identical) continue;
+            char *message = check_identical(fex, &pic);
+            if (message) return message;
+            closed_form_cnt++;
+        }
+    }
+    mu_assert("some feature extractors should have a closed form",
+              closed_form_cnt);
+
+    vmaf_picture_unref(&pic);
+    return NULL;
+}
+
+static char *test_picture_copy_shared()
+{
+    int err = 0;
+
+    VmafPicture pic_a, pic_b;
+    err = vmaf_picture_alloc(&pic_a, VMAF_PIX_FMT_YUV420P, 8, 1920, 1080);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_ref(&pic_b, &pic_a);
+    mu_assert("problem during vmaf_picture_ref", !err);
+
+    const float *a, *b, *c;
+    err = picture_copy_shared(&a, &pic_a, -128);
+    mu_assert("problem during picture_copy_shared", !err);
+    mu_assert("picture_copy_shared did not apply offset", a[0] == -128.);
+    err = picture_copy_shared(&b, &pic_b, -128);
+    mu_assert("problem during picture_copy_shared", !err);
+    mu_assert("picture references should share float plane", a == b);
+    err = picture_copy_shared(&c, &pic_b, 0);
+    mu_assert("problem during picture_copy_shared", !err);
+    mu_assert("float planes with different offsets should differ", a != c);
+
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_unref(&pic_b);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+static int extract_range(VmafPicture *pic, unsigned from, unsigned to,
+                         VmafFeatureCollector *vfc)
+{
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name("motion");
+    VmafFeatureExtractorContext *fex_ctx;
+    int err = vmaf_feature_extractor_context_create(&fex_ctx, fex);
+    if (err) return err;
+    for (unsigned i = from; i < to; i++) {
+        err = vmaf_feature_extractor_context_extract(fex_ctx, &pic[i], &pic[i],
+                                                     i, vfc);
+        if (err) return err;
+    }
+    err = vmaf_feature_extractor_context_flush(fex_ctx, vfc);
+    vmaf_feature_extractor_context_close(fex_ctx);
+    vmaf_feature_extractor_context_destroy(fex_ctx);
+    return err;
+}
+
+static char *test_feature_extractor_segments()
+{
+    int err = 0;
+
+    const unsigned pic_cnt = 7, w = 64, h = 64;
+    VmafPicture pic[pic_cnt];
+    for (unsigned i = 0; i < pic_cnt; i++) {
+        err = vmaf_picture_alloc(&pic[i], VMAF_PIX_FMT_YUV420P, 8, w, h);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        uint8_t *data = pic[i].data[0];
+        for (unsigned y = 0; y < h; y++) {
+            for (unsigned x = 0; x < w; x++)
+                data[y * pic[i].stride[0] + x] = (x * y + i * i * 13) & 0xff;
+        }
+    }
+
+    VmafFeatureCollector *serial, *merged, *segment;
+    err = vmaf_feature_collector_init(&serial);
+    err |= vmaf_feature_collector_init(&merged);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    err = extract_range(pic, 0, pic_cnt, serial);
+    mu_assert("problem during serial extraction", !err);
+
+    // segments [0, 3) and [3, 7), one picture of overlap on each side
+    const unsigned bound[] = { 0, 3, pic_cnt };
+    for (unsigned i = 0; i < 2; i++) {
+        const unsigned from = bound[i] ? bound[i] - 1 : 0;
+        const unsigned to = bound[i + 1] < pic_cnt ? bound[i + 1] + 1 : pic_cnt;
+        err = vmaf_feature_collector_init(&segment);
+        mu_assert("problem during vmaf_feature_collector_init", !err);
+        err = extract_range(pic, from, to, segment);
+        mu_assert("problem during segment extraction", !err);
+        err = vmaf_feature_collector_merge(merged, segment,
+                                           bound[i], bound[i + 1]);
+        mu_assert("problem during vmaf_feature_collector_merge", !err);
+        vmaf_feature_collector_destroy(segment);
+    }
+
+    for (unsigned i = 0; i < pic_cnt; i++) {
+        double a, b;
+        err = vmaf_feature_collector_get_score(serial,
+                "'VMAF_feature_motion2_integer_score'", &a, i);
+        err |= vmaf_feature_collector_get_score(merged,
+                "'VMAF_feature_motion2_integer_score'", &b, i);
+        mu_assert("problem during vmaf_feature_collector_get_score", !err);
+        mu_assert("merged segments should match serial extraction", a == b);
+    }
+
+    vmaf_feature_collector_destroy(serial);
+    vmaf_feature_collector_destroy(merged);
+    for (unsigned i = 0; i < pic_cnt; i++)
+        vmaf_picture_unref(&pic[i]);
+
+    return NULL;
+}
+
+static char *test_feature_extractor_window()
+{
+    int err = 0;
+
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name("motion");
+    mu_assert("motion should declare its window",
+              fex->window.past == 1 && fex->window.future == 1);
+
+    const unsigned pic_cnt = 10, w = 64, h = 64;
+    VmafPicture pic[pic_cnt];
+    for (unsigned i = 0; i < pic_cnt; i++) {
+        err = vmaf_picture_alloc(&pic[i], VMAF_PIX_FMT_YUV420P, 8, w, h);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        uint8_t *data = pic[i].data[0];
+        for (unsigned y = 0; y < h; y++) {
+            for (unsigned x = 0; x < w; x++)
+                data[y * pic[i].stride[0] + x] = (x * y + i * i * 13) & 0xff;
+        }
+    }
+
+    VmafFeatureCollector *serial, *sparse;
+    err = vmaf_feature_collector_init(&serial);
+    err |= vmaf_feature_collector_init(&sparse);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    err = extract_range(pic, 0, pic_cnt, serial);
+    mu_assert("problem during serial extraction", !err);
+
+    // every 4th picture, fed only the windows around it
+    VmafFeatureExtractorContext *fex_ctx;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex);
+    mu_assert("problem during vmaf_feature_extractor_context_create", !err);
+    for (unsigned i = 0; i < pic_cnt; i++) {
+        if (i % 4 == 2)
+            continue;
+        err = vmaf_feature_extractor_context_extract(fex_ctx, &pic[i], &pic[i],
+                                                     i, sparse);
+        mu_assert("problem during sparse extraction", !err);
+    }
+    err = vmaf_feature_extractor_context_flush(fex_ctx, sparse);
+    mu_assert("problem during vmaf_feature_extractor_context_flush", !err);
+    vmaf_feature_extractor_context_close(fex_ctx);
+    vmaf_feature_extractor_context_destroy(fex_ctx);
+
+    for (unsigned i = 0; i < pic_cnt; i += 4) {
+        double a, b;
+        err = vmaf_feature_collector_get_score(serial,
+                "'VMAF_feature_motion2_integer_score'", &a, i);
+        err |= vmaf_feature_collector_get_score(sparse,
+                "'VMAF_feature_motion2_integer_score'", &b, i);
+        mu_assert("problem during vmaf_feature_collector_get_score", !err);
+        mu_assert("sparse extraction should match serial extraction", a == b);
+    }
+
+    vmaf_feature_collector_destroy(serial);
+    vmaf_feature_collector_destroy(sparse);
+    for (unsigned i = 0; i < pic_cnt; i++)
+        vmaf_picture_unref(&pic[i]);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_get_feature_extractor_by_name_and_feature_name);
     mu_run_test(test_feature_extractor_context_pool);
     mu_run_test(test_feature_extractor_flush);
+    mu_run_test(test_feature_extractor_identical);
+    mu_run_test(test_picture_copy_shared);
+    mu_run_test(test_feature_extractor_segments);
+    mu_run_test(test_feature_extractor_window);
     return NULL;
 }
@@ -0,0 +1,117 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include "test.h"
+#include "feature_table.h"
+
+static char *test_feature_table_columns()
+{
+    int err;
+
+    FeatureTable *table;
+    err = feature_table_init(&table, FEATURE_COLUMNS_REQUIRED |
+                             FEATURE_COLUMN_BIT(FEATURE_SSIM), 0);
+    mu_assert("problem during feature_table_init", !err);
+    mu_assert("required column should be present",
+              feature_table_has(table, FEATURE_VIF));
+    mu_assert("requested optional column should be present",
+              feature_table_has(table, FEATURE_SSIM));
+    mu_assert("optional column should not be present",
+              !feature_table_has(table, FEATURE_PSNR) &&
+              !feature_table_has(table, FEATURE_MS_SSIM));
+    mu_assert("empty table should have no frames",
+              !feature_table_frame_cnt(table) &&
+              !feature_table_commit_cnt(table));
+
+    feature_table_free(table);
+    return NULL;
+}
+
+static char *test_feature_table_reserve_and_commit()
+{
+    int err;
+
+    FeatureTable *table;
+    err = feature_table_init(&table, FEATURE_COLUMNS_REQUIRED, 10);
+    mu_assert("problem during feature_table_init", !err);
+
+    /* spans several chunks, frames past the first ones are sparse */
+    const size_t frames[] = { 0, 1, 2, 1023, 1024, 5000 };
+    const size_t frame_cnt = sizeof(frames) / sizeof(frames[0]);
+    err = feature_table_reserve(table, frames[frame_cnt - 1] + 1);
+    mu_assert("problem during feature_table_reserve", !err);
+    err = feature_table_reserve(table, 1);
+    mu_assert("reserving fewer frames should be a no-op", !err);
+
+    for (size_t i = 0; i < frame_cnt; i++) {
+        mu_assert("reserved frame should start uncommitted",
+                  !feature_table_is_committed(table, frames[i]));
+        feature_table_set(table, FEATURE_MOTION, frames[i], i * .5);
+        feature_table_set(table, FEATURE_VIF, frames[i], -1. * i);
+    }
+    mu_assert("written frames should not count before commit",
+              !feature_table_frame_cnt(table) &&
+              !feature_table_commit_cnt(table));
+
+    for (size_t i = 0; i < frame_cnt; i++) {
+        feature_table_commit(table, frames[i]);
+        mu_assert("frame should be committed",
+                  feature_table_is_committed(table, frames[i]));
+    }
+    mu_assert("frame_cnt should be one past the highest committed frame",
+              feature_table_frame_cnt(table) == frames[frame_cnt - 1] + 1);
+    mu_assert("commit_cnt should count committed frames",
+              feature_table_commit_cnt(table) == frame_cnt);
+    mu_assert("frame in between should stay uncommitted",
+              !feature_table_is_committed(table, 3));
+
+    for (size_t i = 0; i < frame_cnt; i++) {
+        mu_assert("motion score does not match",
+                  feature_table_get(table, FEATURE_MOTION, frames[i]) ==
+                  i * .5);
+        mu_assert("vif score does not match",
+                  feature_table_get(table, FEATURE_VIF, frames[i]) == -1. * i);
+    }
+
+    feature_table_free(table);
+    return NULL;
+}
+
+static char *test_feature_table_reserve_limit()
+{
+    int err;
+
+    FeatureTable *table;
+    err = feature_table_init(&table, FEATURE_COLUMNS_REQUIRED, 0);
+    mu_assert("problem during feature_table_init", !err);
+    err = feature_table_reserve(table, (size_t) -1);
+    mu_assert("oversized reservation should fail", err);
+    mu_assert("failed reservation should not add frames",
+              !feature_table_frame_cnt(table));
+
+    feature_table_free(table);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_feature_table_columns);
+    mu_run_test(test_feature_table_reserve_and_commit);
+    mu_run_test(test_feature_table_reserve_limit);
+    return NULL;
+}
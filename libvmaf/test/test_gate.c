@@ -0,0 +1,187 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include "test.h"
+#include "gate.h"
+
+static double picture_score[256];
+
+/* gate.c only needs pooled scores from libvmaf.rc.c */
+int vmaf_score_pooled(VmafContext *vmaf, VmafModel *model,
+                      enum VmafPoolingMethod pool_method, double *score,
+                      unsigned index_low, unsigned index_high)
+{
+    (void) vmaf;
+    (void) model;
+    (void) pool_method;
+    double sum = 0.;
+    for (unsigned i = index_low; i < index_high; i++) {
+        if (isnan(picture_score[i]))
+            return -EINVAL;
+        sum += picture_score[i];
+    }
+    *score = sum / (index_high - index_low);
+    return 0;
+}
+
+static char *test_gate_next()
+{
+    int err;
+
+    VmafGate *gate;
+    err = vmaf_gate_init(&gate, (VmafGateConfiguration) {
+        .threshold = 90., .pic_cnt = 100, .stratum = 16,
+    });
+    mu_assert("problem during vmaf_gate_init", !err);
+
+    unsigned covered[100] = { 0 };
+    unsigned low, high, cnt = 0, first = 0;
+    while (!(err = vmaf_gate_next(gate, &low, &high))) {
+        mu_assert("stratum should not be empty", low < high);
+        if (!cnt++)
+            first = low;
+        for (unsigned i = low; i < high; i++)
+            covered[i]++;
+    }
+    mu_assert("vmaf_gate_next should return 1 when done", err == 1);
+    mu_assert("100 pictures should make 6 strata", cnt == 6);
+    for (unsigned i = 0; i < 100; i++)
+        mu_assert("every picture should be in one stratum", covered[i] == 1);
+    vmaf_gate_close(gate);
+
+    err = vmaf_gate_init(&gate, (VmafGateConfiguration) {
+        .threshold = 90., .pic_cnt = 100, .stratum = 16,
+    });
+    mu_assert("problem during vmaf_gate_init", !err);
+    err = vmaf_gate_next(gate, &low, &high);
+    mu_assert("order should be reproducible", !err && low == first);
+    vmaf_gate_close(gate);
+
+    err = vmaf_gate_init(&gate, (VmafGateConfiguration) { .threshold = 90. });
+    mu_assert("pic_cnt is required", err == -EINVAL);
+
+    return NULL;
+}
+
+static char *run_gate(double mean, double spread, double threshold,
+                      VmafGateStatus *status)
+{
+    int err;
+
+    VmafGate *gate;
+    err = vmaf_gate_init(&gate, (VmafGateConfiguration) {
+        .threshold = threshold, .pic_cnt = 256, .stratum = 4,
+    });
+    mu_assert("problem during vmaf_gate_init", !err);
+
+    for (unsigned i = 0; i < 256; i++)
+        picture_score[i] = NAN;
+
+    unsigned low, high;
+    while (!vmaf_gate_next(gate, &low, &high)) {
+        for (unsigned i = low; i < high; i++)
+            picture_score[i] = mean + spread * ((int) (i * 37 % 17) - 8) / 8.;
+        err = vmaf_gate_check(gate, (VmafContext *) gate, NULL, status);
+        mu_assert("problem during vmaf_gate_check", !err);
+        if (status->decision)
+            break;
+    }
+
+    vmaf_gate_close(gate);
+    return NULL;
+}
+
+static char *test_gate_decide()
+{
+    char *msg;
+    VmafGateStatus status;
+
+    msg = run_gate(95., 2., 90., &status);
+    if (msg) return msg;
+    mu_assert("clear pass should be decided", status.decision ==
+              VMAF_GATE_PASS);
+    mu_assert("clear pass should be decided early",
+              status.scored < status.strata);
+    mu_assert("interval should hold the threshold off",
+              status.ci_low >= 90. && status.ci_low <= status.score);
+
+    msg = run_gate(80., 2., 90., &status);
+    if (msg) return msg;
+    mu_assert("clear fail should be decided", status.decision ==
+              VMAF_GATE_FAIL);
+    mu_assert("clear fail should be decided early",
+              status.scored < status.strata);
+
+    // borderline, only decided by the exact mean of all strata
+    msg = run_gate(90.01, 5., 90., &status);
+    if (msg) return msg;
+    mu_assert("borderline should need every stratum",
+              status.scored == status.strata);
+    mu_assert("exact score should decide the borderline",
+              status.decision == (status.score >= 90. ? VMAF_GATE_PASS :
+                                                        VMAF_GATE_FAIL));
+    mu_assert("interval should collapse once complete",
+              status.ci_low == status.score && status.ci_high == status.score);
+
+    return NULL;
+}
+
+static char *test_gate_partial()
+{
+    int err;
+
+    VmafGate *gate;
+    err = vmaf_gate_init(&gate, (VmafGateConfiguration) {
+        .threshold = 90., .pic_cnt = 64, .stratum = 8,
+    });
+    mu_assert("problem during vmaf_gate_init", !err);
+
+    for (unsigned i = 0; i < 64; i++)
+        picture_score[i] = 95.;
+    unsigned low, high;
+    err = vmaf_gate_next(gate, &low, &high);
+    mu_assert("problem during vmaf_gate_next", !err);
+    picture_score[low] = NAN;
+
+    VmafGateStatus status;
+    err = vmaf_gate_check(gate, (VmafContext *) gate, NULL, &status);
+    mu_assert("problem during vmaf_gate_check", !err);
+    mu_assert("incomplete stratum should be left out", !status.scored);
+    mu_assert("nothing scored should be undecided", !status.decision);
+
+    picture_score[low] = 95.;
+    err = vmaf_gate_check(gate, (VmafContext *) gate, NULL, &status);
+    mu_assert("problem during vmaf_gate_check", !err);
+    mu_assert("completed stratum should be counted", status.scored == 1);
+    mu_assert("score should be the stratum mean", status.score == 95.);
+
+    vmaf_gate_close(gate);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_gate_next);
+    mu_run_test(test_gate_decide);
+    mu_run_test(test_gate_partial);
+    return NULL;
+}
@@ -123,11 +123,51 @@ static char *test_model_set_flags()
     return NULL;
 }
 
+static char *test_model_preview_flags()
+{
+    int err;
+
+    VmafModel *model;
+    VmafModelConfig cfg = {
+        .path = "../../model/vmaf_v0.6.1.pkl",
+    };
+    err = vmaf_model_load_from_path(&model, &cfg);
+    mu_assert("problem during vmaf_model_load_from_path", !err);
+    const double slope = model->feature[0].slope;
+    const double intercept = model->feature[0].intercept;
+    double error;
+    err = vmaf_model_preview_error(model, &error);
+    mu_assert("full resolution model should not have a preview error",
+              err == -EINVAL);
+    vmaf_model_destroy(model);
+
+    VmafModelConfig cfg_preview = {
+        .path = "../../model/vmaf_v0.6.1.pkl",
+        .flags = VMAF_MODEL_FLAG_PREVIEW_2X,
+    };
+    err = vmaf_model_load_from_path(&model, &cfg_preview);
+    mu_assert("problem during vmaf_model_load_from_path", !err);
+    mu_assert("Model should be a 2x preview model.\n", model->preview == 2);
+    mu_assert("Model name should mark preview.\n",
+              strstr(model->name, "_preview_2x"));
+    const VmafPreviewCorrection *c = vmaf_preview_correction("adm2", 2);
+    mu_assert("adm2 correction should be composed into normalization.\n",
+              model->feature[0].slope == slope * c->slope &&
+              model->feature[0].intercept == intercept + slope * c->intercept);
+    err = vmaf_model_preview_error(model, &error);
+    mu_assert("problem during vmaf_model_preview_error", !err);
+    mu_assert("preview error should be calibrated", error > 0.);
+    vmaf_model_destroy(model);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_model_load_and_destroy);
     mu_run_test(test_model_check_default_behavior_unset_flags);
     mu_run_test(test_model_check_default_behavior_set_flags);
     mu_run_test(test_model_set_flags);
+    mu_run_test(test_model_preview_flags);
     return NULL;
 }
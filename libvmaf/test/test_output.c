@@ -0,0 +1,187 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "feature/feature_collector.h"
+#include "output.h"
+
+/* output.c only needs the version string from libvmaf.rc.c */
+const char *vmaf_version(void)
+{
+    return "test";
+}
+
+static uint32_t read_u32(const uint8_t *b)
+{
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static double read_f64(const uint8_t *b)
+{
+    uint64_t u = 0;
+    for (unsigned i = 0; i < 8; i++)
+        u |= (uint64_t)b[i] << (8 * i);
+    double v;
+    memcpy(&v, &u, sizeof(v));
+    return v;
+}
+
+static char *test_write_output_csv()
+{
+    int err;
+
+    VmafFeatureCollector *fc;
+    err = vmaf_feature_collector_init(&fc);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    for (unsigned i = 0; i < 5; i++)
+        err |= vmaf_feature_collector_append(fc, "feature_a", i * 0.5, i);
+    err |= vmaf_feature_collector_append(fc, "feature_b", 9., 3);
+    mu_assert("problem during vmaf_feature_collector_append", !err);
+
+    FILE *f = tmpfile();
+    mu_assert("problem during tmpfile", f);
+    const VmafOutputSampling sampling = { .subsample = 2 };
+    err = vmaf_write_output_csv(fc, f, &sampling);
+    mu_assert("problem during vmaf_write_output_csv", !err);
+    rewind(f);
+
+    char buf[256];
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    buf[len] = '\0';
+    mu_assert("subsampled csv does not match",
+              !strcmp(buf, "Frame,feature_a,feature_b,\n"
+                           "0,0.000000,\n"
+                           "2,1.000000,\n"
+                           "4,2.000000,\n"));
+
+    fclose(f);
+    vmaf_feature_collector_destroy(fc);
+    return NULL;
+}
+
+static char *test_write_output_csv_adaptive()
+{
+    int err;
+
+    VmafFeatureCollector *fc;
+    err = vmaf_feature_collector_init(&fc);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    for (unsigned i = 0; i < 5; i++)
+        err |= vmaf_feature_collector_append(fc, "feature_a", i * 0.5, i);
+    mu_assert("problem during vmaf_feature_collector_append", !err);
+
+    const uint8_t skipped[] = { 0, 1, 1, 0 };
+    const VmafOutputSampling sampling = {
+        .subsample = 4,
+        .skipped = skipped,
+        .cnt = 4,
+    };
+
+    FILE *f = tmpfile();
+    mu_assert("problem during tmpfile", f);
+    err = vmaf_write_output_csv(fc, f, &sampling);
+    mu_assert("problem during vmaf_write_output_csv", !err);
+    rewind(f);
+
+    char buf[256];
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    buf[len] = '\0';
+    mu_assert("adaptively subsampled csv does not match",
+              !strcmp(buf, "Frame,feature_a,\n"
+                           "0,0.000000,\n"
+                           "3,1.500000,\n"
+                           "4,2.000000,\n"));
+
+    fclose(f);
+    vmaf_feature_collector_destroy(fc);
+    return NULL;
+}
+
+static char *test_write_output_bin()
+{
+    int err;
+
+    VmafFeatureCollector *fc;
+    err = vmaf_feature_collector_init(&fc);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    for (unsigned i = 0; i < 4; i++) {
+        err |= vmaf_feature_collector_append(fc, "feature_a", i * 1.5, i);
+        if (i % 2)
+            err |= vmaf_feature_collector_append(fc, "feature_b", -1. / i, i);
+    }
+    mu_assert("problem during vmaf_feature_collector_append", !err);
+
+    FILE *f = tmpfile();
+    mu_assert("problem during tmpfile", f);
+    const VmafOutputSampling sampling = { .subsample = 1 };
+    err = vmaf_write_output_bin(fc, f, &sampling, 1920, 1080);
+    mu_assert("problem during vmaf_write_output_bin", !err);
+    rewind(f);
+
+    uint8_t buf[256];
+    const size_t len = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+
+    const size_t expected_len =
+        8 + 6 * 4 + 4 * 4 + 2 * (4 + strlen("feature_a") + 4 * 8);
+    mu_assert("binary output has the wrong size", len == expected_len);
+    mu_assert("binary output has the wrong magic",
+              !memcmp(buf, VMAF_OUTPUT_BIN_MAGIC, 8));
+    mu_assert("binary output has the wrong header",
+              read_u32(buf + 8) == VMAF_OUTPUT_BIN_VERSION &&
+              read_u32(buf + 12) == 1920 && read_u32(buf + 16) == 1080 &&
+              read_u32(buf + 20) == 1 && read_u32(buf + 24) == 4 &&
+              read_u32(buf + 28) == 2);
+
+    const uint8_t *p = buf + 32;
+    for (unsigned i = 0; i < 4; i++, p += 4)
+        mu_assert("frame numbers do not match", read_u32(p) == i);
+
+    mu_assert("column name does not match",
+              read_u32(p) == 9 && !memcmp(p + 4, "feature_a", 9));
+    p += 4 + 9;
+    for (unsigned i = 0; i < 4; i++, p += 8)
+        mu_assert("column score does not match", read_f64(p) == i * 1.5);
+
+    mu_assert("column name does not match",
+              read_u32(p) == 9 && !memcmp(p + 4, "feature_b", 9));
+    p += 4 + 9;
+    for (unsigned i = 0; i < 4; i++, p += 8) {
+        if (i % 2)
+            mu_assert("column score does not match", read_f64(p) == -1. / i);
+        else
+            mu_assert("unwritten score should be NaN", isnan(read_f64(p)));
+    }
+
+    vmaf_feature_collector_destroy(fc);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_write_output_csv);
+    mu_run_test(test_write_output_csv_adaptive);
+    mu_run_test(test_write_output_bin);
+    return NULL;
+}
@@ -0,0 +1,197 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdio.h>
+
+#include "test.h"
+#include "feature/feature_collector.h"
+#include "partial.h"
+
+static char *test_partial_write_and_read()
+{
+    int err;
+
+    VmafFeatureCollector *fc_a, *fc_b, *fc;
+    err = vmaf_feature_collector_init(&fc_a);
+    err |= vmaf_feature_collector_init(&fc_b);
+    err |= vmaf_feature_collector_init(&fc);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    for (unsigned i = 0; i < 10; i++) {
+        VmafFeatureCollector *dst = i < 4 ? fc_a : fc_b;
+        err |= vmaf_feature_collector_append(dst, "feature_a", i * 1.5, i);
+        if (i % 2)
+            err |= vmaf_feature_collector_append(dst, "feature_b", -1. / i, i);
+    }
+    mu_assert("problem during vmaf_feature_collector_append", !err);
+
+    FILE *f = tmpfile();
+    mu_assert("problem during tmpfile", f);
+    VmafPartialInfo info_a = {
+        .w = 1920, .h = 1080, .pix_fmt = VMAF_PIX_FMT_YUV420P, .bpc = 8,
+        .pic_cnt = 4, .index_low = 0, .index_high = 4,
+    };
+    err = vmaf_partial_write(fc_a, &info_a, f);
+    mu_assert("problem during vmaf_partial_write", !err);
+    VmafPartialInfo info_b = {
+        .w = 1920, .h = 1080, .pix_fmt = VMAF_PIX_FMT_YUV420P, .bpc = 8,
+        .pic_cnt = 6, .index_low = 4, .index_high = 0,
+    };
+    err = vmaf_partial_write(fc_b, &info_b, f);
+    mu_assert("problem during vmaf_partial_write", !err);
+    mu_assert("index_high should default to the last written score",
+              info_b.index_high == 10);
+    rewind(f);
+
+    VmafPartialInfo info;
+    err = vmaf_partial_read(fc, &info, f);
+    mu_assert("problem during vmaf_partial_read", !err);
+    mu_assert("partial info was not preserved",
+              info.w == 1920 && info.h == 1080 && info.bpc == 8 &&
+              info.pix_fmt == VMAF_PIX_FMT_YUV420P && info.pic_cnt == 4 &&
+              info.index_low == 0 && info.index_high == 4);
+    err = vmaf_partial_read(fc, &info, f);
+    mu_assert("problem during vmaf_partial_read", !err);
+    mu_assert("partial range was not preserved",
+              info.index_low == 4 && info.index_high == 10);
+    err = vmaf_partial_read(fc, &info, f);
+    mu_assert("vmaf_partial_read should return 1 at the end", err == 1);
+    fclose(f);
+
+    for (unsigned i = 0; i < 10; i++) {
+        double score;
+        err = vmaf_feature_collector_get_score(fc, "feature_a", &score, i);
+        mu_assert("merged score does not match", !err && score == i * 1.5);
+        err = vmaf_feature_collector_get_score(fc, "feature_b", &score, i);
+        mu_assert("unwritten score should stay unwritten", !(i % 2) == !!err);
+        if (i % 2)
+            mu_assert("merged score does not match", score == -1. / i);
+    }
+
+    vmaf_feature_collector_destroy(fc_a);
+    vmaf_feature_collector_destroy(fc_b);
+    vmaf_feature_collector_destroy(fc);
+    return NULL;
+}
+
+static char *test_partial_read_bad_version()
+{
+    int err;
+
+    FILE *f = tmpfile();
+    mu_assert("problem during tmpfile", f);
+    fwrite(VMAF_PARTIAL_MAGIC, 8, 1, f);
+    const unsigned char version[4] = { VMAF_PARTIAL_VERSION + 1, 0, 0, 0 };
+    fwrite(version, sizeof(version), 1, f);
+    for (unsigned i = 0; i < 8 * 4; i++)
+        fputc(0, f);
+    rewind(f);
+
+    VmafFeatureCollector *fc;
+    err = vmaf_feature_collector_init(&fc);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    VmafPartialInfo info;
+    err = vmaf_partial_read(fc, &info, f);
+    mu_assert("unknown partial version should be rejected", err == -EINVAL);
+
+    fclose(f);
+    vmaf_feature_collector_destroy(fc);
+    return NULL;
+}
+
+static char *test_partial_read_is_atomic()
+{
+    int err;
+
+    VmafFeatureCollector *src, *fc;
+    err = vmaf_feature_collector_init(&src);
+    err |= vmaf_feature_collector_init(&fc);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    for (unsigned i = 0; i < 4; i++) {
+        err |= vmaf_feature_collector_append(src, "feature_a", i, i);
+        err |= vmaf_feature_collector_append(src, "feature_b", -1. * i, i);
+    }
+    mu_assert("problem during vmaf_feature_collector_append", !err);
+
+    FILE *f = tmpfile();
+    mu_assert("problem during tmpfile", f);
+    VmafPartialInfo info = { .index_low = 0, .index_high = 4 };
+    err = vmaf_partial_write(src, &info, f);
+    mu_assert("problem during vmaf_partial_write", !err);
+    const long size = ftell(f);
+
+    FILE *truncated = tmpfile();
+    mu_assert("problem during tmpfile", truncated);
+    rewind(f);
+    for (long i = 0; i < size - 8; i++)
+        fputc(fgetc(f), truncated);
+    rewind(truncated);
+    err = vmaf_partial_read(fc, &info, truncated);
+    mu_assert("truncated partial should be rejected", err == -EINVAL);
+    mu_assert("truncated partial should not append any score", !fc->cnt);
+    fclose(truncated);
+
+    err = vmaf_feature_collector_append(fc, "feature_b", 1., 3);
+    mu_assert("problem during vmaf_feature_collector_append", !err);
+    rewind(f);
+    err = vmaf_partial_read(fc, &info, f);
+    mu_assert("overlapping partial should be rejected", err == -EINVAL);
+    double score;
+    err = vmaf_feature_collector_get_score(fc, "feature_a", &score, 0);
+    mu_assert("overlapping partial should not append any score", err);
+    err = vmaf_feature_collector_get_score(fc, "feature_b", &score, 3);
+    mu_assert("overlapping partial should not overwrite a score",
+              !err && score == 1.);
+    fclose(f);
+
+    vmaf_feature_collector_destroy(src);
+    vmaf_feature_collector_destroy(fc);
+    return NULL;
+}
+
+static char *test_partial_read_header_bounds_range()
+{
+    int err;
+
+    FILE *f = tmpfile();
+    mu_assert("problem during tmpfile", f);
+    fwrite(VMAF_PARTIAL_MAGIC, 8, 1, f);
+    const unsigned char header[9][4] = {
+        { VMAF_PARTIAL_VERSION }, { 0 }, { 0 }, { 0 }, { 0 }, { 0 },
+        { 0 }, { 0xff, 0xff, 0xff, 0xff }, { 1 },
+    };
+    fwrite(header, sizeof(header), 1, f);
+    rewind(f);
+
+    VmafPartialInfo info;
+    err = vmaf_partial_read_header(&info, f);
+    mu_assert("oversized partial range should be rejected", err == -EINVAL);
+
+    fclose(f);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_partial_write_and_read);
+    mu_run_test(test_partial_read_bad_version);
+    mu_run_test(test_partial_read_is_atomic);
+    mu_run_test(test_partial_read_header_bounds_range);
+    return NULL;
+}
@@ -16,7 +16,9 @@
  *
  */
 
+#include <errno.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "test.h"
 #include "picture.h"
@@ -64,9 +66,249 @@ static char *test_picture_data_alignment()
     return NULL;
 }
 
+static char *test_picture_equal()
+{
+    int err;
+
+    VmafPicture pic_a, pic_b;
+    err = vmaf_picture_alloc(&pic_a, VMAF_PIX_FMT_YUV420P, 8, 33, 17);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_alloc(&pic_b, VMAF_PIX_FMT_YUV420P, 8, 33, 17);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+
+    for (unsigned i = 0; i < 3; i++) {
+        // stride padding differs, pixels are the same
+        memset(pic_a.data[i], 0x10, pic_a.stride[i] * pic_a.h[i]);
+        memset(pic_b.data[i], 0x20, pic_b.stride[i] * pic_b.h[i]);
+        for (unsigned j = 0; j < pic_a.h[i]; j++) {
+            uint8_t *a = (uint8_t *) pic_a.data[i] + j * pic_a.stride[i];
+            uint8_t *b = (uint8_t *) pic_b.data[i] + j * pic_b.stride[i];
+            for (unsigned k = 0; k < pic_a.w[i]; k++)
+                a[k] = b[k] = j * k + i;
+        }
+    }
+    mu_assert("pictures with equal pixels should be equal",
+              vmaf_picture_equal(&pic_a, &pic_b));
+
+    ((uint8_t *) pic_b.data[2])[pic_b.stride[2] * (pic_b.h[2] - 1)] ^= 1;
+    mu_assert("pictures with a different pixel should differ",
+              !vmaf_picture_equal(&pic_a, &pic_b));
+
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_unref(&pic_b);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+static unsigned sum_cnt, square_cnt;
+
+static size_t sum_size(VmafPicture *pic)
+{
+    (void) pic;
+    return sizeof(unsigned);
+}
+
+static int sum_compute(VmafPicture *pic, void *data)
+{
+    unsigned *sum = data;
+    *sum = 0;
+    for (unsigned i = 0; i < pic->w[0]; i++)
+        *sum += ((uint8_t *) pic->data[0])[i];
+    sum_cnt++;
+    return 0;
+}
+
+static const VmafPictureIntermediate sum = {
+    .name = "sum",
+    .size = sum_size,
+    .compute = sum_compute,
+};
+
+static int square_compute(VmafPicture *pic, void *data)
+{
+    const void *s;
+    int err = vmaf_picture_intermediate(pic, &sum, &s);
+    if (err) return err;
+    *((unsigned *) data) = *((const unsigned *) s) * *((const unsigned *) s);
+    square_cnt++;
+    return 0;
+}
+
+static const VmafPictureIntermediate square = {
+    .name = "square",
+    .size = sum_size,
+    .compute = square_compute,
+};
+
+static char *test_picture_intermediate()
+{
+    int err;
+
+    VmafPicture pic_a, pic_b;
+    err = vmaf_picture_alloc(&pic_a, VMAF_PIX_FMT_YUV420P, 8, 4, 2);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    memset(pic_a.data[0], 3, pic_a.w[0]);
+    err = vmaf_picture_ref(&pic_b, &pic_a);
+    mu_assert("problem during vmaf_picture_ref", !err);
+
+    const void *data;
+    err = vmaf_picture_intermediate(&pic_a, &square, &data);
+    mu_assert("problem during vmaf_picture_intermediate", !err);
+    mu_assert("dependent intermediate has the wrong value",
+              *((const unsigned *) data) == 144);
+    err = vmaf_picture_intermediate(&pic_b, &sum, &data);
+    mu_assert("problem during vmaf_picture_intermediate", !err);
+    mu_assert("intermediate has the wrong value",
+              *((const unsigned *) data) == 12);
+    err = vmaf_picture_intermediate(&pic_b, &square, &data);
+    mu_assert("problem during vmaf_picture_intermediate", !err);
+    mu_assert("intermediates should be computed once per picture",
+              sum_cnt == 1 && square_cnt == 1);
+
+    memset(pic_a.data[0], 1, pic_a.w[0]);
+    vmaf_picture_intermediate_reset(&pic_a);
+    err = vmaf_picture_intermediate(&pic_b, &square, &data);
+    mu_assert("problem during vmaf_picture_intermediate", !err);
+    mu_assert("stale intermediates should be computed again",
+              *((const unsigned *) data) == 16 && sum_cnt == 2);
+
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_unref(&pic_b);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+static char *test_picture_alloc_planes()
+{
+    int err;
+    VmafPicture pic_a, pic_b;
+
+    err = vmaf_picture_alloc_planes(&pic_a, VMAF_PIX_FMT_YUV420P, 10, 16, 8,
+                                    VMAF_PLANE_U);
+    mu_assert("luma should be required", err == -EINVAL);
+
+    err = vmaf_picture_alloc_planes(&pic_a, VMAF_PIX_FMT_YUV420P, 10, 16, 8,
+                                    VMAF_PLANE_Y);
+    mu_assert("problem during vmaf_picture_alloc_planes", !err);
+    mu_assert("chroma should not be allocated",
+              !pic_a.data[1] && !pic_a.data[2] && !pic_a.stride[1]);
+    mu_assert("chroma should keep its dimensions",
+              pic_a.w[1] == 8 && pic_a.h[1] == 4);
+    mu_assert("planes should be luma only",
+              vmaf_picture_planes(&pic_a) == VMAF_PLANE_Y);
+
+    err = vmaf_picture_alloc(&pic_b, VMAF_PIX_FMT_YUV420P, 10, 16, 8);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    mu_assert("planes should be all planes",
+              vmaf_picture_planes(&pic_b) == VMAF_PLANES_ALL);
+    mu_assert("pictures with different planes should not be equal",
+              !vmaf_picture_equal(&pic_a, &pic_b));
+
+    vmaf_picture_unref(&pic_a);
+    vmaf_picture_unref(&pic_b);
+    return NULL;
+}
+
+static char *test_picture_view()
+{
+    int err;
+    VmafPicture pic, view;
+
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV420P, 8, 16, 8);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    for (unsigned i = 0; i < 3; i++) {
+        for (unsigned y = 0; y < pic.h[i]; y++) {
+            uint8_t *row = (uint8_t *) pic.data[i] + y * pic.stride[i];
+            for (unsigned x = 0; x < pic.w[i]; x++)
+                row[x] = y * 16 + x;
+        }
+    }
+
+    err = vmaf_picture_view(&view, &pic, 3, 2, 8, 4);
+    mu_assert("odd offsets should not be viewed with subsampled chroma",
+              err == -EINVAL);
+    err = vmaf_picture_view(&view, &pic, 10, 2, 8, 4);
+    mu_assert("views should not exceed the picture", err == -EINVAL);
+
+    err = vmaf_picture_view(&view, &pic, 4, 2, 8, 4);
+    mu_assert("problem during vmaf_picture_view", !err);
+    mu_assert("view has the wrong dimensions",
+              view.w[0] == 8 && view.h[0] == 4 &&
+              view.w[1] == 4 && view.h[1] == 2);
+    mu_assert("view should share the stride", view.stride[0] == pic.stride[0]);
+    mu_assert("luma view is at the wrong offset",
+              ((uint8_t *) view.data[0])[0] == 2 * 16 + 4);
+    mu_assert("chroma view is at the wrong offset",
+              ((uint8_t *) view.data[1])[view.stride[1]] == 2 * 16 + 2);
+
+    // the view keeps the picture alive
+    err = vmaf_picture_unref(&pic);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    mu_assert("view should still see the picture",
+              ((uint8_t *) view.data[0])[1] == 2 * 16 + 5);
+    err = vmaf_picture_unref(&view);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+static char *test_picture_semiplanar()
+{
+    int err;
+    VmafPicture pic, copy, view;
+
+    err = vmaf_picture_alloc_planes(&pic, VMAF_PIX_FMT_NV12, 8, 16, 8,
+                                    VMAF_PLANE_Y | VMAF_PLANE_U);
+    mu_assert("interleaved chroma should be all or nothing", err == -EINVAL);
+
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_NV12, 8, 16, 8);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    mu_assert("chroma should count the samples of one component",
+              pic.w[1] == 8 && pic.h[1] == 4 && pic.w[2] == 8);
+    mu_assert("v should be interleaved with u",
+              (uint8_t *) pic.data[2] == (uint8_t *) pic.data[1] + 1 &&
+              pic.stride[2] == pic.stride[1]);
+    for (unsigned y = 0; y < pic.h[1]; y++) {
+        uint8_t *row = (uint8_t *) pic.data[1] + y * pic.stride[1];
+        for (unsigned x = 0; x < 2 * pic.w[1]; x++)
+            row[x] = y * 16 + x;
+    }
+
+    err = vmaf_picture_alloc(&copy, VMAF_PIX_FMT_NV12, 8, 16, 8);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    memset(copy.data[0], 0, copy.stride[0] * copy.h[0]);
+    memset(pic.data[0], 0, pic.stride[0] * pic.h[0]);
+    memcpy(copy.data[1], pic.data[1], pic.stride[1] * pic.h[1]);
+    mu_assert("copies should be equal", vmaf_picture_equal(&pic, &copy));
+    ((uint8_t *) copy.data[2])[2 * 7] ^= 1;
+    mu_assert("the last v sample should be compared",
+              !vmaf_picture_equal(&pic, &copy));
+    vmaf_picture_unref(&copy);
+
+    err = vmaf_picture_view(&view, &pic, 4, 2, 8, 4);
+    mu_assert("problem during vmaf_picture_view", !err);
+    mu_assert("u view is at the wrong offset",
+              ((uint8_t *) view.data[1])[0] == 1 * 16 + 4);
+    mu_assert("v view is at the wrong offset",
+              ((uint8_t *) view.data[2])[0] == 1 * 16 + 5);
+    vmaf_picture_unref(&view);
+    vmaf_picture_unref(&pic);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_picture_alloc_ref_and_unref);
     mu_run_test(test_picture_data_alignment);
+    mu_run_test(test_picture_equal);
+    mu_run_test(test_picture_intermediate);
+    mu_run_test(test_picture_alloc_planes);
+    mu_run_test(test_picture_view);
+    mu_run_test(test_picture_semiplanar);
     return NULL;
 }
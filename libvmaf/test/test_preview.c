@@ -0,0 +1,141 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "test.h"
+#include "preview.h"
+#include "libvmaf/picture.h"
+
+static char *test_preview_decimate()
+{
+    int err;
+
+    VmafPicture src, dst;
+    err = vmaf_picture_alloc(&src, VMAF_PIX_FMT_YUV444P, 8, 8, 4);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned i = 0; i < src.h[p]; i++) {
+            uint8_t *row = (uint8_t *)src.data[p] + i * src.stride[p];
+            for (unsigned j = 0; j < src.w[p]; j++)
+                row[j] = 16 * i + j + p;
+        }
+    }
+
+    err = vmaf_picture_alloc(&dst, VMAF_PIX_FMT_YUV444P, 8, 4, 2);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_preview_decimate(&dst, &src, 2);
+    mu_assert("problem during vmaf_preview_decimate", !err);
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned i = 0; i < dst.h[p]; i++) {
+            uint8_t *row = (uint8_t *)dst.data[p] + i * dst.stride[p];
+            for (unsigned j = 0; j < dst.w[p]; j++) {
+                // mean of 16 * (2i, 2i + 1) + (2j, 2j + 1) + p, rounded
+                mu_assert("decimated pixel is not the 2x2 block mean",
+                          row[j] == 32 * i + 8 + 2 * j + 1 + p);
+            }
+        }
+    }
+
+    err = vmaf_preview_decimate(&dst, &src, 3);
+    mu_assert("decimation factor should be 2", err == -EINVAL);
+
+    vmaf_picture_unref(&dst);
+    err = vmaf_picture_alloc(&dst, VMAF_PIX_FMT_YUV444P, 8, 2, 1);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_preview_decimate(&dst, &src, 2);
+    mu_assert("decimated dimensions should be checked", err == -EINVAL);
+    err = vmaf_preview_decimate(&dst, &src, 4);
+    mu_assert("decimation factor 4 is not calibrated", err == -EINVAL);
+
+    vmaf_picture_unref(&dst);
+    vmaf_picture_unref(&src);
+
+    return NULL;
+}
+
+static char *test_preview_decimate_hbd()
+{
+    int err;
+
+    VmafPicture src, dst;
+    err = vmaf_picture_alloc(&src, VMAF_PIX_FMT_YUV420P, 10, 4, 4);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned i = 0; i < src.h[p]; i++) {
+            uint16_t *row = (uint16_t *)
+                ((uint8_t *)src.data[p] + i * src.stride[p]);
+            for (unsigned j = 0; j < src.w[p]; j++)
+                row[j] = 1023 - (i + j) % 2;
+        }
+    }
+
+    err = vmaf_picture_alloc(&dst, VMAF_PIX_FMT_YUV420P, 10, 2, 2);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_preview_decimate(&dst, &src, 2);
+    mu_assert("problem during vmaf_preview_decimate", !err);
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned i = 0; i < dst.h[p]; i++) {
+            uint16_t *row = (uint16_t *)
+                ((uint8_t *)dst.data[p] + i * dst.stride[p]);
+            for (unsigned j = 0; j < dst.w[p]; j++) {
+                mu_assert("decimated pixel is not the 2x2 block mean",
+                          row[j] == 1023);
+            }
+        }
+    }
+
+    vmaf_picture_unref(&dst);
+    vmaf_picture_unref(&src);
+
+    return NULL;
+}
+
+static char *test_preview_correction()
+{
+    mu_assert("2 should be a valid preview factor",
+              vmaf_preview_factor_valid(2));
+    mu_assert("3 and 4 should not be valid preview factors",
+              !vmaf_preview_factor_valid(3) && !vmaf_preview_factor_valid(4));
+
+    const VmafPreviewCorrection *c = vmaf_preview_correction("adm2", 2);
+    mu_assert("adm2 should have a correction", c);
+    mu_assert("correction should be for adm2",
+              !strcmp(c->feature_name, "adm2"));
+    mu_assert("factor 4 should not have corrections",
+              !vmaf_preview_correction("adm2", 4));
+    mu_assert("psnr_y should not have a correction",
+              !vmaf_preview_correction("psnr_y", 2));
+    mu_assert("factor 3 should not have corrections",
+              !vmaf_preview_correction("adm2", 3));
+
+    mu_assert("expected error should be calibrated",
+              vmaf_preview_expected_error(2) > 0.);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_preview_decimate);
+    mu_run_test(test_preview_decimate_hbd);
+    mu_run_test(test_preview_correction);
+    return NULL;
+}
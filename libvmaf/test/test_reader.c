@@ -0,0 +1,288 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "libvmaf/reader.h"
+
+#define W 33
+#define H 17
+
+static unsigned sample(unsigned frame, unsigned plane, unsigned x, unsigned y)
+{
+    return (frame * 31 + plane * 7 + x * 3 + y * 5) & 0xff;
+}
+
+static void write_frames(FILE *f, unsigned bpc, unsigned frame_cnt, int y4m)
+{
+    const unsigned cw = (W + 1) / 2, ch = (H + 1) / 2;
+    for (unsigned n = 0; n < frame_cnt; n++) {
+        if (y4m) fputs("FRAME\n", f);
+        for (unsigned p = 0; p < 3; p++) {
+            for (unsigned y = 0; y < (p ? ch : H); y++) {
+                for (unsigned x = 0; x < (p ? cw : W); x++) {
+                    const unsigned v = sample(n, p, x, y) << (bpc - 8);
+                    fputc(v & 0xff, f);
+                    if (bpc > 8) fputc(v >> 8, f);
+                }
+            }
+        }
+    }
+}
+
+static int check_picture(VmafPicture *pic, unsigned frame)
+{
+    for (unsigned p = 0; p < 3; p++) {
+        if (!pic->data[p])
+            continue;
+        for (unsigned y = 0; y < pic->h[p]; y++) {
+            for (unsigned x = 0; x < pic->w[p]; x++) {
+                const uint8_t *row =
+                    (uint8_t*)pic->data[p] + y * pic->stride[p];
+                const unsigned v = pic->bpc > 8 ?
+                    ((const uint16_t*)row)[x] : row[x];
+                if (v != sample(frame, p, x, y) << (pic->bpc - 8))
+                    return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static char *test_reader_y4m()
+{
+    int err;
+    char path[] = "/tmp/test_reader_XXXXXX";
+    int fd = mkstemp(path);
+    mu_assert("problem creating temporary file", fd >= 0);
+    FILE *f = fdopen(fd, "wb");
+    fprintf(f, "YUV4MPEG2 W%d H%d F30:1 Ip A1:1 C420jpeg XYSCSS=420JPEG\n",
+            W, H);
+    write_frames(f, 8, 3, 1);
+    fclose(f);
+
+    VmafReader *reader;
+    err = vmaf_reader_open_y4m(&reader, path);
+    mu_assert("problem during vmaf_reader_open_y4m", !err);
+    VmafReaderInfo info;
+    err = vmaf_reader_get_info(reader, &info);
+    mu_assert("problem during vmaf_reader_get_info", !err);
+    mu_assert("wrong stream info",
+              info.w == W && info.h == H && info.bpc == 8 &&
+              info.pix_fmt == VMAF_PIX_FMT_YUV420P && info.frame_cnt == 3);
+
+    VmafPicture pic;
+    err = vmaf_reader_read_picture(reader, &pic, 2);
+    mu_assert("problem reading frame 2", !err);
+    mu_assert("frame 2 has wrong samples", check_picture(&pic, 2));
+    void *data = pic.data[0];
+    vmaf_picture_unref(&pic);
+
+    err = vmaf_reader_read_picture(reader, &pic, 0);
+    mu_assert("problem reading frame 0", !err);
+    mu_assert("frame 0 has wrong samples", check_picture(&pic, 0));
+    mu_assert("released picture was not recycled", pic.data[0] == data);
+
+    VmafPicture pic2;
+    err = vmaf_reader_read_picture(reader, &pic2, 1);
+    mu_assert("problem reading frame 1", !err);
+    mu_assert("frame 1 has wrong samples", check_picture(&pic2, 1));
+    mu_assert("pictures in use must not be shared", pic2.data[0] != data);
+
+    err = vmaf_reader_read_picture(reader, &pic2, 3);
+    mu_assert("reading past the last frame should return 1", err == 1);
+
+    err = vmaf_reader_close(reader);
+    mu_assert("problem during vmaf_reader_close", !err);
+    mu_assert("picture should outlive the reader", check_picture(&pic, 0));
+    vmaf_picture_unref(&pic);
+    unlink(path);
+
+    return NULL;
+}
+
+static char *test_reader_yuv()
+{
+    int err;
+    char path[] = "/tmp/test_reader_XXXXXX";
+    int fd = mkstemp(path);
+    mu_assert("problem creating temporary file", fd >= 0);
+    FILE *f = fdopen(fd, "wb");
+    write_frames(f, 10, 2, 0);
+    fclose(f);
+
+    VmafReader *reader;
+    err = vmaf_reader_open_yuv(&reader, path, VMAF_PIX_FMT_YUV420P, 10, W, H);
+    mu_assert("problem during vmaf_reader_open_yuv", !err);
+
+    VmafPicture pic;
+    for (unsigned i = 0; i < 2; i++) {
+        err = vmaf_reader_read_picture(reader, &pic, i);
+        mu_assert("problem during vmaf_reader_read_picture", !err);
+        mu_assert("10-bit frame has wrong samples", check_picture(&pic, i));
+        vmaf_picture_unref(&pic);
+    }
+    err = vmaf_reader_read_picture(reader, &pic, 2);
+    mu_assert("reading past the last frame should return 1", err == 1);
+
+    vmaf_reader_close(reader);
+    unlink(path);
+
+    return NULL;
+}
+
+static char *test_reader_p010()
+{
+    int err;
+    char path[] = "/tmp/test_reader_XXXXXX";
+    int fd = mkstemp(path);
+    mu_assert("problem creating temporary file", fd >= 0);
+    FILE *f = fdopen(fd, "wb");
+    // luma, then one plane of interleaved uv pairs, msb-aligned
+    const unsigned w = W - 1, h = H - 1;
+    for (unsigned p = 0; p < 2; p++) {
+        for (unsigned y = 0; y < (p ? h / 2 : h); y++) {
+            for (unsigned x = 0; x < w; x++) {
+                const unsigned v =
+                    sample(0, p ? 1 + (x & 1) : 0, p ? x / 2 : x, y) << 8;
+                fputc(v & 0xff, f);
+                fputc(v >> 8, f);
+            }
+        }
+    }
+    fclose(f);
+
+    VmafReader *reader;
+    err = vmaf_reader_open_yuv(&reader, path, VMAF_PIX_FMT_P010, 10, W, H);
+    mu_assert("odd dimensions should not be read as p010", err == -EINVAL);
+    err = vmaf_reader_open_yuv(&reader, path, VMAF_PIX_FMT_P010, 10, w, h);
+    mu_assert("problem during vmaf_reader_open_yuv", !err);
+    VmafReaderInfo info;
+    vmaf_reader_get_info(reader, &info);
+    mu_assert("p010 file should hold one frame", info.frame_cnt == 1);
+
+    VmafPicture pic;
+    err = vmaf_reader_read_picture(reader, &pic, 0);
+    mu_assert("problem during vmaf_reader_read_picture", !err);
+    int ok = 1;
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned y = 0; y < pic.h[p]; y++) {
+            const uint16_t *row = (const uint16_t *)
+                ((uint8_t *) pic.data[p] + y * pic.stride[p]);
+            for (unsigned x = 0; x < pic.w[p]; x++)
+                ok &= row[x * (p ? 2 : 1)] == sample(0, p, x, y) << 8;
+        }
+    }
+    mu_assert("p010 frame has wrong samples", ok);
+    vmaf_picture_unref(&pic);
+
+    vmaf_reader_close(reader);
+    unlink(path);
+
+    return NULL;
+}
+
+static char *test_reader_planes()
+{
+    int err;
+    char path[] = "/tmp/test_reader_XXXXXX";
+    int fd = mkstemp(path);
+    mu_assert("problem creating temporary file", fd >= 0);
+    FILE *f = fdopen(fd, "wb");
+    fprintf(f, "YUV4MPEG2 W%d H%d C420jpeg\n", W, H);
+    write_frames(f, 8, 3, 1);
+    fclose(f);
+
+    VmafReader *reader;
+    err = vmaf_reader_open_y4m(&reader, path);
+    mu_assert("problem during vmaf_reader_open_y4m", !err);
+    err = vmaf_reader_set_planes(reader, VMAF_PLANE_U);
+    mu_assert("luma should be required", err == -EINVAL);
+    err = vmaf_reader_set_planes(reader, VMAF_PLANE_Y);
+    mu_assert("problem during vmaf_reader_set_planes", !err);
+
+    VmafPicture pic;
+    err = vmaf_reader_read_picture(reader, &pic, 2);
+    mu_assert("problem reading frame 2", !err);
+    mu_assert("chroma should not be allocated",
+              !pic.data[1] && !pic.data[2] && pic.w[1] == W / 2);
+    mu_assert("frame 2 has wrong luma", check_picture(&pic, 2));
+    vmaf_picture_unref(&pic);
+    vmaf_reader_close(reader);
+
+    // a pipe has to read past chroma to reach the next frame header
+    int fds[2];
+    mu_assert("problem creating pipe", !pipe(fds));
+    f = fopen(path, "rb");
+    char buf[4096];
+    const size_t n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    mu_assert("problem writing pipe", write(fds[1], buf, n) == (ssize_t)n);
+    close(fds[1]);
+    char pipe_path[64];
+    snprintf(pipe_path, sizeof(pipe_path), "/dev/fd/%d", fds[0]);
+
+    err = vmaf_reader_open_y4m(&reader, pipe_path);
+    mu_assert("problem during vmaf_reader_open_y4m", !err);
+    err = vmaf_reader_set_planes(reader, VMAF_PLANE_Y);
+    mu_assert("problem during vmaf_reader_set_planes", !err);
+    for (unsigned i = 0; i < 3; i++) {
+        err = vmaf_reader_read_picture(reader, &pic, i);
+        mu_assert("problem reading from pipe", !err);
+        mu_assert("piped frame has wrong luma", check_picture(&pic, i));
+        vmaf_picture_unref(&pic);
+    }
+    vmaf_reader_close(reader);
+    close(fds[0]);
+    unlink(path);
+
+    return NULL;
+}
+
+static char *test_reader_y4m_unsupported()
+{
+    char path[] = "/tmp/test_reader_XXXXXX";
+    int fd = mkstemp(path);
+    mu_assert("problem creating temporary file", fd >= 0);
+    FILE *f = fdopen(fd, "wb");
+    fprintf(f, "YUV4MPEG2 W%d H%d Cmono\n", W, H);
+    fclose(f);
+
+    VmafReader *reader;
+    int err = vmaf_reader_open_y4m(&reader, path);
+    mu_assert("unsupported colorspace should fail", err == -EINVAL);
+    unlink(path);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_reader_y4m);
+    mu_run_test(test_reader_yuv);
+    mu_run_test(test_reader_p010);
+    mu_run_test(test_reader_planes);
+    mu_run_test(test_reader_y4m_unsupported);
+    return NULL;
+}
@@ -0,0 +1,179 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "feature/feature_extractor.h"
+#include "feature/feature_collector.h"
+#include "feature/common/cpu.h"
+#include "test.h"
+#include "picture.h"
+#include "ref_cache.h"
+#include "libvmaf/picture.h"
+
+enum vmaf_cpu cpu;
+// ^ FIXME, this is a global in the old libvmaf
+// A few wrapped floating point feature extractors rely on it being a global
+// After we clean those up, We'll add this to the VmafContext
+
+#define PIC_CNT 8
+
+static int picture_fill(VmafPicture *pic, unsigned seed)
+{
+    const unsigned w = 64, h = 48;
+    int err = vmaf_picture_alloc(pic, VMAF_PIX_FMT_YUV420P, 8, w, h);
+    if (err) return err;
+    uint8_t *data = pic->data[0];
+    for (unsigned y = 0; y < h; y++) {
+        for (unsigned x = 0; x < w; x++)
+            data[y * pic->stride[0] + x] = (x * y + seed * seed * 13) & 0xff;
+    }
+    return 0;
+}
+
+/* extract float_motion, through the reference cache if path is set */
+static int extract(VmafPicture *pic, const char *path,
+                   VmafFeatureCollector *vfc, unsigned *extract_cnt)
+{
+    VmafFeatureExtractor *fex =
+        vmaf_get_feature_extractor_by_name("float_motion");
+    VmafFeatureExtractorContext *fex_ctx;
+    int err = vmaf_feature_extractor_context_create(&fex_ctx, fex);
+    if (err) return err;
+
+    VmafRefCache *cache = NULL;
+    if (path) {
+        err = vmaf_ref_cache_open(&cache, path);
+        if (err) return err;
+        err = vmaf_ref_cache_attach(cache, fex_ctx);
+        if (err) return err;
+    }
+
+    for (unsigned i = 0; i < PIC_CNT; i++) {
+        err = cache ?
+            vmaf_ref_cache_extract(cache, &pic[i], &pic[i], i, vfc) :
+            vmaf_feature_extractor_context_extract(fex_ctx, &pic[i], &pic[i],
+                                                   i, vfc);
+        if (err) return err;
+    }
+    err = cache ? vmaf_ref_cache_flush(cache, vfc) :
+                  vmaf_feature_extractor_context_flush(fex_ctx, vfc);
+    if (err) return err;
+
+    *extract_cnt = fex_ctx->profile.cnt;
+    if (cache) {
+        err = vmaf_ref_cache_close(cache);
+        if (err) return err;
+    }
+    vmaf_feature_extractor_context_close(fex_ctx);
+    vmaf_feature_extractor_context_destroy(fex_ctx);
+    return 0;
+}
+
+static int scores_match(VmafFeatureCollector *a, VmafFeatureCollector *b)
+{
+    for (unsigned i = 0; i < PIC_CNT; i++) {
+        double score_a, score_b;
+        int err =
+            vmaf_feature_collector_get_score(a, "'VMAF_feature_motion2_score'",
+                                             &score_a, i);
+        err |=
+            vmaf_feature_collector_get_score(b, "'VMAF_feature_motion2_score'",
+                                             &score_b, i);
+        if (err || score_a != score_b)
+            return 0;
+    }
+    return 1;
+}
+
+static char *test_ref_cache()
+{
+    int err = 0;
+    unsigned extract_cnt;
+
+    cpu = cpu_autodetect(); //FIXME, see above
+
+    char path[] = "/tmp/vmaf_ref_cache_XXXXXX";
+    int fd = mkstemp(path);
+    mu_assert("problem during mkstemp", fd >= 0);
+    close(fd);
+
+    VmafPicture pic[PIC_CNT];
+    for (unsigned i = 0; i < PIC_CNT; i++) {
+        err = picture_fill(&pic[i], i);
+        mu_assert("problem during picture_fill", !err);
+    }
+
+    VmafFeatureCollector *serial, *miss, *hit;
+    err = vmaf_feature_collector_init(&serial);
+    err |= vmaf_feature_collector_init(&miss);
+    err |= vmaf_feature_collector_init(&hit);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    err = extract(pic, NULL, serial, &extract_cnt);
+    mu_assert("problem during uncached extraction", !err);
+    err = extract(pic, path, miss, &extract_cnt);
+    mu_assert("problem during cached extraction", !err);
+    mu_assert("empty cache should run every extraction",
+              extract_cnt == PIC_CNT);
+    mu_assert("cache misses should match uncached extraction",
+              scores_match(serial, miss));
+    err = extract(pic, path, hit, &extract_cnt);
+    mu_assert("problem during cached extraction", !err);
+    mu_assert("warm cache should skip every extraction", !extract_cnt);
+    mu_assert("cache hits should match uncached extraction",
+              scores_match(serial, hit));
+
+    vmaf_feature_collector_destroy(serial);
+    vmaf_feature_collector_destroy(miss);
+    vmaf_feature_collector_destroy(hit);
+
+    // a changed reference picture invalidates its window only
+    vmaf_picture_unref(&pic[5]);
+    err = picture_fill(&pic[5], 42);
+    mu_assert("problem during picture_fill", !err);
+
+    err = vmaf_feature_collector_init(&serial);
+    err |= vmaf_feature_collector_init(&hit);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    err = extract(pic, NULL, serial, &extract_cnt);
+    mu_assert("problem during uncached extraction", !err);
+    err = extract(pic, path, hit, &extract_cnt);
+    mu_assert("problem during cached extraction", !err);
+    mu_assert("changed pictures should be extracted",
+              extract_cnt > 0 && extract_cnt < PIC_CNT);
+    mu_assert("partial hits should match uncached extraction",
+              scores_match(serial, hit));
+
+    vmaf_feature_collector_destroy(serial);
+    vmaf_feature_collector_destroy(hit);
+    for (unsigned i = 0; i < PIC_CNT; i++)
+        vmaf_picture_unref(&pic[i]);
+    remove(path);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_ref_cache);
+    return NULL;
+}
@@ -0,0 +1,213 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "feature/common/cpu.h"
+#include "test.h"
+#include "picture.h"
+#include "scale.h"
+#include "libvmaf/picture.h"
+
+enum vmaf_cpu cpu;
+
+static unsigned sample_at(VmafPicture *pic, unsigned p, unsigned x,
+                          unsigned y)
+{
+    const uint8_t *row = (uint8_t *) pic->data[p] + y * pic->stride[p];
+    const unsigned step = vmaf_picture_step(pic, p);
+    return pic->bpc > 8 ? ((const uint16_t *) row)[x * step] : row[x * step];
+}
+
+static void fill(VmafPicture *pic, unsigned seed, int flat)
+{
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned y = 0; y < pic->h[p]; y++) {
+            uint8_t *row = (uint8_t *) pic->data[p] + y * pic->stride[p];
+            const unsigned step = vmaf_picture_step(pic, p);
+            for (unsigned x = 0; x < pic->w[p]; x++) {
+                seed = seed * 1103515245 + 12345;
+                const unsigned v = flat ? 100 + p : (seed >> 16) & 0xff;
+                if (pic->bpc > 8)
+                    ((uint16_t *) row)[x * step] =
+                        (v << (pic->bpc - 8)) << vmaf_picture_shift(pic);
+                else
+                    row[x * step] = v;
+            }
+        }
+    }
+}
+
+static int pictures_equal(VmafPicture *a, VmafPicture *b)
+{
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned y = 0; y < a->h[p]; y++) {
+            for (unsigned x = 0; x < a->w[p]; x++) {
+                if (sample_at(a, p, x, y) != sample_at(b, p, x, y))
+                    return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static char *test_scale_init()
+{
+    VmafScaler *s;
+    int err = vmaf_scaler_init(&s, VMAF_SCALE_FILTER_NONE,
+                               VMAF_PIX_FMT_YUV420P, 16, 8, 32, 16);
+    mu_assert("a filter should be required", err == -EINVAL);
+    err = vmaf_scaler_init(&s, VMAF_SCALE_FILTER_BICUBIC,
+                           VMAF_PIX_FMT_YUV420P, 16, 1, 32, 16);
+    mu_assert("chroma should not be empty", err == -EINVAL);
+
+    err = vmaf_scaler_init(&s, VMAF_SCALE_FILTER_BICUBIC,
+                           VMAF_PIX_FMT_YUV420P, 16, 8, 32, 16);
+    mu_assert("problem during vmaf_scaler_init", !err);
+    VmafPicture src, dst;
+    err = vmaf_picture_alloc(&src, VMAF_PIX_FMT_YUV420P, 8, 16, 8);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_alloc(&dst, VMAF_PIX_FMT_YUV420P, 8, 30, 16);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_scaler_scale(s, &dst, &src);
+    mu_assert("dimensions should be checked", err == -EINVAL);
+
+    vmaf_picture_unref(&src);
+    vmaf_picture_unref(&dst);
+    vmaf_scaler_close(s);
+    return NULL;
+}
+
+static char *test_scale_flat()
+{
+    const enum VmafScaleFilter filter[] = {
+        VMAF_SCALE_FILTER_BICUBIC, VMAF_SCALE_FILTER_LANCZOS,
+    };
+    // up- and downscaling, the taps sum up to 1
+    const unsigned size[][4] = { { 24, 14, 64, 36 }, { 64, 36, 24, 14 } };
+
+    for (unsigned f = 0; f < 2; f++) {
+        for (unsigned i = 0; i < 2; i++) {
+            VmafScaler *s;
+            VmafPicture src, dst;
+            int err = vmaf_scaler_init(&s, filter[f], VMAF_PIX_FMT_YUV420P,
+                                       size[i][0], size[i][1],
+                                       size[i][2], size[i][3]);
+            mu_assert("problem during vmaf_scaler_init", !err);
+            err = vmaf_picture_alloc(&src, VMAF_PIX_FMT_YUV420P, 10,
+                                     size[i][0], size[i][1]);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            err = vmaf_picture_alloc(&dst, VMAF_PIX_FMT_YUV420P, 10,
+                                     size[i][2], size[i][3]);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            fill(&src, 0, 1);
+            err = vmaf_scaler_scale(s, &dst, &src);
+            mu_assert("problem during vmaf_scaler_scale", !err);
+
+            int flat = 1;
+            for (unsigned p = 0; p < 3; p++) {
+                for (unsigned y = 0; y < dst.h[p]; y++) {
+                    for (unsigned x = 0; x < dst.w[p]; x++)
+                        flat &= sample_at(&dst, p, x, y) == (100 + p) << 2;
+                }
+            }
+            mu_assert("flat pictures should stay flat", flat);
+
+            vmaf_picture_unref(&src);
+            vmaf_picture_unref(&dst);
+            vmaf_scaler_close(s);
+        }
+    }
+    return NULL;
+}
+
+static char *test_scale_identity()
+{
+    // at the same size the source samples are hit exactly
+    const enum VmafPixelFormat pix_fmt[] = {
+        VMAF_PIX_FMT_YUV444P, VMAF_PIX_FMT_NV12, VMAF_PIX_FMT_P010,
+    };
+    const unsigned bpc[] = { 8, 8, 10 };
+
+    for (unsigned i = 0; i < 3; i++) {
+        VmafScaler *s;
+        VmafPicture src, dst;
+        int err = vmaf_scaler_init(&s, VMAF_SCALE_FILTER_LANCZOS, pix_fmt[i],
+                                   20, 12, 20, 12);
+        mu_assert("problem during vmaf_scaler_init", !err);
+        err = vmaf_picture_alloc(&src, pix_fmt[i], bpc[i], 20, 12);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        err = vmaf_picture_alloc(&dst, pix_fmt[i], bpc[i], 20, 12);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        fill(&src, i, 0);
+        err = vmaf_scaler_scale(s, &dst, &src);
+        mu_assert("problem during vmaf_scaler_scale", !err);
+        mu_assert("scaling to the same size should not change samples",
+                  pictures_equal(&src, &dst));
+
+        vmaf_picture_unref(&src);
+        vmaf_picture_unref(&dst);
+        vmaf_scaler_close(s);
+    }
+    return NULL;
+}
+
+static char *test_scale_avx()
+{
+    const enum vmaf_cpu detected = cpu_autodetect();
+    if (detected < VMAF_CPU_AVX)
+        return NULL;
+
+    VmafScaler *s;
+    VmafPicture src, ref, dst;
+    int err = vmaf_scaler_init(&s, VMAF_SCALE_FILTER_BICUBIC,
+                               VMAF_PIX_FMT_YUV420P, 38, 22, 75, 42);
+    mu_assert("problem during vmaf_scaler_init", !err);
+    err = vmaf_picture_alloc(&src, VMAF_PIX_FMT_YUV420P, 10, 38, 22);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 10, 75, 42);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_alloc(&dst, VMAF_PIX_FMT_YUV420P, 10, 75, 42);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    fill(&src, 7, 0);
+
+    cpu = VMAF_CPU_NONE;
+    err = vmaf_scaler_scale(s, &ref, &src);
+    mu_assert("problem during vmaf_scaler_scale", !err);
+    cpu = detected;
+    err = vmaf_scaler_scale(s, &dst, &src);
+    mu_assert("problem during vmaf_scaler_scale", !err);
+    mu_assert("avx and c should scale alike", pictures_equal(&ref, &dst));
+
+    vmaf_picture_unref(&src);
+    vmaf_picture_unref(&ref);
+    vmaf_picture_unref(&dst);
+    vmaf_scaler_close(s);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_scale_init);
+    mu_run_test(test_scale_flat);
+    mu_run_test(test_scale_identity);
+    mu_run_test(test_scale_avx);
+    return NULL;
+}
@@ -0,0 +1,182 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "test.h"
+#include "subsample.h"
+#include "libvmaf/picture.h"
+
+static int select_flat(VmafSubsampler *s, VmafPicture *pic, uint8_t value,
+                       unsigned index, bool *scored, bool *cut)
+{
+    for (unsigned i = 0; i < pic->h[0]; i++)
+        memset((uint8_t *)pic->data[0] + i * pic->stride[0], value, pic->w[0]);
+    return vmaf_subsampler_select(s, pic, pic, index, scored, cut);
+}
+
+static char *test_subsample_select()
+{
+    int err;
+    bool scored, cut;
+
+    VmafPicture pic;
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+
+    VmafSubsampler *s;
+    err = vmaf_subsampler_init(&s, 8);
+    mu_assert("problem during vmaf_subsampler_init", !err);
+
+    // static, every 8th picture is scored
+    unsigned static_cnt = 0;
+    for (unsigned i = 0; i < 16; i++) {
+        err = select_flat(s, &pic, 100, i, &scored, &cut);
+        mu_assert("problem during vmaf_subsampler_select", !err);
+        mu_assert("static content is not a scene cut", !cut);
+        mu_assert("first picture should be scored", i || scored);
+        static_cnt += scored;
+    }
+    mu_assert("static content should be scored every 8th picture",
+              static_cnt == 2);
+    mu_assert("unselected picture should be skipped",
+              vmaf_subsampler_skipped(s, 1));
+
+    // scene cut
+    err = select_flat(s, &pic, 200, 16, &scored, &cut);
+    mu_assert("problem during vmaf_subsampler_select", !err);
+    mu_assert("scene cut should be detected and scored", cut && scored);
+
+    // slow motion, scored more often
+    unsigned motion_cnt = 0;
+    for (unsigned i = 17; i < 33; i++) {
+        err = select_flat(s, &pic, 200 - 4 * (i - 16), i, &scored, &cut);
+        mu_assert("problem during vmaf_subsampler_select", !err);
+        mu_assert("slow motion is not a scene cut", !cut);
+        motion_cnt += scored;
+    }
+    mu_assert("motion should be scored more often than static content",
+              motion_cnt > 2 * static_cnt);
+
+    vmaf_subsampler_unskip(s, 1);
+    mu_assert("picture should be scored after vmaf_subsampler_unskip",
+              !vmaf_subsampler_skipped(s, 1));
+    mu_assert("unread picture should not be skipped",
+              !vmaf_subsampler_skipped(s, 1000));
+
+    unsigned cnt;
+    const uint8_t *skipped = vmaf_subsampler_skip_map(s, &cnt);
+    mu_assert("skip map should cover all pictures read", cnt >= 33);
+    unsigned skipped_cnt = 0;
+    for (unsigned i = 0; i < cnt; i++)
+        skipped_cnt += !!skipped[i];
+    mu_assert("skip map does not match the selection",
+              skipped_cnt == 33 - static_cnt - motion_cnt - 2);
+
+    vmaf_subsampler_close(s);
+    vmaf_picture_unref(&pic);
+    return NULL;
+}
+
+static char *test_subsample_distortion()
+{
+    int err;
+    bool scored, cut;
+
+    VmafPicture ref, dist;
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    for (unsigned i = 0; i < ref.h[0]; i++)
+        memset((uint8_t *)ref.data[0] + i * ref.stride[0], 100, ref.w[0]);
+
+    VmafSubsampler *s;
+    err = vmaf_subsampler_init(&s, 8);
+    mu_assert("problem during vmaf_subsampler_init", !err);
+
+    // static reference, distorted by noise on every other picture
+    unsigned cnt = 0;
+    for (unsigned n = 0; n < 16; n++) {
+        for (unsigned i = 0; i < dist.h[0]; i++) {
+            uint8_t *row = (uint8_t *)dist.data[0] + i * dist.stride[0];
+            for (unsigned j = 0; j < dist.w[0]; j++)
+                row[j] = 100 + ((n % 2) && (j % 2) ? 8 : 0);
+        }
+        err = vmaf_subsampler_select(s, &ref, &dist, n, &scored, &cut);
+        mu_assert("problem during vmaf_subsampler_select", !err);
+        mu_assert("a change of distortion is not a scene cut", !cut);
+        cnt += scored;
+    }
+    mu_assert("changing distortion should be scored more often", cnt > 4);
+
+    vmaf_subsampler_close(s);
+    vmaf_picture_unref(&dist);
+    vmaf_picture_unref(&ref);
+    return NULL;
+}
+
+static char *test_subsample_merge()
+{
+    int err;
+    bool scored, cut;
+
+    VmafPicture pic;
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+
+    VmafSubsampler *s, *segment;
+    err = vmaf_subsampler_init(&s, 4);
+    err |= vmaf_subsampler_init(&segment, 4);
+    mu_assert("problem during vmaf_subsampler_init", !err);
+
+    for (unsigned i = 8; i < 16; i++) {
+        err = select_flat(segment, &pic, 50, i, &scored, &cut);
+        mu_assert("problem during vmaf_subsampler_select", !err);
+    }
+    err = vmaf_subsampler_merge(s, segment, 8, 16);
+    mu_assert("problem during vmaf_subsampler_merge", !err);
+    for (unsigned i = 8; i < 16; i++) {
+        mu_assert("merged selection does not match the segment",
+                  vmaf_subsampler_skipped(s, i) ==
+                  vmaf_subsampler_skipped(segment, i));
+    }
+    mu_assert("segment should start with a scored picture",
+              !vmaf_subsampler_skipped(s, 8));
+    mu_assert("merged segment should skip static pictures",
+              vmaf_subsampler_skipped(s, 9));
+
+    err = vmaf_subsampler_init(NULL, 4);
+    mu_assert("vmaf_subsampler_init should check its arguments",
+              err == -EINVAL);
+
+    vmaf_subsampler_close(segment);
+    vmaf_subsampler_close(s);
+    vmaf_picture_unref(&pic);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_subsample_select);
+    mu_run_test(test_subsample_distortion);
+    mu_run_test(test_subsample_merge);
+    return NULL;
+}
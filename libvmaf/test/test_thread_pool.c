@@ -70,6 +70,8 @@ static char *test_thread_pool_create_enqueue_wait_and_destroy()
     mu_assert("problem during vmaf_thread_pool_enqueue with data", !err);
     err = vmaf_thread_pool_wait(pool);
     mu_assert("problem during vmaf_thread_pool_wait", !err);
+    mu_assert("queue should be empty after vmaf_thread_pool_wait",
+              !vmaf_thread_pool_queue_depth(pool));
     err = vmaf_thread_pool_destroy(pool);
     mu_assert("problem during vmaf_thread_pool_destroy", !err);
 
@@ -9,7 +9,7 @@
 
 #include <libvmaf/libvmaf.rc.h>
 
-static const char short_opts[] = "r:d:w:h:p:b:m:o:xjet:f:i:s:c:nv";
+static const char short_opts[] = "r:d:w:h:p:b:m:o:xjeBPt:f:i:s:c:q:S:R:T:C:V:g:z:D:F:aLnv";
 
 static const struct option long_opts[] = {
     { "reference",        1, NULL, 'r' },
@@ -23,11 +23,25 @@ static const struct option long_opts[] = {
     { "xml",              0, NULL, 'x' },
     { "json",             0, NULL, 'j' },
     { "csv",              0, NULL, 'e' },
+    { "bin",              0, NULL, 'B' },
+    { "partial",          0, NULL, 'P' },
     { "threads",          1, NULL, 't' },
     { "feature",          1, NULL, 'f' },
     { "import",           1, NULL, 'i' },
     { "subsample",        1, NULL, 's' },
+    { "adaptive",         0, NULL, 'a' },
     { "cpumask",          1, NULL, 'c' },
+    { "queue_depth",      1, NULL, 'q' },
+    { "segments",         1, NULL, 'S' },
+    { "range",            1, NULL, 'R' },
+    { "trace",            1, NULL, 'T' },
+    { "ref_cache",        1, NULL, 'C' },
+    { "preview",          1, NULL, 'V' },
+    { "gate",             1, NULL, 'g' },
+    { "crop",             0, NULL, 'L' },
+    { "scale",            1, NULL, 'z' },
+    { "distorted_size",   1, NULL, 'D' },
+    { "in_flight",        1, NULL, 'F' },
     { "no_prediction",    0, NULL, 'n' },
     { "version",          0, NULL, 'v' },
     { NULL,               0, NULL, 0 },
@@ -47,20 +61,37 @@ static void usage(const char *const app, const char *const reason, ...) {
             " --distorted/-d $path:      path to distorted .y4m or .yuv\n"
             " --width/-w $unsigned:      width\n"
             " --height/-h $unsigned:     height\n"
-            " --pixel_format/-p: $string pixel format (420/422/444)\n"
+            " --pixel_format/-p: $string pixel format (420/422/444/nv12/p010)\n"
             " --bitdepth/-b $unsigned:   bitdepth (8/10/12)\n"
             " --model/-m $model-params:  path to model file (required) + optional parameters, e.g.\n"
             "                               path=foo.pkl:disable_clip\n"
             "                               path=foo.pkl:name=foo:enable_transform\n"
-            " --output/-o $path:         path to output file\n"
+            " --output/-o $path:         path to output file, \"-\" writes stdout\n"
             " --xml/-x:                  write output file as XML (default)\n"
             " --json/-j:                 write output file as JSON\n"
             " --csv/-c:                  write output file as CSV\n"
+            " --bin/-B:                  write output file as binary columns, see src/output.h\n"
+            " --partial/-P:              write output file as a partial result, to be imported\n"
             " --threads/-t $unsigned:    number of threads to use\n"
             " --feature/-f $string:      additional feature\n"
-            " --import/-i $path:         path to precomputed feature log\n"
+            " --import/-i $path:         path to partial result, \"-\" reads stdin\n"
             " --cpumask/-c: $mask        restrict permitted CPU instruction sets\n"
             " --subsample/-s: $unsigned  compute scores only every N frames\n"
+            " --adaptive/-a:             subsample by motion, every frame up to every N\n"
+            " --queue_depth/-q $unsigned: read up to N frames ahead, one thread per input\n"
+            " --segments/-S $unsigned:   score N segments in parallel, seekable input only\n"
+            " --range/-R $low:$high:     score pictures [low, high) only, seekable input only\n"
+            " --trace/-T $path:          write Chrome trace-event JSON, needs -Denable_trace=true\n"
+            " --ref_cache/-C $path:      cache reference-only features (motion) in a file\n"
+            " --preview/-V $unsigned:    approximate scores on input decimated by 2\n"
+            " --gate/-g $float:          stop once the mean score is known to be above or\n"
+            "                            below the threshold, exit with 2 below it,\n"
+            "                            seekable input only\n"
+            " --crop/-L:                 score the active area only, without black bars\n"
+            " --scale/-z $string:        scale distorted input to the reference size\n"
+            "                            (bicubic/lanczos)\n"
+            " --distorted_size/-D $wxh:  size of distorted .yuv input, default -w/-h\n"
+            " --in_flight/-F $unsigned:  extract at most N frames at once with threads\n"
             " --no_prediction/-n:        no prediction, extract features only\n"
             " --version/-v:              print version and exit\n"
            );
@@ -96,6 +127,53 @@ static unsigned parse_unsigned(const char *const optarg, const int option,
     return res;
 }
 
+static double parse_double(const char *const optarg, const int option,
+                           const char *const app)
+{
+    char *end;
+    const double res = strtod(optarg, &end);
+    if (*end || end == optarg) error(app, optarg, option, "a number");
+    return res;
+}
+
+static void parse_range(const char *const optarg, const int option,
+                        const char *const app, unsigned *low, unsigned *high)
+{
+    char *end;
+    *low = (unsigned) strtoul(optarg, &end, 0);
+    if (end == optarg || *end != ':')
+        error(app, optarg, option, "a picture range ($low:$high)");
+    const char *const h = end + 1;
+    *high = (unsigned) strtoul(h, &end, 0);
+    if (*end || end == h || *low >= *high)
+        error(app, optarg, option, "a picture range ($low:$high)");
+}
+
+static void parse_size(const char *const optarg, const int option,
+                       const char *const app, unsigned *w, unsigned *h)
+{
+    char *end;
+    *w = (unsigned) strtoul(optarg, &end, 0);
+    if (end == optarg || *end != 'x')
+        error(app, optarg, option, "a size (e.g. 960x540)");
+    const char *const hs = end + 1;
+    *h = (unsigned) strtoul(hs, &end, 0);
+    if (*end || end == hs || !*w || !*h)
+        error(app, optarg, option, "a size (e.g. 960x540)");
+}
+
+static enum VmafScaleFilter parse_scale_filter(const char *const optarg,
+                                               const int option,
+                                               const char *const app)
+{
+    if (!strcmp(optarg, "bicubic"))
+        return VMAF_SCALE_FILTER_BICUBIC;
+    if (!strcmp(optarg, "lanczos"))
+        return VMAF_SCALE_FILTER_LANCZOS;
+    error(app, optarg, option, "a scale filter (bicubic/lanczos)");
+    return VMAF_SCALE_FILTER_NONE;
+}
+
 static unsigned parse_bitdepth(const char *const optarg, const int option,
                                const char *const app)
 {
@@ -117,9 +195,13 @@ static enum VmafPixelFormat parse_pix_fmt(const char *const optarg,
         pix_fmt = VMAF_PIX_FMT_YUV422P;
     if (!strcmp(optarg, "444"))
         pix_fmt = VMAF_PIX_FMT_YUV444P;
+    if (!strcmp(optarg, "nv12"))
+        pix_fmt = VMAF_PIX_FMT_NV12;
+    if (!strcmp(optarg, "p010"))
+        pix_fmt = VMAF_PIX_FMT_P010;
 
     if (!pix_fmt) error(app, optarg, option, "a valid pixel format "
-                                             "(420/422/444)");
+                                             "(420/422/444/nv12/p010)");
 
     return pix_fmt;
 }
@@ -203,6 +285,12 @@ void cli_parse(const int argc, char *const *const argv,
         case 'e':
             settings->output_fmt = VMAF_OUTPUT_FORMAT_CSV;
             break;
+        case 'B':
+            settings->output_fmt = VMAF_OUTPUT_FORMAT_BIN;
+            break;
+        case 'P':
+            settings->write_partial = true;
+            break;
         case 'm':
             if (settings->model_cnt == CLI_SETTINGS_STATIC_ARRAY_LEN) {
                 usage(argv[0], "A maximum of %d models is supported\n",
@@ -231,9 +319,50 @@ void cli_parse(const int argc, char *const *const argv,
         case 's':
             settings->subsample = parse_unsigned(optarg, 's', argv[0]);
             break;
+        case 'a':
+            settings->adaptive = true;
+            break;
         case 'c':
             settings->cpumask = parse_unsigned(optarg, 'c', argv[0]);
             break;
+        case 'q':
+            settings->queue_depth = parse_unsigned(optarg, 'q', argv[0]);
+            break;
+        case 'S':
+            settings->segment_cnt = parse_unsigned(optarg, 'S', argv[0]);
+            break;
+        case 'R':
+            parse_range(optarg, 'R', argv[0], &settings->range_low,
+                        &settings->range_high);
+            break;
+        case 'T':
+            settings->trace_path = optarg;
+            break;
+        case 'C':
+            settings->ref_cache_path = optarg;
+            break;
+        case 'V':
+            settings->preview = parse_unsigned(optarg, 'V', argv[0]);
+            if (settings->preview != 2)
+                error(argv[0], optarg, 'V', "a preview factor (2)");
+            break;
+        case 'g':
+            settings->gate = true;
+            settings->gate_threshold = parse_double(optarg, 'g', argv[0]);
+            break;
+        case 'L':
+            settings->crop = true;
+            break;
+        case 'z':
+            settings->scale_filter = parse_scale_filter(optarg, 'z', argv[0]);
+            break;
+        case 'D':
+            parse_size(optarg, 'D', argv[0], &settings->dist_width,
+                       &settings->dist_height);
+            break;
+        case 'F':
+            settings->in_flight = parse_unsigned(optarg, 'F', argv[0]);
+            break;
         case 'n':
             settings->no_prediction = true;
             break;
@@ -247,9 +376,9 @@ void cli_parse(const int argc, char *const *const argv,
 
     if (!settings->output_fmt)
         settings->output_fmt = VMAF_OUTPUT_FORMAT_XML;
-    if (!settings->path_ref)
+    if (!settings->path_ref && !settings->import_cnt)
         usage(argv[0], "Reference .y4m or .yuv (-r/--reference) is required");
-    if (!settings->path_ref)
+    if (!settings->path_dist && settings->path_ref)
         usage(argv[0], "Distorted .y4m or .yuv (-d/--distorted) is required");
     if (settings->use_yuv && !(settings->width && settings->height &&
         settings->pix_fmt && settings->bitdepth))
@@ -260,6 +389,21 @@ void cli_parse(const int argc, char *const *const argv,
                        "  --pixel_format/-p\n"
                        "  --bitdepth/-b\n");
     }
+    if (settings->dist_width && !settings->use_yuv)
+        usage(argv[0], "--distorted_size/-D is for .yuv input only");
+    if (!settings->dist_width) {
+        settings->dist_width = settings->width;
+        settings->dist_height = settings->height;
+    }
+    if (settings->pix_fmt == VMAF_PIX_FMT_NV12 && settings->bitdepth != 8)
+        usage(argv[0], "nv12 input requires --bitdepth/-b 8");
+    if (settings->pix_fmt == VMAF_PIX_FMT_P010 && settings->bitdepth != 10)
+        usage(argv[0], "p010 input requires --bitdepth/-b 10");
     if ((settings->model_cnt == 0) && !settings->no_prediction)
         usage(argv[0], "At least one model file (-m/--model) is required");
+    if (settings->gate && !settings->model_cnt)
+        usage(argv[0], "The quality gate (-g/--gate) requires a model");
+
+    for (unsigned i = 0; settings->preview && i < settings->model_cnt; i++)
+        settings->model_config[i].flags |= VMAF_MODEL_FLAG_PREVIEW_2X;
 }
@@ -12,11 +12,15 @@
 typedef struct {
     char *path_ref, *path_dist;
     unsigned width, height;
+    unsigned dist_width, dist_height;
     enum VmafPixelFormat pix_fmt;
     unsigned bitdepth;
     bool use_yuv;
     char *output_path;
+    char *trace_path;
+    char *ref_cache_path;
     enum VmafOutputFormat output_fmt;
+    bool write_partial;
     VmafModelConfig model_config[CLI_SETTINGS_STATIC_ARRAY_LEN];
     unsigned model_cnt;
     char *feature[CLI_SETTINGS_STATIC_ARRAY_LEN];
@@ -25,7 +29,17 @@ typedef struct {
     unsigned import_cnt;
     enum VmafLogLevel log_level;
     unsigned subsample;
+    bool adaptive;
+    unsigned preview;
+    bool crop;
+    enum VmafScaleFilter scale_filter;
     unsigned thread_cnt;
+    unsigned queue_depth;
+    unsigned in_flight;
+    unsigned segment_cnt;
+    unsigned range_low, range_high;
+    bool gate;
+    double gate_threshold;
     bool no_prediction;
     uint32_t cpumask;
 } CLISettings;
@@ -0,0 +1,141 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "picture_queue.h"
+
+#include <libvmaf/picture.h>
+
+typedef struct PictureQueue {
+    PictureQueueFetch fetch;
+    void *ctx;
+    VmafPicture *pic;
+    unsigned depth, head, cnt;
+    int status;
+    bool stop;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full;
+} PictureQueue;
+
+static void *picture_queue_reader(void *q)
+{
+    PictureQueue *queue = q;
+
+    for (;;) {
+        // wait for a free slot first, so that at most `depth` are alive
+        pthread_mutex_lock(&(queue->lock));
+        while (queue->cnt == queue->depth && !queue->stop)
+            pthread_cond_wait(&(queue->not_full), &(queue->lock));
+        const bool stop = queue->stop;
+        pthread_mutex_unlock(&(queue->lock));
+        if (stop) break;
+
+        VmafPicture pic;
+        int ret = queue->fetch(queue->ctx, &pic);
+
+        pthread_mutex_lock(&(queue->lock));
+        if (queue->stop) {
+            if (!ret) vmaf_picture_unref(&pic);
+            pthread_mutex_unlock(&(queue->lock));
+            break;
+        }
+        if (ret) {
+            queue->status = ret;
+            pthread_cond_signal(&(queue->not_empty));
+            pthread_mutex_unlock(&(queue->lock));
+            break;
+        }
+        const unsigned tail = (queue->head + queue->cnt) % queue->depth;
+        queue->pic[tail] = pic;
+        queue->cnt++;
+        pthread_cond_signal(&(queue->not_empty));
+        pthread_mutex_unlock(&(queue->lock));
+    }
+
+    return NULL;
+}
+
+int picture_queue_open(PictureQueue **queue, unsigned depth,
+                       PictureQueueFetch fetch, void *ctx)
+{
+    if (!queue) return -EINVAL;
+    if (!depth) return -EINVAL;
+    if (!fetch) return -EINVAL;
+
+    PictureQueue *const q = malloc(sizeof(*q));
+    if (!q) goto fail;
+    memset(q, 0, sizeof(*q));
+    q->fetch = fetch;
+    q->ctx = ctx;
+    q->depth = depth;
+    q->pic = malloc(sizeof(*(q->pic)) * q->depth);
+    if (!q->pic) goto free_q;
+
+    pthread_mutex_init(&(q->lock), NULL);
+    pthread_cond_init(&(q->not_empty), NULL);
+    pthread_cond_init(&(q->not_full), NULL);
+    if (pthread_create(&(q->thread), NULL, picture_queue_reader, q))
+        goto free_pic;
+
+    *queue = q;
+    return 0;
+
+free_pic:
+    pthread_mutex_destroy(&(q->lock));
+    pthread_cond_destroy(&(q->not_empty));
+    pthread_cond_destroy(&(q->not_full));
+    free(q->pic);
+free_q:
+    free(q);
+fail:
+    *queue = NULL;
+    return -ENOMEM;
+}
+
+int picture_queue_pop(PictureQueue *queue, VmafPicture *pic)
+{
+    if (!queue) return -EINVAL;
+    if (!pic) return -EINVAL;
+
+    pthread_mutex_lock(&(queue->lock));
+    while (!queue->cnt && !queue->status)
+        pthread_cond_wait(&(queue->not_empty), &(queue->lock));
+
+    int ret = 0;
+    if (queue->cnt) {
+        *pic = queue->pic[queue->head];
+        queue->head = (queue->head + 1) % queue->depth;
+        queue->cnt--;
+        pthread_cond_signal(&(queue->not_full));
+    } else {
+        ret = queue->status;
+    }
+
+    pthread_mutex_unlock(&(queue->lock));
+    return ret;
+}
+
+void picture_queue_close(PictureQueue *queue)
+{
+    if (!queue) return;
+
+    pthread_mutex_lock(&(queue->lock));
+    queue->stop = true;
+    pthread_cond_signal(&(queue->not_full));
+    pthread_mutex_unlock(&(queue->lock));
+    pthread_join(queue->thread, NULL);
+
+    for (; queue->cnt; queue->cnt--) {
+        vmaf_picture_unref(&queue->pic[queue->head]);
+        queue->head = (queue->head + 1) % queue->depth;
+    }
+
+    pthread_mutex_destroy(&(queue->lock));
+    pthread_cond_destroy(&(queue->not_empty));
+    pthread_cond_destroy(&(queue->not_full));
+    free(queue->pic);
+    free(queue);
+}
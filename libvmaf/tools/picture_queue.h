@@ -0,0 +1,29 @@
+#ifndef __VMAF_PICTURE_QUEUE_H__
+#define __VMAF_PICTURE_QUEUE_H__
+
+#include <libvmaf/picture.h>
+
+/**
+ * Picture fetch callback, run on the reader thread.
+ * Returns 0 on success, 1 at end of stream, or < 0 on error.
+ */
+typedef int (*PictureQueueFetch)(void *ctx, VmafPicture *pic);
+
+typedef struct PictureQueue PictureQueue;
+
+/**
+ * Start a reader thread which calls `fetch` ahead of the consumer,
+ * keeping up to `depth` pictures buffered.
+ */
+int picture_queue_open(PictureQueue **queue, unsigned depth,
+                       PictureQueueFetch fetch, void *ctx);
+
+/**
+ * Pop the next picture, blocking until the reader thread provides one.
+ * Returns the same codes as `PictureQueueFetch`.
+ */
+int picture_queue_pop(PictureQueue *queue, VmafPicture *pic);
+
+void picture_queue_close(PictureQueue *queue);
+
+#endif /* __VMAF_PICTURE_QUEUE_H__ */
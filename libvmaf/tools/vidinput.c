@@ -67,6 +67,12 @@ int video_input_fetch_frame(video_input *_vid,
   return (*_vid->vtbl->fetch_frame)(_vid->ctx,_vid->fin,_ycbcr,_tag);
 }
 
+void video_input_set_luma_only(video_input *_vid,int _luma_only){
+  if(_vid->vtbl->set_luma_only!=NULL){
+    (*_vid->vtbl->set_luma_only)(_vid->ctx,_luma_only);
+  }
+}
+
 void video_input_close(video_input *_vid){
   (*_vid->vtbl->close)(_vid->ctx);
   free(_vid->ctx);
@@ -56,6 +56,7 @@ typedef void (*video_input_get_info_func)(void *_ctx,video_input_info *_ti);
 typedef int (*video_input_fetch_frame_func)(void *_ctx,FILE *_fin,
  video_input_ycbcr _ycbcr,char _tag[5]);
 typedef void (*video_input_close_func)(void *_ctx);
+typedef void (*video_input_set_luma_only_func)(void *_ctx,int _luma_only);
 
 /**Pluggable method table for accessing different formats.*/
 struct video_input_vtbl{
@@ -63,6 +64,8 @@ struct video_input_vtbl{
   video_input_get_info_func     get_info;
   video_input_fetch_frame_func  fetch_frame;
   video_input_close_func        close;
+  /*Optional.*/
+  video_input_set_luma_only_func set_luma_only;
 };
 
 struct video_input{
@@ -85,6 +88,7 @@ typedef struct raw_input_vtbl {
   video_input_get_info_func     get_info;
   video_input_fetch_frame_func  fetch_frame;
   video_input_close_func        close;
+  video_input_set_luma_only_func set_luma_only;
 } raw_input_vtbl;
 
 int video_input_open(video_input *_vid,FILE *_fin);
@@ -93,6 +97,8 @@ void video_input_close(video_input *_vid);
 void video_input_get_info(video_input *_vid,video_input_info *_ti);
 int video_input_fetch_frame(video_input *_vid,
  video_input_ycbcr _ycbcr,char _tag[5]);
+/*Chroma planes of fetched frames are undefined once set, if supported.*/
+void video_input_set_luma_only(video_input *_vid,int _luma_only);
 
 typedef enum{
   /**Chroma decimation by 2 in both the X and Y directions (4:2:0).
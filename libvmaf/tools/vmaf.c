@@ -1,12 +1,18 @@
 #include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "cli_parse.h"
+#include "picture_queue.h"
 #include "vidinput.h"
 
 #include <libvmaf/picture.h>
 #include <libvmaf/libvmaf.rc.h>
+#include <libvmaf/reader.h>
 
 static enum VmafPixelFormat pix_fmt_map(int pf)
 {
@@ -22,39 +28,117 @@ static enum VmafPixelFormat pix_fmt_map(int pf)
     }
 }
 
-static int validate_videos(video_input *vid1, video_input *vid2)
+typedef struct {
+    VmafReader *reader;
+    unsigned index;
+    unsigned planes; ///< Planes which are read, see enum VmafPlane.
+    video_input vid;
+} InputStream;
+
+static int input_open(InputStream *in, const char *path, CLISettings *c,
+                      unsigned w, unsigned h)
+{
+    int err;
+
+    memset(in, 0, sizeof(*in));
+    in->planes = VMAF_PLANES_ALL;
+    if (c->use_yuv) {
+        err = vmaf_reader_open_yuv(&in->reader, path, c->pix_fmt, c->bitdepth,
+                                   w, h);
+    } else {
+        err = vmaf_reader_open_y4m(&in->reader, path);
+    }
+    if (!err) return 0;
+    in->reader = NULL;
+
+    // the daala readers only know planar layouts
+    if (c->use_yuv && (c->pix_fmt == VMAF_PIX_FMT_NV12 ||
+                       c->pix_fmt == VMAF_PIX_FMT_P010))
+    {
+        fprintf(stderr, "could not open file: %s\n", path);
+        return -1;
+    }
+
+    // fall back to the daala readers for inputs libvmaf does not handle
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "could not open file: %s\n", path);
+        return -1;
+    }
+    if (c->use_yuv) {
+        err = raw_input_open(&in->vid, file, w, h, c->pix_fmt, c->bitdepth);
+    } else {
+        err = video_input_open(&in->vid, file);
+    }
+    return err;
+}
+
+static void input_get_info(InputStream *in, VmafReaderInfo *info)
+{
+    if (in->reader) {
+        vmaf_reader_get_info(in->reader, info);
+        return;
+    }
+
+    video_input_info vid_info;
+    video_input_get_info(&in->vid, &vid_info);
+    info->pix_fmt = pix_fmt_map(vid_info.pixel_fmt);
+    info->bpc = vid_info.depth;
+    info->w = vid_info.pic_w;
+    info->h = vid_info.pic_h;
+    info->frame_cnt = 0;
+}
+
+static int input_set_planes(InputStream *in, unsigned planes)
+{
+    in->planes = planes;
+    if (in->reader)
+        return vmaf_reader_set_planes(in->reader, planes);
+    video_input_set_luma_only(&in->vid, planes == VMAF_PLANE_Y);
+    return 0;
+}
+
+static void input_close(InputStream *in)
+{
+    if (in->reader)
+        vmaf_reader_close(in->reader);
+    else
+        video_input_close(&in->vid);
+}
+
+static int validate_videos(InputStream *in1, InputStream *in2, bool scaled)
 {
     int err_cnt = 0;
 
-    video_input_info info1, info2;
-    video_input_get_info(vid1, &info1);
-    video_input_get_info(vid2, &info2);
+    VmafReaderInfo info1, info2;
+    input_get_info(in1, &info1);
+    input_get_info(in2, &info2);
 
-    if ((info1.frame_w != info2.frame_w) || (info1.frame_h != info2.frame_h)) {
+    if (!scaled && ((info1.w != info2.w) || (info1.h != info2.h))) {
         fprintf(stderr, "dimensions do not match: %dx%d, %dx%d\n",
-                info1.frame_w, info1.frame_h, info2.frame_w, info2.frame_h);
+                info1.w, info1.h, info2.w, info2.h);
         err_cnt++;
     }
 
-    if (info1.pixel_fmt != info2.pixel_fmt) {
+    if (info1.pix_fmt != info2.pix_fmt) {
         fprintf(stderr, "pixel formats do not match: %d, %d\n",
-                info1.pixel_fmt, info2.pixel_fmt);
+                info1.pix_fmt, info2.pix_fmt);
         err_cnt++;
     }
 
-    if (!pix_fmt_map(info1.pixel_fmt) || !pix_fmt_map(info2.pixel_fmt)) {
-        fprintf(stderr, "unsupported pixel format: %d\n", info1.pixel_fmt);
+    if (!info1.pix_fmt || !info2.pix_fmt) {
+        fprintf(stderr, "unsupported pixel format: %d\n", info1.pix_fmt);
         err_cnt++;
     }
 
-    if (info1.depth != info2.depth) {
+    if (info1.bpc != info2.bpc) {
         fprintf(stderr, "bitdepths do not match: %d, %d\n",
-                info1.depth, info2.depth);
+                info1.bpc, info2.bpc);
         err_cnt++;
     }
 
-    if (info1.depth < 8 || info1.depth > 16) {
-        fprintf(stderr, "unsupported bitdepth: %d\n", info1.depth);
+    if (info1.bpc < 8 || info1.bpc > 16) {
+        fprintf(stderr, "unsupported bitdepth: %d\n", info1.bpc);
         err_cnt++;
     }
 
@@ -63,7 +147,7 @@ static int validate_videos(video_input *vid1, video_input *vid2)
     return err_cnt;
 }
 
-static int fetch_picture(video_input *vid, VmafPicture *pic)
+static int fetch_picture(video_input *vid, VmafPicture *pic, unsigned planes)
 {
     int ret;
     video_input_ycbcr ycbcr;
@@ -73,8 +157,9 @@ static int fetch_picture(video_input *vid, VmafPicture *pic)
     if (ret < 1) return !ret;
 
     video_input_get_info(vid, &info);
-    ret = vmaf_picture_alloc(pic, pix_fmt_map(info.pixel_fmt), info.depth,
-                             info.pic_w, info.pic_h);
+    ret = vmaf_picture_alloc_planes(pic, pix_fmt_map(info.pixel_fmt),
+                                    info.depth, info.pic_w, info.pic_h,
+                                    planes);
     if (ret) {
         fprintf(stderr, "problem allocating picture.\n");
         return -1;
@@ -86,6 +171,7 @@ static int fetch_picture(video_input *vid, VmafPicture *pic)
 
     if (info.depth == 8) {
         for (unsigned i = 0; i < 3; i++) {
+            if (!pic->data[i]) continue;
             int xdec = i&&!(info.pixel_fmt&1);
             int ydec = i&&!(info.pixel_fmt&2);
             int xstride = info.depth > 8 ? 2 : 1;
@@ -103,6 +189,7 @@ static int fetch_picture(video_input *vid, VmafPicture *pic)
         }
     } else {
         for (unsigned i = 0; i < 3; i++) {
+            if (!pic->data[i]) continue;
             int xdec = i&&!(info.pixel_fmt&1);
             int ydec = i&&!(info.pixel_fmt&2);
             int xstride = info.depth > 8 ? 2 : 1;
@@ -123,155 +210,581 @@ static int fetch_picture(video_input *vid, VmafPicture *pic)
     return 0;
 }
 
-int main(int argc, char *argv[])
+static int input_fetch_picture(void *in, VmafPicture *pic)
 {
-    int err = 0;
+    InputStream *const input = in;
+    if (input->reader)
+        return vmaf_reader_read_picture(input->reader, pic, input->index++);
+    return fetch_picture(&input->vid, pic, input->planes);
+}
 
-    CLISettings c;
-    cli_parse(argc, argv, &c);
+static int next_picture(PictureQueue *queue, InputStream *in,
+                        VmafPicture *pic)
+{
+    if (queue)
+        return picture_queue_pop(queue, pic);
+    return input_fetch_picture(in, pic);
+}
 
-    FILE *file_ref = fopen(c.path_ref, "rb");
-    if (!file_ref) {
-        fprintf(stderr, "could not open file: %s\n", c.path_ref);
-        return -1;
+static int init_context(VmafContext **vmaf, CLISettings *c,
+                        VmafModel **model, VmafActiveArea area)
+{
+    VmafConfiguration cfg = {
+        .log_level = VMAF_LOG_LEVEL_INFO,
+        .n_threads = c->thread_cnt,
+        .n_subsample = c->subsample,
+        .subsample_mode = c->adaptive ? VMAF_SUBSAMPLE_MODE_ADAPTIVE :
+                                        VMAF_SUBSAMPLE_MODE_FIXED,
+        .cpumask = c->cpumask,
+        .preview = c->preview,
+        .scale_filter = c->scale_filter,
+        .max_in_flight = c->in_flight,
+    };
+
+    int err = vmaf_init(vmaf, cfg);
+    if (err) {
+        fprintf(stderr, "problem initializing VMAF context\n");
+        return err;
     }
 
-    FILE *file_dist = fopen(c.path_dist, "rb");
-    if (!file_dist) {
-        fprintf(stderr, "could not open file: %s\n", c.path_dist);
-        return -1;
+    for (unsigned i = 0; i < c->model_cnt; i++) {
+        err = vmaf_use_features_from_model(*vmaf, model[i]);
+        if (err) {
+            fprintf(stderr,
+                    "problem loading feature extractors from model file: %s\n",
+                    c->model_config[i].path);
+            return err;
+        }
     }
 
-    video_input vid_ref;
-    if (c.use_yuv) {
-        err = raw_input_open(&vid_ref, file_ref,
-                             c.width, c.height, c.pix_fmt, c.bitdepth);
-    } else {
-        err = video_input_open(&vid_ref, file_ref);
+    for (unsigned i = 0; i < c->feature_cnt; i++) {
+        err = vmaf_use_feature(*vmaf, c->feature[i]);
+        if (err) {
+            fprintf(stderr, "problem loading feature extractor: %s\n",
+                    c->feature[i]);
+            return err;
+        }
     }
-    if (err) {
-        fprintf(stderr, "problem with reference file: %s\n", c.path_ref);
-        return -1;
+
+    if (c->ref_cache_path) {
+        err = vmaf_use_reference_cache(*vmaf, c->ref_cache_path);
+        if (err) {
+            fprintf(stderr, "problem with reference cache: %s\n",
+                    c->ref_cache_path);
+            return err;
+        }
     }
 
-    video_input vid_dist;
-    if (c.use_yuv) {
-        err = raw_input_open(&vid_dist, file_dist,
-                             c.width, c.height, c.pix_fmt, c.bitdepth);
-    } else {
-        err = video_input_open(&vid_dist, file_dist);
+    if (area.w) {
+        err = vmaf_set_active_area(*vmaf, area);
+        if (err) {
+            fprintf(stderr, "problem setting active area\n");
+            return err;
+        }
     }
-    if (err) {
-        fprintf(stderr, "problem with distorted file: %s\n", c.path_dist);
-        return -1;
+
+    return 0;
+}
+
+#define CROP_DETECT_CNT 8
+
+/*
+ * Bars may change between scenes, so the active area is the union over
+ * reference pictures spread across the input.
+ */
+static int detect_crop(InputStream *in_ref, VmafActiveArea *area)
+{
+    VmafReaderInfo info;
+    input_get_info(in_ref, &info);
+
+    for (unsigned i = 0; i < CROP_DETECT_CNT; i++) {
+        const unsigned index = (uint64_t) info.frame_cnt * i / CROP_DETECT_CNT;
+        VmafPicture pic;
+        int err = vmaf_reader_read_picture(in_ref->reader, &pic, index);
+        if (err) return err;
+        err = vmaf_detect_active_area(&pic, area);
+        vmaf_picture_unref(&pic);
+        if (err) return err;
     }
 
-    err = validate_videos(&vid_ref, &vid_dist);
-    if (err) {
-        fprintf(stderr, "videos are incompatible, %d %s.\n",
-                err, err == 1 ? "problem" : "problems");
-        return -1;
+    return 0;
+}
+
+static void print_crop(VmafActiveArea *area)
+{
+    fprintf(stderr, "active area: %ux%u at %u,%u\n",
+            area->w, area->h, area->x, area->y);
+}
+
+typedef struct {
+    VmafContext *vmaf;
+    VmafReader *ref, *dist;
+    unsigned index_low, index_high, pic_cnt;
+    int err;
+} Segment;
+
+static void *score_segment(void *data)
+{
+    Segment *s = data;
+
+    // one picture of overlap on each side rebuilds temporal state
+    const unsigned begin = s->index_low ? s->index_low - 1 : 0;
+    const unsigned end =
+        s->index_high < s->pic_cnt ? s->index_high + 1 : s->pic_cnt;
+
+    for (unsigned i = begin; i < end; i++) {
+        VmafPicture pic_ref, pic_dist;
+        s->err = vmaf_reader_read_picture(s->ref, &pic_ref, i);
+        if (s->err) break;
+        s->err = vmaf_reader_read_picture(s->dist, &pic_dist, i);
+        if (s->err) {
+            vmaf_picture_unref(&pic_ref);
+            break;
+        }
+        s->err = vmaf_read_pictures(s->vmaf, &pic_ref, &pic_dist, i);
+        if (s->err) break;
     }
 
-    VmafConfiguration cfg = {
-        .log_level = VMAF_LOG_LEVEL_INFO,
-        .n_threads = c.thread_cnt,
-        .n_subsample = c.subsample,
-        .cpumask = c.cpumask,
+    return NULL;
+}
+
+static int seekable_pic_cnt(InputStream *in_ref, InputStream *in_dist,
+                            unsigned *pic_cnt)
+{
+    VmafReaderInfo info_ref, info_dist;
+    input_get_info(in_ref, &info_ref);
+    input_get_info(in_dist, &info_dist);
+    if (!in_ref->reader || !in_dist->reader ||
+        !info_ref.frame_cnt || !info_dist.frame_cnt)
+    {
+        fprintf(stderr, "segments require seekable .y4m or .yuv files\n");
+        return -EINVAL;
+    }
+
+    *pic_cnt = info_ref.frame_cnt < info_dist.frame_cnt ?
+               info_ref.frame_cnt : info_dist.frame_cnt;
+    return 0;
+}
+
+static int score_range(VmafContext *vmaf, CLISettings *c,
+                       InputStream *in_ref, InputStream *in_dist,
+                       unsigned *index_low, unsigned *index_high)
+{
+    unsigned pic_cnt;
+    int err = seekable_pic_cnt(in_ref, in_dist, &pic_cnt);
+    if (err) return err;
+
+    Segment s = {
+        .vmaf = vmaf,
+        .ref = in_ref->reader,
+        .dist = in_dist->reader,
+        .index_low = c->range_low,
+        .index_high = c->range_high < pic_cnt ? c->range_high : pic_cnt,
+        .pic_cnt = pic_cnt,
     };
+    if (s.index_low >= s.index_high) {
+        fprintf(stderr, "range [%d, %d) is outside of the input\n",
+                c->range_low, c->range_high);
+        return -EINVAL;
+    }
 
-    VmafContext *vmaf;
-    err = vmaf_init(&vmaf, cfg);
-    if (err) {
-        fprintf(stderr, "problem initializing VMAF context\n");
-        return -1;
+    err = vmaf_set_segment(vmaf, s.index_low, s.index_high);
+    if (err) return err;
+    score_segment(&s);
+    if (s.err) {
+        fprintf(stderr, "problem scoring range [%d, %d)\n",
+                s.index_low, s.index_high);
+        return s.err;
     }
 
-    VmafModel *model[c.model_cnt];
-    for (unsigned i = 0; i < c.model_cnt; i++) {
-        err = vmaf_model_load_from_path(&model[i], &c.model_config[i]);
-        if (err) {
-            fprintf(stderr, "problem loading model file: %s\n",
-                    c.model_config[i].path);
-            return -1;
+    *index_low = s.index_low;
+    *index_high = s.index_high;
+    return 0;
+}
+
+static int import_partials(VmafContext *vmaf, const char *path,
+                           unsigned *index_low, unsigned *index_high)
+{
+    FILE *infile = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if (!infile) {
+        fprintf(stderr, "could not open file: %s\n", path);
+        return -EINVAL;
+    }
+
+    int err;
+    unsigned low, high;
+    while (!(err = vmaf_import_partial(vmaf, infile, &low, &high))) {
+        if (low < *index_low) *index_low = low;
+        if (high > *index_high) *index_high = high;
+    }
+    if (err < 0)
+        fprintf(stderr, "problem importing partial result: %s\n", path);
+
+    if (infile != stdin)
+        fclose(infile);
+    return err < 0 ? err : 0;
+}
+
+static int score_segments(VmafContext *vmaf, CLISettings *c,
+                          VmafModel **model, InputStream *in_ref,
+                          InputStream *in_dist, unsigned *pic_cnt)
+{
+    int err = 0;
+
+    err = seekable_pic_cnt(in_ref, in_dist, pic_cnt);
+    if (err) return err;
+
+    VmafActiveArea area;
+    err = vmaf_get_active_area(vmaf, &area, NULL);
+    if (err) return err;
+
+    const unsigned segment_cnt =
+        c->segment_cnt < *pic_cnt ? c->segment_cnt : *pic_cnt;
+
+    Segment segment[segment_cnt];
+    pthread_t thread[segment_cnt];
+    unsigned thread_cnt = 0;
+    memset(segment, 0, sizeof(segment));
+
+    for (unsigned i = 0; i < segment_cnt; i++) {
+        Segment *s = &segment[i];
+        s->ref = in_ref->reader;
+        s->dist = in_dist->reader;
+        s->pic_cnt = *pic_cnt;
+        s->index_low = (uint64_t) *pic_cnt * i / segment_cnt;
+        s->index_high = (uint64_t) *pic_cnt * (i + 1) / segment_cnt;
+
+        err = init_context(&s->vmaf, c, model, area);
+        if (err) break;
+        err = vmaf_set_segment(s->vmaf, s->index_low, s->index_high);
+        if (err) break;
+        err = pthread_create(&thread[i], NULL, score_segment, s);
+        if (err) break;
+        thread_cnt++;
+    }
+
+    for (unsigned i = 0; i < thread_cnt; i++) {
+        pthread_join(thread[i], NULL);
+        if (segment[i].err && !err) {
+            fprintf(stderr, "problem scoring segment [%d, %d)\n",
+                    segment[i].index_low, segment[i].index_high);
+            err = segment[i].err;
+        }
+        if (!err)
+            err = vmaf_merge_segment(vmaf, segment[i].vmaf);
+    }
+
+    for (unsigned i = 0; i < segment_cnt; i++) {
+        if (segment[i].vmaf)
+            vmaf_close(segment[i].vmaf);
+    }
+
+    return err;
+}
+
+static int score_gate(VmafContext *vmaf, CLISettings *c, VmafModel **model,
+                      InputStream *in_ref, InputStream *in_dist,
+                      VmafGateStatus *status)
+{
+    unsigned pic_cnt;
+    int err = seekable_pic_cnt(in_ref, in_dist, &pic_cnt);
+    if (err) return err;
+
+    VmafActiveArea area;
+    err = vmaf_get_active_area(vmaf, &area, NULL);
+    if (err) return err;
+
+    VmafGate *gate;
+    err = vmaf_gate_init(&gate, (VmafGateConfiguration) {
+        .threshold = c->gate_threshold,
+        .pic_cnt = pic_cnt,
+    });
+    if (err) return err;
+
+    // every stratum is scored as a segment of its own, see score_segments()
+    Segment s = {
+        .ref = in_ref->reader,
+        .dist = in_dist->reader,
+        .pic_cnt = pic_cnt,
+    };
+    while (!(err = vmaf_gate_next(gate, &s.index_low, &s.index_high))) {
+        err = init_context(&s.vmaf, c, model, area);
+        if (err) break;
+        err = vmaf_set_segment(s.vmaf, s.index_low, s.index_high);
+        if (!err) {
+            score_segment(&s);
+            err = s.err;
         }
-        err = vmaf_use_features_from_model(vmaf, model[i]);
+        if (!err)
+            err = vmaf_merge_segment(vmaf, s.vmaf);
+        vmaf_close(s.vmaf);
         if (err) {
-            fprintf(stderr,
-                    "problem loading feature extractors from model file: %s\n",
-                    c.model_config[i].path);
-            return -1;
+            fprintf(stderr, "problem scoring stratum [%d, %d)\n",
+                    s.index_low, s.index_high);
+            break;
         }
+
+        err = vmaf_gate_check(gate, vmaf, model[0], status);
+        if (err) break;
+        fprintf(stderr, "\r%d/%d", status->scored, status->strata);
+        if (status->decision)
+            break;
     }
+    fprintf(stderr, "\n");
+
+    vmaf_gate_close(gate);
+    return err < 0 ? err : 0;
+}
+
+static int score_sequence(VmafContext *vmaf, CLISettings *c,
+                          InputStream *in_ref, InputStream *in_dist,
+                          unsigned *pic_cnt)
+{
+    int err;
 
-    for (unsigned i = 0; i < c.feature_cnt; i++) {
-        err = vmaf_use_feature(vmaf, c.feature[i]);
+    PictureQueue *queue_ref = NULL, *queue_dist = NULL;
+    if (c->queue_depth) {
+        err = picture_queue_open(&queue_ref, c->queue_depth,
+                                 input_fetch_picture, in_ref);
         if (err) {
-            fprintf(stderr, "problem loading feature extractor: %s\n",
-                    c.feature[i]);
+            fprintf(stderr, "problem starting picture readers\n");
+            return -1;
+        }
+        err = picture_queue_open(&queue_dist, c->queue_depth,
+                                 input_fetch_picture, in_dist);
+        if (err) {
+            fprintf(stderr, "problem starting picture readers\n");
+            picture_queue_close(queue_ref);
             return -1;
         }
     }
 
-    unsigned picture_index;
-    for (picture_index = 0 ;; picture_index++) {
+    for (*pic_cnt = 0 ;; (*pic_cnt)++) {
         VmafPicture pic_ref, pic_dist;
-        int ret1 = fetch_picture(&vid_ref, &pic_ref);
-        int ret2 = fetch_picture(&vid_dist, &pic_dist);
+        int ret1 = next_picture(queue_ref, in_ref, &pic_ref);
+        int ret2 = next_picture(queue_dist, in_dist, &pic_dist);
 
         if (ret1 && ret2) {
             break;
         } else if (ret1 < 0 || ret2 < 0) {
             fprintf(stderr, "problem while reading pictures\n",
-                    c.path_ref, c.path_dist);
+                    c->path_ref, c->path_dist);
             break;
         } else if (ret1) {
             fprintf(stderr, "\"%s\" ended before \"%s\".\n",
-                    c.path_ref, c.path_dist);
+                    c->path_ref, c->path_dist);
             break;
         } else if (ret2) {
             fprintf(stderr, "\"%s\" ended before \"%s\".\n",
-                    c.path_dist, c.path_ref);
+                    c->path_dist, c->path_ref);
             break;
         }
 
-        fprintf(stderr, "\r%d", picture_index);
-        err = vmaf_read_pictures(vmaf, &pic_ref, &pic_dist, picture_index);
+        // without seeking, only the first picture is there to detect on
+        if (c->crop && !*pic_cnt) {
+            VmafActiveArea area;
+            err = vmaf_get_active_area(vmaf, &area, NULL);
+            if (!err && !area.w) {
+                err = vmaf_detect_active_area(&pic_ref, &area);
+                if (!err && area.w) {
+                    print_crop(&area);
+                    err = vmaf_set_active_area(vmaf, area);
+                }
+            }
+            if (err) {
+                fprintf(stderr, "problem detecting active area\n");
+                vmaf_picture_unref(&pic_ref);
+                vmaf_picture_unref(&pic_dist);
+                break;
+            }
+        }
+
+        fprintf(stderr, "\r%d", *pic_cnt);
+        err = vmaf_read_pictures(vmaf, &pic_ref, &pic_dist, *pic_cnt);
         if (err) {
             fprintf(stderr, "problem reading pictures\n");
             break;
         }
     }
     fprintf(stderr, "\n");
+    picture_queue_close(queue_ref);
+    picture_queue_close(queue_dist);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int err = 0;
+
+    CLISettings c;
+    cli_parse(argc, argv, &c);
+
+    InputStream in_ref, in_dist;
+    if (c.path_ref) {
+        err = input_open(&in_ref, c.path_ref, &c, c.width, c.height);
+        if (err) {
+            fprintf(stderr, "problem with reference file: %s\n", c.path_ref);
+            return -1;
+        }
+
+        err = input_open(&in_dist, c.path_dist, &c, c.dist_width,
+                         c.dist_height);
+        if (err) {
+            fprintf(stderr, "problem with distorted file: %s\n", c.path_dist);
+            return -1;
+        }
 
+        err = validate_videos(&in_ref, &in_dist, c.scale_filter);
+        if (err) {
+            fprintf(stderr, "videos are incompatible, %d %s.\n",
+                    err, err == 1 ? "problem" : "problems");
+            return -1;
+        }
+    }
+
+    VmafModel *model[c.model_cnt];
     for (unsigned i = 0; i < c.model_cnt; i++) {
+        err = vmaf_model_load_from_path(&model[i], &c.model_config[i]);
+        if (err) {
+            fprintf(stderr, "problem loading model file: %s\n",
+                    c.model_config[i].path);
+            return -1;
+        }
+    }
+
+    VmafActiveArea area = { 0 };
+    if (c.crop && c.path_ref && in_ref.reader) {
+        VmafReaderInfo info;
+        input_get_info(&in_ref, &info);
+        if (info.frame_cnt) {
+            err = detect_crop(&in_ref, &area);
+            if (err) {
+                fprintf(stderr, "problem detecting active area\n");
+                return -1;
+            }
+            if (area.w)
+                print_crop(&area);
+        }
+    }
+
+    VmafContext *vmaf;
+    err = init_context(&vmaf, &c, model, area);
+    if (err) return -1;
+
+    // chroma is neither allocated nor read unless an extractor uses it
+    unsigned planes;
+    err = vmaf_get_planes(vmaf, &planes);
+    if (!err && c.path_ref) {
+        err = input_set_planes(&in_ref, planes);
+        err |= input_set_planes(&in_dist, planes);
+    }
+    if (err) {
+        fprintf(stderr, "problem selecting planes to read\n");
+        return -1;
+    }
+
+    // imported partial results may extend the range scored here
+    unsigned index_low = UINT_MAX, index_high = 0;
+    VmafGateStatus gate;
+    if (c.gate) {
+        err = score_gate(vmaf, &c, model, &in_ref, &in_dist, &gate);
+        if (err) return -1;
+        fprintf(stderr, "%s: %s (%f, 95%% interval [%f, %f], "
+                "%u/%u strata scored)\n", c.model_config[0].path,
+                gate.decision == VMAF_GATE_PASS ? "pass" : "fail",
+                gate.score, gate.ci_low, gate.ci_high,
+                gate.scored, gate.strata);
+    } else if (c.path_ref) {
+        index_low = 0;
+        if (c.range_high) {
+            err = score_range(vmaf, &c, &in_ref, &in_dist,
+                              &index_low, &index_high);
+        } else if (c.segment_cnt > 1) {
+            err = score_segments(vmaf, &c, model, &in_ref, &in_dist,
+                                 &index_high);
+        } else {
+            err = score_sequence(vmaf, &c, &in_ref, &in_dist, &index_high);
+        }
+        if (err) return -1;
+    }
+
+    for (unsigned i = 0; i < c.import_cnt; i++) {
+        err = import_partials(vmaf, c.import_path[i], &index_low, &index_high);
+        if (err) return -1;
+    }
+
+    unsigned exposed;
+    if (c.crop && !vmaf_get_active_area(vmaf, &area, &exposed) && exposed) {
+        fprintf(stderr, "%u frames have content outside of the active area\n",
+                exposed);
+    }
+
+    for (unsigned i = 0; !c.gate && i < c.model_cnt; i++) {
         double vmaf_score;
         err = vmaf_score_pooled(vmaf, model[i], VMAF_POOL_METHOD_MEAN,
-                                &vmaf_score, 0, picture_index);
+                                &vmaf_score, index_low, index_high);
         if (err) {
             fprintf(stderr, "problem generating pooled VMAF score\n");
             return -1;
         }
 
+        VmafSubsampleReport report;
+        if (!vmaf_subsample_report(vmaf, model[i], &report, index_low,
+                                   index_high))
+        {
+            fprintf(stderr, "%s: %f (%u/%u frames scored, "
+                    "estimated error %f)\n", c.model_config[i].path,
+                    vmaf_score, report.scored, report.pictures,
+                    report.error);
+            continue;
+        }
+
+        double preview_error;
+        if (!vmaf_model_preview_error(model[i], &preview_error)) {
+            fprintf(stderr, "%s: %f (preview, expected error %f)\n",
+                    c.model_config[i].path, vmaf_score, preview_error);
+            continue;
+        }
         fprintf(stderr, "%s: %f\n", c.model_config[i].path, vmaf_score);
     }
 
     if (c.output_path) {
-        FILE *outfile = fopen(c.output_path, "w");
+        FILE *outfile = strcmp(c.output_path, "-") ?
+                        fopen(c.output_path, "wb") : stdout;
         if (!outfile) {
             fprintf(stderr, "could not open file: %s\n", c.output_path);
             return -1;
         }
-        vmaf_write_output(vmaf, outfile, c.output_fmt);
-        fclose(outfile);
+        if (c.write_partial)
+            vmaf_export_partial(vmaf, outfile);
+        else
+            vmaf_write_output(vmaf, outfile, c.output_fmt);
+        if (outfile != stdout)
+            fclose(outfile);
+    }
+
+    if (c.trace_path) {
+        FILE *tracefile = fopen(c.trace_path, "w");
+        if (!tracefile) {
+            fprintf(stderr, "could not open file: %s\n", c.trace_path);
+            return -1;
+        }
+        if (vmaf_write_trace(tracefile) == -ENOSYS)
+            fprintf(stderr, "libvmaf was built without tracing\n");
+        fclose(tracefile);
     }
 
     for (unsigned i = 0; i < c.model_cnt; i++) {
         vmaf_model_destroy(model[i]);
     }
 
-    video_input_close(&vid_ref);
-    video_input_close(&vid_dist);
+    if (c.path_ref) {
+        input_close(&in_ref);
+        input_close(&in_dist);
+    }
     vmaf_close(vmaf);
+    if (c.gate && gate.decision == VMAF_GATE_FAIL)
+        return 2;
     return err;
 }
@@ -0,0 +1,469 @@
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <libvmaf/libvmaf.rc.h>
+#include <libvmaf/picture.h>
+
+#define BENCH_MAX_SWEEP 16
+#define BENCH_RING_SIZE 8
+
+typedef enum pattern_type {
+    PATTERN_GRADIENT,
+    PATTERN_CHECKER,
+    PATTERN_URANDOM,
+    PATTERN_BAD_PATTERN
+} pattern_type;
+
+typedef struct {
+    unsigned width, height, bitdepth, frame_cnt;
+    enum VmafPixelFormat pix_fmt;
+    pattern_type pattern;
+    unsigned noise;
+    unsigned thread_cnt[BENCH_MAX_SWEEP], thread_sweep;
+    unsigned subsample[BENCH_MAX_SWEEP], subsample_sweep;
+    char *extractors[BENCH_MAX_SWEEP];
+    unsigned extractors_sweep;
+    unsigned in_flight;
+    int json;
+} BenchSettings;
+
+typedef struct {
+    unsigned thread_cnt, subsample;
+    const char *extractors;
+} BenchConfig;
+
+typedef struct {
+    int err;
+    double fps;
+    double p50, p99; ///< Time spent in vmaf_read_pictures(), in ms.
+    long peak_rss; ///< In KiB.
+} BenchResult;
+
+static const char short_opts[] = "w:h:p:b:n:P:N:t:s:f:F:j";
+
+static const struct option long_opts[] = {
+    { "width",            1, NULL, 'w' },
+    { "height",           1, NULL, 'h' },
+    { "pixel_format",     1, NULL, 'p' },
+    { "bitdepth",         1, NULL, 'b' },
+    { "frames",           1, NULL, 'n' },
+    { "pattern",          1, NULL, 'P' },
+    { "noise",            1, NULL, 'N' },
+    { "threads",          1, NULL, 't' },
+    { "subsample",        1, NULL, 's' },
+    { "features",         1, NULL, 'f' },
+    { "in_flight",        1, NULL, 'F' },
+    { "json",             0, NULL, 'j' },
+    { NULL,               0, NULL, 0 },
+};
+
+static void usage(const char *const app)
+{
+    fprintf(stderr, "Usage: %s [options]\n\n", app);
+    fprintf(stderr, "Supported options:\n"
+            " --width/-w $unsigned:      width (default 1920)\n"
+            " --height/-h $unsigned:     height (default 1080)\n"
+            " --pixel_format/-p $string: pixel format (420/422/444)\n"
+            " --bitdepth/-b $unsigned:   bitdepth (8/10/12)\n"
+            " --frames/-n $unsigned:     number of frames (default 60)\n"
+            " --pattern/-P $unsigned:    0 gradient, 1 checker, 2 urandom\n"
+            " --noise/-N $unsigned:      distortion amplitude, 8-bit scale\n"
+            " --threads/-t $list:        thread counts to sweep, e.g. 0,2,4\n"
+            " --subsample/-s $list:      subsampling factors to sweep, e.g. 1,2\n"
+            " --features/-f $list:       feature extractor set, e.g.\n"
+            "                               float_adm,float_vif,float_motion\n"
+            "                            may be given several times to sweep\n"
+            " --in_flight/-F $unsigned:  picture pairs being extracted at once,\n"
+            "                            0 unbounded (default)\n"
+            " --json/-j:                 print results as JSON\n"
+           );
+    exit(1);
+}
+
+static unsigned parse_list(const char *optarg, unsigned *list,
+                           const char *app)
+{
+    unsigned cnt = 0;
+    const char *s = optarg;
+    while (*s) {
+        char *end;
+        const unsigned long v = strtoul(s, &end, 0);
+        if (end == s || cnt == BENCH_MAX_SWEEP) usage(app);
+        list[cnt++] = v;
+        s = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') usage(app);
+    }
+    if (!cnt) usage(app);
+    return cnt;
+}
+
+static void parse_settings(const int argc, char *const *const argv,
+                           BenchSettings *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->width = 1920;
+    s->height = 1080;
+    s->bitdepth = 8;
+    s->frame_cnt = 60;
+    s->pix_fmt = VMAF_PIX_FMT_YUV420P;
+    s->pattern = PATTERN_GRADIENT;
+    s->noise = 8;
+
+    int o;
+    while ((o = getopt_long(argc, argv, short_opts, long_opts, NULL)) >= 0) {
+        switch (o) {
+        case 'w':
+            s->width = strtoul(optarg, NULL, 0);
+            break;
+        case 'h':
+            s->height = strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            if (!strcmp(optarg, "420"))
+                s->pix_fmt = VMAF_PIX_FMT_YUV420P;
+            else if (!strcmp(optarg, "422"))
+                s->pix_fmt = VMAF_PIX_FMT_YUV422P;
+            else if (!strcmp(optarg, "444"))
+                s->pix_fmt = VMAF_PIX_FMT_YUV444P;
+            else
+                usage(argv[0]);
+            break;
+        case 'b':
+            s->bitdepth = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            s->frame_cnt = strtoul(optarg, NULL, 0);
+            break;
+        case 'P':
+            s->pattern = strtoul(optarg, NULL, 0);
+            break;
+        case 'N':
+            s->noise = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            s->thread_sweep = parse_list(optarg, s->thread_cnt, argv[0]);
+            break;
+        case 's':
+            s->subsample_sweep = parse_list(optarg, s->subsample, argv[0]);
+            break;
+        case 'f':
+            if (s->extractors_sweep == BENCH_MAX_SWEEP) usage(argv[0]);
+            s->extractors[s->extractors_sweep++] = optarg;
+            break;
+        case 'F':
+            s->in_flight = strtoul(optarg, NULL, 0);
+            break;
+        case 'j':
+            s->json = 1;
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (!s->width || !s->height || !s->frame_cnt) usage(argv[0]);
+    if (s->bitdepth != 8 && s->bitdepth != 10 && s->bitdepth != 12)
+        usage(argv[0]);
+    if (s->pattern >= PATTERN_BAD_PATTERN) usage(argv[0]);
+
+    if (!s->thread_sweep) {
+        s->thread_cnt[0] = 0;
+        s->thread_sweep = 1;
+    }
+    if (!s->subsample_sweep) {
+        s->subsample[0] = 1;
+        s->subsample_sweep = 1;
+    }
+    if (!s->extractors_sweep)
+        s->extractors[s->extractors_sweep++] = "float_adm,float_vif,float_motion";
+}
+
+static unsigned next_rand(unsigned *state)
+{
+    *state = *state * 1103515245 + 12345;
+    return (*state >> 16) & 0x7fff;
+}
+
+static unsigned get_pixel(unsigned i, unsigned j, unsigned frame,
+                          pattern_type pattern, unsigned *rand_state)
+{
+    switch (pattern) {
+    case PATTERN_GRADIENT:
+        return (i + j + 4 * frame) & 255;
+    case PATTERN_CHECKER:
+        return ((i + frame) / 8 % 2 == j / 8 % 2) ? 192 : 64;
+    case PATTERN_URANDOM:
+        return next_rand(rand_state) & 255;
+    default:
+        return 0;
+    }
+}
+
+static void put_pixel(VmafPicture *pic, unsigned plane, unsigned i,
+                      unsigned j, int value)
+{
+    const int max = (1 << pic->bpc) - 1;
+    value = value < 0 ? 0 : value > max ? max : value;
+    uint8_t *row = (uint8_t *) pic->data[plane] + i * pic->stride[plane];
+    if (pic->bpc > 8)
+        ((uint16_t *) row)[j] = value;
+    else
+        row[j] = value;
+}
+
+static int make_pattern(VmafPicture *ref, VmafPicture *dist,
+                        const BenchSettings *s, unsigned frame)
+{
+    int err = vmaf_picture_alloc(ref, s->pix_fmt, s->bitdepth, s->width,
+                                 s->height);
+    err |= vmaf_picture_alloc(dist, s->pix_fmt, s->bitdepth, s->width,
+                              s->height);
+    if (err) return err;
+
+    const unsigned shift = s->bitdepth - 8;
+    unsigned rand_state = frame + 1;
+    for (unsigned i = 0; i < s->height; i++) {
+        for (unsigned j = 0; j < s->width; j++) {
+            const int v =
+                get_pixel(i, j, frame, s->pattern, &rand_state) << shift;
+            const int noise = s->noise ?
+                (int) (next_rand(&rand_state) % (2 * s->noise + 1)) -
+                (int) s->noise : 0;
+            put_pixel(ref, 0, i, j, v);
+            put_pixel(dist, 0, i, j, v + (noise << shift));
+        }
+    }
+    for (unsigned p = 1; p < 3; p++) {
+        for (unsigned i = 0; i < ref->h[p]; i++) {
+            for (unsigned j = 0; j < ref->w[p]; j++) {
+                put_pixel(ref, p, i, j, 128 << shift);
+                put_pixel(dist, p, i, j, 128 << shift);
+            }
+        }
+    }
+    return 0;
+}
+
+static int copy_picture(VmafPicture *dst, VmafPicture *src)
+{
+    int err = vmaf_picture_alloc(dst, src->pix_fmt, src->bpc, src->w[0],
+                                 src->h[0]);
+    if (err) return err;
+    for (unsigned p = 0; p < 3; p++) {
+        const size_t sz = src->stride[p] * src->h[p];
+        memcpy(dst->data[p], src->data[p], sz);
+    }
+    return 0;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    const double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static int use_features(VmafContext *vmaf, const char *list)
+{
+    char *names = strdup(list);
+    if (!names) return -ENOMEM;
+
+    int err = 0;
+    for (char *name = strtok(names, ","); name; name = strtok(NULL, ",")) {
+        err = vmaf_use_feature(vmaf, name);
+        if (err) {
+            fprintf(stderr, "problem loading feature extractor: %s\n", name);
+            break;
+        }
+    }
+    free(names);
+    return err;
+}
+
+static void run_config(const BenchSettings *s, const BenchConfig *c,
+                       BenchResult *r)
+{
+    VmafPicture ring[BENCH_RING_SIZE][2];
+    unsigned ring_cnt = 0;
+    double *latency = NULL;
+    VmafContext *vmaf = NULL;
+    int err = 0;
+
+    for (; ring_cnt < BENCH_RING_SIZE; ring_cnt++) {
+        err = make_pattern(&ring[ring_cnt][0], &ring[ring_cnt][1], s,
+                           ring_cnt);
+        if (err) goto cleanup;
+    }
+
+    latency = malloc(sizeof(*latency) * s->frame_cnt);
+    if (!latency) {
+        err = -ENOMEM;
+        goto cleanup;
+    }
+
+    VmafConfiguration cfg = {
+        .log_level = VMAF_LOG_LEVEL_NONE,
+        .n_threads = c->thread_cnt,
+        .n_subsample = c->subsample,
+        .cpumask = 0,
+        .max_in_flight = s->in_flight,
+    };
+    err = vmaf_init(&vmaf, cfg);
+    if (err) goto cleanup;
+    err = use_features(vmaf, c->extractors);
+    if (err) goto cleanup;
+
+    const double begin = now();
+    for (unsigned i = 0; i < s->frame_cnt; i++) {
+        VmafPicture ref, dist;
+        err = copy_picture(&ref, &ring[i % BENCH_RING_SIZE][0]);
+        err |= copy_picture(&dist, &ring[i % BENCH_RING_SIZE][1]);
+        if (err) goto cleanup;
+
+        const double t = now();
+        err = vmaf_read_pictures(vmaf, &ref, &dist, i);
+        latency[i] = (now() - t) * 1e3;
+        if (err) goto cleanup;
+    }
+    VmafProfile profile;
+    err = vmaf_get_profile(vmaf, &profile);
+    if (err) goto cleanup;
+    r->fps = s->frame_cnt / (now() - begin);
+
+    qsort(latency, s->frame_cnt, sizeof(*latency), cmp_double);
+    r->p50 = latency[s->frame_cnt / 2];
+    r->p99 = latency[(s->frame_cnt - 1) * 99 / 100];
+
+cleanup:
+    if (vmaf) vmaf_close(vmaf);
+    free(latency);
+    for (unsigned i = 0; i < ring_cnt; i++) {
+        vmaf_picture_unref(&ring[i][0]);
+        vmaf_picture_unref(&ring[i][1]);
+    }
+    r->err = err;
+}
+
+/**
+ * Each configuration runs in its own process, so that its peak RSS is not
+ * shadowed by an earlier configuration.
+ */
+static int bench_config(const BenchSettings *s, const BenchConfig *c,
+                        BenchResult *r)
+{
+    int fd[2];
+    if (pipe(fd)) return -errno;
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fd[0]);
+        close(fd[1]);
+        return -errno;
+    }
+    if (!pid) {
+        close(fd[0]);
+        BenchResult result = { 0 };
+        run_config(s, c, &result);
+        const ssize_t n = write(fd[1], &result, sizeof(result));
+        close(fd[1]);
+        _exit(n != sizeof(result));
+    }
+
+    close(fd[1]);
+    memset(r, 0, sizeof(*r));
+    const ssize_t n = read(fd[0], r, sizeof(*r));
+    close(fd[0]);
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) return -errno;
+    if (n != sizeof(*r) || !WIFEXITED(status) || WEXITSTATUS(status))
+        return -EIO;
+#ifdef __APPLE__
+    r->peak_rss = usage.ru_maxrss / 1024;
+#else
+    r->peak_rss = usage.ru_maxrss;
+#endif
+    return r->err;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchSettings s;
+    parse_settings(argc, argv, &s);
+
+    if (s.json) {
+        printf("{\n");
+        printf("  \"version\": \"%s\",\n", vmaf_version());
+        printf("  \"width\": %u,\n", s.width);
+        printf("  \"height\": %u,\n", s.height);
+        printf("  \"bitdepth\": %u,\n", s.bitdepth);
+        printf("  \"frames\": %u,\n", s.frame_cnt);
+        printf("  \"results\": [");
+    } else {
+        printf("%ux%u %u-bit, %u frames\n", s.width, s.height, s.bitdepth,
+               s.frame_cnt);
+        printf("%7s %9s %10s %10s %10s %12s  %s\n", "threads", "subsample",
+               "fps", "p50 ms", "p99 ms", "peak RSS MiB", "features");
+    }
+
+    int err = 0;
+    unsigned cnt = 0;
+    for (unsigned f = 0; f < s.extractors_sweep; f++) {
+        for (unsigned t = 0; t < s.thread_sweep; t++) {
+            for (unsigned i = 0; i < s.subsample_sweep; i++) {
+                BenchConfig c = {
+                    .thread_cnt = s.thread_cnt[t],
+                    .subsample = s.subsample[i],
+                    .extractors = s.extractors[f],
+                };
+                BenchResult r;
+                err = bench_config(&s, &c, &r);
+                if (err) {
+                    fprintf(stderr, "problem running %u threads, "
+                            "subsample %u, features %s: %d\n", c.thread_cnt,
+                            c.subsample, c.extractors, err);
+                    goto end;
+                }
+
+                if (s.json) {
+                    printf("%s\n    { \"threads\": %u, \"subsample\": %u, "
+                           "\"features\": \"%s\", \"fps\": %.2f, "
+                           "\"p50_ms\": %.3f, \"p99_ms\": %.3f, "
+                           "\"peak_rss_kib\": %ld }", cnt ? "," : "",
+                           c.thread_cnt, c.subsample, c.extractors, r.fps,
+                           r.p50, r.p99, r.peak_rss);
+                } else {
+                    printf("%7u %9u %10.2f %10.3f %10.3f %12.1f  %s\n",
+                           c.thread_cnt, c.subsample, r.fps, r.p50, r.p99,
+                           r.peak_rss / 1024., c.extractors);
+                }
+                fflush(stdout);
+                cnt++;
+            }
+        }
+    }
+
+end:
+    if (s.json) {
+        printf("\n  ]\n");
+        printf("}\n");
+    }
+    return err ? 1 : 0;
+}
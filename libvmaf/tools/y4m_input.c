@@ -73,6 +73,8 @@ struct y4m_input{
   y4m_convert_func  convert;
   unsigned char    *dst_buf;
   unsigned char    *aux_buf;
+  /*Only luma is used: chroma is skipped, and never converted.*/
+  int               luma_only;
 };
 
 static int y4m_parse_tags(y4m_input *_y4m,char *_tags){
@@ -764,18 +766,39 @@ static int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,
       return -1;
     }
   }
-  /*Read the frame data that needs no conversion.*/
-  if(fread(_y4m->dst_buf,1,_y4m->dst_buf_read_sz,_fin)!=_y4m->dst_buf_read_sz){
-    fprintf(stderr,"Error reading YUV frame data.\n");
-    return -1;
+  if(_y4m->luma_only){
+    size_t skip_sz;
+    /*Luma always comes first and needs no conversion.*/
+    if(fread(_y4m->dst_buf,1,pic_sz,_fin)!=(size_t)pic_sz){
+      fprintf(stderr,"Error reading YUV frame data.\n");
+      return -1;
+    }
+    /*Seek past the chroma, pipes have to read it.*/
+    skip_sz=_y4m->dst_buf_read_sz-pic_sz;
+    if(fseek(_fin,(long)(skip_sz+_y4m->aux_buf_read_sz),SEEK_CUR)&&
+     (fread(_y4m->dst_buf+pic_sz,1,skip_sz,_fin)!=skip_sz||
+     fread(_y4m->aux_buf,1,_y4m->aux_buf_read_sz,_fin)!=
+     _y4m->aux_buf_read_sz)){
+      fprintf(stderr,"Error reading YUV frame data.\n");
+      return -1;
+    }
   }
-  /*Read the frame data that does need conversion.*/
-  if(fread(_y4m->aux_buf,1,_y4m->aux_buf_read_sz,_fin)!=_y4m->aux_buf_read_sz){
-    fprintf(stderr,"Error reading YUV frame data.\n");
-    return -1;
+  else{
+    /*Read the frame data that needs no conversion.*/
+    if(fread(_y4m->dst_buf,1,_y4m->dst_buf_read_sz,_fin)!=
+     _y4m->dst_buf_read_sz){
+      fprintf(stderr,"Error reading YUV frame data.\n");
+      return -1;
+    }
+    /*Read the frame data that does need conversion.*/
+    if(fread(_y4m->aux_buf,1,_y4m->aux_buf_read_sz,_fin)!=
+     _y4m->aux_buf_read_sz){
+      fprintf(stderr,"Error reading YUV frame data.\n");
+      return -1;
+    }
+    /*Now convert the just read frame.*/
+    (*_y4m->convert)(_y4m,_y4m->dst_buf,_y4m->aux_buf);
   }
-  /*Now convert the just read frame.*/
-  (*_y4m->convert)(_y4m,_y4m->dst_buf,_y4m->aux_buf);
   /*Fill in the frame buffer pointers.*/
   _ycbcr[0].width=_y4m->frame_w;
   _ycbcr[0].height=_y4m->frame_h;
@@ -794,6 +817,10 @@ static int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,
   return 1;
 }
 
+static void y4m_input_set_luma_only(y4m_input *_y4m,int _luma_only){
+  _y4m->luma_only=_luma_only;
+}
+
 static void y4m_input_close(y4m_input *_y4m){
   free(_y4m->dst_buf);
   free(_y4m->aux_buf);
@@ -803,5 +830,6 @@ OC_EXTERN const video_input_vtbl Y4M_INPUT_VTBL={
   (video_input_open_func)y4m_input_open,
   (video_input_get_info_func)y4m_input_get_info,
   (video_input_fetch_frame_func)y4m_input_fetch_frame,
-  (video_input_close_func)y4m_input_close
+  (video_input_close_func)y4m_input_close,
+  (video_input_set_luma_only_func)y4m_input_set_luma_only
 };
@@ -23,6 +23,7 @@ typedef struct yuv_input {
     uint8_t *dst_buf;
     int src_c_dec_v, src_c_dec_h;
     int dst_c_dec_h, dst_c_dec_v;
+    int luma_only;
 } yuv_input;
 
 
@@ -42,6 +43,7 @@ static yuv_input *yuv_input_open(FILE *_fin,
     yuv->height = height;
     yuv->pix_fmt = pix_fmt;
     yuv->bitdepth = bitdepth;
+    yuv->luma_only = 0;
     bool hbd = yuv->bitdepth > 8;
 
     switch (yuv->pix_fmt) {
@@ -100,10 +102,28 @@ static void yuv_input_get_info(yuv_input *_yuv, video_input_info *_info)
     _info->depth = _yuv->bitdepth;
 }
 
+/*Reads only the luma plane if chroma can be skipped with a seek.*/
+static size_t yuv_input_read(yuv_input *yuv, FILE *fin, size_t pic_sz)
+{
+    if (!yuv->luma_only)
+        return fread(yuv->dst_buf, 1, yuv->dst_buf_sz, fin);
+
+    size_t bytes_read = fread(yuv->dst_buf, 1, pic_sz, fin);
+    if (bytes_read != pic_sz)
+        return bytes_read;
+    const size_t c_sz = yuv->dst_buf_sz - pic_sz;
+    if (!fseek(fin, c_sz, SEEK_CUR))
+        return yuv->dst_buf_sz;
+    return bytes_read + fread(yuv->dst_buf + pic_sz, 1, c_sz, fin);
+}
+
 static int yuv_input_fetch_frame(yuv_input *yuv, FILE *fin,
                                  video_input_ycbcr _ycbcr, char _tag[5])
 {
-    size_t bytes_read = fread(yuv->dst_buf, 1, yuv->dst_buf_sz, fin); 
+    unsigned xstride = (yuv->bitdepth>8)?2:1;
+    ptrdiff_t pic_sz = yuv->width * yuv->height * xstride;
+
+    size_t bytes_read = yuv_input_read(yuv, fin, pic_sz);
     if (bytes_read == 0) return 0;
     if (bytes_read != yuv->dst_buf_sz) {
         fprintf(stderr, "Error reading YUV frame data.\n");
@@ -112,8 +132,6 @@ static int yuv_input_fetch_frame(yuv_input *yuv, FILE *fin,
     
     (void) _tag;
 
-    unsigned xstride = (yuv->bitdepth>8)?2:1;
-    ptrdiff_t pic_sz = yuv->width * yuv->height * xstride;
     unsigned frame_c_w = yuv->width/yuv->dst_c_dec_h;
     unsigned frame_c_h = yuv->height/yuv->dst_c_dec_v;
     unsigned c_w = (yuv->width+yuv->dst_c_dec_h-1)/yuv->dst_c_dec_h;
@@ -136,6 +154,10 @@ static int yuv_input_fetch_frame(yuv_input *yuv, FILE *fin,
     return 1;
 }
 
+static void yuv_input_set_luma_only(yuv_input *_yuv, int _luma_only){
+  _yuv->luma_only=_luma_only;
+}
+
 static void yuv_input_close(yuv_input *_yuv){
   free(_yuv->dst_buf);
 }
@@ -144,5 +166,6 @@ OC_EXTERN const raw_input_vtbl YUV_INPUT_VTBL={
   (raw_input_open_func)yuv_input_open,
   (video_input_get_info_func)yuv_input_get_info,
   (video_input_fetch_frame_func)yuv_input_fetch_frame,
-  (video_input_close_func)yuv_input_close
+  (video_input_close_func)yuv_input_close,
+  (video_input_set_luma_only_func)yuv_input_set_luma_only
 };